@@ -0,0 +1,116 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/utils.h>
+
+#include "../xLights/AudioManager.h"
+
+TEST(Audio_Tests, WaveformPyramidMatchesSamples) {
+    srand(42);
+    for (long samples : { 1L, 63L, 64L, 65L, 1000L, 44100L }) {
+        std::vector<float> data(samples);
+        for (auto& d : data) {
+            d = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+        }
+        WaveformPyramid pyramid(data.data(), samples);
+        ASSERT_EQ(samples, pyramid.GetSampleCount());
+
+        for (int i = 0; i < 2000; i++) {
+            // ranges that run off either end of the track are clipped to it
+            long start = rand() % (samples + 10) - 5;
+            long end = start + rand() % (samples + 10);
+            float minimum, maximum, rms;
+            pyramid.GetMinMaxRMS(start, end, minimum, maximum, rms);
+
+            long s = std::max(start, 0L);
+            long e = std::min(end, samples);
+            float expectedMin = 0;
+            float expectedMax = 0;
+            double sumsq = 0;
+            if (s < e) {
+                expectedMin = expectedMax = data[s];
+            }
+            for (long j = s; j < e; j++) {
+                expectedMin = std::min(expectedMin, data[j]);
+                expectedMax = std::max(expectedMax, data[j]);
+                sumsq += (double)data[j] * data[j];
+            }
+            ASSERT_EQ(expectedMin, minimum) << samples << " samples, " << start << " to " << end;
+            ASSERT_EQ(expectedMax, maximum) << samples << " samples, " << start << " to " << end;
+            ASSERT_NEAR(s < e ? std::sqrt(sumsq / (e - s)) : 0.0, rms, 1e-5) << samples << " samples, " << start << " to " << end;
+        }
+    }
+}
+
+// the spectrum kept as bytes should read back within rounding of the floats it came from
+TEST(Audio_Tests, CompactFrameDataMatchesFloat) {
+    // a few seconds of tones sweeping up so every frame has a different spectrum
+    const int rate = 44100;
+    const double pi = 3.14159265358979;
+    std::vector<float> left(rate * 3);
+    double phase = 0;
+    for (size_t i = 0; i < left.size(); i++) {
+        phase += 2.0 * pi * (110.0 + 2000.0 * i / left.size()) / rate;
+        left[i] = 0.5f * std::sin(phase) + 0.25f * std::sin(phase * 3.0);
+    }
+    std::string file = wxFileName(wxFileName::GetTempDir(), "audio_compact.wav").GetFullPath().ToStdString();
+    ASSERT_TRUE(AudioManager::CreateAudioFile(left, left, file, 0));
+
+    auto load = [&file](bool compact) {
+        AudioManager::SetCompactFrameData(compact);
+        auto audio = std::make_unique<AudioManager>(file, 50);
+        while (!audio->IsDataLoaded()) {
+            wxMilliSleep(10);
+        }
+        audio->PrepareFrameData(false);
+        return audio;
+    };
+    auto full = load(false);
+    auto compact = load(true);
+    AudioManager::SetCompactFrameData(false);
+    ASSERT_TRUE(full->IsOk());
+
+    int frames = full->LengthMS() / 50;
+    ASSERT_GT(frames, 10);
+    int withSpectrum = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        for (auto fdt : { FRAMEDATA_HIGH, FRAMEDATA_LOW, FRAMEDATA_SPREAD }) {
+            auto f = full->GetFrameData(frame, fdt, "");
+            auto c = compact->GetFrameData(frame, fdt, "");
+            ASSERT_EQ((bool)f, (bool)c);
+            if (f) {
+                // the levels are not compacted
+                ASSERT_EQ(f.front(), c.front()) << "frame " << frame;
+            }
+        }
+        auto f = full->GetFrameData(frame, FRAMEDATA_VU, "");
+        auto c = compact->GetFrameData(frame, FRAMEDATA_VU, "");
+        ASSERT_EQ((bool)f, (bool)c);
+        ASSERT_EQ(f.size(), c.size());
+        for (size_t n = 0; n < f.size(); n++) {
+            ASSERT_NEAR(std::min(1.0f, std::max(0.0f, f[n])), c[n], 0.5f / 255.0f + 1e-6f) << "frame " << frame << " note " << n;
+        }
+        if (!f.empty()) {
+            withSpectrum++;
+        }
+    }
+    ASSERT_GT(withSpectrum, frames / 2);
+    wxRemoveFile(file);
+}
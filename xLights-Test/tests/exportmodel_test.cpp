@@ -0,0 +1,78 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include <wx/filename.h>
+#include <wx/image.h>
+
+#include "wxfixture.h"
+
+#include "../xLights/SequenceData.h"
+#include "../xLights/xLightsApp.h"
+#include "../xLights/xLightsMain.h"
+#include "../xLights/models/Model.h"
+
+// the benchmark show folder, see benchmark/readme.txt
+static wxString BenchmarkDir() {
+    wxFileName dir(wxString(__FILE__));
+    dir.MakeAbsolute();
+    dir.RemoveLastDir();
+    dir.AppendDir("benchmark");
+    return dir.GetPath();
+}
+
+struct ExportModel_Tests : public IP_Host_Tests
+{
+};
+
+// Props Block 1 comes before Props Row 01 to 05 in DeepGroups.xsq, those groups blend on top of it
+// so the export has to render them too to end up with what a full render puts in its channels.
+TEST_F(ExportModel_Tests, SparseExportMatchesFullRender) {
+    wxInitAllImageHandlers();
+    xLightsApp::showDir = BenchmarkDir();
+    xLightsApp::mediaDir = xLightsApp::showDir;
+    xLightsFrame* frame = new xLightsFrame(nullptr, 0, -1, true);
+    frame->_renderCache.Enable("Disabled");
+    frame->OpenSequence(wxFileName(xLightsApp::showDir, "DeepGroups.xsq").GetFullPath(), nullptr);
+    ASSERT_GT(frame->_seqData.NumFrames(), 0u);
+
+    Model* block = frame->GetModel("Props Block 1");
+    ASSERT_NE(nullptr, block);
+    SequenceData exported;
+    ASSERT_TRUE(frame->RenderModelToSeqData(block, exported));
+
+    bool done = false;
+    bool aborted = false;
+    frame->RenderGridToSeqData([&done, &aborted](bool a) {
+        aborted = a;
+        done = true;
+    });
+    while (!done) {
+        wxYield();
+    }
+    ASSERT_FALSE(aborted);
+
+    ASSERT_EQ(frame->_seqData.NumFrames(), exported.NumFrames());
+    int differences = 0;
+    for (unsigned int f = 0; f < exported.NumFrames(); f++) {
+        for (size_t n = 0; n < block->GetNodeCount(); n++) {
+            for (int32_t c = block->NodeStartChannel(n); c <= block->NodeEndChannel(n); c++) {
+                if (exported[f][c] != frame->_seqData[f][c]) {
+                    differences++;
+                }
+            }
+        }
+    }
+    EXPECT_EQ(0, differences);
+
+    frame->CloseSequence();
+    frame->Destroy();
+}
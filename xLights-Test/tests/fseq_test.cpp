@@ -0,0 +1,297 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <wx/filename.h>
+
+#include "wxfixture.h"
+
+#include "../xLights/FSEQFile.h"
+#include "../xLights/FSEQStreamWriter.h"
+#include "../xLights/Parallel.h"
+#include "../xLights/SequenceData.h"
+
+struct FSEQ_Tests : public IP_Host_Tests
+{
+};
+
+static std::string TempFile(const char* name) {
+    wxFileName fn(wxFileName::GetTempDir(), name);
+    return fn.GetFullPath().ToStdString();
+}
+
+// stands in for the effects, enough work per channel that rendering takes a while
+static void RenderFrame(SequenceData& seqData, int frame) {
+    unsigned char* data = &seqData[frame][0];
+    for (unsigned int c = 0; c < seqData.NumChannels(); c++) {
+        double v = std::sin(c * 0.01 + frame * 0.1) * std::cos(c * 0.003 - frame * 0.05);
+        data[c] = (unsigned char)((v + 1.0) * 127.5);
+    }
+}
+
+static FSEQFile* CreateFile(const std::string& fn, SequenceData& seqData, int threads) {
+    V2FSEQFile* file = (V2FSEQFile*)FSEQFile::createFSEQFile(fn, 2, FSEQFile::CompressionType::zstd, 2);
+    file->enableMinorVersionFeatures(2);
+    file->setChannelCount(seqData.NumChannels());
+    file->setStepTime(seqData.FrameTime());
+    file->setNumFrames(seqData.NumFrames());
+    file->m_compressionThreads = threads;
+    file->writeHeader();
+    return file;
+}
+
+static void ExpectFileMatches(const std::string& fn, SequenceData& seqData) {
+    FSEQFile* file = FSEQFile::openFSEQFile(fn);
+    ASSERT_NE(nullptr, file);
+    ASSERT_EQ(seqData.NumFrames(), file->getNumFrames());
+    std::vector<std::pair<uint32_t, uint32_t>> ranges = { { 0, seqData.NumChannels() } };
+    file->prepareRead(ranges);
+    std::vector<uint8_t> data(seqData.NumChannels());
+    for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+        FSEQFile::FrameData* fd = file->getFrame(f);
+        fd->readFrame(&data[0], data.size());
+        delete fd;
+        if (memcmp(&data[0], &seqData[f][0], data.size()) != 0) {
+            FAIL() << "frame " << f << " differs";
+        }
+    }
+    delete file;
+}
+
+// the file contents apart from the unique id, that is the time the header was written
+static std::vector<uint8_t> FileBytes(const std::string& fn) {
+    std::vector<uint8_t> bytes;
+    FILE* f = fopen(fn.c_str(), "rb");
+    if (f != nullptr) {
+        uint8_t buf[65536];
+        size_t len;
+        while ((len = fread(buf, 1, sizeof(buf), f)) > 0) {
+            bytes.insert(bytes.end(), buf, buf + len);
+        }
+        fclose(f);
+    }
+    if (bytes.size() >= 32) {
+        std::fill(bytes.begin() + 24, bytes.begin() + 32, 0);
+    }
+    return bytes;
+}
+
+TEST_F(FSEQ_Tests, ParallelCompressionMatchesSerial) {
+    SequenceData seqData;
+    seqData.init(30000, 1000, 50);
+    for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+        RenderFrame(seqData, f);
+    }
+
+    std::string serial = TempFile("fseq_serial.fseq");
+    FSEQFile* file = CreateFile(serial, seqData, 0);
+    for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+        file->addFrame(f, &seqData[f][0]);
+    }
+    file->finalize();
+    delete file;
+    ExpectFileMatches(serial, seqData);
+
+    std::string streamed = TempFile("fseq_streamed.fseq");
+    FSEQStreamWriter writer(CreateFile(streamed, seqData, 4), seqData);
+    for (unsigned int f = 0; f < seqData.NumFrames(); f += 7) {
+        writer.FramesDone(f);
+    }
+    writer.Finish();
+    ExpectFileMatches(streamed, seqData);
+
+    std::vector<uint8_t> serialBytes = FileBytes(serial);
+    std::vector<uint8_t> streamedBytes = FileBytes(streamed);
+    ASSERT_EQ(serialBytes.size(), streamedBytes.size());
+    EXPECT_TRUE(serialBytes == streamedBytes);
+
+    wxRemoveFile(serial);
+    wxRemoveFile(streamed);
+}
+
+TEST_F(FSEQ_Tests, ReadAheadMatchesSynchronousRead) {
+    SequenceData seqData;
+    seqData.init(20000, 600, 50);
+    for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+        RenderFrame(seqData, f);
+    }
+    std::string fn = TempFile("fseq_readahead.fseq");
+    FSEQFile* file = CreateFile(fn, seqData, 0);
+    for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+        file->addFrame(f, &seqData[f][0]);
+    }
+    file->finalize();
+    delete file;
+
+    file = FSEQFile::openFSEQFile(fn);
+    ASSERT_NE(nullptr, file);
+    file->enableReadAhead(3, 2);
+    // only part of the channels, as xSchedule reads when a playlist item outputs a subset
+    const uint32_t start = 1000;
+    const uint32_t len = 5000;
+    file->prepareRead({ { start, len } });
+    std::vector<uint8_t> data(seqData.NumChannels());
+    // straight through, then a seek back as happens when a playlist item is restarted
+    std::vector<unsigned int> frames;
+    for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+        frames.push_back(f);
+    }
+    for (unsigned int f = 100; f < 200; f++) {
+        frames.push_back(f);
+    }
+    for (unsigned int f : frames) {
+        FSEQFile::FrameData* fd = file->getFrame(f);
+        ASSERT_NE(nullptr, fd);
+        std::fill(data.begin(), data.end(), 0);
+        fd->readFrame(&data[0], data.size());
+        delete fd;
+        if (memcmp(&data[start], &seqData[f][start], len) != 0) {
+            FAIL() << "frame " << f << " differs";
+        }
+    }
+    FSEQFile::ReadAheadStats stats;
+    ASSERT_TRUE(file->getReadAheadStats(stats));
+    EXPECT_GT(stats.blocksDecoded, 0u);
+    printf("    %u blocks decoded, average %.2fms, max %.2fms, %u stalls\n",
+           stats.blocksDecoded, stats.averageDecodeMS, stats.maxDecodeMS, stats.stalls);
+    delete file;
+    wxRemoveFile(fn);
+}
+
+static void WriteUncompressedFile(const std::string& fn, SequenceData& seqData) {
+    FSEQFile* file = FSEQFile::createFSEQFile(fn, 2, FSEQFile::CompressionType::none, 0);
+    file->setChannelCount(seqData.NumChannels());
+    file->setStepTime(seqData.FrameTime());
+    file->setNumFrames(seqData.NumFrames());
+    file->writeHeader();
+    for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+        file->addFrame(f, &seqData[f][0]);
+    }
+    file->finalize();
+    delete file;
+}
+
+TEST_F(FSEQ_Tests, SequenceDataReadsUncompressedFile) {
+    SequenceData seqData;
+    seqData.init(8000, 200, 50);
+    for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+        RenderFrame(seqData, f);
+    }
+    std::string fn = TempFile("fseq_raw.fseq");
+    WriteUncompressedFile(fn, seqData);
+
+    FSEQFile* file = FSEQFile::openFSEQFile(fn);
+    ASSERT_NE(nullptr, file);
+    ASSERT_TRUE(file->hasRawFrames());
+    SequenceData loaded;
+    ASSERT_TRUE(loaded.initFromFile(fn, file->getChannelDataOffset(), file->getChannelCount(), file->getNumFrames(), file->getStepTime()));
+    delete file;
+    for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+        ASSERT_EQ(0, memcmp(&loaded[f][0], &seqData[f][0], seqData.NumChannels())) << "frame " << f;
+    }
+
+    // the frames don't change when the file is rewritten, as it is when another copy of the sequence is saved
+    SequenceData blank;
+    blank.init(8000, 200, 50);
+    WriteUncompressedFile(fn, blank);
+    wxRemoveFile(fn);
+    for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+        ASSERT_EQ(0, memcmp(&loaded[f][0], &seqData[f][0], seqData.NumChannels())) << "frame " << f;
+    }
+
+    // a file too short for the frames isn't used
+    SequenceData shortFile;
+    seqData.init(8000, 10, 50);
+    WriteUncompressedFile(fn, seqData);
+    EXPECT_FALSE(shortFile.initFromFile(fn, 0, 8000, 200, 50));
+    EXPECT_FALSE(shortFile.IsValidData());
+    wxRemoveFile(fn);
+}
+
+#ifdef USE_MMAP_BLOCKS
+TEST_F(FSEQ_Tests, SequenceDataPagesLargeSequencesToDisk) {
+    SequenceData::SetFileBackedThresholdMB(1);
+    SequenceData seqData;
+    seqData.init(20000, 100, 50);
+    EXPECT_TRUE(seqData.IsFileBacked());
+    EXPECT_EQ(0, seqData[99][19999]);
+    for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+        RenderFrame(seqData, f);
+    }
+    SequenceData check;
+    SequenceData::SetFileBackedThresholdMB(0);
+    check.init(20000, 100, 50);
+    EXPECT_FALSE(check.IsFileBacked());
+    for (unsigned int f = 0; f < check.NumFrames(); f++) {
+        RenderFrame(check, f);
+        ASSERT_EQ(0, memcmp(&check[f][0], &seqData[f][0], check.NumChannels())) << "frame " << f;
+    }
+}
+#endif
+
+// timings only, run with --gtest_also_run_disabled_tests
+TEST_F(FSEQ_Tests, DISABLED_Benchmark_RenderAndSave) {
+    const int threads = std::max(2, (int)std::thread::hardware_concurrency());
+    SequenceData seqData;
+    seqData.init(150000, 1200, 50);
+    std::string fn = TempFile("fseq_benchmark.fseq");
+
+    auto render = [&](const std::function<void(int)>& frameDone) {
+        // the frames complete roughly in order, as the render rows do
+        const int chunk = 20;
+        for (int start = 0; start < (int)seqData.NumFrames(); start += chunk) {
+            int end = std::min(start + chunk, (int)seqData.NumFrames());
+            parallel_for(start, end, [&](int f) { RenderFrame(seqData, f); });
+            frameDone(end - 1);
+        }
+    };
+    auto time = [&](const char* name, const std::function<void()>& f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        printf("    %-32s : %.2fms\n", name, std::chrono::duration<double, std::milli>(end - start).count());
+    };
+
+    printf("Rendering and saving %d frames of %d channels:\n", seqData.NumFrames(), seqData.NumChannels());
+    time("render then save", [&]() {
+        render([](int) {});
+        FSEQFile* file = CreateFile(fn, seqData, 0);
+        for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+            file->addFrame(f, &seqData[f][0]);
+        }
+        file->finalize();
+        delete file;
+    });
+    time("render then parallel save", [&]() {
+        render([](int) {});
+        FSEQFile* file = CreateFile(fn, seqData, threads);
+        for (unsigned int f = 0; f < seqData.NumFrames(); f++) {
+            file->addFrame(f, &seqData[f][0]);
+        }
+        file->finalize();
+        delete file;
+    });
+    time("streamed while rendering", [&]() {
+        FSEQStreamWriter writer(CreateFile(fn, seqData, threads), seqData);
+        render([&](int frame) { writer.FramesDone(frame); });
+        writer.Finish();
+    });
+    ExpectFileMatches(fn, seqData);
+    wxRemoveFile(fn);
+}
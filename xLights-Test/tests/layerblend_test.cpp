@@ -0,0 +1,206 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "../xLights/LayerBlend.h"
+#include "../xLights/PixelBuffer.h"
+
+static const MixTypes ROW_MIX_TYPES[] = {
+    MixTypes::Mix_Normal,
+    MixTypes::Mix_Effect1,
+    MixTypes::Mix_Effect2,
+    MixTypes::Mix_Average,
+    MixTypes::Mix_Additive,
+    MixTypes::Mix_Subtractive,
+    MixTypes::Mix_Min,
+    MixTypes::Mix_Max,
+    MixTypes::Mix_AsBrightness
+};
+
+// random colors with plenty of the special cases (opaque, transparent, black) mixed in
+static std::vector<xlColor> RandomRow(std::mt19937& rng, int count) {
+    std::vector<xlColor> row(count);
+    for (int i = 0; i < count; i++) {
+        row[i].Set(rng() & 0xFF, rng() & 0xFF, rng() & 0xFF, rng() & 0xFF);
+        if (i % 7 == 0) {
+            row[i].alpha = 255;
+        }
+        if (i % 11 == 0) {
+            row[i].alpha = 0;
+        }
+        if (i % 13 == 0) {
+            row[i].Set(0, 0, 0, row[i].alpha);
+        }
+    }
+    return row;
+}
+
+static std::vector<LayerBlend::ISA> SupportedISAs() {
+    std::vector<LayerBlend::ISA> isas = { LayerBlend::ISA::SCALAR };
+    if (LayerBlend::GetBestISA() >= LayerBlend::ISA::SSE41) {
+        isas.push_back(LayerBlend::ISA::SSE41);
+    }
+    if (LayerBlend::GetBestISA() >= LayerBlend::ISA::AVX2) {
+        isas.push_back(LayerBlend::ISA::AVX2);
+    }
+    return isas;
+}
+
+// the per pixel versions PixelBufferClass::mixColors uses
+static void MixPixel(MixTypes mixType, double fadeFactor, float effectMixThreshold, bool effectMixVaries, xlColor& fg, xlColor& bg) {
+    switch (mixType) {
+    case MixTypes::Mix_Normal:
+        fg.alpha = LayerBlend::NormalAlpha(fg.alpha, fadeFactor, effectMixThreshold);
+        bg.AlphaBlendForgroundOnto(fg);
+        break;
+    case MixTypes::Mix_Effect1:
+    case MixTypes::Mix_Effect2: {
+        double emt, emtNot;
+        LayerBlend::EffectMixFactors(effectMixThreshold, effectMixVaries, emt, emtNot);
+        if (mixType == MixTypes::Mix_Effect2) {
+            LayerBlend::EffectMix(fg, bg, emtNot, emt);
+        } else {
+            LayerBlend::EffectMix(fg, bg, emt, emtNot);
+        }
+        break;
+    }
+    case MixTypes::Mix_Average:
+        LayerBlend::Average(fg, bg);
+        break;
+    case MixTypes::Mix_Additive:
+        LayerBlend::Additive(fg, bg);
+        break;
+    case MixTypes::Mix_Subtractive:
+        LayerBlend::Subtractive(fg, bg);
+        break;
+    case MixTypes::Mix_Min:
+        LayerBlend::Min(fg, bg);
+        break;
+    case MixTypes::Mix_Max:
+        LayerBlend::Max(fg, bg);
+        break;
+    case MixTypes::Mix_AsBrightness:
+        LayerBlend::AsBrightness(fg, bg);
+        break;
+    default:
+        break;
+    }
+}
+
+static void ExpectSameColors(const std::vector<xlColor>& expected, const std::vector<xlColor>& actual, const std::string& what) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        // xlColor == ignores alpha
+        if (expected[i] != actual[i] || expected[i].alpha != actual[i].alpha) {
+            FAIL() << what << " differs at pixel " << i << ": expected "
+                   << (int)expected[i].red << "," << (int)expected[i].green << "," << (int)expected[i].blue << "," << (int)expected[i].alpha
+                   << " got "
+                   << (int)actual[i].red << "," << (int)actual[i].green << "," << (int)actual[i].blue << "," << (int)actual[i].alpha;
+        }
+    }
+}
+
+TEST(LayerBlend_Tests, MixRowMatchesPerPixel) {
+    LayerBlend::ISA saved = LayerBlend::GetISA();
+    std::mt19937 rng(1234);
+    // odd size so the leftover pixels at the end of the row are covered
+    const int count = 1037;
+    for (auto isa : SupportedISAs()) {
+        LayerBlend::SetISA(isa);
+        for (auto mixType : ROW_MIX_TYPES) {
+            for (double fadeFactor : { 1.0, 0.37, 0.0 }) {
+                for (float emt : { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f }) {
+                    for (bool varies : { false, true }) {
+                        std::vector<xlColor> fg = RandomRow(rng, count);
+                        std::vector<xlColor> bg = RandomRow(rng, count);
+                        std::vector<xlColor> expectedFg = fg;
+                        std::vector<xlColor> expected = bg;
+                        for (int i = 0; i < count; i++) {
+                            MixPixel(mixType, fadeFactor, emt, varies, expectedFg[i], expected[i]);
+                        }
+                        ASSERT_TRUE(LayerBlend::MixRow(mixType, fadeFactor, emt, varies, &fg[0], &bg[0], count));
+                        ExpectSameColors(expected, bg, std::string(LayerBlend::GetISAName(isa)) + " mix " + std::to_string((int)mixType));
+                    }
+                }
+            }
+        }
+    }
+    LayerBlend::SetISA(saved);
+}
+
+TEST(LayerBlend_Tests, AlphaBlendAndBrightnessMatchPerPixel) {
+    LayerBlend::ISA saved = LayerBlend::GetISA();
+    std::mt19937 rng(4321);
+    const int count = 1001;
+    for (auto isa : SupportedISAs()) {
+        LayerBlend::SetISA(isa);
+
+        std::vector<xlColor> fg = RandomRow(rng, count);
+        std::vector<xlColor> bg = RandomRow(rng, count);
+        std::vector<xlColor> expected = bg;
+        for (int i = 0; i < count; i++) {
+            expected[i].AlphaBlendForgroundOnto(fg[i]);
+        }
+        LayerBlend::AlphaBlendRow(&fg[0], &bg[0], count);
+        ExpectSameColors(expected, bg, std::string(LayerBlend::GetISAName(isa)) + " alpha blend");
+
+        for (int brightness : { 0, 33, 100, 150, 400 }) {
+            std::vector<xlColor> colors = RandomRow(rng, count);
+            expected = colors;
+            for (auto& c : expected) {
+                LayerBlend::Brightness(c, brightness);
+            }
+            LayerBlend::BrightnessRow(&colors[0], count, brightness);
+            ExpectSameColors(expected, colors, std::string(LayerBlend::GetISAName(isa)) + " brightness " + std::to_string(brightness));
+        }
+    }
+    LayerBlend::SetISA(saved);
+}
+
+TEST(LayerBlend_Tests, HSVMixTypesNotHandled) {
+    xlColor fg(10, 20, 30);
+    xlColor bg(40, 50, 60);
+    EXPECT_FALSE(LayerBlend::SupportsMixType(MixTypes::Mix_Mask1));
+    EXPECT_FALSE(LayerBlend::MixRow(MixTypes::Mix_Shadow_1on2, 1.0, 0.0f, false, &fg, &bg, 1));
+    EXPECT_EQ(xlColor(40, 50, 60), bg);
+}
+
+// timings only, run with --gtest_also_run_disabled_tests
+TEST(LayerBlend_Tests, DISABLED_Benchmark_MixRow) {
+    LayerBlend::ISA saved = LayerBlend::GetISA();
+    std::mt19937 rng(42);
+    const int count = 256;
+    const int rows = 20000;
+    std::vector<xlColor> fg = RandomRow(rng, count);
+    std::vector<xlColor> bgStart = RandomRow(rng, count);
+
+    printf("Mixing %d rows of %d pixels:\n", rows, count);
+    for (auto mixType : { MixTypes::Mix_Normal, MixTypes::Mix_Additive, MixTypes::Mix_Max, MixTypes::Mix_Effect1 }) {
+        for (auto isa : SupportedISAs()) {
+            LayerBlend::SetISA(isa);
+            std::vector<xlColor> bg = bgStart;
+            std::vector<xlColor> scratch;
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < rows; r++) {
+                scratch = fg;
+                LayerBlend::MixRow(mixType, 0.8, 0.3f, false, &scratch[0], &bg[0], count);
+            }
+            auto end = std::chrono::steady_clock::now();
+            printf("    mix %2d %-7s : %.2fms\n", (int)mixType, LayerBlend::GetISAName(isa),
+                   std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+    LayerBlend::SetISA(saved);
+}
@@ -0,0 +1,133 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../xLights/LayerFrameCache.h"
+#include "../xLights/RenderBuffer.h"
+
+static void FillFrame(RenderBuffer& buffer, int frame) {
+    for (int y = 0; y < buffer.BufferHt; y++) {
+        for (int x = 0; x < buffer.BufferWi; x++) {
+            buffer.SetPixel(x, y, xlColor(frame, x, y));
+        }
+    }
+}
+
+TEST(LayerFrameCache_Tests, RestoresFrames) {
+    RenderBuffer buffer(nullptr);
+    buffer.InitBuffer(8, 10, "None");
+    LayerFrameCache cache;
+    cache.Prepare(50);
+
+    for (int f = 0; f < 10; f++) {
+        FillFrame(buffer, f);
+        cache.Put(f, buffer, f != 3, cache.GetGeneration());
+    }
+    EXPECT_TRUE(cache.HasFrames(0, 9, 10, 8));
+    EXPECT_FALSE(cache.HasFrames(0, 10, 10, 8));
+    EXPECT_FALSE(cache.HasFrames(0, 9, 8, 10));
+
+    bool valid = false;
+    ASSERT_TRUE(cache.Get(6, buffer, valid));
+    EXPECT_TRUE(valid);
+    EXPECT_EQ(xlColor(6, 9, 7), buffer.GetPixel(9, 7));
+    ASSERT_TRUE(cache.Get(3, buffer, valid));
+    EXPECT_FALSE(valid);
+
+    RenderBuffer other(nullptr);
+    other.InitBuffer(10, 8, "None");
+    EXPECT_FALSE(cache.Get(6, other, valid));
+}
+
+TEST(LayerFrameCache_Tests, EditsInvalidateTheirFrames) {
+    RenderBuffer buffer(nullptr);
+    buffer.InitBuffer(4, 4, "None");
+    LayerFrameCache cache;
+    cache.Prepare(50);
+    for (int f = 0; f < 10; f++) {
+        cache.Put(f, buffer, true, cache.GetGeneration());
+    }
+
+    // an effect from 100ms to 200ms covers frames 2 to 4
+    cache.Invalidate(100, 200);
+    EXPECT_TRUE(cache.HasFrames(0, 1, 4, 4));
+    EXPECT_TRUE(cache.HasFrames(5, 9, 4, 4));
+    for (int f = 2; f <= 4; f++) {
+        EXPECT_FALSE(cache.HasFrames(f, f, 4, 4));
+    }
+
+    // frames rendered before an edit are not kept
+    uint32_t generation = cache.GetGeneration();
+    cache.Invalidate(500, 550);
+    cache.Put(3, buffer, true, generation);
+    EXPECT_FALSE(cache.HasFrames(3, 3, 4, 4));
+    cache.Put(3, buffer, true, cache.GetGeneration());
+    EXPECT_TRUE(cache.HasFrames(3, 3, 4, 4));
+
+    cache.Invalidate(-1, -1);
+    EXPECT_FALSE(cache.HasFrames(0, 0, 4, 4));
+}
+
+TEST(LayerFrameCache_Tests, InvalidateAllAndFrameTime) {
+    RenderBuffer buffer(nullptr);
+    buffer.InitBuffer(4, 4, "None");
+    LayerFrameCache cache;
+    cache.Prepare(50);
+    cache.Put(0, buffer, true, cache.GetGeneration());
+    size_t used = LayerFrameCache::GetSizeBytes();
+    EXPECT_GE(used, 16 * sizeof(xlColor));
+
+    cache.Prepare(50);
+    EXPECT_TRUE(cache.HasFrames(0, 0, 4, 4));
+    cache.Prepare(25);
+    EXPECT_FALSE(cache.HasFrames(0, 0, 4, 4));
+    EXPECT_EQ(used - 16 * sizeof(xlColor), LayerFrameCache::GetSizeBytes());
+
+    cache.Put(0, buffer, true, cache.GetGeneration());
+    LayerFrameCache::InvalidateAll();
+    EXPECT_FALSE(cache.HasFrames(0, 0, 4, 4));
+    cache.Prepare(25);
+    EXPECT_FALSE(cache.HasFrames(0, 0, 4, 4));
+}
+
+TEST(LayerFrameCache_Tests, ThreadsStayWithinTheLimit) {
+    const size_t before = LayerFrameCache::GetSizeBytes();
+    LayerFrameCache::SetMaximumSizeMB(1);
+    const int threads = 8;
+    std::vector<std::unique_ptr<LayerFrameCache>> caches;
+    for (int t = 0; t < threads; t++) {
+        caches.push_back(std::make_unique<LayerFrameCache>());
+        caches.back()->Prepare(50);
+    }
+    // 64 x 64 frames, far more between them than the limit
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&caches, t]() {
+            RenderBuffer buffer(nullptr);
+            buffer.InitBuffer(64, 64, "None");
+            for (int f = 0; f < 100; f++) {
+                caches[t]->Put(f, buffer, true, caches[t]->GetGeneration());
+            }
+        });
+    }
+    for (auto& it : workers) {
+        it.join();
+    }
+    EXPECT_LE(LayerFrameCache::GetSizeBytes(), std::max(before, (size_t)1024 * 1024));
+    caches.clear();
+    EXPECT_EQ(before, LayerFrameCache::GetSizeBytes());
+    LayerFrameCache::SetMaximumSizeMB(1024);
+}
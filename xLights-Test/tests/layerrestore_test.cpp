@@ -0,0 +1,107 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include <list>
+#include <vector>
+
+#include <wx/filename.h>
+#include <wx/image.h>
+
+#include "wxfixture.h"
+
+#include "../xLights/LayerFrameCache.h"
+#include "../xLights/SequenceData.h"
+#include "../xLights/xLightsApp.h"
+#include "../xLights/xLightsMain.h"
+#include "../xLights/models/Model.h"
+#include "../xLights/sequencer/Effect.h"
+#include "../xLights/sequencer/EffectLayer.h"
+#include "../xLights/sequencer/Element.h"
+
+// the benchmark show folder, see benchmark/readme.txt
+static wxString BenchmarkDir() {
+    wxFileName dir(wxString(__FILE__));
+    dir.MakeAbsolute();
+    dir.RemoveLastDir();
+    dir.AppendDir("benchmark");
+    return dir.GetPath();
+}
+
+// a full render forgets the layers rendered before, rendering just the model keeps them
+static bool RenderMatrix(xLightsFrame* frame, bool full) {
+    bool done = false;
+    bool aborted = false;
+    auto callback = [&done, &aborted](bool a) {
+        aborted = a;
+        done = true;
+    };
+    if (full) {
+        frame->RenderGridToSeqData(callback);
+    } else {
+        std::list<Model*> models { frame->GetModel("Big Matrix") };
+        frame->Render(frame->GetSequenceElements(), frame->_seqData, models, std::list<Model*>(), 0, frame->_seqData.NumFrames() - 1, false, false, callback);
+    }
+    while (!done) {
+        wxYield();
+    }
+    return !aborted;
+}
+
+struct LayerRestore_Tests : public IP_Host_Tests
+{
+};
+
+// The second layer of Big Matrix in LargeMatrix.xsq starts with a Spirals effect that fades out.  Dissolve
+// is one of the transitions drawn into the layer's own pixels so it is given a dissolve in as well, restoring
+// the layer must not apply either of them a second time.
+TEST_F(LayerRestore_Tests, RestoredTransitionsMatchFreshRender) {
+    wxInitAllImageHandlers();
+    xLightsApp::showDir = BenchmarkDir();
+    xLightsApp::mediaDir = xLightsApp::showDir;
+    xLightsFrame* frame = new xLightsFrame(nullptr, 0, -1, true);
+    frame->_renderCache.Enable("Disabled");
+    frame->OpenSequence(wxFileName(xLightsApp::showDir, "LargeMatrix.xsq").GetFullPath(), nullptr);
+    ASSERT_GT(frame->_seqData.NumFrames(), 0u);
+
+    Element* matrix = frame->GetSequenceElements().GetElement("Big Matrix");
+    ASSERT_NE(nullptr, matrix);
+    ASSERT_GE(matrix->GetEffectLayerCount(), 2u);
+    Effect* spirals = matrix->GetEffectLayer(1)->GetEffect(0);
+    ASSERT_NE(nullptr, spirals);
+    spirals->GetSettings()["T_CHOICE_In_Transition_Type"] = "Dissolve";
+    ASSERT_EQ("Fade", spirals->GetSettings().Get("T_CHOICE_Out_Transition_Type", ""));
+
+    ASSERT_TRUE(RenderMatrix(frame, true));
+    std::vector<std::vector<uint8_t>> fresh(frame->_seqData.NumFrames());
+    for (unsigned int f = 0; f < frame->_seqData.NumFrames(); f++) {
+        const uint8_t* data = &frame->_seqData[f][0];
+        fresh[f].assign(data, data + frame->_seqData.NumChannels());
+    }
+
+    // only the top layer is rendered again, the layer with the transitions comes from its cache
+    matrix->GetEffectLayer(0)->GetFrameCache()->Invalidate(-1, -1);
+    ASSERT_TRUE(RenderMatrix(frame, false));
+
+    int differences = 0;
+    for (unsigned int f = 0; f < frame->_seqData.NumFrames(); f++) {
+        const uint8_t* data = &frame->_seqData[f][0];
+        for (unsigned int c = 0; c < frame->_seqData.NumChannels(); c++) {
+            if (data[c] != fresh[f][c]) {
+                differences++;
+            }
+        }
+    }
+    EXPECT_EQ(0, differences);
+
+    frame->CloseSequence();
+    frame->Destroy();
+}
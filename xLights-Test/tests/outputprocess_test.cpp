@@ -0,0 +1,178 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "../xLights/outputs/OutputManager.h"
+#include "../xSchedule/OutputProcessColourOrder.h"
+#include "../xSchedule/OutputProcessDim.h"
+#include "../xSchedule/OutputProcessExcludeDim.h"
+#include "../xSchedule/OutputProcessGamma.h"
+#include "../xSchedule/OutputProcessPlan.h"
+#include "../xSchedule/OutputProcessRemap.h"
+#include "../xSchedule/OutputProcessReverse.h"
+#include "../xSchedule/OutputProcessSet.h"
+#include "../xSchedule/OutputProcessSustain.h"
+
+static void DeleteProcesses(std::list<OutputProcess*>& processes) {
+    for (auto it : processes) {
+        delete it;
+    }
+    processes.clear();
+}
+
+TEST(OutputProcess_Tests, PlanMatchesProcessingEachInTurn) {
+    OutputManager om;
+    std::mt19937 rng(42);
+    const int orders[] = { 123, 132, 213, 231, 312, 321 };
+
+    for (int t = 0; t < 500; t++) {
+        size_t channels = 30 + rng() % 300;
+        std::list<OutputProcess*> processes;
+        bool exclude = false;
+        for (int i = 0; i < 6; i++) {
+            auto sc = std::to_string(1 + rng() % channels);
+            switch (rng() % 8) {
+            case 0: processes.push_back(new OutputProcessDim(&om, sc, 1 + rng() % 60, rng() % 100, "")); break;
+            case 1: processes.push_back(new OutputProcessGamma(&om, sc, 1 + rng() % 20, rng() % 2 ? 0.0f : 2.2f, 1.5f, 2.0f, 0.7f, "")); break;
+            case 2: processes.push_back(new OutputProcessSet(&om, sc, 1 + rng() % 20, rng() % 256, "")); break;
+            case 3: {
+                // remap copies with memcpy so the ranges must not overlap
+                long from = std::stol(sc);
+                long to = 1 + rng() % channels;
+                long chs = std::max(1L, std::min<long>(1 + rng() % 20, std::labs(to - from)));
+                processes.push_back(new OutputProcessRemap(&om, sc, to, chs, ""));
+            } break;
+            case 4: processes.push_back(new OutputProcessColourOrder(&om, sc, 1 + rng() % 20, orders[rng() % 6], "")); break;
+            case 5: processes.push_back(new OutputProcessReverse(&om, sc, rng() % 20, 0, "")); break;
+            case 6: processes.push_back(new OutputProcessSustain(&om, sc, 1 + rng() % 20, "")); break;
+            case 7:
+                if (!exclude) {
+                    exclude = true;
+                    processes.push_back(new OutputProcessExcludeDim(&om, sc, 1 + rng() % 30, ""));
+                }
+                break;
+            }
+        }
+
+        std::vector<uint8_t> expected(channels);
+        for (auto& it : expected) {
+            it = rng();
+        }
+        std::vector<uint8_t> actual = expected;
+
+        for (auto it : processes) {
+            it->Frame(expected.data(), channels, processes);
+        }
+        OutputProcessPlan plan(processes, channels);
+        ASSERT_TRUE(plan.IsFor(processes, channels, 100));
+        plan.Frame(actual.data(), channels, processes);
+        ASSERT_EQ(expected, actual) << "chain " << t;
+
+        DeleteProcesses(processes);
+    }
+}
+
+TEST(OutputProcess_Tests, PlanAppliesBrightnessOutsideExcludedChannels) {
+    OutputManager om;
+    std::list<OutputProcess*> processes;
+    processes.push_back(new OutputProcessExcludeDim(&om, "4", 3, ""));
+
+    uint8_t brightness[256];
+    for (int i = 0; i < 256; i++) {
+        brightness[i] = i / 2;
+    }
+    std::vector<uint8_t> buffer(10, 200);
+    OutputProcessPlan plan(processes, buffer.size(), brightness, 50);
+    EXPECT_FALSE(plan.IsFor(processes, buffer.size(), 100));
+    plan.Frame(buffer.data(), buffer.size(), processes);
+
+    std::vector<uint8_t> expected = { 100, 100, 100, 200, 200, 200, 100, 100, 100, 100 };
+    EXPECT_EQ(expected, buffer);
+
+    DeleteProcesses(processes);
+}
+
+TEST(OutputProcess_Tests, DimWithExclusionsAndReverseChangeTheirOwnChannels) {
+    OutputManager om;
+    std::list<OutputProcess*> processes;
+    processes.push_back(new OutputProcessExcludeDim(&om, "4", 1, ""));
+    processes.push_back(new OutputProcessDim(&om, "3", 4, 50, ""));
+    processes.push_back(new OutputProcessReverse(&om, "10", 3, 0, ""));
+
+    std::vector<uint8_t> buffer = { 200, 200, 200, 200, 200, 200, 200, 200, 200, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    std::vector<uint8_t> planned = buffer;
+    for (auto it : processes) {
+        it->Frame(buffer.data(), buffer.size(), processes);
+    }
+    OutputProcessPlan plan(processes, planned.size());
+    plan.Frame(planned.data(), planned.size(), processes);
+    EXPECT_EQ(buffer, planned);
+
+    // channels 3, 5 and 6 are dimmed, 4 is excluded
+    EXPECT_EQ(200, buffer[1]);
+    EXPECT_GT(200, buffer[2]);
+    EXPECT_EQ(200, buffer[3]);
+    EXPECT_EQ(buffer[2], buffer[4]);
+    EXPECT_EQ(buffer[2], buffer[5]);
+    EXPECT_EQ(200, buffer[6]);
+    std::vector<uint8_t> reversed = { 7, 8, 9, 4, 5, 6, 1, 2, 3 };
+    EXPECT_EQ(reversed, std::vector<uint8_t>(buffer.begin() + 9, buffer.end()));
+
+    DeleteProcesses(processes);
+}
+
+// timings only, run with --gtest_also_run_disabled_tests
+TEST(OutputProcess_Tests, DISABLED_Benchmark_Plan) {
+    OutputManager om;
+    const size_t channels = 1000000;
+    const int frames = 100;
+
+    std::list<OutputProcess*> processes;
+    processes.push_back(new OutputProcessExcludeDim(&om, "100", 50, ""));
+    processes.push_back(new OutputProcessDim(&om, "1", 500000, 70, ""));
+    processes.push_back(new OutputProcessGamma(&om, "1", 333333, 2.2f, 1.0f, 1.0f, 1.0f, ""));
+    processes.push_back(new OutputProcessColourOrder(&om, "1", 200000, 213, ""));
+    processes.push_back(new OutputProcessReverse(&om, "600001", 10000, 0, ""));
+    processes.push_back(new OutputProcessSet(&om, "900001", 1000, 255, ""));
+
+    std::vector<uint8_t> buffer(channels);
+    std::mt19937 rng(1);
+    for (auto& it : buffer) {
+        it = rng();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        for (auto it : processes) {
+            it->Frame(buffer.data(), channels, processes);
+        }
+    }
+    auto sequential = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    start = std::chrono::steady_clock::now();
+    OutputProcessPlan plan(processes, channels);
+    auto compile = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        plan.Frame(buffer.data(), channels, processes);
+    }
+    auto planned = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    printf("Output processing %d channels: each in turn %.3fms/frame, plan %.3fms/frame (%d stages, %d segments, compiled in %.1fms)\n",
+           (int)channels, sequential, planned, (int)plan.GetStageCount(), (int)plan.GetSegmentCount(), compile);
+
+    DeleteProcesses(processes);
+}
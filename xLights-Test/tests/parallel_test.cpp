@@ -0,0 +1,170 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include "wxfixture.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "../xLights/JobPool.h"
+#include "../xLights/Parallel.h"
+
+// The parallel_for implementation prior to the work stealing pool.  Every chunk is
+// a heap allocated Job pushed through the single JobPool queue and the caller yields
+// until they are all done.  Kept here so the two can be compared.
+static JobPool GLOBAL_QUEUE_POOL("global_queue");
+
+class GlobalQueueJob : public Job {
+    int max;
+    std::function<void(int)>& func;
+    std::atomic_int& doneCount;
+    std::atomic_int& iteration;
+    const int blockSize;
+public:
+    GlobalQueueJob(int m, std::function<void(int)>& f, std::atomic_int& dc, std::atomic_int& it, int bs) :
+        max(m), func(f), doneCount(dc), iteration(it), blockSize(bs) {}
+    virtual void Process() override {
+        int x;
+        while ((x = iteration.fetch_add(blockSize)) < max) {
+            int newM = std::min(x + blockSize, max);
+            for (; x < newM; x++) {
+                func(x);
+            }
+        }
+        ++doneCount;
+    }
+    virtual bool DeleteWhenComplete() override { return true; }
+    virtual bool SetThreadName() override { return false; }
+};
+
+static void global_queue_parallel_for(int min, int max, std::function<void(int)>&& func) {
+    int calcSteps = std::min(max - min, GLOBAL_QUEUE_POOL.maxSize());
+    if (calcSteps <= 1) {
+        for (int x = min; x < max; x++) {
+            func(x);
+        }
+        return;
+    }
+    std::function<void(int)> f(func);
+    std::atomic_int doneCount(0);
+    std::atomic_int iteration(min);
+    int blockSize = std::max(1, (max - min) / (calcSteps * 20));
+    std::list<Job*> jobs;
+    for (int x = 0; x < calcSteps - 1; x++) {
+        jobs.push_back(new GlobalQueueJob(max, f, doneCount, iteration, blockSize));
+    }
+    GLOBAL_QUEUE_POOL.PushJobs(jobs);
+    GlobalQueueJob(max, f, doneCount, iteration, blockSize).Process();
+    while (doneCount < calcSteps) {
+        std::this_thread::yield();
+    }
+}
+
+static const int RENDER_THREADS = 16;
+static const int FRAMES = 100;
+static const int ROWS = 200;
+static const int COLS = 200;
+
+// Simulates RenderJob::ProcessFrame: several render threads, each frame does a
+// parallel_for over the buffer rows which in turn does a small parallel_for per row
+template <typename PF>
+static double RunNestedWorkload(PF pfor, double& checksum) {
+    std::vector<double> results(RENDER_THREADS);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < RENDER_THREADS; t++) {
+        threads.emplace_back([t, &results, &pfor]() {
+            std::vector<float> buffer(ROWS * COLS);
+            double total = 0;
+            for (int frame = 0; frame < FRAMES; frame++) {
+                pfor(0, ROWS, [&buffer, frame, &pfor](int y) {
+                    pfor(0, COLS / 50, [&buffer, frame, y](int chunk) {
+                        for (int x = chunk * 50; x < (chunk + 1) * 50; x++) {
+                            buffer[y * COLS + x] = std::sin((float)(x + y + frame) * 0.01f);
+                        }
+                    });
+                });
+                total += buffer[frame % (ROWS * COLS)];
+            }
+            results[t] = total;
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    checksum = 0;
+    for (auto r : results) {
+        checksum += r;
+    }
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+TEST(Parallel_Tests, ParallelFor_CoversRange) {
+    std::vector<std::atomic_int> hits(10000);
+    parallel_for(0, 10000, [&hits](int i) { ++hits[i]; });
+    for (auto& h : hits) {
+        EXPECT_EQ(1, h.load());
+    }
+}
+
+TEST(Parallel_Tests, ParallelFor_Nested) {
+    std::atomic<long> sum(0);
+    parallel_for(0, 64, [&sum](int i) {
+        parallel_for(0, 1000, [&sum](int j) { sum += j; });
+    });
+    EXPECT_EQ(64L * 499500L, sum.load());
+}
+
+TEST(Parallel_Tests, ParallelFor_List) {
+    std::list<int> values;
+    for (int i = 0; i < 5000; i++) {
+        values.push_back(i);
+    }
+    std::atomic<long> sum(0);
+    std::atomic_int maxIdx(0);
+    std::function<void(int&, int)> f = [&sum, &maxIdx](int& v, int idx) {
+        sum += v;
+        int cur = maxIdx;
+        while (idx > cur && !maxIdx.compare_exchange_weak(cur, idx)) {
+        }
+    };
+    parallel_for(values, f);
+    EXPECT_EQ(5000L * 4999L / 2, sum.load());
+    EXPECT_EQ(4999, maxIdx.load());
+}
+
+// timings only, run with --gtest_also_run_disabled_tests
+TEST(Parallel_Tests, DISABLED_Benchmark_NestedWorkStealingVsGlobalQueue) {
+    GLOBAL_QUEUE_POOL.Start(ParallelJobPool::POOL.maxSize(), ParallelJobPool::POOL.maxSize());
+
+    double oldSum = 0;
+    double newSum = 0;
+    // warm up both pools so thread creation isn't measured
+    RunNestedWorkload([](int s, int e, std::function<void(int)>&& f) { global_queue_parallel_for(s, e, std::move(f)); }, oldSum);
+    RunNestedWorkload([](int s, int e, std::function<void(int)>&& f) { parallel_for(s, e, std::move(f)); }, newSum);
+
+    double oldMS = RunNestedWorkload([](int s, int e, std::function<void(int)>&& f) { global_queue_parallel_for(s, e, std::move(f)); }, oldSum);
+    double newMS = RunNestedWorkload([](int s, int e, std::function<void(int)>&& f) { parallel_for(s, e, std::move(f)); }, newSum);
+
+    printf("Nested parallel_for, %d render threads x %d frames x %dx%d:\n", RENDER_THREADS, FRAMES, COLS, ROWS);
+    printf("    global queue JobPool : %.1fms\n", oldMS);
+    printf("    work stealing pool   : %.1fms\n", newMS);
+    RecordProperty("GlobalQueueMS", (int)oldMS);
+    RecordProperty("WorkStealingMS", (int)newMS);
+
+    EXPECT_DOUBLE_EQ(oldSum, newSum);
+    GLOBAL_QUEUE_POOL.Stop();
+}
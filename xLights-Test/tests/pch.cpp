@@ -32,6 +32,10 @@
     #pragma comment(lib, "wxmsw" WXWIDGETS_VERSION "ud_propgrid.lib")
     #pragma comment(lib, "wxexpatd.lib")
     #pragma comment(lib, "log4cppLIBd.lib")
+    #pragma comment(lib, "msvcprtd.lib")
+    #pragma comment(lib, "liquidfund.lib")
+    #pragma comment(lib, "libzstdd_static_VS.lib")
+    #pragma comment(lib, "xlsxwriterd.lib")
 #else
     #pragma comment(lib, "wxbase" WXWIDGETS_VERSION "u.lib")
     #pragma comment(lib, "wxbase" WXWIDGETS_VERSION "u_net.lib")
@@ -50,8 +54,41 @@
     #pragma comment(lib, "wxmsw" WXWIDGETS_VERSION "u_propgrid.lib")
     #pragma comment(lib, "wxexpat.lib")
     #pragma comment(lib, "log4cppLIB.lib")
-
+    #pragma comment(lib, "msvcprt.lib")
+    #pragma comment(lib, "liquidfun.lib")
+    #pragma comment(lib, "libzstd_static_VS.lib")
+    #pragma comment(lib, "xlsxwriter.lib")
 #endif
+// the rest of what xLights links as the tests link everything xLights builds
 #pragma comment(lib, "libcurl.dll.a")
+#pragma comment(lib, "z.lib")
+#pragma comment(lib, "iphlpapi.lib")
+#pragma comment(lib, "WS2_32.Lib")
+#pragma comment(lib, "comdlg32.lib")
+#pragma comment(lib, "comctl32.lib")
+#pragma comment(lib, "Rpcrt4.lib")
+#pragma comment(lib, "uuid.lib")
+#pragma comment(lib, "advapi32.lib")
+#pragma comment(lib, "shell32.lib")
+#pragma comment(lib, "ole32.lib")
+#pragma comment(lib, "oleaut32.lib")
+#pragma comment(lib, "odbc32.lib")
+#pragma comment(lib, "odbccp32.lib")
+#pragma comment(lib, "kernel32.lib")
+#pragma comment(lib, "user32.lib")
+#pragma comment(lib, "winspool.lib")
+#pragma comment(lib, "gdi32.lib")
+#pragma comment(lib, "winmm.lib")
+#pragma comment(lib, "ImageHlp.Lib")
+#pragma comment(lib, "avcodec.lib")
+#pragma comment(lib, "avformat.lib")
+#pragma comment(lib, "avutil.lib")
+#pragma comment(lib, "swresample.lib")
+#pragma comment(lib, "SDL2.lib")
+#pragma comment(lib, "swscale.lib")
+#pragma comment(lib, "lua5.3.5-static.lib")
+#pragma comment(lib, "libwebp.lib")
+#pragma comment(lib, "libwebpdecoder.lib")
+#pragma comment(lib, "libwebpdemux.lib")
 #endif
 
@@ -0,0 +1,72 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include <chrono>
+
+#include "../xLights/RenderBenchmark.h"
+#include "../xLights/SequenceData.h"
+
+static void Fill(SequenceData& data) {
+    for (unsigned int f = 0; f < data.NumFrames(); f++) {
+        for (unsigned int c = 0; c < data.NumChannels(); c++) {
+            data[f][c] = (f * 7 + c) & 0xFF;
+        }
+    }
+}
+
+TEST(RenderBenchmark_Tests, ChecksumCoversEveryChannel) {
+    SequenceData a;
+    a.init(300, 20, 50);
+    Fill(a);
+    SequenceData b;
+    b.init(300, 20, 50);
+    Fill(b);
+    EXPECT_EQ(RenderBenchmark::Checksum(a), RenderBenchmark::Checksum(b));
+
+    // the last channel of the last frame
+    b[19][299] = b[19][299] + 1;
+    EXPECT_NE(RenderBenchmark::Checksum(a), RenderBenchmark::Checksum(b));
+    b[19][299] = a[19][299];
+
+    // swapping two channels is a different render too
+    b[0][0] = a[0][1];
+    b[0][1] = a[0][0];
+    EXPECT_NE(RenderBenchmark::Checksum(a), RenderBenchmark::Checksum(b));
+}
+
+TEST(RenderBenchmark_Tests, ReportsTheRender) {
+    SequenceData data;
+    data.init(300, 20, 50);
+    Fill(data);
+
+    RenderBenchmark benchmark;
+    benchmark.Start();
+    // keep this thread busy so it shows up in the thread times
+    auto start = std::chrono::steady_clock::now();
+    volatile uint64_t spin = 0;
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50)) {
+        spin = spin + 1;
+    }
+    benchmark.Finish(data);
+
+    EXPECT_GE(benchmark.GetElapsedUS(), 50000);
+    EXPECT_GT(benchmark.GetFPS(), 0.0);
+    EXPECT_LE(benchmark.GetFPS(), 20 * 1000000.0 / 50000);
+    EXPECT_EQ(RenderBenchmark::Checksum(data), benchmark.GetChecksum());
+    EXPECT_GT(benchmark.GetPeakMemoryKB(), 0u);
+    ASSERT_FALSE(benchmark.GetThreads().empty());
+    EXPECT_GT(benchmark.GetThreads().front().cpuUS, 0);
+
+    std::string json = benchmark.GetJSON("Test \"1\".xsq");
+    EXPECT_NE(std::string::npos, json.find("{\"sequence\":\"Test \\\"1\\\".xsq\",\"frames\":20,\"channels\":300,\"frameMS\":50,"));
+    EXPECT_NE(std::string::npos, json.find("\"threads\":[{\"name\":"));
+}
@@ -0,0 +1,249 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include <chrono>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "wxfixture.h"
+
+#include "../xLights/RenderBuffer.h"
+#include "../xLights/UtilClasses.h"
+#include "../xLights/effects/BarsEffect.h"
+#include "../xLights/effects/ButterflyEffect.h"
+#include "../xLights/effects/EffectParameters.h"
+#include "../xLights/effects/PlasmaEffect.h"
+
+struct RenderBuffer_Tests : public IP_Host_Tests
+{
+};
+
+static void InitTestBuffer(RenderBuffer& buffer, int width, int height) {
+    buffer.InitBuffer(height, width, "None");
+    buffer.SetEffectDuration(0, 10000);
+    buffer.curPeriod = 0;
+    xlColorVector colors = { xlRED, xlGREEN, xlBLUE };
+    xlColorCurveVector curves(colors.size());
+    buffer.SetPalette(colors, curves);
+}
+
+static void FillRandom(RenderBuffer& buffer, std::mt19937& rng) {
+    for (int y = 0; y < buffer.BufferHt; y++) {
+        for (int x = 0; x < buffer.BufferWi; x++) {
+            buffer.SetPixel(x, y, xlColor(rng() & 0xFF, rng() & 0xFF, rng() & 0xFF, rng() & 0xFF));
+        }
+    }
+}
+
+static void ExpectSamePixels(RenderBuffer& expected, RenderBuffer& actual, const std::string& what) {
+    ASSERT_EQ(expected.GetPixelCount(), actual.GetPixelCount());
+    for (int y = 0; y < expected.BufferHt; y++) {
+        for (int x = 0; x < expected.BufferWi; x++) {
+            xlColor e = expected.GetPixel(x, y);
+            xlColor a = actual.GetPixel(x, y);
+            if (e != a || e.alpha != a.alpha) {
+                FAIL() << what << " differs at " << x << "," << y;
+            }
+        }
+    }
+}
+
+// the per pixel versions of the primitives before they worked on rows
+static void DrawBoxPerPixel(RenderBuffer& buffer, int x1, int y1, int x2, int y2, const xlColor& color, bool wrap, bool useAlpha) {
+    int t;
+    if (y1 > y2) {
+        t = y1;
+        y1 = y2;
+        y2 = t;
+    }
+    if (x1 > x2) {
+        t = x1;
+        x1 = x2;
+        x2 = t;
+    }
+    for (int y = y1; y <= y2; y++) {
+        for (int x = x1; x <= x2; x++) {
+            buffer.SetPixel(x, y, color, wrap, useAlpha);
+        }
+    }
+}
+
+TEST_F(RenderBuffer_Tests, DrawBoxMatchesPerPixel) {
+    std::mt19937 rng(99);
+    const xlColor colors[] = { xlColor(10, 200, 30), xlColor(10, 200, 30, 128), xlColor(250, 0, 90, 0) };
+    const int boxes[][4] = { { 2, 3, 17, 9 }, { 17, 9, 2, 3 }, { -5, -5, 40, 40 }, { 0, 0, 0, 0 }, { 19, 11, 19, 11 }, { -3, 4, 8, 30 }, { 25, 25, 30, 30 } };
+
+    for (const auto& color : colors) {
+        for (const auto& box : boxes) {
+            for (bool wrap : { false, true }) {
+                for (bool useAlpha : { false, true }) {
+                    RenderBuffer expected(nullptr);
+                    RenderBuffer actual(nullptr);
+                    InitTestBuffer(expected, 20, 12);
+                    InitTestBuffer(actual, 20, 12);
+                    std::mt19937 r1 = rng;
+                    FillRandom(expected, rng);
+                    FillRandom(actual, r1);
+
+                    DrawBoxPerPixel(expected, box[0], box[1], box[2], box[3], color, wrap, useAlpha);
+                    actual.DrawBox(box[0], box[1], box[2], box[3], color, wrap, useAlpha);
+                    ExpectSamePixels(expected, actual, "DrawBox");
+
+                    DrawBoxPerPixel(expected, box[0], box[1], box[2], box[1], color, wrap, false);
+                    actual.DrawHLine(box[1], box[0], box[2], color, wrap);
+                    ExpectSamePixels(expected, actual, "DrawHLine");
+                }
+            }
+        }
+    }
+}
+
+TEST_F(RenderBuffer_Tests, RowWritesThroughToBuffer) {
+    RenderBuffer buffer(nullptr);
+    InitTestBuffer(buffer, 16, 8);
+    buffer.Clear();
+
+    buffer.FillRow(2, -4, 5, xlRED);
+    buffer.FillRow(9, 0, 15, xlRED);
+    {
+        RenderBuffer::Row row(buffer, 3);
+        ASSERT_EQ(16, row.size());
+        for (int x = 0; x < row.size(); x++) {
+            row[x] = xlColor(x, x, x);
+        }
+    }
+    std::vector<xlColor> colors(4, xlBLUE);
+    buffer.SetRow(5, 14, &colors[0], (int)colors.size());
+
+    for (int x = 0; x < 16; x++) {
+        EXPECT_EQ(x <= 5 ? xlRED : xlBLACK, buffer.GetPixel(x, 2));
+        EXPECT_EQ(xlColor(x, x, x), buffer.GetPixel(x, 3));
+        EXPECT_EQ(x >= 14 ? xlBLUE : xlBLACK, buffer.GetPixel(x, 5));
+    }
+    EXPECT_EQ(nullptr, buffer.GetRow(-1));
+    EXPECT_EQ(nullptr, buffer.GetRow(8));
+}
+
+// exposes the value curve lookups the parameters have to match
+struct ValueCurveEffect : public BarsEffect
+{
+    ValueCurveEffect() :
+        BarsEffect(0) {}
+    using RenderableEffect::GetValueCurveDouble;
+    using RenderableEffect::GetValueCurveInt;
+};
+
+TEST_F(RenderBuffer_Tests, EffectParametersMatchSettings) {
+    ValueCurveEffect effect;
+    RenderBuffer buffer(nullptr);
+    InitTestBuffer(buffer, 20, 12);
+    buffer.SetEffectDuration(0, 5000);
+    buffer.SetState(0, true, "");
+
+    SettingsMap settings;
+    settings["SLIDER_Bars_BarCount"] = "3";
+    settings["VALUECURVE_Bars_Cycles"] = "Active=TRUE|Id=ID_VALUECURVE_Bars_Cycles|Type=Ramp|Min=0.00|Max=300.00|P1=10.00|P2=90.00|RV=TRUE|";
+    settings["VALUECURVE_Bars_Center"] = "Active=FALSE|Id=ID_VALUECURVE_Bars_Center|Type=Ramp|Min=-100.00|Max=100.00|P1=0.00|P2=100.00|RV=TRUE|";
+    settings["SLIDER_Bars_Center"] = "25";
+    settings["CHECKBOX_Bars_3D"] = "1";
+
+    EffectParameters& params = EffectParameters::Get(buffer);
+    ASSERT_TRUE(params.NeedsCompile());
+    params.AddInt(0, "Bars_BarCount", 1, settings, 1, 5);
+    params.AddDouble(1, "Bars_Cycles", 1.0, settings, 0, 300, 10);
+    params.AddDouble(2, "Bars_Center", 0, settings, -100, 100);
+    params.AddBool(3, "CHECKBOX_Bars_3D", false, settings);
+    params.AddString(4, "CHOICE_Bars_Direction", "up", settings);
+    EXPECT_FALSE(params.NeedsCompile());
+
+    // every frame and a second pass over them, as when an effect asks twice a frame
+    for (int pass = 0; pass < 2; pass++) {
+        for (int f = 0; f <= 100; f++) {
+            buffer.curPeriod = f;
+            float offset = buffer.GetEffectTimeIntervalPosition();
+            EXPECT_EQ(effect.GetValueCurveInt("Bars_BarCount", 1, settings, offset, 1, 5, 0, 5000), params.GetInt(0, offset));
+            EXPECT_EQ(effect.GetValueCurveDouble("Bars_Cycles", 1.0, settings, offset, 0, 300, 0, 5000, 10), params.GetDouble(1, offset));
+            EXPECT_EQ(effect.GetValueCurveDouble("Bars_Center", 0, settings, offset, -100, 100, 0, 5000), params.GetDouble(2, offset));
+        }
+    }
+    EXPECT_TRUE(params.GetBool(3));
+    EXPECT_EQ("up", params.GetString(4));
+
+    // the same effect carrying on keeps them, a new one starts again
+    buffer.SetState(50, false, "");
+    EXPECT_FALSE(EffectParameters::Get(buffer).NeedsCompile());
+    buffer.SetState(0, true, "");
+    EXPECT_TRUE(EffectParameters::Get(buffer).NeedsCompile());
+}
+
+// timings only, run with --gtest_also_run_disabled_tests
+TEST_F(RenderBuffer_Tests, DISABLED_Benchmark_Primitives) {
+    const int frames = 500;
+    RenderBuffer buffer(nullptr);
+    InitTestBuffer(buffer, 200, 200);
+
+    auto time = [&](const char* name, const std::function<void()>& f) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++) {
+            f();
+        }
+        auto end = std::chrono::steady_clock::now();
+        printf("    %-22s : %.2fms\n", name, std::chrono::duration<double, std::milli>(end - start).count());
+    };
+
+    printf("%d frames on a 200x200 buffer:\n", frames);
+    time("DrawBox per pixel", [&]() { DrawBoxPerPixel(buffer, 0, 0, 199, 199, xlRED, false, false); });
+    time("DrawBox", [&]() { buffer.DrawBox(0, 0, 199, 199, xlRED, false, false); });
+    time("DrawBox alpha/pixel", [&]() { DrawBoxPerPixel(buffer, 0, 0, 199, 199, xlColor(255, 0, 0, 100), false, true); });
+    time("DrawBox alpha", [&]() { buffer.DrawBox(0, 0, 199, 199, xlColor(255, 0, 0, 100), false, true); });
+    time("ClearTempBuf", [&]() { buffer.ClearTempBuf(); });
+    time("CopyTempBufToPixels", [&]() { buffer.CopyTempBufToPixels(); });
+}
+
+TEST_F(RenderBuffer_Tests, DISABLED_Benchmark_Effects) {
+    const int frames = 200;
+    BarsEffect bars(0);
+    ButterflyEffect butterfly(1);
+    PlasmaEffect plasma(2);
+
+    struct Case {
+        const char* name;
+        RenderableEffect* effect;
+        std::vector<std::pair<std::string, std::string>> settings;
+    };
+    std::vector<Case> cases = {
+        { "Bars up", &bars, { { "CHOICE_Bars_Direction", "up" }, { "CHECKBOX_Bars_3D", "1" } } },
+        { "Bars Left", &bars, { { "CHOICE_Bars_Direction", "Left" }, { "CHECKBOX_Bars_Gradient", "1" } } },
+        { "Butterfly", &butterfly, { { "SLIDER_Butterfly_Style", "1" } } },
+        { "Butterfly plasma", &butterfly, { { "SLIDER_Butterfly_Style", "10" } } },
+        { "Plasma", &plasma, {} }
+    };
+
+    printf("Rendering %d frames on a 200x200 buffer:\n", frames);
+    for (auto& c : cases) {
+        SettingsMap settings;
+        for (const auto& s : c.settings) {
+            settings[s.first] = s.second;
+        }
+        RenderBuffer buffer(nullptr);
+        InitTestBuffer(buffer, 200, 200);
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            buffer.curPeriod = f;
+            buffer.Clear();
+            c.effect->Render(nullptr, settings, buffer);
+        }
+        auto end = std::chrono::steady_clock::now();
+        printf("    %-18s : %.2fms\n", c.name, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+}
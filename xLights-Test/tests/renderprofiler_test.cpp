@@ -0,0 +1,73 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include "../xLights/RenderProfiler.h"
+
+static RenderProfile CreateProfile(int64_t barsUS, int64_t butterflyUS) {
+    RenderProfile p;
+    auto& bars = p.effects["Bars"];
+    bars.renderUS = barsUS;
+    bars.renders = 10;
+    auto& butterfly = p.effects["Butterfly"];
+    butterfly.renderUS = butterflyUS;
+    butterfly.transitionUS = 500;
+    butterfly.cacheHits = 4;
+    auto& arch = p.models["Arch \"1\""];
+    arch.renderUS = barsUS + butterflyUS;
+    arch.transitionUS = 500;
+    arch.blendUS = 250;
+    p.layers["Arch \"1\"/Layer 1"].renderUS = barsUS;
+    p.layers["Arch \"1\"/Layer 2"].renderUS = butterflyUS;
+    return p;
+}
+
+TEST(RenderProfiler_Tests, AddsRendersTogether) {
+    RenderProfile p = CreateProfile(1000, 2000);
+    p.Add(CreateProfile(3000, 0));
+
+    EXPECT_EQ(4000, p.effects["Bars"].renderUS);
+    EXPECT_EQ(20, p.effects["Bars"].renders);
+    EXPECT_EQ(2000, p.effects["Butterfly"].renderUS);
+    EXPECT_EQ(8, p.effects["Butterfly"].cacheHits);
+    EXPECT_EQ(6000 + 1000 + 500, p.models["Arch \"1\""].GetTotalUS());
+}
+
+TEST(RenderProfiler_Tests, ListsSlowestFirst) {
+    RenderProfile p = CreateProfile(1000, 2000);
+
+    std::string json = p.GetJSON(1);
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"Butterfly\",\"totalMS\":2.500,\"renderMS\":2.000"));
+    EXPECT_EQ(std::string::npos, json.find("\"Bars\""));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"Arch \\\"1\\\"/Layer 2\""));
+
+    json = p.GetJSON();
+    EXPECT_LT(json.find("\"Butterfly\""), json.find("\"Bars\""));
+
+    std::string report = p.GetReport();
+    EXPECT_LT(report.find("Butterfly"), report.find("Bars"));
+}
+
+TEST(RenderProfiler_Tests, KeepsRendersUntilReset) {
+    RenderProfiler& profiler = RenderProfiler::GetDefaultProfiler();
+    profiler.Reset();
+    EXPECT_FALSE(profiler.IsEnabled());
+    EXPECT_TRUE(profiler.GetProfile().IsEmpty());
+
+    profiler.SetEnabled(true);
+    profiler.Add(CreateProfile(1000, 2000));
+    profiler.Add(CreateProfile(1000, 2000));
+    profiler.SetEnabled(false);
+    EXPECT_EQ(2000, profiler.GetProfile().effects["Bars"].renderUS);
+
+    profiler.Reset();
+    EXPECT_TRUE(profiler.GetProfile().IsEmpty());
+}
@@ -0,0 +1,235 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <wx/dcmemory.h>
+#include <wx/graphics.h>
+
+#include "wxfixture.h"
+
+#include "../xLights/Parallel.h"
+#include "../xLights/RenderBuffer.h"
+#include "../xLights/UtilClasses.h"
+#include "../xLights/effects/TextEffect.h"
+#include "../xLights/effects/TextLineCache.h"
+
+struct TextEffect_Tests : public IP_Host_Tests
+{
+    TextEffect_Tests() {
+        DrawingContext::Initialize(nullptr);
+    }
+    ~TextEffect_Tests() {
+        DrawingContext::CleanUp();
+    }
+};
+
+// one text effect on a model of its own, like the lyric lines on the faces and matrices of a show
+struct TextModel {
+    std::unique_ptr<RenderBuffer> buffer;
+    SettingsMap settings;
+};
+
+static std::vector<TextModel> CreateTextModels(int count) {
+    const char* directions[] = { "left", "right", "up", "none" };
+    std::vector<TextModel> models(count);
+    for (int i = 0; i < count; i++) {
+        auto& m = models[i];
+        m.buffer = std::make_unique<RenderBuffer>(nullptr);
+        m.buffer->InitBuffer(16 + i % 4 * 8, 48 + i % 5 * 16, "None");
+        m.buffer->SetEffectDuration(0, 10000);
+        xlColorVector colors = { xlRED, xlGREEN, xlBLUE };
+        xlColorCurveVector curves(colors.size());
+        m.buffer->SetPalette(colors, curves);
+
+        m.settings["TEXTCTRL_Text"] = "Line " + std::to_string(i) + " of the song";
+        m.settings["FONTPICKER_Text_Font"] = "arial " + std::to_string(8 + i % 3 * 2);
+        m.settings["CHOICE_Text_Dir"] = directions[i % 4];
+        m.settings["TEXTCTRL_Text_Speed"] = "10";
+        m.settings["CHOICE_Text_Effect"] = "normal";
+        m.settings["CHOICE_Text_Count"] = "none";
+    }
+    return models;
+}
+
+static void RenderFrame(TextEffect& effect, TextModel& m, int frame) {
+    m.buffer->curPeriod = frame;
+    m.buffer->needToInit = frame == 0;
+    m.buffer->Clear();
+    effect.Render(nullptr, m.settings, *m.buffer);
+}
+
+TEST_F(TextEffect_Tests, RenderingOnWorkerThreadsMatchesOneThread) {
+    TextEffect effect(0);
+    auto serial = CreateTextModels(12);
+    auto parallel = CreateTextModels(12);
+    // and a few with the fonts built into xLights
+    for (int i : { 3, 7, 11 }) {
+        const char* font = i == 7 ? "7-7x9 Bold" : "5-5x5 Thin";
+        serial[i].settings["CHOICE_Text_Font"] = font;
+        parallel[i].settings["CHOICE_Text_Font"] = font;
+    }
+
+    auto& cache = TextLineCache::GetDefaultCache();
+    for (int f = 0; f < 10; f++) {
+        // each pass draws the lines itself rather than copying them from the other
+        cache.Clear();
+        for (auto& m : serial) {
+            RenderFrame(effect, m, f);
+        }
+        cache.Clear();
+        parallel_for(0, (int)parallel.size(), [&](int i) {
+            RenderFrame(effect, parallel[i], f);
+        });
+
+        for (size_t i = 0; i < serial.size(); i++) {
+            auto& e = *serial[i].buffer;
+            auto& a = *parallel[i].buffer;
+            for (int y = 0; y < e.BufferHt; y++) {
+                for (int x = 0; x < e.BufferWi; x++) {
+                    if (e.GetPixel(x, y) != a.GetPixel(x, y)) {
+                        FAIL() << "model " << i << " frame " << f << " differs at " << x << "," << y;
+                    }
+                }
+            }
+        }
+    }
+}
+
+#ifdef LINUX
+// draws the text the way it was drawn before the text drawing on Linux moved off the main thread,
+// through a memory DC, so the fonts come out with the same options as they used to
+static wxImage DrawWithMemoryDC(const wxString& text, const wxFontInfo& info, int width, int height) {
+    wxImage image(width, height);
+    image.SetAlpha();
+    memset(image.GetAlpha(), wxIMAGE_ALPHA_TRANSPARENT, width * height);
+    wxBitmap bitmap(image, 32);
+    wxMemoryDC dc(bitmap);
+    wxGraphicsContext* gc = wxGraphicsContext::Create(dc);
+    gc->SetAntialiasMode(wxANTIALIAS_NONE);
+    gc->SetInterpolationQuality(wxInterpolationQuality::wxINTERPOLATION_FAST);
+    gc->SetCompositionMode(wxCompositionMode::wxCOMPOSITION_SOURCE);
+    int style = wxFONTFLAG_NOT_ANTIALIASED;
+    if (info.GetWeight() == wxFONTWEIGHT_BOLD) {
+        style |= wxFONTFLAG_BOLD;
+    }
+    gc->SetFont(gc->CreateFont(info.GetPixelSize().y, info.GetFaceName(), style, *wxWHITE));
+    gc->DrawText(text, 1, 1);
+    gc->Flush();
+    delete gc;
+    dc.SelectObject(wxNullBitmap);
+    return bitmap.ConvertToImage();
+}
+
+TEST_F(TextEffect_Tests, TextMatchesDrawingThroughMemoryDC) {
+    const int width = 120;
+    const int height = 24;
+    for (const char* font : { "arial 8", "arial 12", "arial bold 10", "sans 16" }) {
+        const wxFontInfo& info = TextDrawingContext::GetTextFont(font);
+        const wxString text = "Line 12 of the song";
+        wxImage expected = DrawWithMemoryDC(text, info, width, height);
+
+        TextDrawingContext* ctx = TextDrawingContext::GetContext();
+        ctx->ResetSize(width, height);
+        ctx->Clear();
+        ctx->SetFont(info, xlWHITE);
+        ctx->DrawText(text, 1, 1);
+        wxImage* actual = ctx->FlushAndGetImage();
+        ASSERT_EQ(width, actual->GetWidth());
+        ASSERT_EQ(height, actual->GetHeight());
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (expected.GetRed(x, y) != actual->GetRed(x, y) || expected.GetAlpha(x, y) != actual->GetAlpha(x, y)) {
+                    TextDrawingContext::ReleaseContext(ctx);
+                    FAIL() << font << " differs at " << x << "," << y;
+                }
+            }
+        }
+        TextDrawingContext::ReleaseContext(ctx);
+    }
+}
+#endif
+
+TEST_F(TextEffect_Tests, SameLineOnManyModelsIsDrawnOnce) {
+    TextEffect effect(0);
+    auto models = CreateTextModels(12);
+    for (auto& m : models) {
+        m.settings["TEXTCTRL_Text"] = "The same lyric";
+        m.settings["FONTPICKER_Text_Font"] = "arial 10";
+    }
+
+    auto& cache = TextLineCache::GetDefaultCache();
+    cache.Clear();
+    cache.ResetCounters();
+    for (auto& m : models) {
+        RenderFrame(effect, m, 0);
+    }
+    ASSERT_EQ(1, cache.GetMisses());
+    ASSERT_EQ(11, cache.GetHits());
+    ASSERT_EQ(1, cache.GetCount());
+}
+
+TEST_F(TextEffect_Tests, LineCacheDropsLeastRecentlyUsed) {
+    TextLineCache cache;
+    cache.SetMaxBytes(1000);
+    auto line = std::make_shared<TextLine>();
+    line->rgba.resize(200);
+
+    for (const auto& it : { "a", "b", "c", "d", "e" }) {
+        cache.Put(it, line);
+    }
+    ASSERT_EQ(1000, cache.GetBytes());
+    ASSERT_NE(nullptr, cache.Get("a"));
+
+    // over the limit it drops to three quarters of it, oldest first
+    cache.Put("f", line);
+    ASSERT_EQ(600, cache.GetBytes());
+    ASSERT_EQ(nullptr, cache.Get("b"));
+    ASSERT_EQ(nullptr, cache.Get("c"));
+    ASSERT_EQ(nullptr, cache.Get("d"));
+    ASSERT_NE(nullptr, cache.Get("a"));
+    ASSERT_NE(nullptr, cache.Get("e"));
+    ASSERT_NE(nullptr, cache.Get("f"));
+}
+
+// timings only, run with --gtest_also_run_disabled_tests
+TEST_F(TextEffect_Tests, DISABLED_Benchmark_FiftyTextEffects) {
+    const int frames = 100;
+    TextEffect effect(0);
+    auto models = CreateTextModels(50);
+    // both runs start with no lines drawn, as they would after opening a sequence
+    auto& cache = TextLineCache::GetDefaultCache();
+    cache.Clear();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        for (auto& m : models) {
+            RenderFrame(effect, m, f);
+        }
+    }
+    auto serial = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    cache.Clear();
+    start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        parallel_for(0, (int)models.size(), [&](int i) {
+            RenderFrame(effect, models[i], f);
+        });
+    }
+    auto parallel = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("50 text effects, %d frames: one thread %.2fms, worker threads %.2fms\n", frames, serial, parallel);
+}
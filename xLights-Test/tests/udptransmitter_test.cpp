@@ -0,0 +1,148 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include "../xLights/outputs/UDPTransmitter.h"
+
+TEST(UDPTransmitter_Tests, QueueWithoutBatchIsRefused) {
+    uint8_t packet[4] = { 1, 2, 3, 4 };
+    ASSERT_FALSE(UDPTransmitter::Instance().Queue(0, packet, sizeof(packet)));
+    ASSERT_FALSE(UDPTransmitter::Instance().Queue(-1, packet, sizeof(packet)));
+}
+
+#ifdef __linux__
+TEST(UDPTransmitter_Tests, BatchArrivesInOrderOnLoopback) {
+    int receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(receiver, 0);
+    int size = 4 * 1024 * 1024;
+    setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    timeval timeout = { 1, 0 };
+    setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(0, bind(receiver, (sockaddr*)&addr, sizeof(addr)));
+    socklen_t len = sizeof(addr);
+    getsockname(receiver, (sockaddr*)&addr, &len);
+    int port = ntohs(addr.sin_port);
+
+    auto& transmitter = UDPTransmitter::Instance();
+    transmitter.SetEnabled(true);
+    transmitter.ResetStats();
+    int destination = transmitter.AddDestination("127.0.0.1", 0, "127.0.0.1", port);
+    ASSERT_GE(destination, 0);
+    ASSERT_EQ(destination, transmitter.AddDestination("127.0.0.1", 0, "127.0.0.1", port));
+
+    const int packets = 200;
+    transmitter.StartBatch();
+    for (int i = 0; i < packets; i++) {
+        std::vector<uint8_t> packet(100 + i % 400, (uint8_t)i);
+        packet[0] = i >> 8;
+        packet[1] = i & 0xFF;
+        ASSERT_TRUE(transmitter.Queue(destination, packet.data(), packet.size()));
+    }
+    transmitter.Flush();
+
+    auto stats = transmitter.GetStats();
+    ASSERT_EQ(packets, stats.packets);
+    ASSERT_EQ(0, stats.errors);
+    ASSERT_EQ(1, stats.frames);
+    ASSERT_LT(stats.syscalls, (uint64_t)packets);
+
+    uint8_t buffer[1024];
+    for (int i = 0; i < packets; i++) {
+        auto got = recv(receiver, buffer, sizeof(buffer), 0);
+        ASSERT_EQ(100 + i % 400, got) << "packet " << i;
+        ASSERT_EQ(i, (buffer[0] << 8) + buffer[1]);
+        ASSERT_EQ((uint8_t)i, buffer[got - 1]);
+    }
+    close(receiver);
+
+    // outside a batch the output sends its own packets
+    ASSERT_FALSE(transmitter.Queue(destination, buffer, 10));
+
+    // once output stops the destinations are gone until the outputs are opened again
+    transmitter.CloseSockets();
+    transmitter.StartBatch();
+    ASSERT_FALSE(transmitter.Queue(destination, buffer, 10));
+    transmitter.Flush();
+    ASSERT_EQ(destination, transmitter.AddDestination("127.0.0.1", 0, "127.0.0.1", port));
+    transmitter.CloseSockets();
+}
+
+TEST(UDPTransmitter_Tests, PacedBatchIsSpreadOverTheInterval) {
+    int receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(receiver, 0);
+    int size = 4 * 1024 * 1024;
+    setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    timeval timeout = { 1, 0 };
+    setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(0, bind(receiver, (sockaddr*)&addr, sizeof(addr)));
+    socklen_t len = sizeof(addr);
+    getsockname(receiver, (sockaddr*)&addr, &len);
+    int port = ntohs(addr.sin_port);
+
+    auto& transmitter = UDPTransmitter::Instance();
+    transmitter.SetEnabled(true);
+    transmitter.ResetStats();
+    transmitter.SetPacingMS(20);
+    int destination = transmitter.AddDestination("127.0.0.1", 0, "127.0.0.1", port);
+    ASSERT_GE(destination, 0);
+
+    // enough packets for a slice every 2ms
+    const int packets = 160;
+    transmitter.StartBatch();
+    for (int i = 0; i < packets; i++) {
+        std::vector<uint8_t> packet(500, (uint8_t)i);
+        packet[0] = i >> 8;
+        packet[1] = i & 0xFF;
+        ASSERT_TRUE(transmitter.Queue(destination, packet.data(), packet.size()));
+    }
+    auto start = std::chrono::steady_clock::now();
+    transmitter.Flush();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    transmitter.SetPacingMS(0);
+
+    // the last slice waits until 18ms in, the batch shouldn't take much longer than the 20ms
+    ASSERT_GE(elapsed, 18);
+    ASSERT_LT(elapsed, 200);
+    auto stats = transmitter.GetStats();
+    ASSERT_EQ(packets, stats.packets);
+    ASSERT_EQ(0, stats.errors);
+    ASSERT_GE(stats.syscalls, 10u);
+
+    uint8_t buffer[1024];
+    for (int i = 0; i < packets; i++) {
+        auto got = recv(receiver, buffer, sizeof(buffer), 0);
+        ASSERT_EQ(500, got) << "packet " << i;
+        ASSERT_EQ(i, (buffer[0] << 8) + buffer[1]);
+    }
+    close(receiver);
+    transmitter.CloseSockets();
+}
+#endif
@@ -0,0 +1,39 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "pch.h"
+
+// The tests link against everything xLights builds except xLightsApp.obj, that has the
+// application's main in it, so the parts of it the rest of xLights uses are defined here.
+
+#include "../xLights/xLightsApp.h"
+#include "../xLights/xLightsMain.h"
+#include "../xLights/TraceLog.h"
+
+xLightsFrame* xLightsApp::__frame = nullptr;
+wxString xLightsApp::mediaDir;
+wxString xLightsApp::showDir;
+wxArrayString xLightsApp::sequenceFiles;
+
+wxString xLightsFrame::GetThreadStatusReport() {
+    return jobPool.GetThreadStatus();
+}
+void xLightsFrame::PushTraceContext() {
+    TraceLog::PushTraceContext();
+}
+void xLightsFrame::PopTraceContext() {
+    TraceLog::PopTraceContext();
+}
+void xLightsFrame::AddTraceMessage(const std::string& trc) {
+    TraceLog::AddTraceMessage(trc);
+}
+void xLightsFrame::ClearTraceMessages() {
+    TraceLog::ClearTraceMessages();
+}
@@ -11,10 +11,14 @@
 #include <wx/wx.h>
 #include <wx/string.h>
 #include <wx/ffile.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/dir.h>
 #include <wx/log.h>
 
 #include <algorithm>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 #include <vector>
 
@@ -41,6 +45,10 @@ using namespace Vamp;
 // SDL Functions
 int AudioData::__nextId = 0;
 SDLManager __sdlManager;
+bool AudioManager::__compactFrameData = false;
+std::string AudioManager::__analysisCacheFolder;
+size_t AudioManager::__analysisCacheMaximumSizeMB = 2048;
+static std::mutex __analysisCacheLock;
 
 #define SDL_INPUT_BUFFER_SIZE 8192
 
@@ -1320,59 +1328,77 @@ AudioManager::AudioManager(const std::string& audio_file, int intervalMS, const
     AddAudioDeviceChangeListener([this]() {AudioDeviceChanged();});
 }
 
-std::list<float> AudioManager::CalculateSpectrumAnalysis(const float* in, int n, float& max, int id) const
+// Works out the level of each MIDI note in a window of samples.  Each thread preparing frame data
+// has its own so the fft plan and output are only allocated once per thread.
+class SpectrumAnalyser
 {
-	std::list<float> res;
-	int outcount = n / 2 + 1;
-	kiss_fftr_cfg cfg;
-	kiss_fft_cpx* out = (kiss_fft_cpx*)malloc(sizeof(kiss_fft_cpx) * (outcount));
-	if (out != nullptr)
-	{
-		if ((cfg = kiss_fftr_alloc(n, 0/*is_inverse_fft*/, nullptr, nullptr)) != nullptr)
-		{
-			kiss_fftr(cfg, in, out);
-			free(cfg);
-		}
+public:
+    static constexpr int NOTES = 127;
 
-		for (int j = 0; j < 127; j++)
-		{
+    SpectrumAnalyser(int n, long rate) : _n(n), _outcount(n / 2 + 1)
+    {
+        _cfg = kiss_fftr_alloc(n, 0/*is_inverse_fft*/, nullptr, nullptr);
+        _out.resize(_outcount);
+        for (int j = 0; j < NOTES; j++)
+        {
             // choose the right bucket for this MIDI note
             double freq = 440.0 * exp2f(((double)j - 69.0) / 12.0);
-            int start = freq * (double)n / (double)_rate;
+            int start = freq * (double)n / (double)rate;
             double freqnext = 440.0 * exp2f(((double)j + 1.0 - 69.0) / 12.0);
-            int end = freqnext * (double)n / (double)_rate;
+            int end = freqnext * (double)n / (double)rate;
+            _buckets[j] = { start, end };
+        }
+    }
+    ~SpectrumAnalyser()
+    {
+        if (_cfg != nullptr)
+        {
+            free(_cfg);
+        }
+    }
+
+    void Calculate(const float* in, float& max, float* res)
+    {
+        if (_cfg != nullptr)
+        {
+            kiss_fftr(_cfg, in, &_out[0]);
+        }
 
+        for (int j = 0; j < NOTES; j++)
+        {
             float val = 0.0;
 
             // got through all buckets up to the next note and take the maximums
-            if (end < outcount-1)
+            if (_buckets[j].second < _outcount - 1)
             {
-                for (int k = start; k <= end; k++)
+                for (int k = _buckets[j].first; k <= _buckets[j].second; k++)
                 {
-                    kiss_fft_cpx* cur = out + k;
+                    const kiss_fft_cpx* cur = &_out[k];
                     val = std::max(val, sqrtf(cur->r * cur->r + cur->i * cur->i));
-                    //float valscaled = valnew * scaling;
                 }
             }
 
-			float db = log10(val);
-			if (db < 0.0)
-			{
-				db = 0.0;
-			}
-
-			res.push_back(db);
-			if (db > max)
-			{
-				max = db;
-			}
-		}
+            float db = log10(val);
+            if (db < 0.0)
+            {
+                db = 0.0;
+            }
 
-		free(out);
-	}
+            res[j] = db;
+            if (db > max)
+            {
+                max = db;
+            }
+        }
+    }
 
-	return res;
-}
+private:
+    int _n;
+    int _outcount;
+    kiss_fftr_cfg _cfg = nullptr;
+    std::vector<kiss_fft_cpx> _out;
+    std::pair<int, int> _buckets[NOTES];
+};
 
 void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManagerProgressCallback fn)
 {
@@ -1495,8 +1521,8 @@ void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManager
                     sframe++;
                 }
                 int eframe = currentend / _intervalMS;
-                while (sframe <= eframe) {
-                    _frameData[sframe][4].push_back(features[0][j].values[0]);
+                while (sframe <= eframe && sframe < (int)_frameNotes.size()) {
+                    _frameNotes[sframe].push_back(features[0][j].values[0]);
                     sframe++;
                 }
             }
@@ -1507,11 +1533,11 @@ void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManager
             {
                 logger_pianodata.debug("Piano data calculated:");
                 logger_pianodata.debug("Time MS, Keys");
-                for (size_t i = 0; i < _frameData.size(); i++)
+                for (size_t i = 0; i < _frameNotes.size(); i++)
                 {
                     long ms = i * _intervalMS;
                     std::string keys = "";
-                    for (const auto& it2 : _frameData[i][4])
+                    for (const auto& it2 : _frameNotes[i])
                     {
                         keys += " " + std::string(wxString::Format("%f", it2).c_str());
                     }
@@ -1575,7 +1601,17 @@ void AudioManager::DoPrepareFrameData()
         locker.lock();
     }
 
+    if (LoadFrameDataCache()) {
+        _frameDataPrepared = true;
+        logger_base.info("DoPrepareFrameData: Audio frame data loaded from the cache in %ld. Frames: %d", sw.Time(), _frameDataFrames);
+        return;
+    }
+
     _frameData.clear();
+    _frameSpectrum.clear();
+    _frameHasSpectrum.clear();
+    _frameNotes.clear();
+    _frameDataFrames = 0;
 
 	// samples per frame
 	int samplesperframe = _rate * _intervalMS / 1000;
@@ -1598,129 +1634,120 @@ void AudioManager::DoPrepareFrameData()
 	_bigmin = 1;
 	_bigspectogrammax = -1;
 
-	size_t step = 2048;
-	float *pdata[2];
-
-	int pos = 0;
-	std::list<float> spectrogram;
-
-	// process each frome of the song
-	for (int i = 0; i < frames; i++)
-	{
-		std::vector<std::list<float>> aFrameData;
-		aFrameData.resize(5); // preallocate the spots we will need
-
-		// accumulators
-		float max = -100.0;
-		float min = 100.0;
-		float spread = -100;
-
-		// clear the data if we are about to get new data ... dont clear it if we wont
-		// this happens because the spectrogram function has a fixed window based on the parameters we set and it
-		// does not match our time slices exactly so we have to select which one to use
-		if (pos < i * samplesperframe + samplesperframe  && pos + step < totalsamples)
-		{
-			spectrogram.clear();
-		}
-
-		// only get the data if we are not ahead of the music
-		while (pos < i * samplesperframe + samplesperframe && pos + step < totalsamples)
-		{
-			std::list<float> subspectrogram;
-			pdata[0] = GetRawLeftDataPtr(pos);
-            wxASSERT(pdata[0] != nullptr);
-			pdata[1] = GetRawRightDataPtr(pos);
-			float max2 = 0;
+    if (samplesperframe <= 0 || frames <= 0)
+    {
+        _frameDataPrepared = true;
+        logger_base.info("DoPrepareFrameData: No frames to prepare.");
+        return;
+    }
 
-			if (pdata[0] == nullptr)
-			{
-				subspectrogram.clear();
-			}
-			else
-			{
-				subspectrogram = CalculateSpectrumAnalysis(pdata[0], step, max2, i);
-			}
+    // the data is all loaded so the samples can be read directly
+    FilteredAudioData* fad = GetFilteredAudioData(AUDIOSAMPLETYPE::RAW, -1, -1);
+    const float* rawData = fad == nullptr ? nullptr : fad->data0;
+    auto getRaw = [rawData, this](long offset) {
+        return (rawData != nullptr && offset <= _trackSize) ? rawData[offset] : 0.0f;
+    };
 
-			// and keep track of the larges value so we can normalise it
-			if (max2 > _bigspectogrammax)
-			{
-				_bigspectogrammax = max2;
-			}
-			pos += step;
+    // the spectrogram function has a fixed window which does not match our time slices, each window
+    // belongs to the frame it starts in and a frame without a window keeps the previous frame's spectrum
+    const int step = 2048;
+    const int notes = SpectrumAnalyser::NOTES;
+    const int stride = FRAMEDATA_LEVELS + notes;
+    const int windows = totalsamples > step ? (totalsamples - 1) / step : 0;
+    auto firstWindow = [samplesperframe, step](int frame) {
+        return (int)(((long long)frame * samplesperframe + step - 1) / step);
+    };
 
-			// either take the newly calculated values or if we are merging two results take the maximum of each value
-			if (spectrogram.size() == 0)
-			{
-				spectrogram = subspectrogram;
-			}
-			else
-			{
-				if (subspectrogram.size() > 0)
-				{
-					std::list<float>::iterator sub = subspectrogram.begin();
-					for (std::list<float>::iterator fr = spectrogram.begin(); fr != spectrogram.end(); ++fr)
-					{
-						if (*sub > *fr)
-						{
-							*fr = *sub;
-						}
-						++sub;
-					}
-				}
-			}
-		}
+    _frameData.resize((size_t)frames * stride);
+    std::vector<uint8_t> hasSpectrum(frames, 0);
+    std::vector<uint8_t> hasWindows(frames, 0);
 
-		// now do the raw data analysis for the frame
-		for (int j = 0; j < samplesperframe; j++)
-		{
-			float data = GetRawLeftData(i * samplesperframe + j);
+    struct Extremes {
+        float bigmax = -1;
+        float bigmin = 1;
+        float bigspread = -1;
+        float bigspectrogrammax = -1;
+    };
+    const int chunk = 256;
+    const int chunks = (frames + chunk - 1) / chunk;
+    std::vector<Extremes> extremes(chunks);
+
+	// process the frames of the song in chunks across the threads
+    parallel_for(0, chunks, [&](int c) {
+        SpectrumAnalyser analyser(step, _rate);
+        std::vector<float> subspectrogram(notes);
+        Extremes& ex = extremes[c];
+        const int end = std::min(frames, (c + 1) * chunk);
+        for (int i = c * chunk; i < end; i++)
+        {
+            float* frame = &_frameData[(size_t)i * stride];
+            float* spectrogram = frame + FRAMEDATA_LEVELS;
 
-			// Max data
-			if (data > max)
-			{
-				max = data;
-			}
+            const int wend = std::min(windows, firstWindow(i + 1));
+            for (int w = firstWindow(i); w < wend; w++)
+            {
+                hasWindows[i] = 1;
+                long pos = (long)w * step;
+                float max2 = 0;
+                if (rawData != nullptr && pos <= _trackSize)
+                {
+                    // either take the newly calculated values or if we are merging two results take the maximum of each value
+                    if (!hasSpectrum[i])
+                    {
+                        analyser.Calculate(rawData + pos, max2, spectrogram);
+                        hasSpectrum[i] = 1;
+                    }
+                    else
+                    {
+                        analyser.Calculate(rawData + pos, max2, &subspectrogram[0]);
+                        for (int n = 0; n < notes; n++)
+                        {
+                            spectrogram[n] = std::max(spectrogram[n], subspectrogram[n]);
+                        }
+                    }
+                }
 
-			// Min data
-			if (data < min)
-			{
-				min = data;
-			}
+                // and keep track of the larges value so we can normalise it
+                ex.bigspectrogrammax = std::max(ex.bigspectrogrammax, max2);
+            }
 
-			// Spread data
-			if (max - min > spread)
-			{
-				spread = max - min;
-			}
-		}
+            // now do the raw data analysis for the frame
+            float max = -100.0;
+            float min = 100.0;
+            float spread = -100;
+            for (int j = 0; j < samplesperframe; j++)
+            {
+                float data = getRaw((long)i * samplesperframe + j);
+                max = std::max(max, data);
+                min = std::min(min, data);
+                spread = std::max(spread, max - min);
+            }
+            frame[0] = max;
+            frame[1] = min;
+            frame[2] = spread;
+            ex.bigmax = std::max(ex.bigmax, max);
+            ex.bigmin = std::min(ex.bigmin, min);
+            ex.bigspread = std::max(ex.bigspread, spread);
+        }
+    });
 
-		if (max > _bigmax)
-		{
-			_bigmax = max;
-		}
-		if (min < _bigmin)
-		{
-			_bigmin = min;
-		}
-		if (spread > _bigspread)
-		{
-			_bigspread = spread;
-		}
+    for (const auto& ex : extremes)
+    {
+        _bigmax = std::max(_bigmax, ex.bigmax);
+        _bigmin = std::min(_bigmin, ex.bigmin);
+        _bigspread = std::max(_bigspread, ex.bigspread);
+        _bigspectogrammax = std::max(_bigspectogrammax, ex.bigspectrogrammax);
+    }
 
-		// Now save the results for the frame
-		std::list<float> maxlist;
-		maxlist.push_back(max);
-		std::list<float> minlist;
-		minlist.push_back(min);
-		std::list<float> spreadlist;
-		spreadlist.push_back(spread);
-		aFrameData[0] = maxlist;
-		aFrameData[1] = minlist;
-		aFrameData[2] = spreadlist;
-		aFrameData[3] = spectrogram;
-
-		_frameData.push_back(aFrameData);
-	}
+    // frames past the end of the windows and between them keep the spectrum of the frame before
+    for (int i = 1; i < frames; i++)
+    {
+        if (!hasWindows[i])
+        {
+            hasSpectrum[i] = hasSpectrum[i - 1];
+            std::copy_n(&_frameData[(size_t)(i - 1) * stride + FRAMEDATA_LEVELS], notes, &_frameData[(size_t)i * stride + FRAMEDATA_LEVELS]);
+        }
+    }
 
 	// normalise data ... basically scale the data so the highest value is the scale value.
 	float scale = 1.0; // 0-1 ... where 0.x means that the max value displayed would be x0% of model size
@@ -1728,26 +1755,45 @@ void AudioManager::DoPrepareFrameData()
 	float bigminscale = 1 / (_bigmin * scale);
 	float bigspreadscale = 1 / (_bigspread * scale);
 	float bigspectrogramscale = 1 / (_bigspectogrammax * scale);
-	for (std::vector<std::vector<std::list<float>>>::iterator itframe = _frameData.begin(); itframe != _frameData.end(); ++itframe)
-	{
-		std::list<float>* fl = &(*itframe)[0];
-		std::list<float>::iterator f = fl->begin();
-		*f = (*f * bigmaxscale);
-
-		fl = &(*itframe)[1];
-		f = fl->begin();
-		*f = (*f * bigminscale);
-
-		fl = &(*itframe)[2];
-		f = fl->begin();
-		*f = (*f * bigspreadscale);
+    for (int i = 0; i < frames; i++)
+    {
+        float* frame = &_frameData[(size_t)i * stride];
+        frame[0] = frame[0] * bigmaxscale;
+        frame[1] = frame[1] * bigminscale;
+        frame[2] = frame[2] * bigspreadscale;
+        for (int n = FRAMEDATA_LEVELS; n < stride; n++)
+        {
+            frame[n] = frame[n] * bigspectrogramscale;
+        }
+    }
 
-		fl = &(*itframe)[3];
-		for (std::list<float>::iterator ff = fl->begin(); ff != fl->end(); ++ff)
-		{
-			*ff = *ff * bigspectrogramscale;
-		}
-	}
+    _frameDataCompact = __compactFrameData;
+    if (_frameDataCompact)
+    {
+        // the normalised spectrum is 0-1 so it keeps well enough as a byte, the levels stay as they are
+        _frameSpectrum.resize((size_t)frames * notes);
+        for (int i = 0; i < frames; i++)
+        {
+            const float* spectrogram = &_frameData[(size_t)i * stride + FRAMEDATA_LEVELS];
+            uint8_t* compact = &_frameSpectrum[(size_t)i * notes];
+            for (int n = 0; n < notes; n++)
+            {
+                compact[n] = (uint8_t)(std::min(1.0f, std::max(0.0f, spectrogram[n])) * 255.0f + 0.5f);
+            }
+            std::copy_n(&_frameData[(size_t)i * stride], FRAMEDATA_LEVELS, &_frameData[(size_t)i * FRAMEDATA_LEVELS]);
+        }
+        _frameData.resize((size_t)frames * FRAMEDATA_LEVELS);
+        _frameData.shrink_to_fit();
+        _frameDataStride = FRAMEDATA_LEVELS;
+    }
+    else
+    {
+        _frameDataStride = stride;
+    }
+    _frameHasSpectrum.assign(hasSpectrum.begin(), hasSpectrum.end());
+    _frameNotes.resize(frames);
+    _frameDataFrames = frames;
+    SaveFrameDataCache();
 
 	// flag the fact that the data is all ready
 	_frameDataPrepared = true;
@@ -1788,17 +1834,10 @@ void ProgressFunction(wxProgressDialog* pd, int p)
     }
 }
 
-// Get the pre-prepared data for this frame
-const std::list<float>* AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing)
+// Called with the lock held, prepares the frame data if it has not been
+void AudioManager::WaitForFrameData(std::shared_lock<std::shared_timed_mutex>& lock)
 {
     log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    std::list<float>* rc = nullptr;
-
-    // Grab the lock so we can safely access the frame data
-    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
-
-    // make sure we have audio data
-    if (_data[0] == nullptr) return rc;
 
     // if the frame data has not been prepared
     if (!_frameDataPrepared)
@@ -1817,61 +1856,93 @@ const std::list<float>* AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt,
             lock.lock();
         }
     }
-    if (fdt == FRAMEDATA_NOTES && !_polyphonicTranscriptionDone) {
-        //need to do the polyphonic stuff
-        wxProgressDialog dlg("Processing Audio", "");
-        DoPolyphonicTranscription(&dlg, ProgressFunction);
+}
+
+AudioFrameData AudioManager::GetPreparedFrameData(int frame, FRAMEDATATYPE fdt) const
+{
+    if (frame < 0 || frame >= _frameDataFrames)
+    {
+        return AudioFrameData();
     }
 
-    // now we can grab the data we need
-    try
+    const float* framedata = &_frameData[(size_t)frame * _frameDataStride];
+    switch (fdt)
     {
-        if (frame < (int)_frameData.size())
+    case FRAMEDATA_HIGH:
+        return AudioFrameData(framedata, 1);
+    case FRAMEDATA_LOW:
+        return AudioFrameData(framedata + 1, 1);
+    case FRAMEDATA_SPREAD:
+        return AudioFrameData(framedata + 2, 1);
+    case FRAMEDATA_VU:
+        if (!_frameHasSpectrum[frame])
         {
-            std::vector<std::list<float>>* framedata = &_frameData[frame];
-
-            if (framedata == nullptr)
-            {
-                logger_base.crit("AudioManager::GetFrameData framedata is nullptr ... this is going to crash.");
-            }
-
-            switch (fdt)
-            {
-            case FRAMEDATA_HIGH:
-                rc = &framedata->at(0);
-                break;
-            case FRAMEDATA_LOW:
-                rc = &framedata->at(1);
-                break;
-            case FRAMEDATA_SPREAD:
-                rc = &framedata->at(2);
-                break;
-            case FRAMEDATA_VU:
-                rc = &framedata->at(3);
-                break;
-            case FRAMEDATA_ISTIMINGMARK:
-                // we dont need to do anything here
-                break;
-            case FRAMEDATA_NOTES:
-                rc = &framedata->at(4);
-                break;
-            }
+            return AudioFrameData(framedata, 0);
+        }
+        if (_frameDataCompact)
+        {
+            return AudioFrameData(&_frameSpectrum[(size_t)frame * SpectrumAnalyser::NOTES], SpectrumAnalyser::NOTES);
         }
+        return AudioFrameData(framedata + FRAMEDATA_LEVELS, _frameDataStride - FRAMEDATA_LEVELS);
+    case FRAMEDATA_ISTIMINGMARK:
+        // we dont need to do anything here
+        break;
+    case FRAMEDATA_NOTES:
+        return AudioFrameData(_frameNotes[frame].data(), _frameNotes[frame].size());
     }
-    catch (...)
-    {
-        rc = nullptr;
+    return AudioFrameData();
+}
+
+// Get the pre-prepared data for this frame
+AudioFrameData AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing)
+{
+    // Grab the lock so we can safely access the frame data
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+
+    // make sure we have audio data
+    if (_data[0] == nullptr) return AudioFrameData();
+
+    WaitForFrameData(lock);
+
+    if (fdt == FRAMEDATA_NOTES && !_polyphonicTranscriptionDone) {
+        //need to do the polyphonic stuff
+        wxProgressDialog dlg("Processing Audio", "");
+        DoPolyphonicTranscription(&dlg, ProgressFunction);
     }
 
-    return rc;
+    return GetPreparedFrameData(frame, fdt);
 }
 
-const std::list<float>* AudioManager::GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms)
+AudioFrameData AudioManager::GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms)
 {
     int frame = ms / _intervalMS;
     return GetFrameData(frame, fdt, timing);
 }
 
+// Copies a run of frames' levels under one lock, effects showing the song's history ask for a lot of them
+bool AudioManager::GetFrameLevels(FRAMEDATATYPE fdt, int startFrame, int count, float* levels)
+{
+    std::fill_n(levels, std::max(count, 0), 0.0f);
+    if (fdt != FRAMEDATA_HIGH && fdt != FRAMEDATA_LOW && fdt != FRAMEDATA_SPREAD)
+    {
+        return false;
+    }
+
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+    if (_data[0] == nullptr) return false;
+
+    WaitForFrameData(lock);
+
+    const int level = fdt == FRAMEDATA_HIGH ? 0 : (fdt == FRAMEDATA_LOW ? 1 : 2);
+    const int first = std::max(startFrame, 0);
+    const int last = std::min(startFrame + count, _frameDataFrames);
+    for (int f = first; f < last; f++)
+    {
+        levels[f - startFrame] = _frameData[(size_t)f * _frameDataStride + level];
+    }
+    return true;
+}
+
 // Constant Bitrate Detection Functions
 
 // Decode bitrate
@@ -2123,6 +2194,9 @@ AudioManager::~AudioManager()
     }
 
     while (_filtered.size() > 0) {
+        if (_filtered.back()->pyramidBuild.valid()) {
+            _filtered.back()->pyramidBuild.wait();
+        }
         if (_filtered.back()->data0) {
             free(_filtered.back()->data0);
         }
@@ -2200,6 +2274,16 @@ int AudioManager::OpenMediaFile()
 		_pcmdata = nullptr;
 	}
 
+    // a song opened before is loaded from the analysis cache without decoding it again
+    if (LoadAudioCache())
+    {
+        auto sdl = __sdlManager.GetOutputSDL(_device);
+        if (sdl != nullptr) {
+            _sdlid = sdl->AddAudio(_pcmdatasize, _pcmdata, 100, _rate, _trackSize, _lengthMS);
+        }
+        return err;
+    }
+
 	// Initialize FFmpeg codecs
     #if LIBAVFORMAT_VERSION_MAJOR < 58
     av_register_all();
@@ -2511,6 +2595,8 @@ void AudioManager::DoLoadAudioData(AVFormatContext* formatContext, AVCodecContex
     avformat_close_input(&formatContext);
 
     logger_base.debug("DoLoadAudioData: Song data loaded in %ld. Read: %ld", sw.Time(), read);
+
+    SaveAudioCache();
 }
 
 void AudioManager::LoadAudioFromFrame( AVFormatContext* formatContext, AVCodecContext* codecContext, AVPacket* decodingPacket, AVFrame* frame, SwrContext* au_convert_ctx, bool receivedEOF, int out_channels, uint8_t* out_buffer, long& read, int& lastpct )
@@ -2864,6 +2950,7 @@ void AudioManager::SwitchTo(AUDIOSAMPLETYPE type, int lowNote, int highNote) {
         fad->highNote = 0;
         fad->type = AUDIOSAMPLETYPE::RAW;
         _filtered.push_back(fad);
+        BuildWaveformPyramid(fad);
     }
 
     FilteredAudioData* fad = nullptr;
@@ -2904,6 +2991,7 @@ void AudioManager::SwitchTo(AUDIOSAMPLETYPE type, int lowNote, int highNote) {
                 fad->type = type;
                 NormaliseFilteredAudioData(fad);
                 _filtered.push_back(fad);
+                BuildWaveformPyramid(fad);
             }
         }
         break;
@@ -2985,6 +3073,7 @@ void AudioManager::SwitchTo(AUDIOSAMPLETYPE type, int lowNote, int highNote) {
             fad->type = type;
             NormaliseFilteredAudioData(fad);
             _filtered.push_back(fad);
+            BuildWaveformPyramid(fad);
         }
     }
     break;
@@ -3027,6 +3116,32 @@ FilteredAudioData* AudioManager::GetFilteredAudioData(AUDIOSAMPLETYPE type, int
     return nullptr;
 }
 
+void AudioManager::BuildWaveformPyramid(FilteredAudioData* fad)
+{
+    if (fad->pyramidBuild.valid()) {
+        return;
+    }
+    // the filtered data is not changed once it is in _filtered so it can be read without the lock
+    long trackSize = _trackSize;
+    fad->pyramidBuild = std::async(std::launch::async, [fad, trackSize]() {
+        fad->pyramid = std::make_unique<WaveformPyramid>(fad->data0, trackSize);
+        fad->pyramidReady = true;
+    });
+}
+
+const WaveformPyramid* AudioManager::GetWaveformPyramid(AUDIOSAMPLETYPE type, int lowNote, int highNote)
+{
+    // GetFilteredAudioData waits for SwitchTo to create the raw track, the waveform doesnt
+    if (_filtered.empty()) {
+        return nullptr;
+    }
+    FilteredAudioData* fad = GetFilteredAudioData(type, lowNote, highNote);
+    if (fad == nullptr || !fad->pyramidReady) {
+        return nullptr;
+    }
+    return fad->pyramid.get();
+}
+
 void AudioManager::GetLeftDataMinMax(long start, long end, float& minimum, float& maximum, AUDIOSAMPLETYPE type, int lowNote, int highNote)
 {
     static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
@@ -3044,6 +3159,14 @@ void AudioManager::GetLeftDataMinMax(long start, long end, float& minimum, float
         return;
     }
 
+    if (fad->pyramidReady) {
+        float rms;
+        fad->pyramid->GetMinMaxRMS(start, end, minimum, maximum, rms);
+        minimum = std::min(minimum, 0.0f);
+        maximum = std::max(maximum, 0.0f);
+        return;
+    }
+
     for (int j = start; j < std::min(end, _trackSize); j++) {
         minimum = std::min(minimum, fad->data0[j]);
         maximum = std::max(maximum, fad->data0[j]);
@@ -3163,6 +3286,425 @@ xLightsVamp::~xLightsVamp()
     }
 }
 
+#pragma region Waveform Pyramid
+
+WaveformPyramid::WaveformPyramid(const float* data, long samples) :
+    _data(data), _samples(std::max(samples, 0L))
+{
+    const long blockSize = 1L << BASE_BLOCK_SHIFT;
+    std::vector<Block> level((_samples + blockSize - 1) >> BASE_BLOCK_SHIFT);
+    for (size_t b = 0; b < level.size(); b++) {
+        Block& block = level[b];
+        long start = (long)b << BASE_BLOCK_SHIFT;
+        block.min = block.max = _data[start];
+        block.sumsq = 0;
+        AddSamples(block, start, std::min(start + blockSize, _samples));
+    }
+    _levels.push_back(std::move(level));
+
+    // each level above holds pairs of the blocks below, the last block alone if there are an odd number
+    while (_levels.back().size() > 1) {
+        const std::vector<Block>& below = _levels.back();
+        std::vector<Block> above((below.size() + 1) / 2);
+        for (size_t b = 0; b < above.size(); b++) {
+            above[b] = below[b * 2];
+            if (b * 2 + 1 < below.size()) {
+                Add(above[b], below[b * 2 + 1]);
+            }
+        }
+        _levels.push_back(std::move(above));
+    }
+}
+
+void WaveformPyramid::Add(Block& total, const Block& b)
+{
+    total.min = std::min(total.min, b.min);
+    total.max = std::max(total.max, b.max);
+    total.sumsq += b.sumsq;
+}
+
+void WaveformPyramid::AddSamples(Block& total, long start, long end) const
+{
+    for (long i = start; i < end; i++) {
+        float v = _data[i];
+        total.min = std::min(total.min, v);
+        total.max = std::max(total.max, v);
+        total.sumsq += (double)v * v;
+    }
+}
+
+void WaveformPyramid::GetMinMaxRMS(long start, long end, float& minimum, float& maximum, float& rms) const
+{
+    start = std::max(start, 0L);
+    end = std::min(end, _samples);
+    minimum = 0;
+    maximum = 0;
+    rms = 0;
+    if (start >= end) {
+        return;
+    }
+
+    Block total;
+    total.min = total.max = _data[start];
+    total.sumsq = 0;
+
+    // the whole base blocks in the range, the samples either side of them are added one by one
+    long first = (start + (1L << BASE_BLOCK_SHIFT) - 1) >> BASE_BLOCK_SHIFT;
+    long last = end >> BASE_BLOCK_SHIFT;
+    if (first >= last) {
+        AddSamples(total, start, end);
+    } else {
+        AddSamples(total, start, first << BASE_BLOCK_SHIFT);
+        AddSamples(total, last << BASE_BLOCK_SHIFT, end);
+        // take the odd block at either end of the run at each level then move up to the pairs
+        for (size_t l = 0; first < last && l < _levels.size(); l++) {
+            const std::vector<Block>& level = _levels[l];
+            if (first & 1) {
+                Add(total, level[first++]);
+            }
+            if (last & 1) {
+                Add(total, level[--last]);
+            }
+            first >>= 1;
+            last >>= 1;
+        }
+    }
+    minimum = total.min;
+    maximum = total.max;
+    rms = (float)std::sqrt(total.sumsq / (double)(end - start));
+}
+
+#pragma endregion
+
+#pragma region Analysis Cache
+
+// The analysis cache keeps the decoded audio of each media file and its frame data at each frame
+// interval.  Files are named for the media file's path, size and modification time so an edited
+// song is decoded again, the old files are removed once the cache grows past its maximum size.
+#define AUDIO_CACHE_EXT "acache"
+static const char AUDIO_CACHE_MAGIC[4] = { 'X', 'L', 'A', 'C' };
+static const uint32_t AUDIO_CACHE_VERSION = 1;
+
+static void WriteCacheString(wxFile& file, const std::string& s)
+{
+    uint32_t len = s.size();
+    file.Write(&len, sizeof(len));
+    file.Write(s.c_str(), len);
+}
+
+static bool ReadCacheString(wxFile& file, std::string& s)
+{
+    uint32_t len = 0;
+    if (file.Read(&len, sizeof(len)) != sizeof(len) || len > 65536) return false;
+    std::vector<char> buf(len);
+    if (len > 0 && file.Read(&buf[0], len) != (ssize_t)len) return false;
+    s.assign(buf.begin(), buf.end());
+    return true;
+}
+
+static bool OpenCacheFile(wxFile& file, const std::string& filename)
+{
+    if (filename == "" || !wxFileExists(filename) || !file.Open(filename)) return false;
+    char magic[sizeof(AUDIO_CACHE_MAGIC)];
+    uint32_t version = 0;
+    if (file.Read(magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, AUDIO_CACHE_MAGIC, sizeof(magic)) != 0 ||
+        file.Read(&version, sizeof(version)) != sizeof(version) || version != AUDIO_CACHE_VERSION) {
+        file.Close();
+        return false;
+    }
+    return true;
+}
+
+// writes to a temporary file and renames it so no one ever sees a half written file
+static void WriteCacheFile(const std::string& filename, const std::function<void(wxFile&)>& write)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    wxFileName fn(filename);
+    if (!wxDir::Exists(fn.GetPath()) && !wxFileName::Mkdir(fn.GetPath(), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+        logger_base.warn("Unable to create audio cache folder %s.", (const char*)fn.GetPath().c_str());
+        return;
+    }
+    wxString tmpFile = filename + ".tmp";
+    wxFile file;
+    if (!file.Create(tmpFile, true)) {
+        logger_base.warn("Unable to create audio cache file %s.", (const char*)tmpFile.c_str());
+        return;
+    }
+    file.Write(AUDIO_CACHE_MAGIC, sizeof(AUDIO_CACHE_MAGIC));
+    file.Write(&AUDIO_CACHE_VERSION, sizeof(AUDIO_CACHE_VERSION));
+    write(file);
+    bool ok = !file.Error();
+    file.Close();
+    if (!ok || !wxRenameFile(tmpFile, filename, true)) {
+        logger_base.warn("Failed to write audio cache file %s.", (const char*)filename.c_str());
+        wxRemoveFile(tmpFile);
+    }
+}
+
+void AudioManager::SetAnalysisCacheFolder(const std::string& path)
+{
+    {
+        std::unique_lock<std::mutex> lock(__analysisCacheLock);
+        __analysisCacheFolder = path == "" ? "" : path + wxFileName::GetPathSeparator() + "AudioCache";
+    }
+    EnforceAnalysisCacheSize();
+}
+
+void AudioManager::SetAnalysisCacheMaximumSizeMB(size_t mb)
+{
+    __analysisCacheMaximumSizeMB = mb;
+    EnforceAnalysisCacheSize();
+}
+
+void AudioManager::EnforceAnalysisCacheSize()
+{
+    std::string folder;
+    {
+        std::unique_lock<std::mutex> lock(__analysisCacheLock);
+        folder = __analysisCacheFolder;
+    }
+    if (folder == "" || !wxDir::Exists(folder)) return;
+
+    wxArrayString files;
+    wxDir::GetAllFiles(folder, &files, "*." AUDIO_CACHE_EXT, wxDIR_FILES);
+    std::vector<std::pair<wxDateTime, wxString>> entries;
+    wxULongLong total = 0;
+    for (const auto& f : files) {
+        wxFileName fn(f);
+        total += fn.GetSize();
+        entries.push_back({ fn.GetModificationTime(), f });
+    }
+
+    // least recently used first, loading a file touches it
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    wxULongLong maximum((wxULongLong_t)__analysisCacheMaximumSizeMB * 1024 * 1024);
+    for (const auto& e : entries) {
+        if (total <= maximum) break;
+        wxULongLong size = wxFileName(e.second).GetSize();
+        if (wxRemoveFile(e.second)) {
+            total -= size;
+        }
+    }
+}
+
+std::string AudioManager::GetAnalysisCacheFile(const std::string& suffix) const
+{
+    std::unique_lock<std::mutex> lock(__analysisCacheLock);
+    if (__analysisCacheFolder == "" || _cacheKey == "") return "";
+    return __analysisCacheFolder + wxFileName::GetPathSeparator() + _cacheKey + suffix + "." AUDIO_CACHE_EXT;
+}
+
+bool AudioManager::LoadAudioCache()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    _cacheKey = "";
+    {
+        std::unique_lock<std::mutex> lock(__analysisCacheLock);
+        if (__analysisCacheFolder == "") return false;
+    }
+    wxFileName fn(_audio_file);
+    if (!fn.FileExists()) return false;
+    std::string identity = fn.GetFullPath().ToStdString() + "|" + fn.GetSize().ToString().ToStdString() + "|" +
+        std::to_string(fn.GetModificationTime().GetValue().GetValue());
+#ifdef RESAMPLE_RATE
+    identity += "|" + std::to_string(RESAMPLE_RATE);
+#endif
+    MD5 md5;
+    md5.update(identity.c_str(), identity.size());
+    md5.finalize();
+    _cacheKey = md5.hexdigest();
+
+    std::string filename = GetAnalysisCacheFile("");
+    wxFile file;
+    if (!OpenCacheFile(file, filename)) return false;
+
+    int64_t rate = 0;
+    int32_t channels = 0;
+    int32_t bits = 0;
+    int64_t trackSize = 0;
+    int64_t lengthMS = 0;
+    int64_t pcmdatasize = 0;
+    std::string title, artist, album, hash;
+    if (file.Read(&rate, sizeof(rate)) != sizeof(rate) ||
+        file.Read(&channels, sizeof(channels)) != sizeof(channels) ||
+        file.Read(&bits, sizeof(bits)) != sizeof(bits) ||
+        file.Read(&trackSize, sizeof(trackSize)) != sizeof(trackSize) ||
+        file.Read(&lengthMS, sizeof(lengthMS)) != sizeof(lengthMS) ||
+        !ReadCacheString(file, title) || !ReadCacheString(file, artist) || !ReadCacheString(file, album) || !ReadCacheString(file, hash) ||
+        file.Read(&pcmdatasize, sizeof(pcmdatasize)) != sizeof(pcmdatasize) ||
+        rate <= 0 || channels <= 0 || trackSize <= 0 || pcmdatasize != trackSize * 2 * (int64_t)sizeof(int16_t)) {
+        logger_base.warn("Audio cache file %s is not valid.", (const char*)filename.c_str());
+        return false;
+    }
+
+    // the data arrays are laid out the same as when the file is decoded
+    long size = sizeof(float) * (trackSize + _extra);
+    float* left = (float*)calloc(size, 1);
+    float* right = channels == 2 ? (float*)calloc(size, 1) : left;
+    Uint8* pcmdata = (Uint8*)calloc(pcmdatasize + PCMFUDGE, 1);
+    if (left == nullptr || right == nullptr || pcmdata == nullptr || file.Read(pcmdata, pcmdatasize) != pcmdatasize) {
+        logger_base.warn("Unable to load audio cache file %s.", (const char*)filename.c_str());
+        if (right != left) free(right);
+        free(left);
+        free(pcmdata);
+        return false;
+    }
+    const int16_t* pcm = (const int16_t*)pcmdata;
+    for (int64_t i = 0; i < trackSize; i++) {
+        left[i] = ((float)pcm[i * 2]) / (float)0x8000;
+        if (channels > 1) {
+            right[i] = ((float)pcm[i * 2 + 1]) / (float)0x8000;
+        }
+    }
+
+    if (_data[1] != nullptr && _data[1] != _data[0]) {
+        free(_data[1]);
+    }
+    if (_data[0] != nullptr) {
+        free(_data[0]);
+    }
+    _data[0] = left;
+    _data[1] = right;
+    _pcmdata = pcmdata;
+    _pcmdatasize = pcmdatasize;
+    _rate = rate;
+    _channels = channels;
+    _bits = bits;
+    _lengthMS = lengthMS;
+    _title = title;
+    _artist = artist;
+    _album = album;
+    _hash = hash;
+    {
+        std::unique_lock<std::shared_timed_mutex> locker(_mutexAudioLoad);
+        _trackSize = trackSize;
+    }
+    SetLoadedData(trackSize);
+
+    // so it is the last to be removed when the cache is full
+    fn.Assign(filename);
+    fn.Touch();
+    logger_base.debug("Audio loaded from cache file %s.", (const char*)filename.c_str());
+    return true;
+}
+
+void AudioManager::SaveAudioCache()
+{
+    std::string filename = GetAnalysisCacheFile("");
+    if (filename == "" || _pcmdata == nullptr || _trackSize <= 0 || _pcmdatasize < (long)(_trackSize * 2 * sizeof(int16_t))) return;
+
+    // the same as Hash() but without touching _hash which the main thread may be setting
+    MD5 md5;
+    md5.update((unsigned char *)_data[0], sizeof(float) * _trackSize);
+    md5.finalize();
+    std::string hash = md5.hexdigest();
+
+    // the pcm data is half the size of the float data and converts back to it exactly
+    WriteCacheFile(filename, [this, &hash](wxFile& file) {
+        int64_t rate = _rate;
+        int32_t channels = _channels;
+        int32_t bits = _bits;
+        int64_t trackSize = _trackSize;
+        int64_t lengthMS = _lengthMS;
+        int64_t pcmdatasize = trackSize * 2 * sizeof(int16_t);
+        file.Write(&rate, sizeof(rate));
+        file.Write(&channels, sizeof(channels));
+        file.Write(&bits, sizeof(bits));
+        file.Write(&trackSize, sizeof(trackSize));
+        file.Write(&lengthMS, sizeof(lengthMS));
+        WriteCacheString(file, _title);
+        WriteCacheString(file, _artist);
+        WriteCacheString(file, _album);
+        WriteCacheString(file, hash);
+        file.Write(&pcmdatasize, sizeof(pcmdatasize));
+        file.Write(_pcmdata, pcmdatasize);
+    });
+    EnforceAnalysisCacheSize();
+}
+
+// called with the frame data lock held
+bool AudioManager::LoadFrameDataCache()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::string filename = GetAnalysisCacheFile("_" + std::to_string(_intervalMS) + "ms");
+    wxFile file;
+    if (!OpenCacheFile(file, filename)) return false;
+
+    int32_t frames = 0;
+    int32_t stride = 0;
+    uint8_t compact = 0;
+    int64_t trackSize = 0;
+    float big[4];
+    if (file.Read(&trackSize, sizeof(trackSize)) != sizeof(trackSize) ||
+        file.Read(&frames, sizeof(frames)) != sizeof(frames) ||
+        file.Read(&stride, sizeof(stride)) != sizeof(stride) ||
+        file.Read(&compact, sizeof(compact)) != sizeof(compact) ||
+        file.Read(big, sizeof(big)) != sizeof(big) ||
+        trackSize != _trackSize || frames <= 0 || (compact != 0) != __compactFrameData ||
+        stride != (compact ? FRAMEDATA_LEVELS : FRAMEDATA_LEVELS + SpectrumAnalyser::NOTES)) {
+        return false;
+    }
+
+    std::vector<float> frameData((size_t)frames * stride);
+    std::vector<uint8_t> spectrum(compact ? (size_t)frames * SpectrumAnalyser::NOTES : 0);
+    std::vector<uint8_t> hasSpectrum(frames);
+    ssize_t dataSize = frameData.size() * sizeof(float);
+    if (file.Read(&frameData[0], dataSize) != dataSize ||
+        (compact && file.Read(&spectrum[0], spectrum.size()) != (ssize_t)spectrum.size()) ||
+        file.Read(&hasSpectrum[0], frames) != frames) {
+        logger_base.warn("Audio frame data cache file %s is not valid.", (const char*)filename.c_str());
+        return false;
+    }
+
+    _frameData.swap(frameData);
+    _frameSpectrum.swap(spectrum);
+    _frameHasSpectrum.assign(hasSpectrum.begin(), hasSpectrum.end());
+    _frameNotes.clear();
+    _frameNotes.resize(frames);
+    _frameDataFrames = frames;
+    _frameDataStride = stride;
+    _frameDataCompact = compact != 0;
+    _bigmax = big[0];
+    _bigmin = big[1];
+    _bigspread = big[2];
+    _bigspectogrammax = big[3];
+
+    wxFileName(filename).Touch();
+    return true;
+}
+
+// called with the frame data lock held
+void AudioManager::SaveFrameDataCache()
+{
+    std::string filename = GetAnalysisCacheFile("_" + std::to_string(_intervalMS) + "ms");
+    if (filename == "" || _frameDataFrames <= 0) return;
+
+    WriteCacheFile(filename, [this](wxFile& file) {
+        int64_t trackSize = _trackSize;
+        int32_t frames = _frameDataFrames;
+        int32_t stride = _frameDataStride;
+        uint8_t compact = _frameDataCompact ? 1 : 0;
+        float big[4] = { _bigmax, _bigmin, _bigspread, _bigspectogrammax };
+        file.Write(&trackSize, sizeof(trackSize));
+        file.Write(&frames, sizeof(frames));
+        file.Write(&stride, sizeof(stride));
+        file.Write(&compact, sizeof(compact));
+        file.Write(big, sizeof(big));
+        file.Write(&_frameData[0], _frameData.size() * sizeof(float));
+        if (compact) {
+            file.Write(&_frameSpectrum[0], _frameSpectrum.size());
+        }
+        std::vector<uint8_t> hasSpectrum(_frameHasSpectrum.begin(), _frameHasSpectrum.end());
+        file.Write(&hasSpectrum[0], hasSpectrum.size());
+    });
+    EnforceAnalysisCacheSize();
+}
+
+#pragma endregion
+
 std::string AudioManager::Hash()
 {
     if (_hash == "")
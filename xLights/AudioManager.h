@@ -10,6 +10,9 @@
  * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
  **************************************************************/
 
+#include <atomic>
+#include <cstdint>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <list>
@@ -86,6 +89,88 @@ typedef enum FRAMEDATATYPE {
 	FRAMEDATA_NOTES
 } FRAMEDATATYPE;
 
+/**
+ * The values of one FRAMEDATATYPE for one frame.  It points into the AudioManager's frame data
+ * and stays valid until the frame data is prepared again.  A compact store keeps the spectrum
+ * as bytes, those are converted back to 0-1 as they are read.
+ */
+class AudioFrameData
+{
+public:
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef float value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const float* pointer;
+        typedef float reference;
+
+        const_iterator(const AudioFrameData* data, size_t idx) : _data(data), _idx(idx) {}
+        float operator*() const { return (*_data)[_idx]; }
+        const_iterator& operator++() { ++_idx; return *this; }
+        const_iterator operator++(int) { const_iterator r = *this; ++_idx; return r; }
+        bool operator==(const const_iterator& other) const { return _idx == other._idx; }
+        bool operator!=(const const_iterator& other) const { return _idx != other._idx; }
+
+    private:
+        const AudioFrameData* _data;
+        size_t _idx;
+    };
+
+    AudioFrameData() {}
+    AudioFrameData(const float* values, size_t count) : _values(values), _count(count), _valid(true) {}
+    AudioFrameData(const uint8_t* compact, size_t count) : _compact(compact), _count(count), _valid(true) {}
+
+    // false if there is no data for the frame
+    explicit operator bool() const { return _valid; }
+    size_t size() const { return _count; }
+    bool empty() const { return _count == 0; }
+    float operator[](size_t idx) const { return _values != nullptr ? _values[idx] : (float)_compact[idx] / 255.0f; }
+    float front() const { return (*this)[0]; }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, _count); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+private:
+    const float* _values = nullptr;
+    const uint8_t* _compact = nullptr;
+    size_t _count = 0;
+    bool _valid = false;
+};
+
+/**
+ * The min, max and sum of squares of a track's samples in blocks of 64, 128, 256 ... samples,
+ * each level built from the one below.  Any run of samples is covered by the largest blocks
+ * that fit plus at most a block's worth of samples at each end, so the waveform for a pixel
+ * costs the same however many samples the pixel spans.  It points at the samples, which must
+ * outlive it.
+ */
+class WaveformPyramid
+{
+public:
+    WaveformPyramid(const float* data, long samples);
+
+    // over the samples from start up to but not including end, all 0 if there are none
+    void GetMinMaxRMS(long start, long end, float& minimum, float& maximum, float& rms) const;
+    long GetSampleCount() const { return _samples; }
+
+private:
+    static constexpr int BASE_BLOCK_SHIFT = 6;
+    struct Block {
+        float min;
+        float max;
+        double sumsq;
+    };
+    static void Add(Block& total, const Block& b);
+    void AddSamples(Block& total, long start, long end) const;
+
+    const float* _data;
+    long _samples;
+    std::vector<std::vector<Block>> _levels;
+};
+
 typedef enum MEDIAPLAYINGSTATE {
 	PLAYING,
 	PAUSED,
@@ -247,6 +332,10 @@ typedef struct FilteredAudioData
     float* data0 = nullptr;
     float* data1 = nullptr;
     int16_t* pcmdata = nullptr;
+    // built from data0 in the background once the filtered data has been created
+    std::unique_ptr<WaveformPyramid> pyramid;
+    std::future<void> pyramidBuild;
+    std::atomic_bool pyramidReady{ false };
 } FilteredAudioData;
 
 class AudioManager
@@ -254,7 +343,21 @@ class AudioManager
     std::shared_timed_mutex _mutex;
     std::shared_timed_mutex _mutexAudioLoad;
     long _loadedData = 0;
-    std::vector<std::vector<std::list<float>>> _frameData;
+    // per frame the high, low and spread levels followed by the spectrum, or with a compact
+    // store just the levels with the spectrum kept as bytes in _frameSpectrum
+    static constexpr int FRAMEDATA_LEVELS = 3;
+    std::vector<float> _frameData;
+    std::vector<uint8_t> _frameSpectrum;
+    std::vector<bool> _frameHasSpectrum;
+    std::vector<std::vector<float>> _frameNotes;
+    int _frameDataFrames = 0;
+    int _frameDataStride = 0;
+    bool _frameDataCompact = false;
+    static bool __compactFrameData;
+    // identifies the media file in the analysis cache, empty if it is not being cached
+    std::string _cacheKey;
+    static std::string __analysisCacheFolder;
+    static size_t __analysisCacheMaximumSizeMB;
 	std::string _audio_file;
 	xLightsVamp _vamp;
 	long _rate = 44100;
@@ -299,7 +402,15 @@ class AudioManager
     static int decodebitrateindex(int bitrateindex, int version, int layertype);
 	int decodesamplerateindex(int samplerateindex, int version) const;
     static int decodesideinfosize(int version, int mono);
-	std::list<float> CalculateSpectrumAnalysis(const float* in, int n, float& max, int id) const;
+    void WaitForFrameData(std::shared_lock<std::shared_timed_mutex>& lock);
+
+    std::string GetAnalysisCacheFile(const std::string& suffix) const;
+    bool LoadAudioCache();
+    void SaveAudioCache();
+    bool LoadFrameDataCache();
+    void SaveFrameDataCache();
+    static void EnforceAnalysisCacheSize();
+    AudioFrameData GetPreparedFrameData(int frame, FRAMEDATATYPE fdt) const;
 
     void LoadAudioFromFrame( AVFormatContext* formatContext, AVCodecContext* codecContext, AVPacket* decodingPacket, AVFrame* frame, SwrContext* au_convert_ctx,
                              bool receivedEOF, int out_channels, uint8_t* out_buffer, long& read, int& lastpct );
@@ -309,6 +420,7 @@ class AudioManager
     void SetLoadedData(long pos);
 
     void NormaliseFilteredAudioData(FilteredAudioData* fad);
+    void BuildWaveformPyramid(FilteredAudioData* fad);
 
     static bool WriteAudioFrame( AVFormatContext *oc, AVCodecContext* codecContext, AVStream *st, float *sampleBuff, int sampleCount, bool clearQueue = false );
 
@@ -362,8 +474,16 @@ public:
     void SetStepBlock(int step, int block);
 	void SetFrameInterval(int intervalMS);
 	int GetFrameInterval() const { return _intervalMS; }
-	const std::list<float>* GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing);
-	const std::list<float>* GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms);
+	AudioFrameData GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing);
+	AudioFrameData GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms);
+    // copies the HIGH, LOW or SPREAD level of count frames from startFrame, 0 for frames outside the song
+    bool GetFrameLevels(FRAMEDATATYPE fdt, int startFrame, int count, float* levels);
+    // keep the spectrum as bytes rather than floats, a quarter of the memory for slightly coarser values
+    static void SetCompactFrameData(bool compact) { __compactFrameData = compact; }
+    // decoded audio and frame data are kept in an AudioCache folder under path so songs open without
+    // decoding or analysing them again, an empty path turns the cache off
+    static void SetAnalysisCacheFolder(const std::string& path);
+    static void SetAnalysisCacheMaximumSizeMB(size_t mb);
 	void DoPrepareFrameData();
 	void DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManagerProgressCallback progresscallback);
 	bool IsPolyphonicTranscriptionDone() const { return _polyphonicTranscriptionDone; };
@@ -372,6 +492,8 @@ public:
     void DoLoadAudioData(AVFormatContext* formatContext, AVCodecContext* codecContext, AVStream* audioStream, AVFrame* frame);
 
     FilteredAudioData* GetFilteredAudioData(AUDIOSAMPLETYPE type, int lowNote, int highNote);
+    // the pyramid of the left channel of a track SwitchTo has created, nullptr while it is still being built
+    const WaveformPyramid* GetWaveformPyramid(AUDIOSAMPLETYPE type, int lowNote, int highNote);
     static bool CreateAudioFile( const std::vector<float>& left, const std::vector<float>& right, const std::string& targetFile, long bitrate );
     bool WriteCurrentAudio( const std::string& path, long bitrate);
 
@@ -2,8 +2,14 @@
 #define _FILE_OFFSET_BITS 64
 #define __STDC_FORMAT_MACROS
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -786,6 +792,56 @@ static const int V2FSEQ_OUT_BUFFER_FLUSH_SIZE = 16 * 1024 * 1024;  // 50% full,
 static const int V2FSEQ_OUT_COMPRESSION_BLOCK_SIZE = 64 * 1024; // 64KB blocks
 #endif
 
+// A compression block decoded by the read ahead, holding just the ranges being read
+struct ReadAheadBlock {
+    uint32_t index = 0;
+    uint32_t firstFrame = 0;
+    uint32_t numFrames = 0;
+    uint32_t frameSize = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    std::vector<uint8_t> data;
+    bool done = false;
+};
+
+// A frame handed out by the read ahead, it points into the decoded block so nothing
+// is copied until readFrame
+class ReadAheadFrameData : public FSEQFile::FrameData {
+public:
+    ReadAheadFrameData(uint32_t frame, const std::shared_ptr<ReadAheadBlock>& block) :
+        FrameData(frame),
+        m_block(block) {
+        uint32_t fidx = frame > block->firstFrame ? frame - block->firstFrame : 0;
+        if (block->numFrames > 0 && fidx >= block->numFrames) {
+            fidx = block->numFrames - 1;
+        }
+        m_data = &block->data[(size_t)fidx * block->frameSize];
+    }
+    virtual ~ReadAheadFrameData() {}
+
+    virtual bool readFrame(uint8_t* data, uint32_t maxChannels) override {
+        uint32_t offset = 0;
+        for (auto& rng : m_block->ranges) {
+            if (rng.first < maxChannels) {
+                uint32_t toCopy = std::min(rng.second, maxChannels - rng.first);
+                memcpy(&data[rng.first], &m_data[offset], toCopy);
+            }
+            offset += rng.second;
+        }
+        return true;
+    }
+
+    [[nodiscard]] virtual size_t GetSize() const override {
+        return m_block->frameSize;
+    }
+
+    [[nodiscard]] virtual uint8_t* GetData() const override {
+        return m_data;
+    }
+
+    std::shared_ptr<ReadAheadBlock> m_block;
+    uint8_t* m_data;
+};
+
 class V2Handler {
 public:
     V2Handler(V2FSEQFile* f) :
@@ -819,6 +875,9 @@ public:
 
     virtual void prepareRead(uint32_t frame) {}
 
+    virtual void enableReadAhead(int blocks, int threads) {}
+    virtual bool getReadAheadStats(FSEQFile::ReadAheadStats& stats) { return false; }
+
     virtual void finalize() {
         if (!m_file->getVariableHeaders().empty()) {
             for (int x = 0; x < m_variableHeaderOffsets.size(); x++) {
@@ -911,7 +970,217 @@ public:
             m_maxBlocks = m_file->m_frameOffsets.size() - 1;
         }
     }
-    virtual ~V2CompressedHandler() {}
+    virtual ~V2CompressedHandler() {
+        stopReadAhead();
+    }
+
+    // decompresses a whole block, outLen is the size of all the frames in it
+    virtual bool decompressBlock(const uint8_t* in, uint64_t inLen, uint8_t* out, uint64_t outLen) = 0;
+
+    virtual void enableReadAhead(int blocks, int threads) override {
+        stopReadAhead();
+        if (blocks <= 0) {
+            return;
+        }
+        if (threads <= 0) {
+            threads = std::min(blocks, std::max(1, (int)std::thread::hardware_concurrency() / 2));
+        }
+        m_readAheadBlocks = blocks;
+        m_stopReadAhead = false;
+        for (int x = 0; x < threads; x++) {
+            m_readAheadThreads.emplace_back([this]() { readAheadWorker(); });
+        }
+    }
+
+    // the subclasses must call this in their destructor so the workers are
+    // not left calling decompressBlock
+    void stopReadAhead() {
+        {
+            std::unique_lock<std::mutex> lock(m_readAheadLock);
+            m_stopReadAhead = true;
+            m_toDecode.clear();
+        }
+        m_readAheadSignal.notify_all();
+        for (auto& t : m_readAheadThreads) {
+            t.join();
+        }
+        m_readAheadThreads.clear();
+        m_readAhead.clear();
+        m_readAheadBlocks = 0;
+    }
+
+    virtual void prepareRead(uint32_t frame) override {
+        if (m_readAheadBlocks > 0) {
+            // the ranges may have changed, start again
+            std::unique_lock<std::mutex> lock(m_readAheadLock);
+            m_readAhead.clear();
+            m_toDecode.clear();
+            queueReadAhead(findBlock(frame));
+        }
+    }
+
+    virtual bool getReadAheadStats(FSEQFile::ReadAheadStats& stats) override {
+        if (m_readAheadBlocks <= 0) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(m_readAheadLock);
+        stats = m_readAheadStats;
+        stats.bufferedBlocks = 0;
+        stats.bufferedFrames = 0;
+        for (auto& b : m_readAhead) {
+            if (!b->done) {
+                break;
+            }
+            uint32_t end = b->firstFrame + b->numFrames;
+            if (m_lastFrameRead >= b->firstFrame && m_lastFrameRead < end) {
+                stats.bufferedFrames += end - m_lastFrameRead - 1;
+            } else {
+                stats.bufferedFrames += b->numFrames;
+                stats.bufferedBlocks++;
+            }
+        }
+        return true;
+    }
+
+    uint32_t findBlock(uint32_t frame) const {
+        uint32_t b = 0;
+        while (b + 2 < m_file->m_frameOffsets.size() && frame >= m_file->m_frameOffsets[b + 1].first) {
+            b++;
+        }
+        return b;
+    }
+
+    // called with m_readAheadLock held, queues the blocks from first up to the read ahead
+    // limit that aren't already queued
+    void queueReadAhead(uint32_t first) {
+        if (m_file->m_frameOffsets.empty()) {
+            return;
+        }
+        uint32_t numBlocks = m_file->m_frameOffsets.size() - 1;
+        uint32_t next = m_readAhead.empty() ? first : m_readAhead.back()->index + 1;
+        while (next < numBlocks && next <= first + m_readAheadBlocks) {
+            std::shared_ptr<ReadAheadBlock> b = std::make_shared<ReadAheadBlock>();
+            b->index = next;
+            b->firstFrame = m_file->m_frameOffsets[next].first;
+            uint32_t endFrame = std::min((uint32_t)m_file->getNumFrames(), m_file->m_frameOffsets[next + 1].first);
+            b->numFrames = endFrame > b->firstFrame ? endFrame - b->firstFrame : 0;
+            b->frameSize = m_file->m_dataBlockSize;
+            b->ranges = m_file->m_rangesToRead;
+            m_readAhead.push_back(b);
+            m_toDecode.push_back(b);
+            next++;
+        }
+        m_readAheadSignal.notify_all();
+    }
+
+    FrameData* getReadAheadFrame(uint32_t frame) {
+        std::unique_lock<std::mutex> lock(m_readAheadLock);
+        uint32_t idx;
+        if (!m_readAhead.empty() && frame >= m_readAhead.front()->firstFrame && frame < m_readAhead.front()->firstFrame + m_readAhead.front()->numFrames) {
+            idx = m_readAhead.front()->index;
+        } else {
+            idx = findBlock(frame);
+        }
+        while (!m_readAhead.empty() && m_readAhead.front()->index < idx) {
+            m_readAhead.pop_front();
+        }
+        if (!m_readAhead.empty() && m_readAhead.front()->index != idx) {
+            // jumped back or past everything read ahead
+            m_readAhead.clear();
+        }
+        m_toDecode.erase(std::remove_if(m_toDecode.begin(), m_toDecode.end(), [idx](const std::shared_ptr<ReadAheadBlock>& b) { return b->index < idx; }), m_toDecode.end());
+        if (m_readAhead.empty()) {
+            m_toDecode.clear();
+        }
+        queueReadAhead(idx);
+        if (m_readAhead.empty()) {
+            // the frame isn't in any block, the caller reads it directly
+            return nullptr;
+        }
+
+        std::shared_ptr<ReadAheadBlock> block = m_readAhead.front();
+        if (!block->done) {
+            auto start = std::chrono::steady_clock::now();
+            m_readAheadDone.wait(lock, [&block]() { return block->done; });
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            m_readAheadStats.stalls++;
+            m_readAheadStats.lastStallMS = ms;
+            m_readAheadStats.maxStallMS = std::max(m_readAheadStats.maxStallMS, ms);
+        }
+        m_lastFrameRead = frame;
+        return new ReadAheadFrameData(frame, block);
+    }
+
+    void readAheadWorker() {
+        std::vector<uint8_t> in;
+        std::vector<uint8_t> out;
+        std::unique_lock<std::mutex> lock(m_readAheadLock);
+        while (true) {
+            m_readAheadSignal.wait(lock, [this]() { return m_stopReadAhead || !m_toDecode.empty(); });
+            if (m_stopReadAhead) {
+                break;
+            }
+            std::shared_ptr<ReadAheadBlock> b = m_toDecode.front();
+            m_toDecode.pop_front();
+            lock.unlock();
+
+            auto start = std::chrono::steady_clock::now();
+            decodeBlock(*b, in, out);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            lock.lock();
+            b->done = true;
+            m_readAheadStats.averageDecodeMS = (m_readAheadStats.averageDecodeMS * m_readAheadStats.blocksDecoded + ms) / (m_readAheadStats.blocksDecoded + 1);
+            m_readAheadStats.blocksDecoded++;
+            m_readAheadStats.lastDecodeMS = ms;
+            m_readAheadStats.maxDecodeMS = std::max(m_readAheadStats.maxDecodeMS, ms);
+            m_readAheadDone.notify_all();
+        }
+    }
+
+    void decodeBlock(ReadAheadBlock& b, std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+        uint64_t chanCount = m_file->getChannelCount();
+        b.data.resize((size_t)std::max(b.numFrames, (uint32_t)1) * b.frameSize);
+        if (b.numFrames == 0) {
+            return;
+        }
+        uint64_t len = m_file->m_frameOffsets[b.index + 1].second;
+        len -= m_file->m_frameOffsets[b.index].second;
+        uint64_t max = m_file->getNumFrames();
+        max *= chanCount;
+        if (len > max) {
+            len = max;
+        }
+        in.resize(len);
+        {
+            // the workers share the file
+            std::unique_lock<std::mutex> lock(m_fileLock);
+            seek(m_file->m_frameOffsets[b.index].second, SEEK_SET);
+            uint64_t bread = read(&in[0], len);
+            if (bread != len) {
+                LogErr(VB_SEQUENCE, "Failed to read channel data for block %d!   Needed to read %" PRIu64 " but read %d\n", (int)b.index, len, (int)bread);
+            }
+        }
+        out.resize((size_t)b.numFrames * chanCount);
+        if (!decompressBlock(&in[0], len, &out[0], out.size())) {
+            LogErr(VB_SEQUENCE, "Failed to decompress block %d.\n", (int)b.index);
+        }
+        for (uint32_t f = 0; f < b.numFrames; f++) {
+            const uint8_t* src = &out[(size_t)f * chanCount];
+            uint8_t* dst = &b.data[(size_t)f * b.frameSize];
+            if (!m_file->m_sparseRanges.empty()) {
+                memcpy(dst, src, std::min((uint64_t)b.frameSize, chanCount));
+            } else {
+                uint32_t sz = 0;
+                for (auto& rng : b.ranges) {
+                    if (rng.first < chanCount && sz + rng.second <= b.frameSize) {
+                        memcpy(&dst[sz], &src[rng.first], rng.second);
+                        sz += rng.second;
+                    }
+                }
+            }
+        }
+    }
 
     virtual uint32_t computeMaxBlocks(int maxNumBlocks) override {
         if (m_maxBlocks > 0) {
@@ -996,6 +1265,20 @@ public:
     uint32_t m_curFrameInBlock;
     uint32_t m_curBlock;
     uint32_t m_maxBlocks;
+
+    // read ahead, m_readAhead is the ring of blocks from the one holding the last
+    // frame requested onwards
+    int m_readAheadBlocks = 0;
+    std::deque<std::shared_ptr<ReadAheadBlock>> m_readAhead;
+    std::deque<std::shared_ptr<ReadAheadBlock>> m_toDecode;
+    std::vector<std::thread> m_readAheadThreads;
+    std::mutex m_readAheadLock;
+    std::mutex m_fileLock;
+    std::condition_variable m_readAheadSignal;
+    std::condition_variable m_readAheadDone;
+    bool m_stopReadAhead = false;
+    uint32_t m_lastFrameRead = 0;
+    FSEQFile::ReadAheadStats m_readAheadStats;
 };
 
 #ifndef NO_ZSTD
@@ -1015,6 +1298,8 @@ public:
         LogDebug(VB_SEQUENCE, "  Prepared to read/write a ZSTD compress fseq file.\n");
     }
     virtual ~V2ZSTDCompressionHandler() {
+        stopReadAhead();
+        stopWorkers();
         free(m_outBuffer.dst);
         if (m_inBuffer.src != nullptr) {
             free((void*)m_inBuffer.src);
@@ -1029,7 +1314,32 @@ public:
     virtual uint8_t getCompressionType() override { return 1; }
     virtual std::string GetType() const override { return "Compressed ZSTD"; }
 
+    virtual bool decompressBlock(const uint8_t* in, uint64_t inLen, uint8_t* out, uint64_t outLen) override {
+        ZSTD_DCtx* dctx = ZSTD_createDCtx();
+        ZSTD_inBuffer_s input = { in, inLen, 0 };
+        ZSTD_outBuffer_s output = { out, outLen, 0 };
+        bool ok = true;
+        while (output.pos < output.size && input.pos < input.size) {
+            size_t r = ZSTD_decompressStream(dctx, &output, &input);
+            if (ZSTD_isError(r)) {
+                ok = false;
+                break;
+            }
+            if (r == 0) {
+                break;
+            }
+        }
+        ZSTD_freeDCtx(dctx);
+        return ok && output.pos == output.size;
+    }
+
     virtual FrameData *getFrame(uint32_t frame) override {
+        if (m_readAheadBlocks > 0) {
+            FrameData* data = getReadAheadFrame(frame);
+            if (data != nullptr) {
+                return data;
+            }
+        }
 
         if (m_file == nullptr) LogDebug(VB_SEQUENCE, " getFrame m_file unexpectantly null.\n");
 
@@ -1046,7 +1356,6 @@ public:
                 if (m_dctx == nullptr) LogDebug(VB_SEQUENCE, " getFrame ZSTD_createDStream failed.\n");
             }
             ZSTD_initDStream(m_dctx);
-            seek(m_file->m_frameOffsets[m_curBlock].second, SEEK_SET);
 
             uint64_t len = m_file->m_frameOffsets[m_curBlock + 1].second;
             len -= m_file->m_frameOffsets[m_curBlock].second;
@@ -1062,16 +1371,21 @@ public:
             if (m_inBuffer.src == nullptr) LogDebug(VB_SEQUENCE, " getFrame m_inBuffer.src malloc failed.\n");
             m_inBuffer.pos = 0;
             m_inBuffer.size = len;
-            int bread = read((void*)m_inBuffer.src, len);
-            if (bread != len) {
-                LogErr(VB_SEQUENCE, "Failed to read channel data for frame %d!   Needed to read %" PRIu64 " but read %d\n", frame, len, (int)bread);
-            }
+            {
+                // the read ahead workers may be seeking the same file
+                std::unique_lock<std::mutex> lock(m_fileLock);
+                seek(m_file->m_frameOffsets[m_curBlock].second, SEEK_SET);
+                int bread = read((void*)m_inBuffer.src, len);
+                if (bread != len) {
+                    LogErr(VB_SEQUENCE, "Failed to read channel data for frame %d!   Needed to read %" PRIu64 " but read %d\n", frame, len, (int)bread);
+                }
 
-            if (m_curBlock < m_file->m_frameOffsets.size() - 2) {
-                //let the kernel know that we'll likely need the next block in the near future
-                uint64_t len2 = m_file->m_frameOffsets[m_curBlock + 2].second;
-                len2 -= m_file->m_frameOffsets[m_curBlock + 1].second;
-                preload(tell(), len2);
+                if (m_curBlock < m_file->m_frameOffsets.size() - 2) {
+                    //let the kernel know that we'll likely need the next block in the near future
+                    uint64_t len2 = m_file->m_frameOffsets[m_curBlock + 2].second;
+                    len2 -= m_file->m_frameOffsets[m_curBlock + 1].second;
+                    preload(tell(), len2);
+                }
             }
 
             free(m_outBuffer.dst);
@@ -1157,7 +1471,29 @@ public:
             count += input.pos;
         }
     }
+    int getBlockCompressionLevel(uint32_t frame) const {
+        int clevel = m_file->m_compressionLevel == -99 ? 2 : m_file->m_compressionLevel;
+        if (clevel < -25 || clevel > 25) {
+            clevel = 2;
+        }
+        if (frame == 0 && (ZSTD_versionNumber() > 10305)) {
+            // first frame needs to be grabbed as fast as possible
+            // or remotes may be off by a few frames at start.  Thus,
+            // if using recent zstd, we'll use the negative levels
+            // for the first block so the decompression can
+            // be as fast as possible
+            clevel = -10;
+        }
+        if (ZSTD_versionNumber() <= 10305 && clevel < 0) {
+            clevel = 0;
+        }
+        return clevel;
+    }
     virtual void addFrame(uint32_t frame, const uint8_t* data) override {
+        if (m_file->m_compressionThreads > 1) {
+            addFrameParallel(frame, data);
+            return;
+        }
         if (m_cctx == nullptr) {
             m_cctx = ZSTD_createCStream();
         }
@@ -1165,21 +1501,7 @@ public:
             uint64_t offset = tell();
             //LogDebug(VB_SEQUENCE, "  Preparing to create a compressed block of data starting at frame %d, offset  %" PRIu64 ".\n", frame, offset);
             m_file->m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(frame, offset));
-            int clevel = m_file->m_compressionLevel == -99 ? 2 : m_file->m_compressionLevel;
-            if (clevel < -25 || clevel > 25) {
-                clevel = 2;
-            }
-            if (frame == 0 && (ZSTD_versionNumber() > 10305)) {
-                // first frame needs to be grabbed as fast as possible
-                // or remotes may be off by a few frames at start.  Thus,
-                // if using recent zstd, we'll use the negative levels
-                // for the first block so the decompression can
-                // be as fast as possible
-                clevel = -10;
-            }
-            if (ZSTD_versionNumber() <= 10305 && clevel < 0) {
-                clevel = 0;
-            }
+            int clevel = getBlockCompressionLevel(frame);
             ZSTD_initCStream(m_cctx, clevel);
             //ZSTD_CCtx_reset(m_cctx, ZSTD_reset_session_only);
             //ZSTD_CCtx_refCDict(m_cctx, NULL);
@@ -1236,6 +1558,16 @@ public:
         }
     }
     virtual void finalize() override {
+        if (m_file->m_compressionThreads > 1) {
+            if (m_curFrameInBlock) {
+                LogDebug(VB_SEQUENCE, "  Finalized last block of data.  Frames in block: %d.\n", m_curFrameInBlock);
+                queueBlock();
+            }
+            writeBlocks(true);
+            stopWorkers();
+            V2CompressedHandler::finalize();
+            return;
+        }
         if (m_curFrameInBlock) {
             ZSTD_inBuffer_s input = {
                 0, 0, 0
@@ -1253,10 +1585,166 @@ public:
         V2CompressedHandler::finalize();
     }
 
+    // Parallel compression.  The frames of a block are collected and the whole block is
+    // compressed as one zstd frame on a worker thread, exactly what the streaming
+    // compressor produces for a block.  The blocks are written in order by the thread
+    // calling addFrame/finalize so the file itself is only ever touched by that thread.
+    struct CompressionBlock {
+        uint32_t firstFrame = 0;
+        int clevel = 2;
+        std::vector<uint8_t> raw;
+        std::vector<uint8_t> compressed;
+        bool done = false;
+    };
+
+    void addFrameParallel(uint32_t frame, const uint8_t* data) {
+        if (m_workers.empty()) {
+            m_stopWorkers = false;
+            for (int x = 0; x < m_file->m_compressionThreads; x++) {
+                m_workers.emplace_back([this]() { compressBlocks(); });
+            }
+        }
+        if (m_curFrameInBlock == 0) {
+            m_block = std::make_shared<CompressionBlock>();
+            m_block->firstFrame = frame;
+            m_block->clevel = getBlockCompressionLevel(frame);
+            m_block->raw.reserve((size_t)std::max(m_framesPerBlock, (uint32_t)10) * m_file->getChannelCount());
+        }
+        if (m_file->m_sparseRanges.empty()) {
+            m_block->raw.insert(m_block->raw.end(), data, data + m_file->getChannelCount());
+        } else {
+            for (auto& a : m_file->m_sparseRanges) {
+                m_block->raw.insert(m_block->raw.end(), &data[a.first], &data[a.first] + a.second);
+            }
+        }
+        m_curFrameInBlock++;
+        // same block boundaries as the streaming compressor
+        if ((m_curBlock == 0 && m_curFrameInBlock == 10) || (m_curFrameInBlock >= m_framesPerBlock && m_curBlock + 1 < m_maxBlocks)) {
+            queueBlock();
+        }
+        writeBlocks(false);
+    }
+
+    void queueBlock() {
+        {
+            std::unique_lock<std::mutex> lock(m_blockLock);
+            m_blocks.push_back(m_block);
+            m_toCompress.push_back(m_block);
+        }
+        m_blockSignal.notify_one();
+        m_block.reset();
+        m_curFrameInBlock = 0;
+        m_curBlock++;
+    }
+
+    // writes the blocks at the front of the queue that have been compressed.  Only waits
+    // for the workers if too many blocks are queued or all is set.
+    void writeBlocks(bool all) {
+        std::unique_lock<std::mutex> lock(m_blockLock);
+        while (!m_blocks.empty()) {
+            std::shared_ptr<CompressionBlock> b = m_blocks.front();
+            if (!b->done) {
+                if (!all && m_blocks.size() <= m_workers.size() + 1) {
+                    return;
+                }
+                m_blockDone.wait(lock, [b]() { return b->done; });
+            }
+            m_blocks.pop_front();
+            lock.unlock();
+            m_file->m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(b->firstFrame, tell()));
+            write(&b->compressed[0], b->compressed.size());
+            lock.lock();
+        }
+    }
+
+    void compressBlocks() {
+        ZSTD_CStream* ctx = ZSTD_createCStream();
+        std::unique_lock<std::mutex> lock(m_blockLock);
+        while (true) {
+            m_blockSignal.wait(lock, [this]() { return m_stopWorkers || !m_toCompress.empty(); });
+            if (m_toCompress.empty()) {
+                break;
+            }
+            std::shared_ptr<CompressionBlock> b = m_toCompress.front();
+            m_toCompress.pop_front();
+            lock.unlock();
+
+            // the same streaming calls as addFrame so the block is byte for byte what the
+            // serial compressor writes
+            b->compressed.resize(ZSTD_compressBound(b->raw.size()));
+            ZSTD_initCStream(ctx, b->clevel);
+            ZSTD_inBuffer_s input = { &b->raw[0], b->raw.size(), 0 };
+            ZSTD_outBuffer_s output = { &b->compressed[0], b->compressed.size(), 0 };
+            size_t ret = 0;
+            while (input.pos < input.size && !ZSTD_isError(ret)) {
+                ret = ZSTD_compressStream2(ctx, &output, &input, ZSTD_e_continue);
+            }
+            if (!ZSTD_isError(ret)) {
+                // compressBound leaves room for the whole frame so this finishes in one call
+                ret = ZSTD_compressStream2(ctx, &output, &input, ZSTD_e_end);
+            }
+            if (ZSTD_isError(ret) || ret != 0) {
+                LogErr(VB_SEQUENCE, "Failed to compress block starting at frame %d, storing it uncompressed: %s\n", (int)b->firstFrame, ZSTD_isError(ret) ? ZSTD_getErrorName(ret) : "output buffer too small");
+                storeUncompressed(*b);
+            } else {
+                b->compressed.resize(output.pos);
+            }
+            std::vector<uint8_t>().swap(b->raw);
+
+            lock.lock();
+            b->done = true;
+            m_blockDone.notify_all();
+        }
+        ZSTD_freeCStream(ctx);
+    }
+
+    // Wraps the raw data of the block in a zstd frame made only of raw (stored) blocks
+    // so the block still decompresses with any zstd decoder.
+    static void storeUncompressed(CompressionBlock& b) {
+        static const size_t MAX_RAW_BLOCK = 128 * 1024;
+        b.compressed.clear();
+        b.compressed.reserve(b.raw.size() + 6 + 3 * (b.raw.size() / MAX_RAW_BLOCK + 1));
+        // magic number, frame header descriptor with no content size or checksum and a 128K window
+        const uint8_t header[] = { 0x28, 0xB5, 0x2F, 0xFD, 0x00, 0x38 };
+        b.compressed.insert(b.compressed.end(), header, header + sizeof(header));
+        size_t pos = 0;
+        do {
+            size_t len = std::min(MAX_RAW_BLOCK, b.raw.size() - pos);
+            uint32_t blockHeader = (uint32_t)(len << 3) | ((pos + len == b.raw.size()) ? 1 : 0);
+            b.compressed.push_back(blockHeader & 0xFF);
+            b.compressed.push_back((blockHeader >> 8) & 0xFF);
+            b.compressed.push_back((blockHeader >> 16) & 0xFF);
+            b.compressed.insert(b.compressed.end(), b.raw.begin() + pos, b.raw.begin() + pos + len);
+            pos += len;
+        } while (pos < b.raw.size());
+    }
+
+    void stopWorkers() {
+        {
+            std::unique_lock<std::mutex> lock(m_blockLock);
+            m_stopWorkers = true;
+            m_toCompress.clear();
+        }
+        m_blockSignal.notify_all();
+        for (auto& t : m_workers) {
+            t.join();
+        }
+        m_workers.clear();
+    }
+
     ZSTD_CCtx* m_cctx = nullptr;
     ZSTD_DStream* m_dctx = nullptr;
     ZSTD_outBuffer_s m_outBuffer;
     ZSTD_inBuffer_s m_inBuffer;
+
+    std::shared_ptr<CompressionBlock> m_block;
+    std::deque<std::shared_ptr<CompressionBlock>> m_blocks;     // in file order, waiting to be written
+    std::deque<std::shared_ptr<CompressionBlock>> m_toCompress; // waiting for a worker
+    std::vector<std::thread> m_workers;
+    std::mutex m_blockLock;
+    std::condition_variable m_blockSignal;
+    std::condition_variable m_blockDone;
+    bool m_stopWorkers = false;
 };
 #endif
 
@@ -1270,6 +1758,7 @@ public:
         m_inBuffer(nullptr) {
     }
     virtual ~V2ZLIBCompressionHandler() {
+        stopReadAhead();
         if (m_outBuffer) {
             free(m_outBuffer);
         }
@@ -1280,14 +1769,32 @@ public:
     virtual uint8_t getCompressionType() override { return 2; }
     virtual std::string GetType() const override { return "Compressed ZLIB"; }
 
+    virtual bool decompressBlock(const uint8_t* in, uint64_t inLen, uint8_t* out, uint64_t outLen) override {
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+        stream.next_in = (Bytef*)in;
+        stream.avail_in = inLen;
+        stream.next_out = out;
+        stream.avail_out = outLen;
+        inflateInit(&stream);
+        int r = inflate(&stream, Z_FINISH);
+        inflateEnd(&stream);
+        return r == Z_STREAM_END || stream.avail_out == 0;
+    }
+
     virtual FrameData* getFrame(uint32_t frame) override {
+        if (m_readAheadBlocks > 0) {
+            FrameData* data = getReadAheadFrame(frame);
+            if (data != nullptr) {
+                return data;
+            }
+        }
         if (m_curBlock >= m_file->m_frameOffsets.size() || (frame < m_file->m_frameOffsets[m_curBlock].first) || (frame >= m_file->m_frameOffsets[m_curBlock + 1].first)) {
             //frame is not in the current block
             m_curBlock = 0;
             while (frame >= m_file->m_frameOffsets[m_curBlock + 1].first) {
                 m_curBlock++;
             }
-            seek(m_file->m_frameOffsets[m_curBlock].second, SEEK_SET);
             uint64_t len = m_file->m_frameOffsets[m_curBlock + 1].second;
             len -= m_file->m_frameOffsets[m_curBlock].second;
             if (m_inBuffer) {
@@ -1295,16 +1802,21 @@ public:
             }
             m_inBuffer = (uint8_t*)malloc(len);
 
-            int bread = read((void*)m_inBuffer, len);
-            if (bread != len) {
-                LogErr(VB_SEQUENCE, "Failed to read channel data for frame %d!   Needed to read %" PRIu64 " but read %d\n", frame, len, (int)bread);
-            }
+            {
+                // the read ahead workers may be seeking the same file
+                std::unique_lock<std::mutex> lock(m_fileLock);
+                seek(m_file->m_frameOffsets[m_curBlock].second, SEEK_SET);
+                int bread = read((void*)m_inBuffer, len);
+                if (bread != len) {
+                    LogErr(VB_SEQUENCE, "Failed to read channel data for frame %d!   Needed to read %" PRIu64 " but read %d\n", frame, len, (int)bread);
+                }
 
-            if (m_curBlock < m_file->m_frameOffsets.size() - 2) {
-                //let the kernel know that we'll likely need the next block in the near future
-                uint64_t len = m_file->m_frameOffsets[m_curBlock + 2].second;
-                len -= m_file->m_frameOffsets[m_curBlock+1].second;
-                preload(tell(), len);
+                if (m_curBlock < m_file->m_frameOffsets.size() - 2) {
+                    //let the kernel know that we'll likely need the next block in the near future
+                    uint64_t len = m_file->m_frameOffsets[m_curBlock + 2].second;
+                    len -= m_file->m_frameOffsets[m_curBlock+1].second;
+                    preload(tell(), len);
+                }
             }
 
             if (m_stream == nullptr) {
@@ -1843,6 +2355,17 @@ FrameData* V2FSEQFile::getFrame(uint32_t frame) {
     }
     return nullptr;
 }
+void V2FSEQFile::enableReadAhead(int blocks, int threads) {
+    if (m_handler != nullptr) {
+        m_handler->enableReadAhead(blocks, threads);
+    }
+}
+bool V2FSEQFile::getReadAheadStats(ReadAheadStats& stats) const {
+    if (m_handler != nullptr) {
+        return m_handler->getReadAheadStats(stats);
+    }
+    return false;
+}
 void V2FSEQFile::addFrame(uint32_t frame,
                           const uint8_t* data) {
     if (m_handler != nullptr) {
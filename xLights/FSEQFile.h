@@ -39,6 +39,19 @@ public:
         zlib
     };
 
+    //How the read ahead is keeping up, see enableReadAhead
+    struct ReadAheadStats {
+        uint32_t blocksDecoded = 0;
+        double lastDecodeMS = 0;     // time to read and decompress the most recent block
+        double averageDecodeMS = 0;
+        double maxDecodeMS = 0;
+        uint32_t stalls = 0;         // getFrame calls that had to wait for their block
+        double lastStallMS = 0;
+        double maxStallMS = 0;
+        uint32_t bufferedBlocks = 0; // decoded blocks after the one holding the last frame requested
+        uint32_t bufferedFrames = 0; // decoded frames after the last frame requested
+    };
+
 protected:
     //open file for reading
     FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t> &header);
@@ -73,6 +86,13 @@ public:
     //It may not be used right away and will be deleted at some point in the future
     virtual FrameData *getFrame(uint32_t frame) = 0;
 
+    //Decompress the blocks after the one being read on background threads so getFrame
+    //doesn't stall when it moves into the next compression block.  blocks is how many
+    //blocks to keep ahead, 0 turns it off.  threads <= 0 picks a number of threads.
+    //Call before prepareRead.
+    virtual void enableReadAhead(int blocks, int threads = 0) {}
+    virtual bool getReadAheadStats(ReadAheadStats &stats) const { return false; }
+
     //For writing to the fseq file
     virtual void enableMinorVersionFeatures(uint8_t ver) {}
     virtual void initializeFromFSEQ(const FSEQFile& fseq);
@@ -91,6 +111,12 @@ public:
     int           getVersionMinor() const { return m_seqVersionMinor; }
     uint64_t      getUniqueId() const { return m_uniqueId; }
     const std::string& getFilename() const { return m_filename; }
+    uint64_t      getChannelDataOffset() const { return m_seqChanDataOffset; }
+    uint64_t      getFileSize() const { return m_seqFileSize; }
+
+    //true if every frame is stored uncompressed with all the channels, frame N starting
+    //at getChannelDataOffset() + N * getChannelCount(), so the frames can be read directly
+    virtual bool hasRawFrames() const { return false; }
 
 
     virtual uint32_t getMaxChannel() const = 0;
@@ -148,6 +174,7 @@ public:
     virtual void finalize() override;
 
     virtual uint32_t getMaxChannel() const override;
+    virtual bool hasRawFrames() const override { return true; }
 
 
     //The ranges to read and the data size needed to read the ranges
@@ -169,6 +196,9 @@ public:
     virtual void prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &ranges, uint32_t startFrame = 0) override;
     virtual FrameData *getFrame(uint32_t frame) override;
 
+    virtual void enableReadAhead(int blocks, int threads = 0) override;
+    virtual bool getReadAheadStats(ReadAheadStats &stats) const override;
+
     virtual void writeHeader() override;
     virtual void addFrame(uint32_t frame,
                           const uint8_t *data) override;
@@ -177,6 +207,9 @@ public:
     virtual void dumpInfo(bool indent = false) override;
 
     virtual uint32_t getMaxChannel() const override;
+    virtual bool hasRawFrames() const override {
+        return m_compressionType == CompressionType::none && m_sparseRanges.empty();
+    }
 
     virtual void enableMinorVersionFeatures(uint8_t ver) override {
         m_seqVersionMinor = ver;
@@ -195,6 +228,10 @@ public:
     std::vector<std::pair<uint32_t, uint64_t>> m_frameOffsets;
     uint32_t m_dataBlockSize;
     bool m_allowExtendedBlocks;
+
+    // when writing a zstd file with more than one thread, whole compression blocks are
+    // compressed concurrently while addFrame carries on accepting frames
+    int m_compressionThreads = 0;
 private:
 
     void createHandler();
@@ -0,0 +1,100 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "FSEQStreamWriter.h"
+#include "FSEQFile.h"
+#include "SequenceData.h"
+
+#include <algorithm>
+
+#include <wx/filefn.h>
+
+#include <log4cpp/Category.hh>
+
+FSEQStreamWriter::FSEQStreamWriter(FSEQFile* file, SequenceData& seqData, const std::string& finalName) :
+    _file(file), _fileName(file->getFilename()), _finalName(finalName), _seqData(seqData), _numFrames(seqData.NumFrames())
+{
+    _thread = std::thread([this]() { Run(); });
+}
+
+FSEQStreamWriter::~FSEQStreamWriter()
+{
+    if (_file != nullptr) {
+        Abort();
+    }
+}
+
+void FSEQStreamWriter::FramesDone(int frame)
+{
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        if (frame <= _ready) {
+            return;
+        }
+        _ready = std::min(frame, _numFrames - 1);
+    }
+    _signal.notify_one();
+}
+
+void FSEQStreamWriter::Run()
+{
+    int next = 0;
+    std::unique_lock<std::mutex> lock(_lock);
+    while (next < _numFrames && !_abort) {
+        _signal.wait(lock, [this, next]() { return _stop || _ready >= next; });
+        if (_ready < next) {
+            break;
+        }
+        int last = _ready;
+        lock.unlock();
+        for (; next <= last && !_abort; ++next) {
+            _file->addFrame(next, &_seqData[next][0]);
+        }
+        _written = next;
+        lock.lock();
+    }
+}
+
+void FSEQStreamWriter::Stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _stop = true;
+    }
+    _signal.notify_one();
+    _thread.join();
+}
+
+void FSEQStreamWriter::Finish()
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    int written = _written;
+    FramesDone(_numFrames - 1);
+    Stop();
+    logger_base.debug("fseq streaming: %d of %d frames were written while rendering.", written, _numFrames);
+    _file->finalize();
+    delete _file;
+    _file = nullptr;
+    if (_finalName != "" && !wxRenameFile(_fileName, _finalName, true)) {
+        logger_base.error("fseq streaming: unable to rename %s to %s.", (const char*)_fileName.c_str(), (const char*)_finalName.c_str());
+    }
+}
+
+void FSEQStreamWriter::Abort()
+{
+    _abort = true;
+    Stop();
+    delete _file;
+    _file = nullptr;
+    if (_finalName != "") {
+        wxRemoveFile(_fileName);
+    }
+}
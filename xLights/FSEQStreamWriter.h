@@ -0,0 +1,67 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class FSEQFile;
+class SequenceData;
+
+/**
+ * Writes a SequenceData to an fseq file while the sequence is still rendering.
+ *
+ * The render reports each frame once every row has finished it and the writer's
+ * thread hands the finished frames to the file, so the compression overlaps the
+ * render instead of being a separate step once the render is done.  For zstd files
+ * the blocks are also compressed on several threads.
+ *
+ * If the file is a temporary one it is renamed to the real name once it is complete
+ * and deleted if the writing is aborted, so an existing fseq is never left truncated.
+ */
+class FSEQStreamWriter
+{
+public:
+    // takes ownership of the file, its header must already have been written.  If
+    // finalName is set the file is renamed to it when finished.
+    FSEQStreamWriter(FSEQFile* file, SequenceData& seqData, const std::string& finalName = "");
+    ~FSEQStreamWriter();
+
+    // every frame up to and including frame is final, can be called from any thread
+    void FramesDone(int frame);
+
+    // writes the frames not written yet and completes the file
+    void Finish();
+    // stops writing, the file is left incomplete or deleted if it is a temporary one
+    void Abort();
+
+    int GetFramesWritten() const { return _written; }
+
+private:
+    void Run();
+    void Stop();
+
+    FSEQFile* _file = nullptr;
+    std::string _fileName;
+    std::string _finalName;
+    SequenceData& _seqData;
+    const int _numFrames;
+    std::thread _thread;
+    std::mutex _lock;
+    std::condition_variable _signal;
+    int _ready = -1;
+    bool _stop = false;
+    std::atomic_bool _abort = false;
+    std::atomic_int _written = 0;
+};
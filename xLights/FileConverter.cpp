@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <map>
+#include <thread>
 
 #include <wx/app.h>
 #include <wx/arrstr.h>
@@ -1568,19 +1569,30 @@ void FileConverter::ReadFalconFile(ConvertParameters& params)
         return;
     }
 
+    int channel_offset = 0;
+    if (params.data_layer) {
+        channel_offset = params.data_layer->GetChannelOffset();
+    }
+
+    if (params.read_mode == ConvertParameters::READ_MODE_LOAD_MAIN && channel_offset == 0 &&
+        file->hasRawFrames() && file->getChannelCount() == roundTo4(numChannels) &&
+        params.seq_data.initFromFile(params.inp_filename.ToStdString(), file->getChannelDataOffset(), file->getChannelCount(), falconPeriods, seqStepTime)) {
+        // an uncompressed fseq with every channel is read in one go rather than frame by frame
+        delete file;
+        return;
+    }
+
     std::vector<std::pair<uint32_t, uint32_t>> rng;
     rng.push_back(std::pair<uint32_t, uint32_t>(0, numChannels));
+    // the frames are read straight through so decompress the blocks ahead on all the cores
+    int readThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    file->enableReadAhead(readThreads, readThreads);
     file->prepareRead(rng);
     if (params.read_mode == ConvertParameters::READ_MODE_LOAD_MAIN ||
         params.read_mode == ConvertParameters::READ_MODE_IMPORT) {
         params.seq_data.init(numChannels, falconPeriods, seqStepTime);
     }
 
-    int channel_offset = 0;
-    if (params.data_layer) {
-        channel_offset = params.data_layer->GetChannelOffset();
-    }
-
     uint8_t *tmpBuf = new uint8_t[numChannels];
     int periodsRead = 0;
     while (periodsRead < falconPeriods) {
@@ -1625,11 +1637,10 @@ void FileConverter::ReadFalconFile(ConvertParameters& params)
     delete file;
 }
 
-void FileConverter::WriteFalconPiFile(ConvertParameters& params)
+FSEQFile* FileConverter::CreateFalconPiFile(ConvertParameters& params)
 {
     static log4cpp::Category &logger_conversion = log4cpp::Category::getInstance(std::string("log_conversion"));
-    logger_conversion.debug("Start fseq write");
-       
+
     const wxUint8 fType = params.xLightsFrm->_fseqVersion;
     int vMajor = 2;
     int clevel = 2;
@@ -1656,7 +1667,7 @@ void FileConverter::WriteFalconPiFile(ConvertParameters& params)
     FSEQFile *file = FSEQFile::createFSEQFile(params.out_filename, vMajor, ctype, clevel);
     if (!file) {
         params.ConversionError(wxString("Unable to create file: ") + params.out_filename + ". Check directory and file permissions.");
-        return;
+        return nullptr;
     }
     size_t stepSize = roundTo4(params.seq_data.NumChannels());
     wxUint16 stepTime = params.seq_data.FrameTime();
@@ -1694,6 +1705,10 @@ void FileConverter::WriteFalconPiFile(ConvertParameters& params)
             logger_conversion.info("Sparse range - Start: %d  End: %d   Size: %d\n", r.first + 1, (r.first + r.second), r.second);
         }
     }
+    if (vMajor >= 2 && ctype == FSEQFile::CompressionType::zstd) {
+        // compress the blocks in parallel
+        ((V2FSEQFile*)file)->m_compressionThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
     if (vMajor == 2 && params.elements) {
         for (int x = 0; x < params.elements->GetNumberOfTimingElements(); x++) {
             TimingElement *te = params.elements->GetTimingElement(x);
@@ -1756,6 +1771,18 @@ void FileConverter::WriteFalconPiFile(ConvertParameters& params)
     
 
     file->writeHeader();
+    return file;
+}
+
+void FileConverter::WriteFalconPiFile(ConvertParameters& params)
+{
+    static log4cpp::Category &logger_conversion = log4cpp::Category::getInstance(std::string("log_conversion"));
+    logger_conversion.debug("Start fseq write");
+
+    FSEQFile *file = CreateFalconPiFile(params);
+    if (!file) {
+        return;
+    }
     size_t size = params.seq_data.NumFrames();
     for (int x = 0; x < size; x++) {
         file->addFrame(x, &params.seq_data[x][0]);
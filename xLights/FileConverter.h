@@ -26,6 +26,7 @@ class OutputManager;
 class wxArrayInt;
 class wxArrayString;
 class SequenceElements;
+class FSEQFile;
 
 class ConvertParameters
 {
@@ -90,6 +91,8 @@ class FileConverter
         static void ReadConductorFile(ConvertParameters& params);
         static void ReadFalconFile(ConvertParameters& params);
         static void WriteFalconPiFile(ConvertParameters& params);
+        // creates the file and writes its header, the caller adds the frames
+        static FSEQFile* CreateFalconPiFile(ConvertParameters& params);
 
     
         static bool LoadVixenProfile(ConvertParameters& params, const wxString& ProfileName,
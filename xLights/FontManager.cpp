@@ -11,14 +11,16 @@
 #include "FontManager.h"
 #include "../../../include/xLightsFontImages.h"
 
+#include <wx/mstream.h>
+
 #define FONT_BITMAP_COLUMNS 8
 #define FONT_BITMAP_ROWS 16
 
-xlFont::xlFont(wxBitmap& bitmap_)
-: bitmap(bitmap_)
+xlFont::xlFont(const wxImage& image_)
+: image(image_)
 {
-    char_width = ((bitmap.GetWidth()-1) / FONT_BITMAP_COLUMNS)-1;
-    char_height = ((bitmap.GetHeight()-1) / FONT_BITMAP_ROWS)-1;
+    char_width = ((image.GetWidth()-1) / FONT_BITMAP_COLUMNS)-1;
+    char_height = ((image.GetHeight()-1) / FONT_BITMAP_ROWS)-1;
     caps_height = char_height;
 }
 
@@ -43,7 +45,6 @@ void xlFont::GatherInfo()
     {
         widths[i] = char_width;
     }
-    wxImage image = bitmap.ConvertToImage();
     for( int y = 0; y < FONT_BITMAP_ROWS; y++)
     {
         int y_pos = (y * (char_height + 1)) + 1;
@@ -70,40 +71,53 @@ FontManager::FontManager()
 {
 }
 
-std::vector<wxBitmap> FontManager::bitmaps;
+std::vector<wxImage> FontManager::images;
 std::vector<xlFont> FontManager::fonts;
-bool FontManager::initialized = false;
+std::once_flag FontManager::initialized;
 wxArrayString FontManager::names;
 
+#define XL_FONT_IMAGE(name) LoadPNG(name##_png, sizeof(name##_png))
+
+static wxImage LoadPNG(const unsigned char* data, size_t size)
+{
+    wxMemoryInputStream stream(data, size);
+    return wxImage(stream, wxBITMAP_TYPE_PNG);
+}
+
 FontManager::~FontManager()
 {
 }
 
 void FontManager::init()
 {
-    if( !initialized )
-    {
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_5_5x5_thin_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_5_5x5_full_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_6_5x6_thin_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_6_5x6_thin_vertical_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_6_6x6_thin_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_6_6x6_thin_vertical_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_7_7x9_thin));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_7_7x9_thinnarrow));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_7_7x9_bold));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_8_8x8_thin_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_8_8x8_thin_vertical_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_10_12x12_bold_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_10_12x12_bold_vertical_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_10_12x12_thin_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_10_12x12_thin_vertical_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_12_15x15_bold_system));
-        bitmaps.push_back(wxBITMAP_PNG_FROM_DATA(font_12_15x15_bold_vertical_system));
-
-        for( int i = 0; i < bitmaps.size(); i++ )
+    std::call_once(initialized, []() {
+        get_font_names();
+        if (wxImage::FindHandler(wxBITMAP_TYPE_PNG) == nullptr) {
+            wxImage::AddHandler(new wxPNGHandler);
+        }
+
+        images.push_back(XL_FONT_IMAGE(font_5_5x5_thin_system));
+        images.push_back(XL_FONT_IMAGE(font_5_5x5_full_system));
+        images.push_back(XL_FONT_IMAGE(font_6_5x6_thin_system));
+        images.push_back(XL_FONT_IMAGE(font_6_5x6_thin_vertical_system));
+        images.push_back(XL_FONT_IMAGE(font_6_6x6_thin_system));
+        images.push_back(XL_FONT_IMAGE(font_6_6x6_thin_vertical_system));
+        images.push_back(XL_FONT_IMAGE(font_7_7x9_thin));
+        images.push_back(XL_FONT_IMAGE(font_7_7x9_thinnarrow));
+        images.push_back(XL_FONT_IMAGE(font_7_7x9_bold));
+        images.push_back(XL_FONT_IMAGE(font_8_8x8_thin_system));
+        images.push_back(XL_FONT_IMAGE(font_8_8x8_thin_vertical_system));
+        images.push_back(XL_FONT_IMAGE(font_10_12x12_bold_system));
+        images.push_back(XL_FONT_IMAGE(font_10_12x12_bold_vertical_system));
+        images.push_back(XL_FONT_IMAGE(font_10_12x12_thin_system));
+        images.push_back(XL_FONT_IMAGE(font_10_12x12_thin_vertical_system));
+        images.push_back(XL_FONT_IMAGE(font_12_15x15_bold_system));
+        images.push_back(XL_FONT_IMAGE(font_12_15x15_bold_vertical_system));
+
+        // the fonts refer to the images so they are only created once every image is loaded
+        for( int i = 0; i < images.size(); i++ )
         {
-            fonts.push_back(xlFont(bitmaps[i]));
+            fonts.push_back(xlFont(images[i]));
             fonts[i].GatherInfo();
         }
 
@@ -112,14 +126,14 @@ void FontManager::init()
             wxArrayString parts = wxSplit(names[i], '-');
             fonts[i].SetCapsHeight(wxAtoi(parts[0]));
         }
-
-        initialized = true;
-    }
+    });
 }
 
 wxArrayString FontManager::get_font_names()
 {
-    if( names.size() == 0 )
+    // init calls this from whichever thread renders the first XL font text
+    static std::once_flag namesAdded;
+    std::call_once(namesAdded, []()
     {
         names.Add("5-5x5 Thin");
         names.Add("5-5x5 Mono");
@@ -138,14 +152,14 @@ wxArrayString FontManager::get_font_names()
         names.Add("10-12x12 Thin Vertical");
         names.Add("12-15x15 Bold");
         names.Add("12-15x15 Bold Vertical");
-    }
+    });
 
     return names;
 }
 
 xlFont* FontManager::get_font(wxString font_name)
 {
-    for( int i = 0; i < bitmaps.size(); i++ )
+    for( int i = 0; i < fonts.size(); i++ )
     {
         if( names[i] == font_name )
         {
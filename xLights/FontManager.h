@@ -10,6 +10,7 @@
  * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
  **************************************************************/
 
+#include <mutex>
 #include <vector>
 #include "wx/wx.h"
 
@@ -18,9 +19,9 @@
 class xlFont
 {
     public:
-        xlFont(wxBitmap& bitmap_);
+        xlFont(const wxImage& image_);
         virtual ~xlFont();
-        wxBitmap* get_bitmap() { return &bitmap; }
+        const wxImage& get_image() const { return image; }
         int GetWidth() { return char_width; }
         int GetHeight() { return char_height; }
         int GetCharWidth(int ascii); 
@@ -33,7 +34,7 @@ class xlFont
         int char_height;  // the standard character height
         int caps_height;  // the capital letter height
         int widths[XL_FONT_WIDTHS];  // the trimmed width of each character
-        wxBitmap& bitmap;
+        const wxImage& image;
 };
 
 class FontManager
@@ -45,6 +46,7 @@ class FontManager
             return me;
         }
 
+        // loads the fonts the first time it is called, safe to call from the render threads
         void init();
 
         virtual ~FontManager();
@@ -60,8 +62,9 @@ class FontManager
         FontManager(FontManager const&);     // Don't implement
         void operator=(FontManager const&);  // Don't implement
 
-        static std::vector<wxBitmap> bitmaps;
+        // images rather than bitmaps so the fonts can be read without GTK off the main thread
+        static std::vector<wxImage> images;
         static std::vector<xlFont> fonts;
-        static bool initialized;
+        static std::once_flag initialized;
         static wxArrayString names;
 };
@@ -0,0 +1,613 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <atomic>
+#include <cstring>
+
+#include "LayerBlend.h"
+#include "PixelBuffer.h"
+
+// The SIMD paths are only used on 64bit x86.  32bit builds may be doing the scalar
+// float math on the x87 unit which would not give the same results.
+#if defined(__x86_64__) || defined(_M_X64)
+#define LAYERBLEND_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TARGET_SSE41
+#define TARGET_AVX2
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+    // (float)alpha / 255.0 as used by the Min/Max/AsBrightness mixes
+    struct AlphaScaleTable {
+        float scale[256];
+        AlphaScaleTable() {
+            for (int x = 0; x < 256; x++) {
+                scale[x] = (float)x / 255.0;
+            }
+        }
+    };
+    static const AlphaScaleTable ALPHA_SCALE;
+
+    struct Kernels {
+        void (*alphaBlend)(const xlColor* fg, xlColor* bg, int count);
+        void (*brightness)(xlColor* c, int count, int brightness);
+        void (*additive)(const xlColor* fg, xlColor* bg, int count);
+        void (*subtractive)(const xlColor* fg, xlColor* bg, int count);
+        void (*min)(const xlColor* fg, xlColor* bg, int count);
+        void (*max)(const xlColor* fg, xlColor* bg, int count);
+        void (*asBrightness)(const xlColor* fg, xlColor* bg, int count);
+        void (*average)(const xlColor* fg, xlColor* bg, int count);
+        void (*effectMix)(xlColor* fg, xlColor* bg, int count, double fgScale, double bgScale);
+    };
+
+    //
+    // Scalar versions, also used for the leftover pixels at the end of a row
+    //
+    void AlphaBlendScalar(const xlColor* fg, xlColor* bg, int count) {
+        for (int i = 0; i < count; i++) {
+            bg[i].AlphaBlendForgroundOnto(fg[i]);
+        }
+    }
+    void BrightnessScalar(xlColor* c, int count, int brightness) {
+        for (int i = 0; i < count; i++) {
+            LayerBlend::Brightness(c[i], brightness);
+        }
+    }
+    template <void (*F)(const xlColor&, xlColor&)>
+    void MixScalar(const xlColor* fg, xlColor* bg, int count) {
+        for (int i = 0; i < count; i++) {
+            F(fg[i], bg[i]);
+        }
+    }
+    void EffectMixScalar(xlColor* fg, xlColor* bg, int count, double fgScale, double bgScale) {
+        for (int i = 0; i < count; i++) {
+            LayerBlend::EffectMix(fg[i], bg[i], fgScale, bgScale);
+        }
+    }
+
+    static const Kernels SCALAR_KERNELS = {
+        AlphaBlendScalar,
+        BrightnessScalar,
+        MixScalar<LayerBlend::Additive>,
+        MixScalar<LayerBlend::Subtractive>,
+        MixScalar<LayerBlend::Min>,
+        MixScalar<LayerBlend::Max>,
+        MixScalar<LayerBlend::AsBrightness>,
+        MixScalar<LayerBlend::Average>,
+        EffectMixScalar
+    };
+
+#ifdef LAYERBLEND_X86
+    inline int PixelBits(const xlColor* c) {
+        int v;
+        memcpy(&v, c, sizeof(v));
+        return v;
+    }
+
+    //
+    // SSE4.1, 4 pixels at a time.  Where float math is needed each pixel is
+    // expanded to a 4 x int32/float vector (r, g, b, a) so the operations are
+    // exactly the ones the scalar code does.
+    //
+    TARGET_SSE41 inline __m128i Expand(const xlColor* c) {
+        return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(PixelBits(c)));
+    }
+    TARGET_SSE41 inline __m128i Pack4(__m128i p0, __m128i p1, __m128i p2, __m128i p3) {
+        return _mm_packus_epi16(_mm_packus_epi32(p0, p1), _mm_packus_epi32(p2, p3));
+    }
+    // x / 255 for 0 <= x <= 255 * 255
+    TARGET_SSE41 inline __m128i Div255(__m128i x) {
+        return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(x, _mm_set1_epi32(1)), _mm_srli_epi32(x, 8)), 8);
+    }
+
+    TARGET_SSE41 void AlphaBlendSSE41(const xlColor* fg, xlColor* bg, int count) {
+        const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 c255 = _mm_set1_ps(255.0f);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i res[4];
+            for (int k = 0; k < 4; k++) {
+                __m128 f = _mm_cvtepi32_ps(Expand(fg + i + k));
+                __m128 b = _mm_cvtepi32_ps(Expand(bg + i + k));
+                __m128 a = _mm_div_ps(_mm_shuffle_ps(f, f, 0xFF), c255);
+                __m128 d = _mm_add_ps(_mm_mul_ps(f, a), _mm_mul_ps(b, _mm_sub_ps(one, a)));
+                res[k] = _mm_cvttps_epi32(d);
+            }
+            __m128i f = _mm_loadu_si128((const __m128i*)(fg + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(bg + i));
+            // alpha is left alone unless the foreground is opaque
+            __m128i alpha = _mm_or_si128(_mm_and_si128(b, alphaMask),
+                                         _mm_and_si128(_mm_cmpeq_epi8(f, _mm_set1_epi8((char)0xFF)), alphaMask));
+            __m128i out = _mm_or_si128(_mm_andnot_si128(alphaMask, Pack4(res[0], res[1], res[2], res[3])), alpha);
+            _mm_storeu_si128((__m128i*)(bg + i), out);
+        }
+        AlphaBlendScalar(fg + i, bg + i, count - i);
+    }
+
+    TARGET_SSE41 void BrightnessSSE41(xlColor* c, int count, int brightness) {
+        const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+        float ba = brightness;
+        ba /= 100.0f;
+        const __m128 bav = _mm_set1_ps(ba);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i res[4];
+            for (int k = 0; k < 4; k++) {
+                res[k] = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(Expand(c + i + k)), bav));
+            }
+            __m128i orig = _mm_loadu_si128((const __m128i*)(c + i));
+            __m128i out = _mm_or_si128(_mm_andnot_si128(alphaMask, Pack4(res[0], res[1], res[2], res[3])),
+                                       _mm_and_si128(orig, alphaMask));
+            _mm_storeu_si128((__m128i*)(c + i), out);
+        }
+        BrightnessScalar(c + i, count - i, brightness);
+    }
+
+    TARGET_SSE41 void AdditiveSSE41(const xlColor* fg, xlColor* bg, int count) {
+        const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i f = _mm_loadu_si128((const __m128i*)(fg + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(bg + i));
+            _mm_storeu_si128((__m128i*)(bg + i), _mm_or_si128(_mm_adds_epu8(f, b), alphaMask));
+        }
+        MixScalar<LayerBlend::Additive>(fg + i, bg + i, count - i);
+    }
+
+    TARGET_SSE41 void SubtractiveSSE41(const xlColor* fg, xlColor* bg, int count) {
+        const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i f = _mm_loadu_si128((const __m128i*)(fg + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(bg + i));
+            _mm_storeu_si128((__m128i*)(bg + i), _mm_or_si128(_mm_subs_epu8(b, f), alphaMask));
+        }
+        MixScalar<LayerBlend::Subtractive>(fg + i, bg + i, count - i);
+    }
+
+    template <bool isMax>
+    TARGET_SSE41 void MinMaxSSE41(const xlColor* fg, xlColor* bg, int count) {
+        const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i f = _mm_loadu_si128((const __m128i*)(fg + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(bg + i));
+            __m128i m = isMax ? _mm_max_epu8(f, b) : _mm_min_epu8(f, b);
+            __m128i p[4] = { m, _mm_srli_si128(m, 4), _mm_srli_si128(m, 8), _mm_srli_si128(m, 12) };
+            __m128i res[4];
+            for (int k = 0; k < 4; k++) {
+                __m128 scale = _mm_set1_ps(ALPHA_SCALE.scale[fg[i + k].alpha]);
+                res[k] = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(p[k])), scale));
+            }
+            _mm_storeu_si128((__m128i*)(bg + i), _mm_or_si128(Pack4(res[0], res[1], res[2], res[3]), alphaMask));
+        }
+        if (isMax) {
+            MixScalar<LayerBlend::Max>(fg + i, bg + i, count - i);
+        } else {
+            MixScalar<LayerBlend::Min>(fg + i, bg + i, count - i);
+        }
+    }
+    TARGET_SSE41 void MinSSE41(const xlColor* fg, xlColor* bg, int count) {
+        MinMaxSSE41<false>(fg, bg, count);
+    }
+    TARGET_SSE41 void MaxSSE41(const xlColor* fg, xlColor* bg, int count) {
+        MinMaxSSE41<true>(fg, bg, count);
+    }
+
+    TARGET_SSE41 void AsBrightnessSSE41(const xlColor* fg, xlColor* bg, int count) {
+        const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i res[4];
+            for (int k = 0; k < 4; k++) {
+                __m128i prod = Div255(_mm_mullo_epi32(Expand(fg + i + k), Expand(bg + i + k)));
+                __m128 scale = _mm_set1_ps(ALPHA_SCALE.scale[fg[i + k].alpha]);
+                res[k] = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(prod), scale));
+            }
+            _mm_storeu_si128((__m128i*)(bg + i), _mm_or_si128(Pack4(res[0], res[1], res[2], res[3]), alphaMask));
+        }
+        MixScalar<LayerBlend::AsBrightness>(fg + i, bg + i, count - i);
+    }
+
+    TARGET_SSE41 void AverageSSE41(const xlColor* fg, xlColor* bg, int count) {
+        const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+        const __m128i zero = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i f = _mm_loadu_si128((const __m128i*)(fg + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(bg + i));
+            __m128i fBlack = _mm_cmpeq_epi32(_mm_and_si128(f, rgbMask), zero);
+            __m128i bBlack = _mm_cmpeq_epi32(_mm_and_si128(b, rgbMask), zero);
+            // (f + b) / 2 per byte without overflowing
+            __m128i avg = _mm_add_epi8(_mm_and_si128(f, b),
+                                       _mm_and_si128(_mm_srli_epi16(_mm_xor_si128(f, b), 1), _mm_set1_epi8(0x7F)));
+            __m128i out = _mm_blendv_epi8(avg, b, fBlack);
+            out = _mm_blendv_epi8(out, f, bBlack);
+            _mm_storeu_si128((__m128i*)(bg + i), out);
+        }
+        MixScalar<LayerBlend::Average>(fg + i, bg + i, count - i);
+    }
+
+    // int32 (r, g, b, a) * scale truncated back to int32, done in double like the scalar code
+    TARGET_SSE41 inline __m128i ScaleD(__m128i v, __m128d scale) {
+        __m128i lo = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(v), scale));
+        __m128i hi = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), scale));
+        return _mm_unpacklo_epi64(lo, hi);
+    }
+
+    TARGET_SSE41 void EffectMixSSE41(xlColor* fg, xlColor* bg, int count, double fgScale, double bgScale) {
+        const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+        const __m128i byteMask = _mm_set1_epi32(0xFF);
+        const __m128d fs = _mm_set1_pd(fgScale);
+        const __m128d bs = _mm_set1_pd(bgScale);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i res[4];
+            for (int k = 0; k < 4; k++) {
+                // the sum wraps at 255 the same as the uint8_t in xlColor::Set does
+                __m128i sum = _mm_add_epi32(ScaleD(Expand(fg + i + k), fs), ScaleD(Expand(bg + i + k), bs));
+                res[k] = _mm_and_si128(sum, byteMask);
+            }
+            _mm_storeu_si128((__m128i*)(bg + i), _mm_or_si128(Pack4(res[0], res[1], res[2], res[3]), alphaMask));
+        }
+        EffectMixScalar(fg + i, bg + i, count - i, fgScale, bgScale);
+    }
+
+    static const Kernels SSE41_KERNELS = {
+        AlphaBlendSSE41,
+        BrightnessSSE41,
+        AdditiveSSE41,
+        SubtractiveSSE41,
+        MinSSE41,
+        MaxSSE41,
+        AsBrightnessSSE41,
+        AverageSSE41,
+        EffectMixSSE41
+    };
+
+    //
+    // AVX2, 8 pixels at a time.  The float math is done 2 pixels per register.
+    //
+    TARGET_AVX2 inline __m256i Expand2(const xlColor* c) {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)c));
+    }
+    TARGET_AVX2 inline __m256i Pack8(__m256i p01, __m256i p23, __m256i p45, __m256i p67) {
+        // packs work within the 128bit lanes so this comes out as 0 2 4 6 1 3 5 7
+        __m256i p = _mm256_packus_epi16(_mm256_packus_epi32(p01, p23), _mm256_packus_epi32(p45, p67));
+        return _mm256_permutevar8x32_epi32(p, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+    }
+    TARGET_AVX2 inline __m256 Scale2(const xlColor* fg) {
+        float s0 = ALPHA_SCALE.scale[fg[0].alpha];
+        float s1 = ALPHA_SCALE.scale[fg[1].alpha];
+        return _mm256_setr_ps(s0, s0, s0, s0, s1, s1, s1, s1);
+    }
+    TARGET_AVX2 inline __m256i Div255(__m256i x) {
+        return _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(1)), _mm256_srli_epi32(x, 8)), 8);
+    }
+
+    TARGET_AVX2 void AlphaBlendAVX2(const xlColor* fg, xlColor* bg, int count) {
+        const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 c255 = _mm256_set1_ps(255.0f);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i res[4];
+            for (int k = 0; k < 4; k++) {
+                __m256 f = _mm256_cvtepi32_ps(Expand2(fg + i + k * 2));
+                __m256 b = _mm256_cvtepi32_ps(Expand2(bg + i + k * 2));
+                __m256 a = _mm256_div_ps(_mm256_shuffle_ps(f, f, 0xFF), c255);
+                __m256 d = _mm256_add_ps(_mm256_mul_ps(f, a), _mm256_mul_ps(b, _mm256_sub_ps(one, a)));
+                res[k] = _mm256_cvttps_epi32(d);
+            }
+            __m256i f = _mm256_loadu_si256((const __m256i*)(fg + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(bg + i));
+            __m256i alpha = _mm256_or_si256(_mm256_and_si256(b, alphaMask),
+                                            _mm256_and_si256(_mm256_cmpeq_epi8(f, _mm256_set1_epi8((char)0xFF)), alphaMask));
+            __m256i out = _mm256_or_si256(_mm256_andnot_si256(alphaMask, Pack8(res[0], res[1], res[2], res[3])), alpha);
+            _mm256_storeu_si256((__m256i*)(bg + i), out);
+        }
+        AlphaBlendScalar(fg + i, bg + i, count - i);
+    }
+
+    TARGET_AVX2 void BrightnessAVX2(xlColor* c, int count, int brightness) {
+        const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000);
+        float ba = brightness;
+        ba /= 100.0f;
+        const __m256 bav = _mm256_set1_ps(ba);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i res[4];
+            for (int k = 0; k < 4; k++) {
+                res[k] = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(Expand2(c + i + k * 2)), bav));
+            }
+            __m256i orig = _mm256_loadu_si256((const __m256i*)(c + i));
+            __m256i out = _mm256_or_si256(_mm256_andnot_si256(alphaMask, Pack8(res[0], res[1], res[2], res[3])),
+                                          _mm256_and_si256(orig, alphaMask));
+            _mm256_storeu_si256((__m256i*)(c + i), out);
+        }
+        BrightnessScalar(c + i, count - i, brightness);
+    }
+
+    TARGET_AVX2 void AdditiveAVX2(const xlColor* fg, xlColor* bg, int count) {
+        const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i f = _mm256_loadu_si256((const __m256i*)(fg + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(bg + i));
+            _mm256_storeu_si256((__m256i*)(bg + i), _mm256_or_si256(_mm256_adds_epu8(f, b), alphaMask));
+        }
+        MixScalar<LayerBlend::Additive>(fg + i, bg + i, count - i);
+    }
+
+    TARGET_AVX2 void SubtractiveAVX2(const xlColor* fg, xlColor* bg, int count) {
+        const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i f = _mm256_loadu_si256((const __m256i*)(fg + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(bg + i));
+            _mm256_storeu_si256((__m256i*)(bg + i), _mm256_or_si256(_mm256_subs_epu8(b, f), alphaMask));
+        }
+        MixScalar<LayerBlend::Subtractive>(fg + i, bg + i, count - i);
+    }
+
+    template <bool isMax>
+    TARGET_AVX2 void MinMaxAVX2(const xlColor* fg, xlColor* bg, int count) {
+        const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i f = _mm256_loadu_si256((const __m256i*)(fg + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(bg + i));
+            __m256i m = isMax ? _mm256_max_epu8(f, b) : _mm256_min_epu8(f, b);
+            __m128i lo = _mm256_castsi256_si128(m);
+            __m128i hi = _mm256_extracti128_si256(m, 1);
+            __m128i p[4] = { lo, _mm_srli_si128(lo, 8), hi, _mm_srli_si128(hi, 8) };
+            __m256i res[4];
+            for (int k = 0; k < 4; k++) {
+                __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(p[k]));
+                res[k] = _mm256_cvttps_epi32(_mm256_mul_ps(v, Scale2(fg + i + k * 2)));
+            }
+            _mm256_storeu_si256((__m256i*)(bg + i), _mm256_or_si256(Pack8(res[0], res[1], res[2], res[3]), alphaMask));
+        }
+        if (isMax) {
+            MixScalar<LayerBlend::Max>(fg + i, bg + i, count - i);
+        } else {
+            MixScalar<LayerBlend::Min>(fg + i, bg + i, count - i);
+        }
+    }
+    TARGET_AVX2 void MinAVX2(const xlColor* fg, xlColor* bg, int count) {
+        MinMaxAVX2<false>(fg, bg, count);
+    }
+    TARGET_AVX2 void MaxAVX2(const xlColor* fg, xlColor* bg, int count) {
+        MinMaxAVX2<true>(fg, bg, count);
+    }
+
+    TARGET_AVX2 void AsBrightnessAVX2(const xlColor* fg, xlColor* bg, int count) {
+        const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i res[4];
+            for (int k = 0; k < 4; k++) {
+                __m256i prod = Div255(_mm256_mullo_epi32(Expand2(fg + i + k * 2), Expand2(bg + i + k * 2)));
+                res[k] = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(prod), Scale2(fg + i + k * 2)));
+            }
+            _mm256_storeu_si256((__m256i*)(bg + i), _mm256_or_si256(Pack8(res[0], res[1], res[2], res[3]), alphaMask));
+        }
+        MixScalar<LayerBlend::AsBrightness>(fg + i, bg + i, count - i);
+    }
+
+    TARGET_AVX2 void AverageAVX2(const xlColor* fg, xlColor* bg, int count) {
+        const __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+        const __m256i zero = _mm256_setzero_si256();
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i f = _mm256_loadu_si256((const __m256i*)(fg + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(bg + i));
+            __m256i fBlack = _mm256_cmpeq_epi32(_mm256_and_si256(f, rgbMask), zero);
+            __m256i bBlack = _mm256_cmpeq_epi32(_mm256_and_si256(b, rgbMask), zero);
+            __m256i avg = _mm256_add_epi8(_mm256_and_si256(f, b),
+                                          _mm256_and_si256(_mm256_srli_epi16(_mm256_xor_si256(f, b), 1), _mm256_set1_epi8(0x7F)));
+            __m256i out = _mm256_blendv_epi8(avg, b, fBlack);
+            out = _mm256_blendv_epi8(out, f, bBlack);
+            _mm256_storeu_si256((__m256i*)(bg + i), out);
+        }
+        MixScalar<LayerBlend::Average>(fg + i, bg + i, count - i);
+    }
+
+    // one pixel (4 x int32) at a time, AVX converts 4 int32 to 4 doubles in one go
+    TARGET_AVX2 inline __m128i ScaleD4(__m128i v, __m256d scale) {
+        return _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(v), scale));
+    }
+
+    TARGET_AVX2 void EffectMixAVX2(xlColor* fg, xlColor* bg, int count, double fgScale, double bgScale) {
+        const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+        const __m128i byteMask = _mm_set1_epi32(0xFF);
+        const __m256d fs = _mm256_set1_pd(fgScale);
+        const __m256d bs = _mm256_set1_pd(bgScale);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i res[4];
+            for (int k = 0; k < 4; k++) {
+                __m128i f = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(PixelBits(fg + i + k)));
+                __m128i b = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(PixelBits(bg + i + k)));
+                res[k] = _mm_and_si128(_mm_add_epi32(ScaleD4(f, fs), ScaleD4(b, bs)), byteMask);
+            }
+            __m128i out = _mm_packus_epi16(_mm_packus_epi32(res[0], res[1]), _mm_packus_epi32(res[2], res[3]));
+            _mm_storeu_si128((__m128i*)(bg + i), _mm_or_si128(out, alphaMask));
+        }
+        EffectMixScalar(fg + i, bg + i, count - i, fgScale, bgScale);
+    }
+
+    static const Kernels AVX2_KERNELS = {
+        AlphaBlendAVX2,
+        BrightnessAVX2,
+        AdditiveAVX2,
+        SubtractiveAVX2,
+        MinAVX2,
+        MaxAVX2,
+        AsBrightnessAVX2,
+        AverageAVX2,
+        EffectMixAVX2
+    };
+#endif
+
+    LayerBlend::ISA DetectISA() {
+#ifdef LAYERBLEND_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+        __cpuid(info, 1);
+        bool sse41 = (info[2] & (1 << 19)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        bool sse41 = __builtin_cpu_supports("sse4.1");
+        bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+        if (avx2) {
+            return LayerBlend::ISA::AVX2;
+        }
+        if (sse41) {
+            return LayerBlend::ISA::SSE41;
+        }
+#endif
+        return LayerBlend::ISA::SCALAR;
+    }
+
+    const LayerBlend::ISA BEST_ISA = DetectISA();
+    std::atomic<LayerBlend::ISA> activeISA(BEST_ISA);
+
+    const Kernels& GetKernels() {
+#ifdef LAYERBLEND_X86
+        switch (activeISA.load(std::memory_order_relaxed)) {
+        case LayerBlend::ISA::AVX2:
+            return AVX2_KERNELS;
+        case LayerBlend::ISA::SSE41:
+            return SSE41_KERNELS;
+        default:
+            break;
+        }
+#endif
+        return SCALAR_KERNELS;
+    }
+}
+
+LayerBlend::ISA LayerBlend::GetISA() {
+    return activeISA;
+}
+
+LayerBlend::ISA LayerBlend::GetBestISA() {
+    return BEST_ISA;
+}
+
+void LayerBlend::SetISA(ISA isa) {
+    activeISA = std::min(isa, BEST_ISA);
+}
+
+const char* LayerBlend::GetISAName(ISA isa) {
+    switch (isa) {
+    case ISA::AVX2:
+        return "AVX2";
+    case ISA::SSE41:
+        return "SSE4.1";
+    default:
+        return "Scalar";
+    }
+}
+
+bool LayerBlend::SupportsMixType(MixTypes mixType) {
+    switch (mixType) {
+    case MixTypes::Mix_Normal:
+    case MixTypes::Mix_Effect1:
+    case MixTypes::Mix_Effect2:
+    case MixTypes::Mix_Average:
+    case MixTypes::Mix_Additive:
+    case MixTypes::Mix_Subtractive:
+    case MixTypes::Mix_Min:
+    case MixTypes::Mix_Max:
+    case MixTypes::Mix_AsBrightness:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool LayerBlend::MixRow(MixTypes mixType, double fadeFactor, float effectMixThreshold, bool effectMixVaries,
+                        xlColor* fg, xlColor* bg, int count) {
+    const Kernels& kernels = GetKernels();
+    switch (mixType) {
+    case MixTypes::Mix_Normal:
+        if (fadeFactor != 1.0 || effectMixThreshold != 0.0f) {
+            for (int i = 0; i < count; i++) {
+                fg[i].alpha = NormalAlpha(fg[i].alpha, fadeFactor, effectMixThreshold);
+            }
+        }
+        kernels.alphaBlend(fg, bg, count);
+        return true;
+    case MixTypes::Mix_Effect1:
+    case MixTypes::Mix_Effect2: {
+        double emt, emtNot;
+        EffectMixFactors(effectMixThreshold, effectMixVaries, emt, emtNot);
+        if (mixType == MixTypes::Mix_Effect2) {
+            kernels.effectMix(fg, bg, count, emtNot, emt);
+        } else {
+            kernels.effectMix(fg, bg, count, emt, emtNot);
+        }
+        return true;
+    }
+    case MixTypes::Mix_Average:
+        kernels.average(fg, bg, count);
+        return true;
+    case MixTypes::Mix_Additive:
+        kernels.additive(fg, bg, count);
+        return true;
+    case MixTypes::Mix_Subtractive:
+        kernels.subtractive(fg, bg, count);
+        return true;
+    case MixTypes::Mix_Min:
+        kernels.min(fg, bg, count);
+        return true;
+    case MixTypes::Mix_Max:
+        kernels.max(fg, bg, count);
+        return true;
+    case MixTypes::Mix_AsBrightness:
+        kernels.asBrightness(fg, bg, count);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void LayerBlend::AlphaBlendRow(const xlColor* fg, xlColor* bg, int count) {
+    GetKernels().alphaBlend(fg, bg, count);
+}
+
+void LayerBlend::BrightnessRow(xlColor* c, int count, int brightness) {
+    if (brightness < 0) {
+        // the scalar code wraps negative values, not worth doing that in the SIMD code
+        BrightnessScalar(c, count, brightness);
+        return;
+    }
+    GetKernels().brightness(c, count, brightness);
+}
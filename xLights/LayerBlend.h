@@ -0,0 +1,157 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "Color.h"
+
+enum class MixTypes;
+
+/**
+ * Row at a time versions of the layer blending done by PixelBufferClass::CalcOutput.
+ *
+ * The per pixel functions below are the reference implementation and are what
+ * PixelBufferClass::mixColors uses.  The row functions produce bit identical
+ * results but use SSE4.1 or AVX2 when the CPU supports it (selected at runtime,
+ * 64bit x86 only), otherwise they just loop over the per pixel functions.
+ */
+class LayerBlend
+{
+public:
+    enum class ISA {
+        SCALAR,
+        SSE41,
+        AVX2
+    };
+
+    // the instruction set the row functions are currently using
+    static ISA GetISA();
+    // the best instruction set this CPU supports
+    static ISA GetBestISA();
+    // force a particular instruction set (clamped to what is supported), mostly for testing
+    static void SetISA(ISA isa);
+    static const char* GetISAName(ISA isa);
+
+    // true if MixRow can handle the mix type
+    static bool SupportsMixType(MixTypes mixType);
+
+    // bg[i] = mix of fg[i] onto bg[i].  Returns false if the mix type is not one
+    // that can be done a row at a time, in which case nothing is touched.  fg is
+    // used as scratch space.
+    static bool MixRow(MixTypes mixType, double fadeFactor, float effectMixThreshold, bool effectMixVaries,
+                       xlColor* fg, xlColor* bg, int count);
+
+    // bg[i].AlphaBlendForgroundOnto(fg[i])
+    static void AlphaBlendRow(const xlColor* fg, xlColor* bg, int count);
+
+    // apply a brightness (percent) to each color, leaves alpha alone
+    static void BrightnessRow(xlColor* c, int count, int brightness);
+
+    //
+    // Per pixel reference implementations
+    //
+    static uint8_t NormalAlpha(uint8_t alpha, double fadeFactor, float effectMixThreshold) {
+        return alpha * fadeFactor * (1.0 - effectMixThreshold);
+    }
+
+    static void EffectMixFactors(float effectMixThreshold, bool effectMixVaries, double& emt, double& emtNot) {
+        static const int n = 0; //increase to change the curve of the crossfade
+        if (!effectMixVaries) {
+            emt = effectMixThreshold;
+            if ((emt > 0.000001) && (emt < 0.99999)) {
+                emtNot = 1 - effectMixThreshold;
+                //make cross-fade linear
+                emt = cos((M_PI / 4) * (pow(2 * emt - 1, 2 * n + 1) + 1));
+                emtNot = cos((M_PI / 4) * (pow(2 * emtNot - 1, 2 * n + 1) + 1));
+            } else {
+                emtNot = effectMixThreshold;
+                emt = 1 - effectMixThreshold;
+            }
+        } else {
+            emt = effectMixThreshold;
+            emtNot = 1 - effectMixThreshold;
+        }
+    }
+
+    // Effect1 passes (emt, emtNot), Effect2 passes (emtNot, emt)
+    static void EffectMix(xlColor& fg, xlColor& bg, double fgScale, double bgScale) {
+        fg.Set(fg.Red() * fgScale, fg.Green() * fgScale, fg.Blue() * fgScale);
+        bg.Set(bg.Red() * bgScale, bg.Green() * bgScale, bg.Blue() * bgScale);
+        bg.Set(fg.Red() + bg.Red(), fg.Green() + bg.Green(), fg.Blue() + bg.Blue());
+    }
+
+    static void Average(const xlColor& fg, xlColor& bg) {
+        // only average when both colors are non-black
+        if (bg == xlBLACK) {
+            bg = fg;
+        } else if (fg != xlBLACK) {
+            bg.Set((fg.Red() + bg.Red()) / 2, (fg.Green() + bg.Green()) / 2, (fg.Blue() + bg.Blue()) / 2, (fg.alpha + bg.alpha) / 2);
+        }
+    }
+
+    static void Additive(const xlColor& fg, xlColor& bg) {
+        int r = fg.red + bg.red;
+        int g = fg.green + bg.green;
+        int b = fg.blue + bg.blue;
+        if (r > 255) r = 255;
+        if (g > 255) g = 255;
+        if (b > 255) b = 255;
+        bg.Set(r, g, b);
+    }
+
+    static void Subtractive(const xlColor& fg, xlColor& bg) {
+        int r = bg.red - fg.red;
+        int g = bg.green - fg.green;
+        int b = bg.blue - fg.blue;
+        if (r < 0) r = 0;
+        if (g < 0) g = 0;
+        if (b < 0) b = 0;
+        bg.Set(r, g, b);
+    }
+
+    static void Min(const xlColor& fg, xlColor& bg) {
+        float alpha = (float)fg.alpha / 255.0;
+        int r = std::min(fg.red, bg.red) * alpha;
+        int g = std::min(fg.green, bg.green) * alpha;
+        int b = std::min(fg.blue, bg.blue) * alpha;
+        bg.Set(r, g, b);
+    }
+
+    static void Max(const xlColor& fg, xlColor& bg) {
+        float alpha = (float)fg.alpha / 255.0;
+        int r = std::max(fg.red, bg.red) * alpha;
+        int g = std::max(fg.green, bg.green) * alpha;
+        int b = std::max(fg.blue, bg.blue) * alpha;
+        bg.Set(r, g, b);
+    }
+
+    static void AsBrightness(const xlColor& fg, xlColor& bg) {
+        float alpha = (float)fg.alpha / 255.0;
+        int r = fg.red * bg.red / 255 * alpha;
+        int g = fg.green * bg.green / 255 * alpha;
+        int b = fg.blue * bg.blue / 255 * alpha;
+        bg.Set(r, g, b);
+    }
+
+    static void Brightness(xlColor& color, int brightness) {
+        float ba = brightness;
+        ba /= 100.0f;
+        float f = color.red * ba;
+        color.red = std::min((int)f, 255);
+        f = color.green * ba;
+        color.green = std::min((int)f, 255);
+        f = color.blue * ba;
+        color.blue = std::min((int)f, 255);
+    }
+};
@@ -0,0 +1,160 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <algorithm>
+
+#include "LayerFrameCache.h"
+#include "RenderBuffer.h"
+
+std::atomic<uint32_t> LayerFrameCache::__epoch(1);
+std::atomic<size_t> LayerFrameCache::__totalBytes(0);
+std::atomic<size_t> LayerFrameCache::__maximumBytes((size_t)1024 * 1024 * 1024);
+
+LayerFrameCache::~LayerFrameCache()
+{
+    Clear();
+}
+
+void LayerFrameCache::InvalidateAll()
+{
+    ++__epoch;
+}
+
+void LayerFrameCache::SetMaximumSizeMB(size_t mb)
+{
+    __maximumBytes = mb * 1024 * 1024;
+}
+
+void LayerFrameCache::ClearFrame(Frame& frame)
+{
+    __totalBytes -= frame.pixels.size() * sizeof(xlColor);
+    std::vector<xlColor>().swap(frame.pixels);
+    frame.cached = false;
+    frame.valid = false;
+}
+
+void LayerFrameCache::Clear()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    ++_generation;
+    for (auto& f : _frames) {
+        ClearFrame(f);
+    }
+    _frames.clear();
+}
+
+void LayerFrameCache::Invalidate(int startMS, int endMS)
+{
+    if (startMS < 0 || endMS < 0) {
+        Clear();
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_lock);
+    ++_generation;
+    if (_frameTimeMS <= 0) {
+        return;
+    }
+    int start = startMS / _frameTimeMS;
+    int end = endMS / _frameTimeMS;
+    for (int f = std::max(start, 0); f <= end && f < (int)_frames.size(); ++f) {
+        ClearFrame(_frames[f]);
+    }
+}
+
+void LayerFrameCache::InvalidateFrames(int startFrame, int endFrame)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    ++_generation;
+    for (int f = std::max(startFrame, 0); f <= endFrame && f < (int)_frames.size(); ++f) {
+        ClearFrame(_frames[f]);
+    }
+}
+
+void LayerFrameCache::Prepare(int frameTimeMS)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    if (_frameTimeMS != frameTimeMS || _epoch != __epoch) {
+        ++_generation;
+        for (auto& f : _frames) {
+            ClearFrame(f);
+        }
+        _frames.clear();
+        _frameTimeMS = frameTimeMS;
+        _epoch = __epoch;
+    }
+}
+
+bool LayerFrameCache::HasFrames(int startFrame, int endFrame, int width, int height)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    if (startFrame < 0 || endFrame >= (int)_frames.size() || _epoch != __epoch) {
+        return false;
+    }
+    for (int f = startFrame; f <= endFrame; ++f) {
+        const Frame& frame = _frames[f];
+        if (!frame.cached || (frame.valid && (frame.width != width || frame.height != height))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LayerFrameCache::Get(int frame, RenderBuffer& buffer, bool& valid)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    if (frame < 0 || frame >= (int)_frames.size() || !_frames[frame].cached || _epoch != __epoch) {
+        return false;
+    }
+    const Frame& f = _frames[frame];
+    if (f.valid) {
+        if (f.width != buffer.BufferWi || f.height != buffer.BufferHt || f.pixels.size() != buffer.GetPixelCount()) {
+            return false;
+        }
+        std::copy(f.pixels.begin(), f.pixels.end(), buffer.GetPixels());
+    }
+    valid = f.valid;
+    return true;
+}
+
+void LayerFrameCache::Put(int frame, RenderBuffer& buffer, bool valid, uint32_t generation)
+{
+    if (frame < 0) {
+        return;
+    }
+    size_t count = valid ? buffer.GetPixelCount() : 0;
+    if (valid && count == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_lock);
+    if (generation != _generation) {
+        // the layer was edited while the frame was being rendered
+        return;
+    }
+    if (frame >= (int)_frames.size()) {
+        _frames.resize(frame + 1);
+    }
+    Frame& f = _frames[frame];
+    ClearFrame(f);
+    if (count > 0) {
+        // reserve the memory in one step, other threads are putting frames in their own caches
+        size_t bytes = count * sizeof(xlColor);
+        size_t total = __totalBytes;
+        do {
+            if (total + bytes > __maximumBytes) {
+                return;
+            }
+        } while (!__totalBytes.compare_exchange_weak(total, total + bytes));
+        f.pixels.assign(buffer.GetPixels(), buffer.GetPixels() + count);
+        f.width = buffer.BufferWi;
+        f.height = buffer.BufferHt;
+    }
+    f.valid = valid;
+    f.cached = true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Color.h"
+
+class RenderBuffer;
+
+/**
+ * The rendered output of one effect layer, a frame at a time.
+ *
+ * The cache belongs to the EffectLayer so it survives from one render to the
+ * next and is handed to PixelBufferClass::LayerInfo while rendering.  Edits to
+ * the layer invalidate the frames they cover, so when one layer of a model is
+ * changed the model's other layers are restored from here rather than being
+ * re-rendered and only the blending of the layers has to be redone.
+ *
+ * All the caches share a memory limit, once it is reached frames are simply not
+ * kept which just means those frames are rendered next time.
+ */
+class LayerFrameCache
+{
+public:
+    LayerFrameCache() {}
+    ~LayerFrameCache();
+
+    // forget the frames that render startMS to endMS, startMS < 0 forgets everything
+    void Invalidate(int startMS, int endMS);
+    void InvalidateFrames(int startFrame, int endFrame);
+    void Clear();
+
+    // called before rendering, clears the cache if it was filled at a different
+    // frame time or before InvalidateAll was called
+    void Prepare(int frameTimeMS);
+
+    // bumped by every invalidation, frames rendered before it changed are not kept
+    uint32_t GetGeneration() const { return _generation; }
+
+    // true if every frame from startFrame to endFrame can be restored to a width x height buffer
+    bool HasFrames(int startFrame, int endFrame, int width, int height);
+    // copies the frame into the buffer, valid is set to whether the layer produced any output
+    bool Get(int frame, RenderBuffer& buffer, bool& valid);
+    void Put(int frame, RenderBuffer& buffer, bool valid, uint32_t generation);
+
+    // forget the frames in every cache, used when something other than the effects has changed
+    static void InvalidateAll();
+    static void SetMaximumSizeMB(size_t mb);
+    static size_t GetSizeBytes() { return __totalBytes; }
+
+private:
+    struct Frame {
+        bool cached = false;
+        bool valid = false;
+        int width = 0;
+        int height = 0;
+        std::vector<xlColor> pixels;
+    };
+
+    void ClearFrame(Frame& frame);
+
+    std::mutex _lock;
+    std::vector<Frame> _frames;
+    int _frameTimeMS = 0;
+    uint32_t _epoch = 0;
+    std::atomic<uint32_t> _generation = 0;
+
+    static std::atomic<uint32_t> __epoch;
+    static std::atomic<size_t> __totalBytes;
+    static std::atomic<size_t> __maximumBytes;
+};
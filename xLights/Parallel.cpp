@@ -10,30 +10,274 @@
 //  Created by Daniel Kulp on 8/2/18.
 //  Copyright © 2018 Daniel Kulp. All rights reserved.
 
+// needed to ensure the __WXMSW__ is defined
+#include <wx/wx.h>
+
 #include "Parallel.h"
 #include <thread>
 #include <algorithm>
+#include <deque>
+#include <sstream>
+#include <iomanip>
+
+#include "../common/xlBaseApp.h"
+#include "ExternalHooks.h"
+
+#ifdef LINUX
+    #include <X11/Xlib.h>
+#endif
+
+#include <log4cpp/Category.hh>
 
-#include "JobPool.h"
+void ParallelTask::Execute() {
+    try {
+        Process();
+    } catch (...) {
+        //nothing
+    }
+    // the owner may destroy the task as soon as the last one completes so this
+    // must be the last thing that touches it
+    std::unique_lock<std::mutex> locker(lock);
+    if (++doneCount >= total) {
+        signal.notify_all();
+    }
+}
+
+void ParallelTask::WaitForCompletion() {
+    std::unique_lock<std::mutex> locker(lock);
+    signal.wait(locker, [this]() { return doneCount >= total; });
+}
+
+
+class ParallelJobPoolWorker {
+public:
+    enum STATUS_TYPE {
+        STARTING,
+        IDLE,
+        RUNNING_JOB,
+        STOPPED
+    };
 
-ParallelJobPool::ParallelJobPool(const std::string &name) : JobPool(name) {
+    ParallelJobPoolWorker(ParallelJobPool *p, int idx) : pool(p), index(idx), status(STARTING), thread(nullptr) {}
+    ~ParallelJobPoolWorker() {
+        Join();
+        delete thread;
+    }
+
+    void Join() {
+        if (thread != nullptr && thread->joinable()) {
+            thread->join();
+        }
+    }
+
+    void Start() {
+        thread = new std::thread(&ParallelJobPoolWorker::StartFunc, this);
+    }
+
+    void Push(ParallelTask *task, int count) {
+        std::unique_lock<std::mutex> locker(lock);
+        for (int x = 0; x < count; x++) {
+            queue.push_back(task);
+        }
+    }
+    // the owning thread works LIFO off the back, most likely to still be in cache
+    ParallelTask *PopBack() {
+        std::unique_lock<std::mutex> locker(lock);
+        if (queue.empty()) {
+            return nullptr;
+        }
+        ParallelTask *t = queue.back();
+        queue.pop_back();
+        return t;
+    }
+    // thieves take the oldest work from the front
+    ParallelTask *PopFront() {
+        std::unique_lock<std::mutex> locker(lock);
+        if (queue.empty()) {
+            return nullptr;
+        }
+        ParallelTask *t = queue.front();
+        queue.pop_front();
+        return t;
+    }
+    size_t QueueSize() {
+        std::unique_lock<std::mutex> locker(lock);
+        return queue.size();
+    }
+
+    std::string GetStatus();
+
+    ParallelJobPool * const pool;
+    const int index;
+    std::atomic<STATUS_TYPE> status;
+
+private:
+    void StartFunc();
+    void Entry();
+
+    std::mutex lock;
+    std::deque<ParallelTask*> queue;
+    std::thread *thread;
+};
+
+static thread_local ParallelJobPoolWorker *currentWorker = nullptr;
+
+#ifndef __WXMSW__
+static void SetThreadName(const std::string &name) {
+#ifdef __WXOSX__
+    pthread_setname_np(name.c_str());
+#else
+    pthread_setname_np(pthread_self(), name.c_str());
+#endif
+}
+#else
+static void SetThreadName(const std::string &name) {}
+#endif
+
+void ParallelJobPoolWorker::StartFunc() {
+    try {
+        xlCrashHandler::SetupCrashHandlerForNonWxThread();
+#ifdef LINUX
+        XInitThreads();
+#endif
+        Entry();
+    } catch (...) {
+        wxTheApp->OnUnhandledException();
+    }
+}
+
+void ParallelJobPoolWorker::Entry() {
+    static log4cpp::Category &logger_jobpool = log4cpp::Category::getInstance(std::string("log_jobpool"));
+    logger_jobpool.debug("ParallelJobPoolWorker %d started", index);
+
+    currentWorker = this;
+    SetThreadName(pool->threadNameBase);
+    SetThreadQOS(10);
+    while (!pool->stopped) {
+        status = IDLE;
+        ParallelTask *task = PopBack();
+        if (task == nullptr) {
+            task = pool->Steal(index + 1);
+        }
+        if (task != nullptr) {
+            --pool->pending;
+            status = RUNNING_JOB;
+            RunInAutoReleasePool([task]() { task->Execute(); });
+            status = IDLE;
+            continue;
+        }
+        // parallel_for calls tend to come in bursts (one per frame/layer), spin
+        // briefly before going to sleep to avoid the wakeup latency
+        bool found = false;
+        for (int x = 0; x < 32 && !found; x++) {
+            std::this_thread::yield();
+            found = pool->pending > 0;
+        }
+        if (!found) {
+            pool->Sleep(this);
+        }
+    }
+    status = STOPPED;
+    currentWorker = nullptr;
+    logger_jobpool.debug("ParallelJobPoolWorker %d exiting", index);
+}
+
+std::string ParallelJobPoolWorker::GetStatus() {
+    std::stringstream ret;
+    ret << "Thread: ";
+    ret << std::showbase // show the 0x prefix
+        << std::internal // fill between the prefix and the number
+        << std::setfill('0') << std::setw(10)
+        << std::hex << (thread ? thread->get_id() : std::thread::id())
+        << "    " << std::dec;
+    ret << pool->threadNameBase << " - ";
+    switch (status) {
+    case STARTING:
+        ret << "<starting>";
+        break;
+    case IDLE:
+        ret << "<idle>";
+        break;
+    case RUNNING_JOB:
+        ret << "<running job>";
+        break;
+    case STOPPED:
+        ret << "<stopped>";
+        break;
+    }
+    ret << "  queued: " << QueueSize();
+    return ret.str();
+}
+
+
+ParallelJobPool::ParallelJobPool(const std::string &name) :
+    numWorkers(0), sleepers(0), pending(0), nextQueue(0), stopped(false), threadNameBase(name) {
+    workers.fill(nullptr);
     unsigned c = std::thread::hardware_concurrency() - 1; //1 thread is the calling thread
-    if (c < 4) {
-        c = 4;
+    if (c < MIN_THREADS) {
+        c = MIN_THREADS;
+    }
+    SetMaxThreadCount(c);
+}
+
+ParallelJobPool::~ParallelJobPool() {
+    Stop();
+}
+
+void ParallelJobPool::SetMaxThreadCount(int maxThreads) {
+    // workers are created lazily so raising the count just lets more start, lowering
+    // it leaves the existing ones running but limits how finely work is split up
+    maxNumThreads = std::clamp(maxThreads, MIN_THREADS, MAX_THREADS);
+}
+
+void ParallelJobPool::StartWorkers() {
+    std::unique_lock<std::mutex> locker(threadLock);
+    if (stopped) {
+        return;
+    }
+    static log4cpp::Category &logger_jobpool = log4cpp::Category::getInstance(std::string("log_jobpool"));
+    int cur = numWorkers;
+    while (cur < maxNumThreads) {
+        ParallelJobPoolWorker *w = new ParallelJobPoolWorker(this, cur);
+        workers[cur] = w;
+        ++cur;
+        // publish the worker before it can be seen by the stealers
+        numWorkers = cur;
+        w->Start();
+    }
+    logger_jobpool.info("Parallel thread pool %s started with %d threads", threadNameBase.c_str(), cur);
+}
+
+void ParallelJobPool::Stop() {
+    std::unique_lock<std::mutex> locker(threadLock);
+    stopped = true;
+    {
+        std::unique_lock<std::mutex> sl(sleepLock);
+        sleepSignal.notify_all();
+    }
+    int n = numWorkers;
+    numWorkers = 0;
+    // the workers can still be stealing from each other until they have all exited
+    // so none can be deleted until every one of them has been joined
+    for (int x = 0; x < n; x++) {
+        workers[x]->Join();
+    }
+    for (int x = 0; x < n; x++) {
+        delete workers[x];
+        workers[x] = nullptr;
     }
-    Start(c, c);
 }
 
 int ParallelJobPool::calcSteps(int minStep, int total) {
     if (minStep > 0) {
         int calcSteps = total / minStep;
-        if (calcSteps > ParallelJobPool::maxSize()) {
-            calcSteps = ParallelJobPool::maxSize();
-            int i = inFlight;
+        if (calcSteps > maxSize()) {
+            calcSteps = maxSize();
+            int i = pending;
             // LOTS of things using the parallel pool to a point where
-            // the queue is long and we're wasting time/locks managing the queue.
+            // the queues are long and we're just adding overhead splitting things up.
             // In that case, we split into larger blocks.  Still in parallel,
-            // but fewer so the existing queue can be reduced
+            // but fewer so the existing queues can be reduced
             if (i > (maxNumThreads * 4)) {
                 calcSteps = 2;
             } else if (i > (maxNumThreads * 2)) {
@@ -48,50 +292,127 @@ int ParallelJobPool::calcSteps(int minStep, int total) {
     return 1;
 }
 
+bool ParallelJobPool::Push(ParallelTask *task, int count) {
+    if (numWorkers < maxNumThreads) {
+        StartWorkers();
+    }
+    int n = numWorkers;
+    if (n == 0) {
+        // pool is stopped, the caller will have to do it all
+        return false;
+    }
+    pending += count;
+    if (currentWorker != nullptr && currentWorker->pool == this) {
+        // nested call from one of our own workers, keep it local, the idle workers will steal it
+        currentWorker->Push(task, count);
+    } else {
+        // external thread (render jobs, UI), spread across the workers so
+        // the callers don't all contend on the same queue lock
+        for (int x = 0; x < count; x++) {
+            workers[nextQueue++ % n]->Push(task, 1);
+        }
+    }
+    if (sleepers > 0) {
+        std::unique_lock<std::mutex> locker(sleepLock);
+        if (count > 1) {
+            sleepSignal.notify_all();
+        } else {
+            sleepSignal.notify_one();
+        }
+    }
+    return true;
+}
+
+ParallelTask *ParallelJobPool::Steal(unsigned int startIdx) {
+    if (pending <= 0) {
+        return nullptr;
+    }
+    // unsigned so the index stays in range once nextQueue has passed INT_MAX
+    unsigned int n = numWorkers;
+    for (unsigned int x = 0; x < n; x++) {
+        ParallelJobPoolWorker *w = workers[(startIdx + x) % n];
+        if (w != nullptr) {
+            ParallelTask *t = w->PopFront();
+            if (t != nullptr) {
+                return t;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void ParallelJobPool::Sleep(ParallelJobPoolWorker *worker) {
+    std::unique_lock<std::mutex> locker(sleepLock);
+    ++sleepers;
+    sleepSignal.wait(locker, [this]() { return pending > 0 || stopped; });
+    --sleepers;
+}
+
+void ParallelJobPool::Run(ParallelTask *task, int count) {
+    task->total = count;
+    task->doneCount = 0;
+    if (count <= 1 || !Push(task, count - 1)) {
+        task->total = 1;
+    }
+    task->Execute();
+
+    // rather than sleep while the others finish up, help out
+    ParallelJobPoolWorker *self = (currentWorker != nullptr && currentWorker->pool == this) ? currentWorker : nullptr;
+    while (task->doneCount < task->total) {
+        ParallelTask *t = self ? self->PopBack() : nullptr;
+        if (t == nullptr) {
+            t = Steal(self ? self->index + 1 : nextQueue.load());
+        }
+        if (t == nullptr) {
+            // nothing left queued, anything of ours still outstanding is running elsewhere
+            break;
+        }
+        --pending;
+        t->Execute();
+    }
+    task->WaitForCompletion();
+}
+
+std::string ParallelJobPool::GetThreadStatus() {
+    std::stringstream ret;
+    ret << "\n";
+    std::unique_lock<std::mutex> locker(threadLock);
+    int n = numWorkers;
+    for (int x = 0; x < n; x++) {
+        ret << workers[x]->GetStatus();
+        ret << "\n";
+    }
+    return ret.str();
+}
+
 ParallelJobPool ParallelJobPool::POOL("parallel_tasks");
 
 
-class ParallelJob : public Job {
-    int max;
+class ParallelForTask : public ParallelTask {
+    const int max;
     std::function<void(int)>& func;
-    std::atomic_int &doneCount;
-    std::atomic_int &iteration;
-    const int calcSteps;
+    std::atomic_int iteration;
     const int blockSize;
 public:
-    ParallelJob(int m, std::function<void(int)>& f,
-                std::atomic_int &dc,
-                std::atomic_int &it,
-                int cs,
-                int bs)
-        : max(m), func(f), iteration(it), doneCount(dc), calcSteps(cs), blockSize(bs) {}
-    virtual ~ParallelJob() {};
+    ParallelForTask(int mn, int m, std::function<void(int)>& f, int bs)
+        : ParallelTask(), max(m), func(f), iteration(mn), blockSize(bs) {}
+    virtual ~ParallelForTask() {};
     virtual void Process() override {
-        try {
-            int x;
-            if (blockSize > 1) {
-                while ((x = iteration.fetch_add(blockSize, std::memory_order_relaxed)) < max) {
-                    int newM = std::min(x + blockSize, max);
-                    while (x < newM) {
-                        func(x);
-                        x++;
-                    }
-                }
-            } else {
-                while ((x = iteration.fetch_add(1, std::memory_order_relaxed)) < max) {
+        int x;
+        if (blockSize > 1) {
+            while ((x = iteration.fetch_add(blockSize, std::memory_order_relaxed)) < max) {
+                int newM = std::min(x + blockSize, max);
+                while (x < newM) {
                     func(x);
+                    x++;
                 }
             }
-        } catch (...) {
-            //nothing
-        }
-        int newDoneCount = ++doneCount;
-        if (newDoneCount >= calcSteps) {
-            ParallelJobPool::POOL.poolSignal.notify_all();
+        } else {
+            while ((x = iteration.fetch_add(1, std::memory_order_relaxed)) < max) {
+                func(x);
+            }
         }
     };
-    virtual bool DeleteWhenComplete() override { return true; };
-    virtual bool SetThreadName() override { return false; }
 };
 
 void parallel_for(int min, int max, std::function<void(int)>&& func, int minStep, ParallelJobPool *pool) {
@@ -101,24 +422,11 @@ void parallel_for(int min, int max, std::function<void(int)>&& func, int minStep
             func(x);
         }
     } else {
-        std::function<void(int)> f(func);
-        std::atomic_int doneCount = 0;
-        std::atomic_int iteration(min);
-        
         // do about 5% at a time, reduces contention on the atomic_int yet keeps unit of
         // work small enough to allow work stealing for faster cores/threads
         int blockSize = (max - min) / (calcSteps * 20);
         if (blockSize < 1) blockSize = 1;
-        std::list<Job*> jobs;
-        for (int x = 0; x < calcSteps-1; x++) {
-            jobs.push_back(new ParallelJob(max, f, doneCount, iteration, calcSteps, blockSize));
-        }
-        pool->PushJobs(jobs);
-        ParallelJob(max, f, doneCount, iteration, calcSteps, blockSize).Process();
-        std::unique_lock<std::mutex> lock(pool->poolLock);
-        while (doneCount < calcSteps) {
-            pool->poolSignal.wait_for(lock, std::chrono::nanoseconds(1000000));
-        }
+        ParallelForTask task(min, max, func, blockSize);
+        pool->Run(&task, calcSteps);
     }
 }
-
@@ -10,25 +10,94 @@
  * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
  **************************************************************/
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <list>
 #include <mutex>
+#include <string>
 #include <thread>
 
-#include "JobPool.h"
 
+/**
+ * A unit of work handed to the ParallelJobPool.  The same task object is queued
+ * several times and Process() is called concurrently from each thread that picks
+ * it up, so Process() must pull its work from shared (atomic) state.
+ * Tasks are owned by the caller and must outlive ParallelJobPool::Run.
+ */
+class ParallelTask {
+public:
+    ParallelTask() {}
+    virtual ~ParallelTask() {}
+    virtual void Process() = 0;
+
+private:
+    friend class ParallelJobPool;
+    friend class ParallelJobPoolWorker;
+    void Execute();
+    void WaitForCompletion();
+
+    std::atomic_int doneCount = 0;
+    int total = 0;
+    std::mutex lock;
+    std::condition_variable signal;
+};
+
+
+class ParallelJobPoolWorker;
+
+/**
+ * Work stealing pool used by parallel_for.  Each worker thread owns its own deque,
+ * tasks queued from a worker go onto that worker's deque (LIFO for the owner), idle
+ * workers steal from the other end of their siblings' deques.  The thread calling
+ * Run participates in the work instead of sleeping/yielding until it's done.
+ */
+class ParallelJobPool {
+    static constexpr int MAX_THREADS = 250;
+    static constexpr int MIN_THREADS = 4;
+
+    std::array<ParallelJobPoolWorker*, MAX_THREADS> workers;
+    std::atomic_int numWorkers;
+    std::mutex threadLock;
+
+    std::mutex sleepLock;
+    std::condition_variable sleepSignal;
+    std::atomic_int sleepers;
+    std::atomic_int pending;
+    std::atomic_uint nextQueue;
+    std::atomic_bool stopped;
+
+    std::string threadNameBase;
+    int maxNumThreads;
 
-class ParallelJobPool : public JobPool {
 public:
     ParallelJobPool(const std::string &name);
-    
+    ~ParallelJobPool();
+
     static ParallelJobPool POOL;
-    
+
     int calcSteps(int minStep, int size);
     static void SetPJPMaxThreadCount(int maxThreads) { POOL.SetMaxThreadCount(maxThreads); }
-    
-    std::mutex poolLock;
-    std::condition_variable poolSignal;
+    void SetMaxThreadCount(int maxThreads);
+
+    int size() const { return numWorkers; }
+    int maxSize() const { return maxNumThreads; }
+    int queued() const { return pending; }
+
+    // Queues "count" invocations of task->Process(), runs one on the calling
+    // thread and helps with the rest until every invocation has completed
+    void Run(ParallelTask *task, int count);
+
+    void Stop();
+    std::string GetThreadStatus();
+
+private:
+    friend class ParallelJobPoolWorker;
+    bool Push(ParallelTask *task, int count);
+    void StartWorkers();
+    ParallelTask *Steal(unsigned int startIdx);
+    void Sleep(ParallelJobPoolWorker *worker);
 };
 
 
@@ -55,44 +124,30 @@ void parallel_for(int start, int max, std::function<void(int)>&& f, int minStep
  */
 template <typename T>
 void parallel_for(std::list<T> &list, std::function<void(T&, int)>& f, int minStep = 1) {
-    class ParallelListJob : public Job {
-        std::atomic_int &doneCount;
+    class ParallelListTask : public ParallelTask {
         std::function<void(T&, int)>& func;
-        std::mutex &lock;
-        std::atomic_int &index;
-        typename std::list<T>::iterator &iterator;
+        std::mutex lock;
+        int index = 0;
+        typename std::list<T>::iterator iterator;
         const int max;
     public:
-        ParallelListJob(std::atomic_int &dc,
-                        std::function<void(T&, int)>& f,
-                        typename std::list<T>::iterator &it,
-                        std::mutex &l,
-                        std::atomic_int &idx,
-                        int m)
-            : Job(), doneCount(dc), func(f), iterator(it), lock(l), index(idx), max(m) {}
-        void Process() {
-            try {
-                while (true) {
-                    lock.lock();
-                    int idx = index.fetch_add(1);
-                    if (idx < max) {
-                        T &t = *iterator;
-                        ++iterator;
-                        lock.unlock();
-                        func(t, idx);
-                    } else {
-                        lock.unlock();
-                        doneCount++;
-                        return;
-                    }
+        ParallelListTask(std::function<void(T&, int)>& f, std::list<T> &l)
+            : ParallelTask(), func(f), iterator(l.begin()), max(l.size()) {}
+        virtual void Process() override {
+            while (true) {
+                std::unique_lock<std::mutex> locker(lock);
+                int idx = index++;
+                if (idx >= max) {
+                    return;
                 }
-            } catch (...) {
-                //nothing
-                doneCount++;
+                T &t = *iterator;
+                ++iterator;
+                locker.unlock();
+                func(t, idx);
             }
         }
     };
-    
+
     int size = list.size();
     int calcSteps = ParallelJobPool::POOL.calcSteps(minStep, size);
     if (calcSteps == 1) {
@@ -102,18 +157,7 @@ void parallel_for(std::list<T> &list, std::function<void(T&, int)>& f, int minSt
             idx++;
         }
     } else {
-        std::atomic_int doneCount(0);
-        std::mutex lock;
-        std::atomic_int idx(0);
-        typename std::list<T>::iterator it = list.begin();
-        
-        for (int x = 0; x < calcSteps-1; x++) {
-            ParallelJobPool::POOL.PushJob(new ParallelListJob(doneCount, f, it, lock, idx, size));
-        }
-        ParallelListJob(doneCount, f, it, lock, idx, size).Process();
-        while (doneCount < calcSteps) {
-            std::this_thread::yield();
-        }
+        ParallelListTask task(f, list);
+        ParallelJobPool::POOL.Run(&task, calcSteps);
     }
 }
-
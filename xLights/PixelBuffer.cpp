@@ -20,12 +20,16 @@
 #include "xLightsMain.h"
 #include <log4cpp/Category.hh>
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <random>
 #include "Parallel.h"
 #include "UtilFunctions.h"
 #include "DissolveTransitionPattern.h"
 #include "GPURenderUtils.h"
+#include "LayerBlend.h"
+#include "LayerFrameCache.h"
 
 // This is needed for visual studio
 #ifdef _MSC_VER
@@ -1140,8 +1144,6 @@ double ColourDistance(xlColor e1, xlColor e2)
 
 void PixelBufferClass::mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg, xlColor &bg, int layerNum)
 {
-    static const int n = 0;  //increase to change the curve of the crossfade
-
     LayerInfo *layer = layers[layerNum];
     if (!layer->buffer.allowAlpha && layer->fadeFactor != 1.0) {
         //need to fade the first here as we're not mixing anything
@@ -1168,37 +1170,19 @@ void PixelBufferClass::mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg
     switch (layer->mixType)
     {
     case MixTypes::Mix_Normal:
-        fg.alpha = fg.alpha * layer->fadeFactor * (1.0 - effectMixThreshold);
+        fg.alpha = LayerBlend::NormalAlpha(fg.alpha, layer->fadeFactor, effectMixThreshold);
         bg.AlphaBlendForgroundOnto(fg);
         break;
     case MixTypes::Mix_Effect1:
     case MixTypes::Mix_Effect2:
     {
         double emt, emtNot;
-        if (!layer->effectMixVaries) {
-            emt = effectMixThreshold;
-            if ((emt > 0.000001) && (emt < 0.99999)) {
-                emtNot = 1 - effectMixThreshold;
-                //make cross-fade linear
-                emt = cos((M_PI/4)*(pow(2*emt-1,2*n+1)+1));
-                emtNot = cos((M_PI/4)*(pow(2*emtNot-1,2*n+1)+1));
-            } else {
-                emtNot = effectMixThreshold;
-                emt = 1 - effectMixThreshold;
-            }
-        } else {
-            emt = effectMixThreshold;
-            emtNot = 1 - effectMixThreshold;
-        }
-
+        LayerBlend::EffectMixFactors(effectMixThreshold, layer->effectMixVaries, emt, emtNot);
         if (layer->mixType == MixTypes::Mix_Effect2) {
-            fg.Set(fg.Red()*(emtNot),fg.Green()*(emtNot), fg.Blue()*(emtNot));
-            bg.Set(bg.Red()*(emt),bg.Green()*(emt), bg.Blue()*(emt));
+            LayerBlend::EffectMix(fg, bg, emtNot, emt);
         } else {
-            fg.Set(fg.Red()*(emt),fg.Green()*(emt), fg.Blue()*(emt));
-            bg.Set(bg.Red()*(emtNot),bg.Green()*(emtNot), bg.Blue()*(emtNot));
+            LayerBlend::EffectMix(fg, bg, emt, emtNot);
         }
-        bg.Set(fg.Red()+bg.Red(), fg.Green()+bg.Green(), fg.Blue()+bg.Blue());
         break;
     }
     case MixTypes::Mix_Mask1:
@@ -1306,12 +1290,7 @@ void PixelBufferClass::mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg
         break;
     }
     case MixTypes::Mix_Average:
-        // only average when both colors are non-black
-        if (bg == xlBLACK) {
-            bg = fg;
-        } else if (fg != xlBLACK) {
-            bg.Set((fg.Red() + bg.Red()) / 2, (fg.Green() + bg.Green()) / 2, (fg.Blue() + bg.Blue()) / 2, (fg.alpha + bg.alpha) / 2);
-        }
+        LayerBlend::Average(fg, bg);
         break;
     case MixTypes::Mix_BottomTop:
         bg = y < layer->BufferHt/2 ? fg : bg;
@@ -1361,217 +1340,222 @@ void PixelBufferClass::mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg
         }
     } break;
     case MixTypes::Mix_Additive:
-        {
-            int r = fg.red + bg.red;
-            int g = fg.green + bg.green;
-            int b = fg.blue + bg.blue;
-            if (r > 255) r = 255;
-            if (g > 255) g = 255;
-            if (b > 255) b = 255;
-            bg.Set(r, g, b);
-        }
+        LayerBlend::Additive(fg, bg);
         break;
     case MixTypes::Mix_Subtractive:
-        {
-            int r = bg.red - fg.red;
-            int g = bg.green - fg.green;
-            int b = bg.blue - fg.blue;
-            if (r < 0)
-                r = 0;
-            if (g < 0) g = 0;
-            if (b < 0) b = 0;
-            bg.Set(r, g, b);
-        }
+        LayerBlend::Subtractive(fg, bg);
         break;
-
     case MixTypes::Mix_Min:
-        {
-            float alpha = (float)fg.alpha / 255.0;
-            int r = std::min(fg.red, bg.red) * alpha;
-            int g = std::min(fg.green, bg.green) * alpha;
-            int b = std::min(fg.blue, bg.blue) * alpha;
-            bg.Set(r, g, b);
-        }
+        LayerBlend::Min(fg, bg);
         break;
     case MixTypes::Mix_Max:
-        {
-            float alpha = (float)fg.alpha / 255.0;
-            int r = std::max(fg.red, bg.red) * alpha;
-            int g = std::max(fg.green, bg.green) * alpha;
-            int b = std::max(fg.blue, bg.blue) * alpha;
-            bg.Set(r, g, b);
-        }
+        LayerBlend::Max(fg, bg);
         break;
     case MixTypes::Mix_AsBrightness:
-        {
-        float alpha = (float)fg.alpha / 255.0;
-        int r = fg.red * bg.red / 255 * alpha;
-        int g = fg.green * bg.green / 255 * alpha;
-        int b = fg.blue * bg.blue / 255 * alpha;
-        bg.Set(r, g, b);
-    }
+        LayerBlend::AsBrightness(fg, bg);
         break;
     }
 }
 
-void PixelBufferClass::GetMixedColor(int node, const std::vector<bool> & validLayers, int EffectPeriod, int saveLayer)
+void PixelBufferClass::mixColorRow(const wxCoord *x, const wxCoord *y, xlColor *fg, xlColor *bg, int count, int layerNum)
 {
-    auto &sparkle = layers[0]->buffer.Nodes[node]->sparkle;
-    int cnt = 0;
-    xlColor c(xlBLACK);
-    xlColor color;
+    LayerInfo *layer = layers[layerNum];
+    if ((layer->buffer.allowAlpha || layer->fadeFactor == 1.0)
+        && !layer->isChromaKey
+        && LayerBlend::MixRow(layer->mixType, layer->fadeFactor, layer->outputEffectMixThreshold, layer->effectMixVaries, fg, bg, count)) {
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        mixColors(x[i], y[i], fg[i], bg[i], layerNum);
+    }
+}
 
+void PixelBufferClass::GetMixedColors(int startNode, int endNode, const std::vector<bool> & validLayers, int saveLayer)
+{
+    std::vector<NodeBaseClassPtr> &Nodes = layers[saveLayer]->buffer.Nodes;
+    std::vector<NodeBaseClassPtr> &sparkleNodes = layers[0]->buffer.Nodes;
+    const int count = endNode - startNode;
+
+    // each layer's colors for the run of nodes are collected first and then
+    // mixed onto the result as a row, on the stack as this is done for every run of every frame
+    wxASSERT(count <= MIX_RUN);
+    xlColor c[MIX_RUN];
+    xlColor colors[MIX_RUN];
+    wxCoord xs[MIX_RUN];
+    wxCoord ys[MIX_RUN];
+    std::fill(c, c + count, xlBLACK);
+
+    // nodes before mixedEnd have had at least one layer applied
+    int mixedEnd = startNode;
     for (int layer = numLayers - 1; layer >= 0; layer--) {
-        if (validLayers[layer]) {
-            auto thelayer = layers[layer];
-            if (node >= thelayer->buffer.Nodes.size()) {
-                //logger_base.crit("PixelBufferClass::GetMixedColor thelayer->buffer.Nodes does not contain node %d as it is only %d in size ... this was going to crash.", node, thelayer->buffer.Nodes.size());
-            } else {
-                int x = 0;
-                int y = 0;
-                if (thelayer->buffer.Nodes[node]->Coords.size() > 1) {
-                    color.Set(0, 0, 0, 0);
-                    xlColor c2;
-                    bool found = false;
-                    for (auto it = thelayer->buffer.Nodes[node]->Coords.begin(); it != thelayer->buffer.Nodes[node]->Coords.end(); ++it) {
-                        //find the last coordinate with a color, compatibility with older xLights that only allowed a
-                        //node to exist once in the submodel and would use the coord of the last appearance
-                        auto coord = *it;
-                        int x1 = coord.bufX;
-                        int y1 = coord.bufY;
-                        
-                        if (!thelayer->isMasked(x1, y1)) {
-                            thelayer->buffer.GetPixel(x1, y1, c2);
-                            if (c2.alpha != 0) {
-                                found = true;
-                                color = c2;
-                                x = x1;
-                                y = y1;
-                                break;
-                            }
+        if (!validLayers[layer]) {
+            continue;
+        }
+        auto thelayer = layers[layer];
+        int layerEnd = std::min(endNode, (int)thelayer->buffer.Nodes.size());
+        if (layerEnd <= startNode) {
+            continue;
+        }
+        bool hasSparkles = thelayer->use_music_sparkle_count ||
+                           thelayer->sparkle_count > 0 ||
+                           thelayer->outputSparkleCount > 0;
+        int b = thelayer->outputBrightnessAdjust;
+
+        for (int node = startNode; node < layerEnd; node++) {
+            int idx = node - startNode;
+            xlColor &color = colors[idx];
+            if (!Nodes[node]->IsVisible()) {
+                // unmapped pixel, will be set to black
+                color = xlBLACK;
+                continue;
+            }
+            int x = 0;
+            int y = 0;
+            if (thelayer->buffer.Nodes[node]->Coords.size() > 1) {
+                color.Set(0, 0, 0, 0);
+                xlColor c2;
+                bool found = false;
+                for (auto it = thelayer->buffer.Nodes[node]->Coords.begin(); it != thelayer->buffer.Nodes[node]->Coords.end(); ++it) {
+                    //find the last coordinate with a color, compatibility with older xLights that only allowed a
+                    //node to exist once in the submodel and would use the coord of the last appearance
+                    auto coord = *it;
+                    int x1 = coord.bufX;
+                    int y1 = coord.bufY;
+
+                    if (!thelayer->isMasked(x1, y1)) {
+                        thelayer->buffer.GetPixel(x1, y1, c2);
+                        if (c2.alpha != 0) {
+                            found = true;
+                            color = c2;
+                            x = x1;
+                            y = y1;
+                            break;
                         }
                     }
-                    if (!found) {
-                        auto &coord = thelayer->buffer.Nodes[node]->Coords[0];
-                        x = coord.bufX;
-                        y = coord.bufY;
-                    }
-                } else {
+                }
+                if (!found) {
                     auto &coord = thelayer->buffer.Nodes[node]->Coords[0];
                     x = coord.bufX;
                     y = coord.bufY;
-                    
-                    if (thelayer->isMasked(x, y)
-                        || x < 0
-                        || y < 0
-                        || x >= thelayer->BufferWi
-                        || y >= thelayer->BufferHt
-                        ) {
-                        color.Set(0, 0, 0, 0);
-                    } else {
-                        thelayer->buffer.GetPixel(x, y, color);
-                    }
                 }
-                // adjust for HSV adjustments
-                if (thelayer->needsHSVAdjust) {
-                    HSVValue hsv = color.asHSV();
+            } else {
+                auto &coord = thelayer->buffer.Nodes[node]->Coords[0];
+                x = coord.bufX;
+                y = coord.bufY;
 
-                    if (thelayer->outputHueAdjust != 0) {
-                        hsv.hue += thelayer->outputHueAdjust;
-                        if (hsv.hue < 0) {
-                            hsv.hue += 1.0;
-                        } else if (hsv.hue > 1) {
-                            hsv.hue -= 1.0;
-                        }
+                if (thelayer->isMasked(x, y)
+                    || x < 0
+                    || y < 0
+                    || x >= thelayer->BufferWi
+                    || y >= thelayer->BufferHt
+                    ) {
+                    color.Set(0, 0, 0, 0);
+                } else {
+                    thelayer->buffer.GetPixel(x, y, color);
+                }
+            }
+            xs[idx] = x;
+            ys[idx] = y;
+
+            // adjust for HSV adjustments
+            if (thelayer->needsHSVAdjust) {
+                HSVValue hsv = color.asHSV();
+
+                if (thelayer->outputHueAdjust != 0) {
+                    hsv.hue += thelayer->outputHueAdjust;
+                    if (hsv.hue < 0) {
+                        hsv.hue += 1.0;
+                    } else if (hsv.hue > 1) {
+                        hsv.hue -= 1.0;
                     }
+                }
 
-                    if (thelayer->outputSaturationAdjust != 0) {
-                        hsv.saturation += thelayer->outputSaturationAdjust;
-                        if (hsv.saturation < 0) {
-                            hsv.saturation = 0.0;
-                        } else if (hsv.saturation > 1) {
-                            hsv.saturation = 1.0;
-                        }
+                if (thelayer->outputSaturationAdjust != 0) {
+                    hsv.saturation += thelayer->outputSaturationAdjust;
+                    if (hsv.saturation < 0) {
+                        hsv.saturation = 0.0;
+                    } else if (hsv.saturation > 1) {
+                        hsv.saturation = 1.0;
                     }
+                }
 
-                    if (thelayer->outputValueAdjust != 0) {
-                        hsv.value += thelayer->outputValueAdjust;
-                        if (hsv.value < 0) {
-                            hsv.value = 0.0;
-                        } else if (hsv.value > 1) {
-                            hsv.value = 1.0;
-                        }
+                if (thelayer->outputValueAdjust != 0) {
+                    hsv.value += thelayer->outputValueAdjust;
+                    if (hsv.value < 0) {
+                        hsv.value = 0.0;
+                    } else if (hsv.value > 1) {
+                        hsv.value = 1.0;
                     }
-
-                    unsigned char alpha = color.Alpha();
-                    color = hsv;
-                    color.alpha = alpha;
                 }
 
-                // add sparkles
-                if (color != xlBLACK &&
-                    (thelayer->use_music_sparkle_count ||
-                        thelayer->sparkle_count > 0 ||
-                        thelayer->outputSparkleCount > 0)) {
-
-                    int sc = thelayer->outputSparkleCount;
-                    switch (sparkle % (208 - sc))
-                    {
-                    case 1:
-                    case 7:
-                        // too dim
-                        //color.Set("#444444");
-                        break;
-                    case 2:
-                    case 6:
-                        color = thelayer->sparklesColour.ApplyBrightness(0.53f);
-                        break;
-                    case 3:
-                    case 5:
-                        color = thelayer->sparklesColour.ApplyBrightness(0.75f);
-                        break;
-                    case 4:
-                        color = thelayer->sparklesColour;
-                        break;
-                    default:
-                        break;
-                    }
-                    sparkle++;
+                unsigned char alpha = color.Alpha();
+                color = hsv;
+                color.alpha = alpha;
+            }
+
+            // add sparkles
+            if (hasSparkles && color != xlBLACK) {
+                auto &sparkle = sparkleNodes[node]->sparkle;
+                int sc = thelayer->outputSparkleCount;
+                switch (sparkle % (208 - sc))
+                {
+                case 1:
+                case 7:
+                    // too dim
+                    //color.Set("#444444");
+                    break;
+                case 2:
+                case 6:
+                    color = thelayer->sparklesColour.ApplyBrightness(0.53f);
+                    break;
+                case 3:
+                case 5:
+                    color = thelayer->sparklesColour.ApplyBrightness(0.75f);
+                    break;
+                case 4:
+                    color = thelayer->sparklesColour;
+                    break;
+                default:
+                    break;
                 }
-                int b = thelayer->outputBrightnessAdjust;
-                if (thelayer->contrast != 0) {
-                    //contrast is not 0, can handle brightness change at same time
-                    HSVValue hsv = color.asHSV();
-                    hsv.value = hsv.value * ((double)b / 100.0);
+                sparkle++;
+            }
 
-                    // Apply Contrast
-                    if (hsv.value < 0.5) {
-                        // reduce brightness when below 0.5 in the V value or increase if > 0.5
-                        hsv.value = hsv.value - (hsv.value* ((double)thelayer->contrast / 100.0));
-                    } else {
-                        hsv.value = hsv.value + (hsv.value* ((double)thelayer->contrast / 100.0));
-                    }
+            if (thelayer->contrast != 0) {
+                //contrast is not 0, can handle brightness change at same time
+                HSVValue hsv = color.asHSV();
+                hsv.value = hsv.value * ((double)b / 100.0);
 
-                    if (hsv.value < 0.0) hsv.value = 0.0;
-                    if (hsv.value > 1.0) hsv.value = 1.0;
-                    unsigned char alpha = color.Alpha();
-                    color = hsv;
-                    color.alpha = alpha;
-                } else if (b != 100) {
-                    //just brightness
-                    float ba = b;
-                    ba /= 100.0f;
-                    float f = color.red * ba;
-                    color.red = std::min((int)f, 255);
-                    f = color.green * ba;
-                    color.green = std::min((int)f, 255);
-                    f = color.blue * ba;
-                    color.blue = std::min((int)f, 255);
+                // Apply Contrast
+                if (hsv.value < 0.5) {
+                    // reduce brightness when below 0.5 in the V value or increase if > 0.5
+                    hsv.value = hsv.value - (hsv.value* ((double)thelayer->contrast / 100.0));
+                } else {
+                    hsv.value = hsv.value + (hsv.value* ((double)thelayer->contrast / 100.0));
                 }
 
-                if (cnt > 0) {
-                    mixColors(x, y, color, c, layer);
-                } else if (thelayer->fadeFactor != 1.0) {
+                if (hsv.value < 0.0) hsv.value = 0.0;
+                if (hsv.value > 1.0) hsv.value = 1.0;
+                unsigned char alpha = color.Alpha();
+                color = hsv;
+                color.alpha = alpha;
+            }
+        }
+        if (thelayer->contrast == 0 && b != 100) {
+            //just brightness
+            LayerBlend::BrightnessRow(&colors[0], layerEnd - startNode, b);
+        }
+
+        int mixCount = std::min(mixedEnd, layerEnd) - startNode;
+        if (mixCount > 0) {
+            mixColorRow(&xs[0], &ys[0], &colors[0], &c[0], mixCount, layer);
+        }
+        if (layerEnd > mixedEnd) {
+            // first layer for these nodes, nothing to mix with
+            int first = mixedEnd - startNode;
+            if (thelayer->fadeFactor != 1.0) {
+                for (int idx = first; idx < layerEnd - startNode; idx++) {
+                    xlColor &color = colors[idx];
                     //need to fade the first here as we're not mixing anything
                     HSVValue hsv = color.asHSV();
                     hsv.value *= thelayer->fadeFactor;
@@ -1579,17 +1563,23 @@ void PixelBufferClass::GetMixedColor(int node, const std::vector<bool> & validLa
                         hsv.value *= color.alpha;
                         hsv.value /= 255.0f;
                     }
-                    c = hsv;
-                } else {
-                    c.AlphaBlendForgroundOnto(color);
+                    c[idx] = hsv;
                 }
-
-                cnt++;
+            } else {
+                LayerBlend::AlphaBlendRow(&colors[first], &c[first], layerEnd - mixedEnd);
             }
+            mixedEnd = layerEnd;
         }
     }
     // set color for physical output
-    layers[saveLayer]->buffer.Nodes[node]->SetColor(c);
+    for (int node = startNode; node < endNode; node++) {
+        if (!Nodes[node]->IsVisible()) {
+            // unmapped pixel - set to black
+            Nodes[node]->SetColor(xlBLACK);
+        } else {
+            Nodes[node]->SetColor(c[node - startNode]);
+        }
+    }
 }
 
 void PixelBufferClass::GetMixedColor(int lx, int ly, xlColor& c, const std::vector<bool> & validLayers, int EffectPeriod)
@@ -2034,32 +2024,49 @@ void PixelBufferClass::Blur(LayerInfo* layer, float offset)
             d = (b - 1) / 2;
             u = (b - 1) / 2;
         }
-        RenderBuffer orig(layer->buffer);
-        for (int x = 0; x < layer->BufferWi; x++) {
-            for (int y = 0; y < layer->BufferHt; y++) {
+        // the box is separable, sum each column over the rows in range and then
+        // sum those across the columns in range, a row at a time
+        int w = layer->BufferWi;
+        int h = layer->BufferHt;
+        std::vector<xlColor> orig(w * h);
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                layer->buffer.GetPixel(x, y, orig[y * w + x]);
+            }
+        }
+        std::vector<int> colSums(w * 4);
+        for (int y = 0; y < h; y++) {
+            int jstart = std::max(y - d, 0);
+            int jend = std::min(y + u, h - 1);
+            std::fill(colSums.begin(), colSums.end(), 0);
+            for (int j = jstart; j <= jend; j++) {
+                const xlColor *src = &orig[j * w];
+                for (int i = 0; i < w; i++) {
+                    colSums[i * 4] += src[i].red;
+                    colSums[i * 4 + 1] += src[i].green;
+                    colSums[i * 4 + 2] += src[i].blue;
+                    colSums[i * 4 + 3] += src[i].alpha;
+                }
+            }
+            RenderBuffer::Row row(layer->buffer, y);
+            for (int x = 0; x < w; x++) {
+                int istart = std::max(x - d, 0);
+                int iend = std::min(x + u, w - 1);
                 int r = 0;
                 int g = 0;
                 int b2 = 0;
                 int a = 0;
-                int sm = 0;
-                for (int i = x - d; i <= x + u; i++) {
-                    if (i >= 0 && i < layer->BufferWi) {
-                        for (int j = y - d; j <= y + u; j++) {
-                            if (j >=0 && j < layer->BufferHt) {
-                                const xlColor &c = orig.GetPixel(i, j);
-                                r += c.red;
-                                g += c.green;
-                                b2 += c.blue;
-                                a += c.alpha;
-                                ++sm;
-                            }
-                        }
-                    }
+                for (int i = istart; i <= iend; i++) {
+                    r += colSums[i * 4];
+                    g += colSums[i * 4 + 1];
+                    b2 += colSums[i * 4 + 2];
+                    a += colSums[i * 4 + 3];
                 }
-                if (sm == 0) {
+                int sm = (iend - istart + 1) * (jend - jstart + 1);
+                if (sm <= 0) {
                     sm = 1;
                 }
-                layer->buffer.SetPixel(x, y, xlColor(r/sm, g/sm, b2/sm, a/sm));
+                row[x] = xlColor(r/sm, g/sm, b2/sm, a/sm);
             }
         }
     }
@@ -3052,7 +3059,61 @@ void PixelBufferClass::HandleLayerBlurZoom(int EffectPeriod, int layer) {
     GPURenderUtils::commitRenderBuffer(&layers[layer]->buffer);
 }
 
-void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & validLayers, int saveLayer)
+void PixelBufferClass::SetLayerFrameCache(int layer, const std::shared_ptr<LayerFrameCache>& cache)
+{
+    if (layer < numLayers) {
+        layers[layer]->frameCache = cache;
+        if (cache != nullptr) {
+            cache->Prepare(frameTimeInMs);
+        }
+    }
+}
+
+LayerFrameCache* PixelBufferClass::GetLayerFrameCache(int layer) const
+{
+    if (layer >= numLayers || layers[layer]->frameCache == nullptr) {
+        return nullptr;
+    }
+    // canvas layers are rendered on top of the layers below and variable sub buffers
+    // change size every frame so neither can be restored on their own
+    if (layers[layer]->canvas || layers[layer]->renderingDisabled || IsVariableSubBuffer(layer)) {
+        return nullptr;
+    }
+    return layers[layer]->frameCache.get();
+}
+
+bool PixelBufferClass::IsLayerCached(int layer, int startFrame, int endFrame) const
+{
+    LayerFrameCache* cache = GetLayerFrameCache(layer);
+    if (cache == nullptr) {
+        return false;
+    }
+    return cache->HasFrames(startFrame, endFrame, layers[layer]->buffer.BufferWi, layers[layer]->buffer.BufferHt);
+}
+
+bool PixelBufferClass::RestoreLayerFromCache(int layer, int frame, bool& valid)
+{
+    LayerFrameCache* cache = GetLayerFrameCache(layer);
+    if (cache == nullptr || !cache->Get(frame, layers[layer]->buffer, valid)) {
+        return false;
+    }
+    // CalcOutput needs the period the effect would have been rendered at
+    SetLayer(layer, frame, false);
+    return true;
+}
+
+void PixelBufferClass::SaveLayerToCache(int layer, int frame, bool valid, uint32_t generation)
+{
+    LayerFrameCache* cache = GetLayerFrameCache(layer);
+    if (cache != nullptr) {
+        if (valid) {
+            GPURenderUtils::waitForRenderCompletion(&layers[layer]->buffer);
+        }
+        cache->Put(frame, layers[layer]->buffer, valid, generation);
+    }
+}
+
+void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & validLayers, int saveLayer, bool timeTransitions)
 {
     int curStep;
 
@@ -3063,9 +3124,9 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
         if (layers[ii]->use_music_sparkle_count &&
             layers[ii]->buffer.GetMedia() != nullptr) {
             float f = 0.0;
-            std::list<float> const * const pf = layers[ii]->buffer.GetMedia()->GetFrameData(layers[ii]->buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr) {
-                f = *pf->cbegin();
+            AudioFrameData const pf = layers[ii]->buffer.GetMedia()->GetFrameData(layers[ii]->buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (pf) {
+                f = pf.front();
             }
             layers[ii]->music_sparkle_count_factor = f;
         } else {
@@ -3113,7 +3174,13 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
             int fakeLayerIndex = numLayers - 1;
             if ( fakeLayerIndex - ii > 1 )
                prevRB = &layers[ii+1]->buffer;
-            layers[ii]->renderTransitions(isFirstFrame, prevRB);
+            if (timeTransitions) {
+                auto start = std::chrono::steady_clock::now();
+                layers[ii]->renderTransitions(isFirstFrame, prevRB);
+                layers[ii]->transitionUS += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            } else {
+                layers[ii]->renderTransitions(isFirstFrame, prevRB);
+            }
         } else {
            layers[ii]->mask.clear();
         }
@@ -3159,16 +3226,18 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
     }
     */
 
-    std::vector<NodeBaseClassPtr> &Nodes = layers[saveLayer]->buffer.Nodes;
-    parallel_for(0, NodeCount, [this, &Nodes, &validLayers, saveLayer, EffectPeriod] (int i) {
-        if (!Nodes[i]->IsVisible()) {
-            // unmapped pixel - set to black
-            Nodes[i]->SetColor(xlBLACK);
-        } else {
-            // get blend of two effects
-            GetMixedColor(i, validLayers, EffectPeriod, saveLayer);
-        }
-    }, blockSize);
+    int runs = (NodeCount + MIX_RUN - 1) / MIX_RUN;
+    parallel_for(0, runs, [this, NodeCount, &validLayers, saveLayer] (int r) {
+        int start = r * MIX_RUN;
+        GetMixedColors(start, std::min(start + MIX_RUN, (int)NodeCount), validLayers, saveLayer);
+    }, std::max(blockSize / MIX_RUN, 1));
+}
+
+int64_t PixelBufferClass::TakeTransitionTimeUS(int layer)
+{
+    int64_t us = layers[layer]->transitionUS;
+    layers[layer]->transitionUS = 0;
+    return us;
 }
 
 static int DecodeType(const std::string &type)
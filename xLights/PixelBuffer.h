@@ -57,6 +57,7 @@ class SequenceElements;
 class SettingsMap;
 class DimmingCurve;
 class ModelGroup;
+class LayerFrameCache;
 
 class PixelBufferClass
 {
@@ -195,6 +196,10 @@ private:
         int suppressUntil = 0;
 
         std::vector<uint8_t> mask;
+        int64_t transitionUS = 0; // time spent on transitions since TakeTransitionTimeUS
+        // the layer's output from previous renders, owned by the EffectLayer
+        std::shared_ptr<LayerFrameCache> frameCache;
+
         void renderTransitions(bool isFirstFrame, const RenderBuffer* prevRB);
         void calculateMask(const std::string &type, bool mode, bool isFirstFrame);
         bool isMasked(int x, int y);
@@ -232,6 +237,8 @@ private:
 
     //both fg and bg may be modified, bg will contain the new, mixed color to be the bg for the next mix
     void mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg, xlColor &bg, int layer);
+    //same as calling mixColors for each of the count colors, uses LayerBlend where it can
+    void mixColorRow(const wxCoord *x, const wxCoord *y, xlColor *fg, xlColor *bg, int count, int layer);
     void reset(int layers, int timing, bool isNode = false);
 	void Blur(LayerInfo* layer, float offset);
     void RotoZoom(LayerInfo* layer, float offset);
@@ -239,7 +246,9 @@ private:
     void RotateY(RenderBuffer &buffer, GPURenderUtils::RotoZoomSettings &settings);
     void RotateZAndZoom(RenderBuffer &buffer, GPURenderUtils::RotoZoomSettings &settings);
     
-    void GetMixedColor(int node, const std::vector<bool> & validLayers, int EffectPeriod, int saveLayer);
+    // nodes are mixed in runs of at most MIX_RUN so each layer can be blended onto the result a row at a time
+    static constexpr int MIX_RUN = 256;
+    void GetMixedColors(int startNode, int endNode, const std::vector<bool> & validLayers, int saveLayer);
 
     std::string modelName;
     std::string lastBufferType;
@@ -300,7 +309,19 @@ public:
 
     
     void HandleLayerBlurZoom(int EffectPeriod, int layer);
-    void CalcOutput(int EffectPeriod, const std::vector<bool> &validLayers, int saveLayer = 0);
+
+    // the rendered output of the layer can be kept between renders so layers that
+    // haven't changed can be restored rather than rendered again
+    void SetLayerFrameCache(int layer, const std::shared_ptr<LayerFrameCache>& cache);
+    // nullptr if the layer's output can't be cached with its current settings
+    LayerFrameCache* GetLayerFrameCache(int layer) const;
+    bool IsLayerCached(int layer, int startFrame, int endFrame) const;
+    bool RestoreLayerFromCache(int layer, int frame, bool& valid);
+    void SaveLayerToCache(int layer, int frame, bool valid, uint32_t generation);
+    // timeTransitions adds the time spent on each layer's transitions up for TakeTransitionTimeUS
+    void CalcOutput(int EffectPeriod, const std::vector<bool> &validLayers, int saveLayer = 0, bool timeTransitions = false);
+    // microseconds CalcOutput has spent timing the layer's transitions since this was last called
+    int64_t TakeTransitionTimeUS(int layer);
     void SetColors(int layer, const unsigned char *fdata);
     void GetColors(unsigned char *fdata, const std::vector<bool> &restrictRange);
 
@@ -8,6 +8,7 @@
  * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
  **************************************************************/
 
+#include <chrono>
 #include <mutex>
 #include <condition_variable>
 #include <map>
@@ -27,6 +28,10 @@
 #include "Parallel.h"
 #include "ExternalHooks.h"
 #include "GPURenderUtils.h"
+#include "LayerFrameCache.h"
+#include "RenderProfiler.h"
+#include "effects/TextLineCache.h"
+#include "FSEQStreamWriter.h"
 
 #include <log4cpp/Category.hh>
 
@@ -35,6 +40,13 @@
 //other common strings
 static const std::string STR_EMPTY("");
 
+// how a layer's frames are produced while the layer's current effect lasts
+enum class LayerCacheState {
+    UNDECIDED, // decided at the next frame
+    RENDER,    // rendered, saved to the layer's frame cache if it can be
+    RESTORE    // restored from the layer's frame cache
+};
+
 class EffectLayerInfo {
 public:
     EffectLayerInfo(): element(nullptr)
@@ -57,6 +69,11 @@ public:
         settingsMaps.resize(l);
         effectStates.resize(l);
         validLayers.resize(l + 1); //extra one for the blending layer
+        cacheStates.resize(l);
+        cacheGenerations.resize(l);
+        saveToCache.resize(l);
+        profileEffects.resize(l);
+        profileLayers.resize(l);
     }
 
     int numLayers;
@@ -69,8 +86,27 @@ public:
     std::vector<SettingsMap> settingsMaps;
     std::vector<bool> effectStates;
     std::vector<bool> validLayers;
+    std::vector<LayerCacheState> cacheStates;
+    std::vector<uint32_t> cacheGenerations;
+    std::vector<bool> saveToCache;
+
+    // where the times go when profiling, looked up the first time they are needed
+    RenderProfileTimes* profileModel = nullptr;
+    std::vector<RenderProfileTimes*> profileEffects;
+    std::vector<RenderProfileTimes*> profileLayers;
 };
 
+// the time to measure from when profiling, rendering doesn't read the clock otherwise
+static std::chrono::steady_clock::time_point ProfileStart(bool profiling)
+{
+    return profiling ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+}
+
+static int64_t MicrosecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
 class RenderEvent {
 public:
     RenderEvent() : mutex(), signal() {}
@@ -189,6 +225,23 @@ private:
     const int finalFrame;
 };
 
+// The last step of a full render, fed by an AggregatorRenderer over every row so it is told
+// as soon as a frame is complete and passes it on to the fseq writer
+class FSEQStreamRenderer: public NextRenderer {
+public:
+    FSEQStreamRenderer(FSEQStreamWriter *w, int end) : NextRenderer(), writer(w), endFrame(end) {
+    }
+
+    virtual void setPreviousFrameDone(int frame) override {
+        NextRenderer::setPreviousFrameDone(frame);
+        writer->FramesDone(frame == END_OF_RENDER_FRAME ? endFrame : frame);
+    }
+
+private:
+    FSEQStreamWriter *writer;
+    const int endFrame;
+};
+
 class SNPair {
 public:
     SNPair(int s, int n) : strand(s), node(n) {}
@@ -547,6 +600,24 @@ public:
         return frame - (ef->GetStartTimeMS() / frameTime);
     }
 
+    const RenderProfile& GetProfile() const { return profile; }
+
+    // the times to add the layer's current effect to, only called when profiling
+    void GetProfileTimes(Element* el, EffectLayerInfo& info, int layer, Effect* ef, RenderProfileTimes*& model, RenderProfileTimes*& effect, RenderProfileTimes*& elayer) {
+        if (info.profileModel == nullptr) {
+            info.profileModel = &profile.models[el->GetFullName()];
+        }
+        if (info.profileLayers[layer] == nullptr) {
+            info.profileLayers[layer] = &profile.layers[el->GetFullName() + "/Layer " + std::to_string(layer + 1)];
+        }
+        if (info.profileEffects[layer] == nullptr) {
+            info.profileEffects[layer] = &profile.effects[ef->GetEffectName()];
+        }
+        model = info.profileModel;
+        effect = info.profileEffects[layer];
+        elayer = info.profileLayers[layer];
+    }
+
     bool ProcessFrame(int frame, Element *el, EffectLayerInfo &info, PixelBufferClass *buffer, int strand = -1, bool blend = false) {
         wxStopWatch sw;
         bool effectsToUpdate = false;
@@ -618,6 +689,9 @@ public:
             Effect* compare = copy != nullptr ? copy : ef;
 
             if (compare != info.currentEffects[layer]) {
+                // a persistent effect starts from the output of the effect before it so if
+                // that was rendered this one has to be as well
+                bool follows = info.currentEffects[layer] != nullptr && info.cacheStates[layer] == LayerCacheState::RENDER;
                 if (copy != nullptr) {
                     info.currentEffects[layer] = copy;
                 } else {
@@ -626,12 +700,64 @@ public:
                 SetInializingStatus(frame, layer, info.submodel, strand, -1);
                 initialize(layer, frame, ef, info.settingsMaps[layer], buffer);
                 info.effectStates[layer] = true;
+                info.profileEffects[layer] = nullptr;
+                info.cacheStates[layer] = (follows && buffer->IsPersistent(layer)) ? LayerCacheState::RENDER : LayerCacheState::UNDECIDED;
             }
 
             if (buffer->IsVariableSubBuffer(layer)) {
                 buffer->PrepareVariableSubBuffer(frame, layer);
             }
 
+            RenderProfileTimes* modelTimes = nullptr;
+            RenderProfileTimes* effectTimes = nullptr;
+            RenderProfileTimes* layerTimes = nullptr;
+            if (profiling && ef != nullptr) {
+                GetProfileTimes(el, info, layer, ef, modelTimes, effectTimes, layerTimes);
+            }
+
+            // duplicates depend on another model's effects so they are always rendered
+            LayerFrameCache* frameCache = copy == nullptr ? buffer->GetLayerFrameCache(layer) : nullptr;
+            if (info.cacheStates[layer] == LayerCacheState::UNDECIDED) {
+                // restored frames don't advance the effect's state so either all of the
+                // rest of the effect comes from the cache or none of it does
+                bool restore = false;
+                if (frameCache != nullptr && ef != nullptr) {
+                    int lastFrame = std::min((int)endFrame, (ef->GetEndTimeMS() - 1) / seqData->FrameTime());
+                    restore = buffer->IsLayerCached(layer, frame, lastFrame);
+                }
+                info.cacheStates[layer] = restore ? LayerCacheState::RESTORE : LayerCacheState::RENDER;
+            }
+            if (info.cacheStates[layer] == LayerCacheState::RESTORE) {
+                bool valid = false;
+                auto start = ProfileStart(modelTimes != nullptr);
+                if (frameCache != nullptr && buffer->RestoreLayerFromCache(layer, frame, valid)) {
+                    info.validLayers[layer] = valid;
+                    info.saveToCache[layer] = false;
+                    effectsToUpdate |= valid;
+                    if (modelTimes != nullptr) {
+                        int64_t us = MicrosecondsSince(start);
+                        for (auto t : { modelTimes, effectTimes, layerTimes }) {
+                            t->restoreUS += us;
+                            t->cacheHits++;
+                        }
+                    }
+                    continue;
+                }
+                // the layer was edited while we were rendering, render the rest of the effect
+                info.cacheStates[layer] = LayerCacheState::RENDER;
+                SetInializingStatus(frame, layer, info.submodel, strand, -1);
+                initialize(layer, frame, ef, info.settingsMaps[layer], buffer);
+                info.effectStates[layer] = true;
+                if (buffer->IsPersistent(layer)) {
+                    // per model buffers carry on from the restored output
+                    buffer->UnMergeBuffersForLayer(layer);
+                }
+            }
+            info.saveToCache[layer] = frameCache != nullptr;
+            if (frameCache != nullptr) {
+                info.cacheGenerations[layer] = frameCache->GetGeneration();
+            }
+
             bool persist = buffer->IsPersistent(layer);
             bool freeze = false;
             if (ef != nullptr && buffer != nullptr) {
@@ -675,10 +801,11 @@ public:
                     }
 
                     // preload the buffer with the output from the lower layers
+                    auto start = ProfileStart(modelTimes != nullptr);
                     RenderBuffer& rb = buffer->BufferForLayer(layer, -1);
 
                     // I have to calc the output here to apply blend, rotozoom and transitions
-                    buffer->CalcOutput(frame, vl, layer);
+                    buffer->CalcOutput(frame, vl, layer, modelTimes != nullptr);
                     std::vector<uint8_t> done(rb.GetPixelCount());
                     rb.CopyNodeColorsToPixels(done);
                     // now fill in any spaces in the buffer that don't have nodes mapped to them
@@ -692,9 +819,20 @@ public:
                         }
                         });
                     buffer->UnMergeBuffersForLayer(layer);
+                    if (modelTimes != nullptr) {
+                        modelTimes->blendUS += MicrosecondsSince(start);
+                    }
                 }
 
+                auto start = ProfileStart(modelTimes != nullptr);
                 info.validLayers[layer] = xLights->RenderEffectFromMap(suppress, ef, layer, frame, info.settingsMaps[layer], *buffer, b, true, &renderEvent);
+                if (modelTimes != nullptr) {
+                    int64_t us = MicrosecondsSince(start);
+                    for (auto t : { modelTimes, effectTimes, layerTimes }) {
+                        t->renderUS += us;
+                        t->renders++;
+                    }
+                }
                 effectsToUpdate |= info.validLayers[layer];
                 info.effectStates[layer] = b;
 
@@ -708,19 +846,40 @@ public:
                 info.effectStates[layer] = b;
                 effectsToUpdate = true;
             }
+
+            // saved before CalcOutput, the transitions are applied to the buffer in place when blending
+            if (info.saveToCache[layer]) {
+                buffer->SaveLayerToCache(layer, frame, info.validLayers[layer], info.cacheGenerations[layer]);
+            }
         }
 
         if (effectsToUpdate) {
             maybeWaitForFrame(frame);
             SetCalOutputStatus(frame, info.submodel, strand, -1);
+            bool timeModel = profiling && info.profileModel != nullptr;
+            auto start = ProfileStart(timeModel);
             if (blend) {
                 buffer->SetColors(numLayers, &((*seqData)[frame][0]));
                 info.validLayers[numLayers] = true;
             }
-            buffer->CalcOutput(frame, info.validLayers);
+            buffer->CalcOutput(frame, info.validLayers, 0, timeModel);
             buffer->GetColors(&((*seqData)[frame][0]), rangeRestriction);
+            if (timeModel) {
+                info.profileModel->blendUS += MicrosecondsSince(start);
+            }
+        }
+        if (profiling && info.profileModel != nullptr) {
+            // transitions are done while blending, move their time to the layers they belong to
+            for (int layer = 0; layer < numLayers; ++layer) {
+                int64_t us = buffer->TakeTransitionTimeUS(layer);
+                if (us != 0 && info.profileEffects[layer] != nullptr) {
+                    info.profileModel->blendUS -= us;
+                    info.profileModel->transitionUS += us;
+                    info.profileEffects[layer]->transitionUS += us;
+                    info.profileLayers[layer]->transitionUS += us;
+                }
+            }
         }
-
         if (sw.Time() > 500) {
             RenderBuffer& b = buffer->BufferForLayer(0, -1);
             renderLog.info("*** Frame #%d at %dms render on model %s (%dx%d) took more than 1/2s => %dms.", frame, frame * b.frameTimeInMs, (const char *)el->GetName().c_str(), b.BufferWi, b.BufferHt, sw.Time());
@@ -741,22 +900,108 @@ public:
             SetGenericStatus("%s: Processing frame %d ", frame, true, true);
         }
     }
+
+    void SetRenderPool(JobPool *p) {
+        renderPool = p;
+    }
+
+    virtual void setPreviousFrameDone(int frame) override {
+        NextRenderer::setPreviousFrameDone(frame);
+        if (frame >= waitingForFrame && parked.exchange(false)) {
+            // the rows we depend on have caught up, get back in line
+            renderPool->PushJob(this);
+        }
+    }
+
+    // The job is driven by the render DAG.  Each call renders as many frames as the rows
+    // it depends on have completed and then hands the thread back to the pool rather than
+    // blocking, setPreviousFrameDone re-queues it when more input frames are available.
     virtual void Process() override {
-        static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
         static log4cpp::Category& logger_jobpool = log4cpp::Category::getInstance(std::string("log_jobpool"));
-        logger_jobpool.debug("Render job thread id 0x%x or %d", wxThread::GetCurrentId(), wxThread::GetCurrentId());
 
+        auto now = std::chrono::steady_clock::now();
+        if (renderState == RenderState::STARTING) {
+            logger_jobpool.debug("Render job thread id 0x%x or %d", wxThread::GetCurrentId(), wxThread::GetCurrentId());
+        } else {
+            waitTimeUS += std::chrono::duration_cast<std::chrono::microseconds>(now - idleSince).count();
+        }
+        ++slices;
+
+        std::unique_lock<std::recursive_timed_mutex> lock(rowToRender->GetRenderLock(), std::defer_lock);
+        if (renderState == RenderState::STARTING) {
+            if (!StartRender(lock)) {
+                return;
+            }
+        } else {
+            lock.lock();
+            if (renderState == RenderState::RENDERING && (rowToRender->GetEffectLayerCount() != numLayers || rowToRender->getChangeCount() != parkedChangeCount)) {
+                // the row was edited while we were waiting on input, the layers may not line up with
+                // the layer infos and the effects we are part way through may have been deleted and
+                // their memory reused so leave the rest for the next render
+                rowToRender->SetDirtyRange(nextFrame * seqData->FrameTime(), endFrame * seqData->FrameTime());
+                renderState = RenderState::FINISHING;
+            }
+        }
+        sliceStart = std::chrono::steady_clock::now();
+        waitTimeUS += std::chrono::duration_cast<std::chrono::microseconds>(sliceStart - now).count();
+
+        if (renderState == RenderState::RENDERING && !RenderFrames(lock)) {
+            // parked waiting on input, another thread may already own the job
+            return;
+        }
+        if (HasNext()) {
+            //make sure the previous has told us we're at the end.  If we return before waiting, the previous
+            //may try sending the END_OF_RENDER_FRAME to us and we'll have been deleted
+            SetGenericStatus("%s: Waiting on previous renderer for final frame", 0, true);
+            if (!WaitForInput(END_OF_RENDER_FRAME, lock)) {
+                return;
+            }
+
+            //let the next know we're done
+            SetGenericStatus("%s: Notifying next renderer of final frame", 0, true);
+            FrameDone(END_OF_RENDER_FRAME);
+            xLights->CallAfter(&xLightsFrame::SetStatusText, wxString("Done Rendering \"" + rowToRender->GetModelName() + "\""), 0);
+            SetGenericStatus("%s: All done - Completed frame %d ", endFrame, true, false);
+        } else {
+            xLights->CallAfter(&xLightsFrame::RenderDone);
+        }
+        rowToRender->CleanupAfterRender();
+        renderState = RenderState::DONE;
+        computeTimeUS += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sliceStart).count();
+        lock.unlock();
+        //printf("Done rendering %lx (next %lx)\n", (unsigned long)this, (unsigned long)next);
+        renderLog.debug("Rendering thread exiting.");
+        // once this is set the job can be deleted at any time
+        currentFrame = END_OF_RENDER_FRAME;
+    }
+
+    int GetWaitTimeMS() const { return (int)(waitTimeUS / 1000); }
+    int GetComputeTimeMS() const { return (int)(computeTimeUS / 1000); }
+    int GetSliceCount() const { return slices; }
+
+    void AbortRender() {
+        abort = true;
+    }
+
+    ModelElement* GetModelElement() const { return rowToRender; }
+
+private:
+
+    // first slice, grab the row and set up the effects at the start frame
+    // returns false if the job has nothing to do
+    bool StartRender(std::unique_lock<std::recursive_timed_mutex> &lock) {
         SetGenericStatus("Initializing rendering thread for %s", 0);
-        int origChangeCount;
         int ss, es;
 
         rowToRender->IncWaitCount();
-        std::unique_lock<std::recursive_timed_mutex> lock(rowToRender->GetRenderLock());
+        lock.lock();
         if (rowToRender->DecWaitCount() && !HasNext()) {
             // other threads for this model waiting, we'll bail fast and let them handle this
             renderLog.debug("Rendering thread exiting early.");
+            renderState = RenderState::DONE;
+            lock.unlock();
             currentFrame = END_OF_RENDER_FRAME; // this is needed otherwise the job does not look done
-            return;
+            return false;
         }
         SetGenericStatus("Got lock on rendering thread for %s", 0);
 
@@ -781,12 +1026,9 @@ public:
         if (startFrame < 0) startFrame = 0;
         if (endFrame > (int)seqData->NumFrames()) endFrame = seqData->NumFrames() - 1;
 
-        EffectLayerInfo mainModelInfo(numLayers);
-        std::map<SNPair, Effect*> nodeEffects;
-        std::map<SNPair, SettingsMap> nodeSettingsMaps;
-        std::map<SNPair, bool> nodeEffectStates;
-        std::map<SNPair, int> nodeEffectIdxs;
-
+        mainModelInfo.resize(numLayers);
+        renderState = RenderState::RENDERING;
+        nextFrame = startFrame;
         try {
             //for (int layer = 0; layer < numLayers; ++layer) {
             for (int layer = numLayers - 1; layer >= 0; --layer) {
@@ -798,10 +1040,94 @@ public:
                 initialize(layer, startFrame, mainModelInfo.currentEffects[layer], mainModelInfo.settingsMaps[layer], mainBuffer);
                 mainModelInfo.effectStates[layer] = true;
             }
+            AttachLayerFrameCaches(rowToRender, mainModelInfo, mainBuffer);
+            for (const auto& a : subModelInfos) {
+                AttachLayerFrameCaches(a->element, *a, a->buffer.get());
+            }
+        } catch (std::exception &ex) {
+            LogException(ex.what());
+            renderState = RenderState::FINISHING;
+        } catch (...) {
+            LogException(nullptr);
+            renderState = RenderState::FINISHING;
+        }
+        return true;
+    }
+
+    void AttachLayerFrameCaches(Element* el, EffectLayerInfo& info, PixelBufferClass* buffer) {
+        for (int layer = 0; layer < (int)el->GetEffectLayerCount() && layer < (int)info.cacheStates.size(); ++layer) {
+            buffer->SetLayerFrameCache(layer, el->GetEffectLayer(layer)->GetFrameCache());
+            info.cacheStates[layer] = LayerCacheState::UNDECIDED;
+            info.saveToCache[layer] = false;
+        }
+    }
+
+    // Layers rendered up to lastFrame may have changed where the persistent effects that
+    // carry on after lastFrame start from, their cached frames can't be used any more
+    void InvalidatePersistentFramesAfter(int lastFrame, Element* el, EffectLayerInfo& info, PixelBufferClass* buffer) {
+        for (int layer = 0; layer < (int)el->GetEffectLayerCount() && layer < (int)info.cacheStates.size(); ++layer) {
+            LayerFrameCache* cache = buffer->GetLayerFrameCache(layer);
+            if (cache == nullptr || info.cacheStates[layer] != LayerCacheState::RENDER) {
+                continue;
+            }
+            EffectLayer* elayer = el->GetEffectLayer(layer);
+            std::unique_lock<std::recursive_mutex> elock(elayer->GetLock());
+            int idx = 0;
+            Effect* ef = findEffectForFrame(elayer, lastFrame, idx);
+            int endMS = -1;
+            if (ef != nullptr && ef->IsPersistent()) {
+                endMS = ef->GetEndTimeMS();
+            }
+            if (ef != nullptr) {
+                Effect* next = elayer->GetEffectStartingAtTime(ef->GetEndTimeMS());
+                while (next != nullptr && next->IsPersistent()) {
+                    endMS = next->GetEndTimeMS();
+                    next = elayer->GetEffectStartingAtTime(endMS);
+                }
+            }
+            if (endMS != -1) {
+                cache->InvalidateFrames(lastFrame + 1, (endMS - 1) / seqData->FrameTime());
+            }
+        }
+    }
 
-            for (int frame = startFrame; frame <= endFrame; ++frame) {
+    // returns true if the inputs for the frame are available, false if the job has been
+    // parked until they are in which case the caller must return without touching the job
+    bool WaitForInput(int frame, std::unique_lock<std::recursive_timed_mutex> &lock) {
+        if (previousFrameDone >= frame) {
+            return true;
+        }
+        SetWaitingStatus(frame);
+        if (renderPool == nullptr) {
+            auto s = std::chrono::steady_clock::now();
+            waitForFrame(frame);
+            waitTimeUS += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s).count();
+            return true;
+        }
+        idleSince = std::chrono::steady_clock::now();
+        computeTimeUS += std::chrono::duration_cast<std::chrono::microseconds>(idleSince - sliceStart).count();
+        parkedChangeCount = rowToRender->getChangeCount();
+        lock.unlock();
+        waitingForFrame = frame;
+        parked = true;
+        if (previousFrameDone >= frame) {
+            // the frame completed while we were parking, if the notification didn't
+            // already re-queue us then do it ourselves
+            bool expected = true;
+            if (parked.compare_exchange_strong(expected, false)) {
+                renderPool->PushJob(this);
+            }
+        }
+        return false;
+    }
+
+    // returns false if the job was parked waiting on input
+    bool RenderFrames(std::unique_lock<std::recursive_timed_mutex> &lock) {
+        static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        try {
+            for (; nextFrame <= endFrame; ++nextFrame) {
+                int frame = nextFrame;
                 currentFrame = frame;
-                SetGenericStatus("%s: Starting frame %d ", frame, true, true);
 
                 if (abort) {
                     rowToRender->SetDirtyRange(frame * seqData->FrameTime(), endFrame * seqData->FrameTime());
@@ -815,10 +1141,10 @@ public:
                     rowToRender->SetDirtyRange(frame * seqData->FrameTime(), endFrame * seqData->FrameTime());
                     break;
                 }
-                if (abort) {
-                    rowToRender->SetDirtyRange(frame * seqData->FrameTime(), endFrame * seqData->FrameTime());
-                    break;
+                if (!WaitForInput(frame, lock)) {
+                    return false;
                 }
+                SetGenericStatus("%s: Starting frame %d ", frame, true, true);
 
                 bool cleared = ProcessFrame(frame, rowToRender, mainModelInfo, mainBuffer, -1, supportsModelBlending);
                 if (!subModelInfos.empty()) {
@@ -873,13 +1199,34 @@ public:
                         }
 
                         SetRenderingStatus(frame, &nodeSettingsMaps[node], -1, -1, strand, inode, cleared);
-                        if (xLights->RenderEffectFromMap(false, el, 0, frame, nodeSettingsMaps[node], *buffer, nodeEffectStates[node], true, &renderEvent)) {
+                        auto start = ProfileStart(profiling && el != nullptr);
+                        bool rendered = xLights->RenderEffectFromMap(false, el, 0, frame, nodeSettingsMaps[node], *buffer, nodeEffectStates[node], true, &renderEvent);
+                        RenderProfileTimes* modelTimes = nullptr;
+                        RenderProfileTimes* effectTimes = nullptr;
+                        if (profiling && el != nullptr) {
+                            int64_t us = MicrosecondsSince(start);
+                            modelTimes = &profile.models[rowToRender->GetFullName()];
+                            effectTimes = &profile.effects[el->GetEffectName()];
+                            for (auto t : { modelTimes, effectTimes }) {
+                                t->renderUS += us;
+                                t->renders++;
+                            }
+                        }
+                        if (rendered) {
                             SetCalOutputStatus(frame, -1, strand, inode);
                             //copy to output
+                            start = ProfileStart(modelTimes != nullptr);
                             std::vector<bool> valid(2, true);
                             buffer->SetColors(1, &((*seqData)[frame][0]));
-                            buffer->CalcOutput(frame, valid);
+                            buffer->CalcOutput(frame, valid, 0, modelTimes != nullptr);
                             buffer->GetColors(&((*seqData)[frame][0]), rangeRestriction);
+                            if (modelTimes != nullptr) {
+                                int64_t us = MicrosecondsSince(start);
+                                int64_t tus = buffer->TakeTransitionTimeUS(0);
+                                modelTimes->blendUS += us - tus;
+                                modelTimes->transitionUS += tus;
+                                effectTimes->transitionUS += tus;
+                            }
                         }
                     }
                 }
@@ -889,46 +1236,34 @@ public:
                     FrameDone(frame);
                 }
             }
+            InvalidatePersistentFramesAfter(nextFrame - 1, rowToRender, mainModelInfo, mainBuffer);
+            for (const auto& a : subModelInfos) {
+                InvalidatePersistentFramesAfter(nextFrame - 1, a->element, *a, a->buffer.get());
+            }
             SetGenericStatus("%s: All done - Completed frame %d ", endFrame, true, false);
-        } catch ( std::exception &ex) {
-            wxASSERT(false); // so when we debug we catch them
-            printf("Caught an exception %s", ex.what());
-			renderLog.error("Caught an exception on rendering thread: " + std::string(ex.what()));
-            logger_base.error("Caught an exception on rendering thread: %s", ex.what());
-		} catch ( ... ) {
-            wxASSERT(false); // so when we debug we catch them
-            printf("Caught an unknown exception");
-			renderLog.error("Caught an unknown exception on rendering thread.");
-            logger_base.error("Caught an unknown exception on rendering thread.");
+        } catch (std::exception &ex) {
+            LogException(ex.what());
+        } catch (...) {
+            LogException(nullptr);
         }
-        if (HasNext()) {
-            //make sure the previous has told us we're at the end.  If we return before waiting, the previous
-            //may try sending the END_OF_RENDER_FRAME to us and we'll have been deleted
-            SetGenericStatus("%s: Waiting on previous renderer for final frame", 0, true);
-            waitForFrame(END_OF_RENDER_FRAME);
+        renderState = RenderState::FINISHING;
+        return true;
+    }
 
-            //let the next know we're done
-            SetGenericStatus("%s: Notifying next renderer of final frame", 0, true);
-            FrameDone(END_OF_RENDER_FRAME);
-            xLights->CallAfter(&xLightsFrame::SetStatusText, wxString("Done Rendering \"" + rowToRender->GetModelName() + "\""), 0);
-            SetGenericStatus("%s: All done - Completed frame %d ", endFrame, true, false);
+    void LogException(const char *what) {
+        static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        wxASSERT(false); // so when we debug we catch them
+        if (what != nullptr) {
+            printf("Caught an exception %s", what);
+            renderLog.error("Caught an exception on rendering thread: " + std::string(what));
+            logger_base.error("Caught an exception on rendering thread: %s", what);
         } else {
-            xLights->CallAfter(&xLightsFrame::RenderDone);
+            printf("Caught an unknown exception");
+            renderLog.error("Caught an unknown exception on rendering thread.");
+            logger_base.error("Caught an unknown exception on rendering thread.");
         }
-        rowToRender->CleanupAfterRender();
-        currentFrame = END_OF_RENDER_FRAME;
-        //printf("Done rendering %lx (next %lx)\n", (unsigned long)this, (unsigned long)next);
-		renderLog.debug("Rendering thread exiting.");
-	}
-
-    void AbortRender() {
-        abort = true;
     }
 
-    ModelElement* GetModelElement() const { return rowToRender; }
-
-private:
-
     void initialize(int layer, int frame, Effect *el, SettingsMap &settingsMap, PixelBufferClass *buffer) {
         bool layerEnabled = true;
         if (el == nullptr || el->GetEffectIndex() == -1) {
@@ -1034,6 +1369,37 @@ private:
     std::vector<EffectLayerInfo *> subModelInfos;
 
     std::map<SNPair, PixelBufferClassPtr> nodeBuffers;
+
+    // per render state kept between slices
+    enum class RenderState {
+        STARTING,
+        RENDERING,
+        FINISHING,
+        DONE
+    };
+    RenderState renderState = RenderState::STARTING;
+    int nextFrame = 0;
+    int origChangeCount = 0;
+    EffectLayerInfo mainModelInfo;
+    std::map<SNPair, Effect*> nodeEffects;
+    std::map<SNPair, SettingsMap> nodeSettingsMaps;
+    std::map<SNPair, bool> nodeEffectStates;
+    std::map<SNPair, int> nodeEffectIdxs;
+
+    // scheduling
+    JobPool *renderPool = nullptr;
+    std::atomic_bool parked = false;
+    int parkedChangeCount = 0; // the row's change count when it was parked, see Process
+    std::atomic_int waitingForFrame = 0;
+    std::chrono::steady_clock::time_point sliceStart;
+    std::chrono::steady_clock::time_point idleSince;
+    std::atomic<int64_t> waitTimeUS = 0;
+    std::atomic<int64_t> computeTimeUS = 0;
+    std::atomic_int slices = 0;
+
+    // only touched by the thread rendering the job
+    bool profiling = RenderProfiler::GetDefaultProfiler().IsEnabled();
+    RenderProfile profile;
 };
 
 
@@ -1103,8 +1469,11 @@ public:
     int endFrame;
     RenderJob **jobs;
     AggregatorRenderer **aggregators;
+    AggregatorRenderer *fseqAggregator = nullptr;
+    NextRenderer *fseqRenderer = nullptr;
     RenderProgressDialog *renderProgressDialog;
     std::list<Model *> restriction;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
 };
 
 void xLightsFrame::LogRenderStatus()
@@ -1125,6 +1494,7 @@ void xLightsFrame::LogRenderStatus()
                 }
 
                 logger_base.debug("    Progress %s - %ld%%.", (const char *)job->GetName().c_str(), (long)(curFrame - it->startFrame + 1) * 100 / frames);
+                logger_base.debug("             Compute %dms, Waiting %dms, Slices %d.", job->GetComputeTimeMS(), job->GetWaitTimeMS(), job->GetSliceCount());
                 std::string su = job->GetStatusForUser();
                 if (!su.empty()) {
                     logger_base.debug("             %s.", (const char *)su.c_str());
@@ -1255,12 +1625,44 @@ void xLightsFrame::UpdateRenderStatus() {
         }
 
         if (done) {
+            static log4cpp::Category &logger_render = log4cpp::Category::getInstance(std::string("log_render"));
+            if (logger_render.isDebugEnabled()) {
+                long computeMS = 0;
+                long waitMS = 0;
+                for (size_t row = 0; row < rpi->numRows; ++row) {
+                    if (rpi->jobs[row]) {
+                        computeMS += rpi->jobs[row]->GetComputeTimeMS();
+                        waitMS += rpi->jobs[row]->GetWaitTimeMS();
+                    }
+                }
+                logger_render.debug("Render of %d rows complete. Total compute %ldms, total waiting on other rows %ldms.", countModels, computeMS, waitMS);
+
+                auto& textCache = TextLineCache::GetDefaultCache();
+                logger_render.debug("Text line cache: %u hits, %u misses, holding %d lines in %dKB.",
+                                    textCache.GetHits(), textCache.GetMisses(), (int)textCache.GetCount(), (int)(textCache.GetBytes() / 1024));
+            }
+            TextLineCache::GetDefaultCache().ResetCounters();
+
+            RenderProfile profile;
+            for (size_t row = 0; row < rpi->numRows; ++row) {
+                if (rpi->jobs[row]) {
+                    profile.Add(rpi->jobs[row]->GetProfile());
+                }
+            }
+            if (!profile.IsEmpty()) {
+                profile.wallUS = MicrosecondsSince(rpi->startTime);
+                RenderProfiler::GetDefaultProfiler().Add(profile);
+                logger_render.info("%s", (const char*)profile.GetReport().c_str());
+            }
+
             for (size_t row = 0; row < rpi->numRows; ++row) {
                 if (rpi->jobs[row]) {
                     delete rpi->jobs[row];
                 }
                 delete rpi->aggregators[row];
             }
+            delete rpi->fseqAggregator;
+            delete rpi->fseqRenderer;
             if (rpi->renderProgressDialog) {
                 delete rpi->renderProgressDialog;
                 rpi->renderProgressDialog = nullptr;
@@ -1398,6 +1800,11 @@ void xLightsFrame::RenderTree::Print() {
 }
 
 void xLightsFrame::BuildRenderTree() {
+    if (renderTree.modelsChangeCount != modelsChangeCount) {
+        // the models have changed, the layers rendered for them before can't be reused
+        LayerFrameCache::InvalidateAll();
+        renderTree.modelsChangeCount = modelsChangeCount;
+    }
     unsigned int curChangeCount = _sequenceElements.GetMasterViewChangeCount() + modelsChangeCount;
     if (renderTree.renderTreeChangeCount != curChangeCount) {
         renderTree.Clear();
@@ -1426,7 +1833,8 @@ void xLightsFrame::Render(SequenceElements& seqElements,
                           const std::list<Model *> &restrictToModels,
                           int startFrame, int endFrame,
                           bool progressDialog, bool clear,
-                          std::function<void(bool)>&& callback)
+                          std::function<void(bool)>&& callback,
+                          FSEQStreamWriter* fseqStream)
 {
     abortedRenderJobs = 0;
 
@@ -1452,7 +1860,8 @@ void xLightsFrame::Render(SequenceElements& seqElements,
     int numRows = models.size();
     RenderJob **jobs = new RenderJob*[numRows];
     AggregatorRenderer **aggregators = new AggregatorRenderer*[numRows];
-    std::vector<std::set<int>> channelMaps(seqData.NumChannels());
+    // channel ranges of each row, used to build the dependency graph between the rows
+    std::vector<std::unique_ptr<RenderTreeData>> rowRanges(numRows);
 
     size_t row = 0;
     for (auto it = models.begin(); it != models.end(); ++it, ++row) {
@@ -1482,6 +1891,7 @@ void xLightsFrame::Render(SequenceElements& seqElements,
 
                     job->setRenderRange(startFrame, endFrame);
                     job->SetRangeRestriction(ranges);
+                    job->SetRenderPool(&jobPool);
                     if (seqElements.SupportsModelBlending()) {
                         job->SetModelBlending();
                     }
@@ -1493,21 +1903,13 @@ void xLightsFrame::Render(SequenceElements& seqElements,
 
                     jobs[row] = job;
                     aggregators[row]->addNext(job);
-                    size_t cn = buffer->GetChanCountPerNode();
-                    for (size_t node = 0; node < buffer->GetNodeCount(); ++node) {
-                        uint32_t start = buffer->NodeStartChannel(node);
-                        for (size_t c = 0; c < cn; ++c) {
-                            size_t cnum = start + c;
-                            if (cnum < seqData.NumChannels()) {
-                                for (const auto i : channelMaps[cnum]) {
-                                    int idx = i;
-                                    if (idx != row) {
-                                        if (jobs[idx]->addNext(aggregators[row])) {
-                                            aggregators[row]->incNumAggregated();
-                                        }
-                                    }
-                                }
-                                channelMaps[cnum].insert(row);
+
+                    // this row consumes the output of every earlier row it overlaps
+                    rowRanges[row].reset(new RenderTreeData(*it));
+                    for (size_t idx = 0; idx < row; ++idx) {
+                        if (jobs[idx] != nullptr && rowRanges[idx]->Overlaps(*rowRanges[row])) {
+                            if (jobs[idx]->addNext(aggregators[row])) {
+                                aggregators[row]->incNumAggregated();
                             }
                         }
                     }
@@ -1516,9 +1918,22 @@ void xLightsFrame::Render(SequenceElements& seqElements,
         }
     }
 
+    AggregatorRenderer *fseqAggregator = nullptr;
+    FSEQStreamRenderer *fseqRenderer = nullptr;
+    if (fseqStream != nullptr) {
+        fseqAggregator = new AggregatorRenderer(seqData.NumFrames());
+        fseqRenderer = new FSEQStreamRenderer(fseqStream, endFrame);
+        fseqAggregator->addNext(fseqRenderer);
+        for (row = 0; row < numRows; ++row) {
+            if (jobs[row] != nullptr && jobs[row]->addNext(fseqAggregator)) {
+                fseqAggregator->incNumAggregated();
+            }
+        }
+    }
+
     logger_render.debug("Aggregators created.");
 
-    channelMaps.clear();
+    rowRanges.clear();
     RenderProgressDialog *renderProgressDialog = nullptr;
     if (progressDialog) {
         renderProgressDialog = new RenderProgressDialog(this);
@@ -1581,10 +1996,14 @@ void xLightsFrame::Render(SequenceElements& seqElements,
         pi->renderProgressDialog = renderProgressDialog;
         pi->restriction = restrictToModels;
         pi->aggregators = aggregators;
+        pi->fseqAggregator = fseqAggregator;
+        pi->fseqRenderer = fseqRenderer;
 
         renderProgressInfo.push_back(pi);
         RenderStatusTimer.Start(100, false);
     } else {
+        delete fseqAggregator;
+        delete fseqRenderer;
         callback(abortedRenderJobs > 0);
         if (progressDialog) {
             delete renderProgressDialog;
@@ -1746,7 +2165,7 @@ bool xLightsFrame::AbortRender(int maxTimeMS, int* numThreadsAborted)
     return renderProgressInfo.empty();
 }
 
-void xLightsFrame::RenderGridToSeqData(std::function<void(bool)>&& callback) {
+void xLightsFrame::RenderGridToSeqData(std::function<void(bool)>&& callback, FSEQStreamWriter* fseqStream) {
 
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
@@ -1778,6 +2197,10 @@ void xLightsFrame::RenderGridToSeqData(std::function<void(bool)>&& callback) {
     }
     std::list<Model*> restricts;
 
+    // a full render is how the user picks up changes to images, videos, fonts etc used by the
+    // effects so nothing rendered before is reused
+    LayerFrameCache::InvalidateAll();
+
     logger_base.debug("Rendering %d models %d frames.", models.size(), _seqData.NumFrames());
 
 
@@ -1796,7 +2219,7 @@ void xLightsFrame::RenderGridToSeqData(std::function<void(bool)>&& callback) {
         });
     });
 #else
-    Render(_sequenceElements, _seqData, models, restricts, 0, _seqData.NumFrames() - 1, true, false, std::move(callback));
+    Render(_sequenceElements, _seqData, models, restricts, 0, _seqData.NumFrames() - 1, true, false, std::move(callback), fseqStream);
 #endif
 }
 
@@ -1869,6 +2292,61 @@ void xLightsFrame::RenderEffectForModel(const std::string &model, int startms, i
     }
 }
 
+bool xLightsFrame::RenderModelToSeqData(Model* model, SequenceData& seqData) {
+
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    // data layers are only mixed in by a full render
+    if (CurrentSeqXmlFile == nullptr || CurrentSeqXmlFile->GetDataLayers().GetNumLayers() > 1) {
+        return false;
+    }
+
+    BuildRenderTree();
+    RenderTreeData* modelData = nullptr;
+    for (const auto& it : renderTree.data) {
+        if (it->model == model) {
+            modelData = it;
+        }
+    }
+    if (modelData == nullptr) {
+        return false;
+    }
+
+    // the models blended under it and, like RenderDirtyModels, everything that blends on top
+    // of those so the export has the same channel data as a full render
+    std::list<Model*> models;
+    addModelsUpTo(models, modelData->renderOrder, model);
+    for (auto x = models.begin(); x != models.end(); ++x) {
+        for (const auto& it : renderTree.data) {
+            if (it->model == *x) {
+                addModelsFrom(models, it->renderOrder, it->model);
+            }
+        }
+    }
+    std::list<Model*> restricts;
+    restricts.push_back(model);
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (const auto& it : modelData->ranges) {
+        ranges.push_back(std::pair<uint32_t, uint32_t>(it.start, it.end - it.start + 1));
+    }
+    seqData.initSparse(_seqData.NumChannels(), _seqData.NumFrames(), _seqData.FrameTime(), ranges);
+    if (!seqData.IsValidData()) {
+        return false;
+    }
+
+    logger_base.debug("Rendering %d models to export %s.", (int)models.size(), (const char *)model->GetName().c_str());
+    bool done = false;
+    bool aborted = false;
+    Render(_sequenceElements, seqData, models, restricts, 0, seqData.NumFrames() - 1, false, true, [&done, &aborted] (bool a) {
+        aborted = a;
+        done = true;
+    });
+    while (!done) {
+        wxYield();
+    }
+    return !aborted;
+}
+
 void xLightsFrame::RenderTimeSlice(int startms, int endms, bool clear) {
 
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
@@ -1976,22 +2454,30 @@ bool xLightsFrame::DoExportModel(unsigned int startFrame, unsigned int endFrame,
     wxASSERT(data != nullptr);
     int cpn = job->getBuffer()->GetChanCountPerNode();
 
+    // rendering only the model and what it depends on into sparse frames keeps the memory
+    // used in proportion to the model rather than the whole show
+    SequenceData modelData;
+    SequenceData* source = &_seqData;
     if (doRender) {
-        RenderAll();
-        // Render all to capture any effects at the group levels
-        // wait to complete
-        while (mRendering) {
-            wxYield();
+        if (RenderModelToSeqData(m, modelData)) {
+            source = &modelData;
+        } else {
+            RenderAll();
+            // Render all to capture any effects at the group levels
+            // wait to complete
+            while (mRendering) {
+                wxYield();
+            }
         }
     }
     Model* m2 = GetModel(model);
-    for (size_t frame = 0; frame < _seqData.NumFrames(); ++frame) {
+    for (size_t frame = 0; frame < source->NumFrames(); ++frame) {
         for (size_t x = 0; x < job->getBuffer()->GetNodeCount(); ++x) {
             //chan in main buffer
             int ostart = m2->NodeStartChannel(x);
             int nstart = job->getBuffer()->NodeStartChannel(x);
             //copy to render buffer for export
-            job->getBuffer()->SetNodeChannelValues(x, &_seqData[frame][ostart]);
+            job->getBuffer()->SetNodeChannelValues(x, &(*source)[frame][ostart]);
             job->getBuffer()->GetNodeChannelValues(x, &((*data)[frame][nstart]));
         }
     }
@@ -0,0 +1,240 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+// needed to ensure the __WXMSW__ is defined
+#include <wx/wx.h>
+
+#include <algorithm>
+#include <cstdio>
+
+#ifdef __WXMSW__
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifdef __WXOSX__
+#include <mach/mach.h>
+#include <pthread.h>
+#endif
+
+#ifdef LINUX
+#include <dirent.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#endif
+
+#include "RenderBenchmark.h"
+#include "SequenceData.h"
+#include "UtilFunctions.h"
+
+void RenderBenchmark::Start()
+{
+    _startThreads = GetThreadTimes();
+    _start = std::chrono::steady_clock::now();
+}
+
+void RenderBenchmark::Finish(const SequenceData& data)
+{
+    _elapsedUS = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start).count();
+    _frames = data.NumFrames();
+    _channels = data.NumChannels();
+    _frameTime = data.FrameTime();
+
+    _threads.clear();
+    for (const auto& it : GetThreadTimes()) {
+        ThreadTime t = it.second;
+        auto s = _startThreads.find(it.first);
+        if (s != _startThreads.end()) {
+            t.cpuUS -= s->second.cpuUS;
+        }
+        // threads that were just sitting there
+        if (t.cpuUS >= 1000) {
+            _threads.push_back(t);
+        }
+    }
+    std::stable_sort(_threads.begin(), _threads.end(), [](const ThreadTime& a, const ThreadTime& b) { return a.cpuUS > b.cpuUS; });
+
+    _checksum = Checksum(data);
+    _peakMemoryKB = GetProcessPeakMemoryKB();
+}
+
+double RenderBenchmark::GetFPS() const
+{
+    return _elapsedUS == 0 ? 0.0 : _frames * 1000000.0 / _elapsedUS;
+}
+
+static std::string FormatChecksum(uint64_t checksum)
+{
+    char buf[20];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)checksum);
+    return buf;
+}
+
+std::string RenderBenchmark::GetReport(const std::string& sequence) const
+{
+    char buf[512];
+    snprintf(buf, sizeof(buf), "Benchmark of %s: %u frames of %u channels rendered in %.3fs, %.1f frames/sec.\n"
+                               "    Peak memory %lluMB, checksum %s.\n",
+             sequence.c_str(), _frames, _channels, _elapsedUS / 1000000.0, GetFPS(),
+             (unsigned long long)(_peakMemoryKB / 1024), FormatChecksum(_checksum).c_str());
+    std::string report = buf;
+    for (const auto& it : _threads) {
+        snprintf(buf, sizeof(buf), "    %-20s %9.3fs CPU, %5.1f%% busy\n",
+                 it.name.c_str(), it.cpuUS / 1000000.0, _elapsedUS == 0 ? 0.0 : it.cpuUS * 100.0 / _elapsedUS);
+        report += buf;
+    }
+    return report;
+}
+
+std::string RenderBenchmark::GetJSON(const std::string& sequence) const
+{
+    char buf[512];
+    snprintf(buf, sizeof(buf), "\",\"frames\":%u,\"channels\":%u,\"frameMS\":%u,\"elapsedMS\":%.3f,\"fps\":%.3f,\"peakMemoryMB\":%llu,\"checksum\":\"%s\",\"threads\":[",
+             _frames, _channels, _frameTime, _elapsedUS / 1000.0, GetFPS(),
+             (unsigned long long)(_peakMemoryKB / 1024), FormatChecksum(_checksum).c_str());
+    std::string json = "{\"sequence\":\"" + JSONSafe(sequence) + buf;
+    for (size_t i = 0; i < _threads.size(); i++) {
+        snprintf(buf, sizeof(buf), "\",\"cpuMS\":%.3f,\"utilisation\":%.3f}",
+                 _threads[i].cpuUS / 1000.0, _elapsedUS == 0 ? 0.0 : (double)_threads[i].cpuUS / _elapsedUS);
+        json += std::string(i == 0 ? "" : ",") + "{\"name\":\"" + JSONSafe(_threads[i].name) + buf;
+    }
+    return json + "]}";
+}
+
+uint64_t RenderBenchmark::Checksum(const SequenceData& data)
+{
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned int f = 0; f < data.NumFrames(); f++) {
+        const unsigned char* d = data[f][0];
+        for (unsigned int c = 0; c < data.NumChannels(); c++) {
+            hash ^= d[c];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+uint64_t RenderBenchmark::GetProcessPeakMemoryKB()
+{
+#ifdef __WXMSW__
+    PROCESS_MEMORY_COUNTERS mc;
+    if (::GetProcessMemoryInfo(::GetCurrentProcess(), &mc, sizeof(mc)) != 0) {
+        return mc.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __WXOSX__
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+std::map<uint64_t, ThreadTime> RenderBenchmark::GetThreadTimes()
+{
+    std::map<uint64_t, ThreadTime> res;
+#if defined(__WXMSW__)
+    HANDLE snap = ::CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snap == INVALID_HANDLE_VALUE) {
+        return res;
+    }
+    DWORD pid = ::GetCurrentProcessId();
+    THREADENTRY32 te;
+    te.dwSize = sizeof(te);
+    for (BOOL ok = ::Thread32First(snap, &te); ok; ok = ::Thread32Next(snap, &te)) {
+        if (te.th32OwnerProcessID != pid) continue;
+        HANDLE h = ::OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, te.th32ThreadID);
+        if (h == nullptr) continue;
+        FILETIME created, exited, kernel, user;
+        if (::GetThreadTimes(h, &created, &exited, &kernel, &user)) {
+            ULARGE_INTEGER k, u;
+            k.LowPart = kernel.dwLowDateTime;
+            k.HighPart = kernel.dwHighDateTime;
+            u.LowPart = user.dwLowDateTime;
+            u.HighPart = user.dwHighDateTime;
+            ThreadTime& t = res[te.th32ThreadID];
+            t.name = "Thread " + std::to_string(te.th32ThreadID);
+            t.cpuUS = (int64_t)((k.QuadPart + u.QuadPart) / 10); // 100ns units
+        }
+        ::CloseHandle(h);
+    }
+    ::CloseHandle(snap);
+#elif defined(__WXOSX__)
+    thread_act_array_t threads;
+    mach_msg_type_number_t count = 0;
+    if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS) {
+        return res;
+    }
+    for (mach_msg_type_number_t i = 0; i < count; i++) {
+        thread_basic_info_data_t info;
+        mach_msg_type_number_t infoCount = THREAD_BASIC_INFO_COUNT;
+        if (thread_info(threads[i], THREAD_BASIC_INFO, (thread_info_t)&info, &infoCount) == KERN_SUCCESS) {
+            uint64_t tid = threads[i];
+            thread_identifier_info_data_t ident;
+            infoCount = THREAD_IDENTIFIER_INFO_COUNT;
+            if (thread_info(threads[i], THREAD_IDENTIFIER_INFO, (thread_info_t)&ident, &infoCount) == KERN_SUCCESS) {
+                tid = ident.thread_id;
+            }
+            ThreadTime& t = res[tid];
+            char name[64] = "";
+            pthread_t pt = pthread_from_mach_thread_np(threads[i]);
+            if (pt != nullptr) {
+                pthread_getname_np(pt, name, sizeof(name));
+            }
+            t.name = name[0] ? name : "Thread " + std::to_string(tid);
+            t.cpuUS = ((int64_t)info.user_time.seconds + info.system_time.seconds) * 1000000 + info.user_time.microseconds + info.system_time.microseconds;
+        }
+        mach_port_deallocate(mach_task_self(), threads[i]);
+    }
+    vm_deallocate(mach_task_self(), (vm_address_t)threads, count * sizeof(thread_act_t));
+#elif defined(LINUX)
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return res;
+    }
+    long ticks = sysconf(_SC_CLK_TCK);
+    while (struct dirent* e = readdir(dir)) {
+        if (e->d_name[0] == '.') continue;
+        std::string task = std::string("/proc/self/task/") + e->d_name;
+        std::ifstream stat(task + "/stat");
+        std::string line;
+        if (!std::getline(stat, line)) continue;
+
+        // the name is in brackets and can hold spaces and brackets of its own
+        size_t close = line.rfind(')');
+        if (close == std::string::npos) continue;
+        std::istringstream fields(line.substr(close + 1));
+        std::string field;
+        int64_t utime = 0, stime = 0;
+        // state is field 3, utime and stime are 14 and 15
+        for (int f = 3; f <= 15 && fields >> field; f++) {
+            if (f == 14) utime = std::atoll(field.c_str());
+            if (f == 15) stime = std::atoll(field.c_str());
+        }
+
+        ThreadTime& t = res[std::strtoull(e->d_name, nullptr, 10)];
+        std::ifstream comm(task + "/comm");
+        std::getline(comm, t.name);
+        t.cpuUS = (utime + stime) * 1000000 / ticks;
+    }
+    closedir(dir);
+#endif
+    return res;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class SequenceData;
+
+struct ThreadTime
+{
+    std::string name;
+    int64_t cpuUS = 0;
+};
+
+/**
+ * Measures one render of a sequence for the -bm command line option.
+ *
+ * Start is called as the render starts and Finish once the last frame is done.  The
+ * checksum covers every channel of every frame so two builds, or two machines, can be
+ * checked to render a sequence exactly the same.  Thread times come from the OS so
+ * they include every thread that did any of the work, not just the render pool's.
+ */
+class RenderBenchmark
+{
+public:
+    RenderBenchmark() {}
+    ~RenderBenchmark() {}
+
+    void Start();
+    void Finish(const SequenceData& data);
+
+    int64_t GetElapsedUS() const { return _elapsedUS; }
+    double GetFPS() const;
+    uint64_t GetChecksum() const { return _checksum; }
+    uint64_t GetPeakMemoryKB() const { return _peakMemoryKB; }
+    // CPU time each thread spent on the render, busiest first
+    const std::vector<ThreadTime>& GetThreads() const { return _threads; }
+
+    std::string GetReport(const std::string& sequence) const;
+    std::string GetJSON(const std::string& sequence) const;
+
+    static uint64_t Checksum(const SequenceData& data);
+    // the most memory the process has used so far
+    static uint64_t GetProcessPeakMemoryKB();
+    // CPU time used by each of the process's threads so far by thread id, empty if the platform can't tell us
+    static std::map<uint64_t, ThreadTime> GetThreadTimes();
+
+private:
+    std::chrono::steady_clock::time_point _start;
+    std::map<uint64_t, ThreadTime> _startThreads;
+    int64_t _elapsedUS = 0;
+    unsigned int _frames = 0;
+    unsigned int _channels = 0;
+    unsigned int _frameTime = 0;
+    uint64_t _checksum = 0;
+    uint64_t _peakMemoryKB = 0;
+    std::vector<ThreadTime> _threads;
+};
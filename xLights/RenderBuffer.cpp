@@ -270,6 +270,12 @@ DrawingContext::DrawingContext(int BufferWi, int BufferHt, bool allowShared, boo
             }
         }
     }
+#ifdef LINUX
+    // On Linux everything is drawn by cairo straight into the image, see CreateGraphicsContext,
+    // so there is no memory DC or bitmap. GTK is only safe to use from the main thread.
+    return;
+#endif
+
     bitmap = new wxBitmap(*image);
     dc = new wxMemoryDC(*bitmap);
 
@@ -337,14 +343,7 @@ PathDrawingContext::~PathDrawingContext() {}
 
 
 TextDrawingContext::TextDrawingContext(int BufferWi, int BufferHt, bool allowShared)
-#ifdef __WXMSW__
-    : DrawingContext(BufferWi, BufferHt, allowShared, true)
-#elif defined(__WXOSX__)
     : DrawingContext(BufferWi, BufferHt, allowShared, true)
-#elif defined(LINUX)
-    // Linux does text rendering on main thread so using the shared stuff is fine
-    : DrawingContext(BufferWi, BufferHt, true, true)
-#endif
 {
     fontStyle = 0;
     fontSize = 0;
@@ -353,6 +352,13 @@ TextDrawingContext::TextDrawingContext(int BufferWi, int BufferHt, bool allowSha
 TextDrawingContext::~TextDrawingContext() {}
 
 void DrawingContext::ResetSize(int BufferWi, int BufferHt) {
+#ifdef LINUX
+    // the context draws into the image we are about to replace
+    if (gc != nullptr) {
+        delete gc;
+        gc = nullptr;
+    }
+#endif
     if (bitmap != nullptr) {
         delete bitmap;
         bitmap = nullptr;
@@ -395,8 +401,28 @@ size_t DrawingContext::GetHeight() const
     return 0;
 }
 
+wxGraphicsContext* DrawingContext::CreateGraphicsContext()
+{
+#ifdef LINUX
+    // a cairo image surface and a pango font map of the thread's own, nothing shared with GTK
+    // so this is safe on the render threads
+    return wxGraphicsRenderer::GetCairoRenderer()->CreateContextFromImage(*image);
+#else
+    return wxGraphicsContext::Create(*dc);
+#endif
+}
+
 void DrawingContext::Clear()
 {
+#ifdef LINUX
+    image->Clear();
+    if (AllowAlphaChannel()) {
+        image->SetAlpha();
+        memset(image->GetAlpha(), wxIMAGE_ALPHA_TRANSPARENT, image->GetWidth() * image->GetHeight());
+    }
+    return;
+#endif
+
     if (dc != nullptr)
     {
         dc->SelectObject(nullBitmap);
@@ -425,7 +451,7 @@ void PathDrawingContext::Clear() {
         gc = nullptr;
     }
     DrawingContext::Clear();
-    gc = wxGraphicsContext::Create(*dc);
+    gc = CreateGraphicsContext();
 
     if (gc == nullptr)
     {
@@ -463,7 +489,7 @@ void TextDrawingContext::Clear()
         }
     }
 #else
-    gc = wxGraphicsContext::Create(*dc);
+    gc = CreateGraphicsContext();
 #endif
 
     if (gc == nullptr) {
@@ -478,6 +504,7 @@ void TextDrawingContext::Clear()
 }
 
 void TextDrawingContext::SetOverlayMode(bool b) {
+    if (gc == nullptr) return;
     gc->SetCompositionMode(b ? wxCompositionMode::wxCOMPOSITION_OVER : wxCompositionMode::wxCOMPOSITION_SOURCE);
 }
 
@@ -487,10 +514,14 @@ bool TextDrawingContext::AllowAlphaChannel() {
 
 wxImage *DrawingContext::FlushAndGetImage() {
     if (gc != nullptr) {
+        // on Linux this is what copies the drawing into the image
         gc->Flush();
         delete gc;
         gc = nullptr;
     }
+    if (dc == nullptr) {
+        return image;
+    }
     dc->SelectObject(nullBitmap);
     *image = bitmap->ConvertToImage();
     dc->SelectObject(*bitmap);
@@ -518,7 +549,7 @@ void TextDrawingContext::SetPen(wxPen& pen)
 {
     if (gc != nullptr) {
         gc->SetPen(pen);
-    } else {
+    } else if (dc != nullptr) {
         dc->SetPen(pen);
     }
 }
@@ -582,7 +613,7 @@ void TextDrawingContext::SetFont(const wxFontInfo& font, const xlColor& color)
             fontColor = color;
         }
         gc->SetFont(this->font);
-    } else {
+    } else if (dc != nullptr) {
         wxFont f(font);
     #ifdef __WXMSW__
         /*
@@ -678,7 +709,7 @@ const wxFontInfo& TextDrawingContext::GetShapeFont(const std::string& font)
 void TextDrawingContext::DrawText(const wxString &msg, int x, int y, double rotation) {
     if (gc != nullptr) {
         gc->DrawText(msg, x, y, DegToRad(rotation));
-    } else {
+    } else if (dc != nullptr) {
         dc->DrawRotatedText(msg, x, y, rotation);
     }
 }
@@ -686,7 +717,7 @@ void TextDrawingContext::DrawText(const wxString &msg, int x, int y, double rota
 void TextDrawingContext::DrawText(const wxString &msg, int x, int y) {
     if (gc != nullptr) {
         gc->DrawText(msg, x, y);
-    } else {
+    } else if (dc != nullptr) {
         dc->DrawText(msg, x, y);
     }
 }
@@ -694,10 +725,13 @@ void TextDrawingContext::DrawText(const wxString &msg, int x, int y) {
 void TextDrawingContext::GetTextExtent(const wxString &msg, double *width, double *height) {
     if (gc != nullptr) {
         gc->GetTextExtent(msg, width, height);
-    } else {
+    } else if (dc != nullptr) {
         wxSize size = dc->GetTextExtent(msg);
         *width = size.GetWidth();
         *height = size.GetHeight();
+    } else {
+        *width = 0;
+        *height = 0;
     }
 }
 void TextDrawingContext::GetTextExtents(const wxString &msg, wxArrayDouble &extents) {
@@ -705,6 +739,10 @@ void TextDrawingContext::GetTextExtents(const wxString &msg, wxArrayDouble &exte
         gc->GetPartialTextExtents(msg, extents);
         return;
     }
+    if (dc == nullptr) {
+        extents.clear();
+        return;
+    }
     wxArrayInt sizes;
     dc->GetPartialTextExtents(msg, sizes);
     extents.resize(sizes.size());
@@ -982,6 +1020,25 @@ void RenderBuffer::GetMultiColorBlend(float n, bool circular, xlColor &color, in
 }
 
 // 0,0 is lower left
+// pnew drawn over the top of pold as SetPixel does when useAlpha is set
+static inline xlColor AlphaOver(const xlColor &pnew, const xlColor &pold)
+{
+    xlColor c;
+    int r = pnew.red + (pold.red * (255 - pnew.alpha)) / 255;
+    if (r > 255) r = 255;
+    c.red = r;
+    int g = pnew.green + (pold.green * (255 - pnew.alpha)) / 255;
+    if (g > 255) g = 255;
+    c.green = g;
+    int b = pnew.blue + (pold.blue * (255 - pnew.alpha)) / 255;
+    if (b > 255) b = 255;
+    c.blue = b;
+    int a = pnew.alpha + (pold.alpha * (255 - pnew.alpha)) / 255;
+    if (a > 255) a = 255;
+    c.alpha = a;
+    return c;
+}
+
 void RenderBuffer::SetPixel(int x, int y, const xlColor &color, bool wrap, bool useAlpha, bool dmx_ignore)
 {
     if (!dmx_ignore && dmx_buffer) {
@@ -1015,24 +1072,7 @@ void RenderBuffer::SetPixel(int x, int y, const xlColor &color, bool wrap, bool
         //else
         if (useAlpha && color.Alpha() != 255)
         {
-            xlColor pnew = color;
-            xlColor pold = pixels[y*BufferWi + x];
-
-            xlColor c;
-            int r = pnew.red + (pold.red * (255 - pnew.alpha)) / 255;
-            if (r > 255) r = 255;
-            c.red = r;
-            int g = pnew.green + (pold.green * (255 - pnew.alpha)) / 255;
-            if (g > 255) g = 255;
-            c.green = g;
-            int b = pnew.blue + (pold.blue * (255 - pnew.alpha)) / 255;
-            if (b > 255) b = 255;
-            c.blue = b;
-            int a = pnew.alpha + (pold.alpha * (255 - pnew.alpha)) / 255;
-            if (a > 255) a = 255;
-            c.alpha = a;
-
-            pixels[y*BufferWi + x] = c;
+            pixels[y*BufferWi + x] = AlphaOver(color, pixels[y*BufferWi + x]);
         }
         else
         {
@@ -1126,9 +1166,14 @@ void RenderBuffer::DrawHLine(int y, int xstart, int xend, const xlColor &color,
         xstart = xend;
         xend = i;
     }
-    for (int x = xstart; x <= xend; x++) {
-        SetPixel(x, y, color, wrap);
+    if (wrap && (xstart < 0 || xend >= BufferWi || y < 0 || y >= BufferHt)) {
+        // wrapped pixels can land anywhere
+        for (int x = xstart; x <= xend; x++) {
+            SetPixel(x, y, color, wrap);
+        }
+        return;
     }
+    FillRow(y, xstart, xend, color);
 }
 void RenderBuffer::DrawVLine(int x, int ystart, int yend, const xlColor &color, bool wrap) {
     if (ystart > yend) {
@@ -1151,9 +1196,91 @@ void RenderBuffer::DrawBox(int x1, int y1, int x2, int y2, const xlColor& color,
         x1 = x2;
         x2 = i;
     }
-    for (int x = x1; x <= x2; x++) {
+    if (wrap && (x1 < 0 || x2 >= BufferWi || y1 < 0 || y2 >= BufferHt)) {
+        // wrapped pixels can land anywhere (and more than once)
+        for (int x = x1; x <= x2; x++) {
+            for (int y = y1; y <= y2; y++) {
+                SetPixel(x, y, color, wrap, useAlpha);
+            }
+        }
+        return;
+    }
+    y1 = std::max(y1, 0);
+    y2 = std::min(y2, BufferHt - 1);
+    if (useAlpha && color.Alpha() != 255) {
+        x1 = std::max(x1, 0);
+        x2 = std::min(x2, BufferWi - 1);
         for (int y = y1; y <= y2; y++) {
-            SetPixel(x, y, color, wrap, useAlpha);
+            xlColor *row = GetRow(y);
+            if (row == nullptr) {
+                for (int x = x1; x <= x2; x++) {
+                    SetPixel(x, y, color, wrap, useAlpha);
+                }
+            } else {
+                for (int x = x1; x <= x2; x++) {
+                    row[x] = AlphaOver(color, row[x]);
+                }
+            }
+        }
+    } else {
+        for (int y = y1; y <= y2; y++) {
+            FillRow(y, x1, x2, color);
+        }
+    }
+}
+
+void RenderBuffer::FillRow(int y, int xstart, int xend, const xlColor &color) {
+    xstart = std::max(xstart, 0);
+    xend = std::min(xend, BufferWi - 1);
+    if (xstart > xend || y < 0 || y >= BufferHt) {
+        return;
+    }
+    xlColor *row = GetRow(y);
+    if (row == nullptr) {
+        for (int x = xstart; x <= xend; x++) {
+            SetPixel(x, y, color);
+        }
+        return;
+    }
+    std::fill(row + xstart, row + xend + 1, color);
+}
+
+void RenderBuffer::SetRow(int y, int xstart, const xlColor *colors, int count) {
+    if (xstart < 0) {
+        colors -= xstart;
+        count += xstart;
+        xstart = 0;
+    }
+    count = std::min(count, BufferWi - xstart);
+    if (count <= 0 || y < 0 || y >= BufferHt) {
+        return;
+    }
+    xlColor *row = GetRow(y);
+    if (row == nullptr) {
+        for (int x = 0; x < count; x++) {
+            SetPixel(xstart + x, y, colors[x]);
+        }
+        return;
+    }
+    memcpy(row + xstart, colors, count * sizeof(xlColor));
+}
+
+RenderBuffer::Row::Row(RenderBuffer &b, int yy) : buffer(b), y(yy), width(b.BufferWi) {
+    pixels = buffer.GetRow(y);
+    if (pixels == nullptr) {
+        copy.resize(width);
+        for (int x = 0; x < width; x++) {
+            buffer.GetPixel(x, y, copy[x]);
+        }
+        written.resize(width, 0);
+        pixels = copy.data();
+    }
+}
+
+RenderBuffer::Row::~Row() {
+    for (int x = 0; x < (int)copy.size(); x++) {
+        if (written[x]) {
+            buffer.SetPixel(x, y, copy[x]);
         }
     }
 }
@@ -1528,6 +1655,7 @@ void RenderBuffer::SetState(int period, bool ResetState, const std::string& mode
 {
     if (ResetState) {
         needToInit = true;
+        ++effectGeneration;
     }
     curPeriod = period;
     curPeriod = period;
@@ -1546,8 +1674,8 @@ void RenderBuffer::SetState(int period, bool ResetState, const std::string& mode
 
 void RenderBuffer::ClearTempBuf()
 {
-    for (size_t i = 0; i < tempbufVector.size(); i++) {
-        tempbuf[i].Set(0, 0, 0, 0);
+    if (tempbufVector.size() > 0) {
+        memset(tempbuf, 0x00, sizeof(xlColor) * tempbufVector.size());
     }
 }
 void RenderBuffer::CopyTempBufToPixels() {
@@ -1719,6 +1847,7 @@ RenderBuffer::RenderBuffer(RenderBuffer& buffer) : pixelVector(buffer.pixels, &b
     fadeinsteps = buffer.fadeinsteps;
     fadeoutsteps = buffer.fadeoutsteps;
     needToInit = buffer.needToInit;
+    effectGeneration = buffer.effectGeneration;
     allowAlpha = buffer.allowAlpha;
     dmx_buffer = buffer.dmx_buffer;
     _nodeBuffer = buffer._nodeBuffer;
@@ -11,6 +11,7 @@
  **************************************************************/
 
 #include <stdint.h>
+#include <algorithm>
 #include <map>
 #include <list>
 #include <vector>
@@ -85,6 +86,8 @@ public:
     virtual wxImage *FlushAndGetImage();
     virtual bool AllowAlphaChannel() { return true;};
 protected:
+    wxGraphicsContext* CreateGraphicsContext();
+
     wxImage *image;
     wxBitmap *bitmap;
     wxBitmap nullBitmap;
@@ -481,6 +484,54 @@ public:
         return pixels[y * BufferWi + x];
     }
 
+    //row at a time access for effects that can fill whole rows instead of pixel by pixel
+    //GetRow returns nullptr if y is outside the buffer or this is a DMX buffer (where the
+    //colors have to go through SetPixel), RenderBuffer::Row handles both of those
+    xlColor *GetRow(int y) {
+        if (dmx_buffer || y < 0 || y >= BufferHt || (size_t)(y + 1) * BufferWi > pixelVector.size()) {
+            return nullptr;
+        }
+        return &pixels[y * BufferWi];
+    }
+    //sets xstart to xend (inclusive) of row y, clipped to the buffer
+    void FillRow(int y, int xstart, int xend, const xlColor &color);
+    //copies count colors to row y starting at xstart, clipped to the buffer
+    void SetRow(int y, int xstart, const xlColor *colors, int count);
+
+    /**
+     * A row of the buffer to render into.  Normally this points straight at the
+     * pixels, for DMX buffers or rows outside the buffer it is a copy of the row
+     * and the pixels that were written through operator[] or data() are passed
+     * through SetPixel when the Row is destroyed.
+     */
+    class Row {
+    public:
+        Row(RenderBuffer &buffer, int y);
+        ~Row();
+        Row(const Row &) = delete;
+        Row &operator=(const Row &) = delete;
+
+        xlColor &operator[](int x) {
+            if (!written.empty()) {
+                written[x] = 1;
+            }
+            return pixels[x];
+        }
+        xlColor *data() {
+            std::fill(written.begin(), written.end(), 1);
+            return pixels;
+        }
+        int size() const { return width; }
+
+    private:
+        RenderBuffer &buffer;
+        const int y;
+        const int width;
+        xlColor *pixels;
+        std::vector<xlColor> copy;
+        std::vector<uint8_t> written;
+    };
+
     int GetNodeCount() const { return Nodes.size();}
     void SetNodePixel(int nodeNum, const xlColor &color, bool dmx_ignore = false);
     void CopyNodeColorsToPixels(std::vector<uint8_t> &done);
@@ -576,6 +627,8 @@ public:
     int fadeoutsteps = 0;
 
     bool needToInit = false;
+    // bumped each time the buffer starts an effect or the effect's settings change
+    uint32_t effectGeneration = 0;
     bool allowAlpha = false;
     bool dmx_buffer = false;
     bool _isCopy = false;
@@ -12,76 +12,138 @@
 #include "sequencer/SequenceElements.h"
 #include "RenderBuffer.h"
 #include "models/Model.h"
+#include "effects/EffectManager.h"
+#include "effects/RenderableEffect.h"
 
 #include <log4cpp/Category.hh>
 
 #include <wx/filename.h>
 #include <wx/dir.h>
+#include <algorithm>
+#include <condition_variable>
 #include <functional>
+#include <thread>
+#include <zstd.h>
 #include "xLightsVersion.h"
 #include "UtilFunctions.h"
-#include "TraceLog.h"
 #include "ExternalHooks.h"
 
-#ifdef __WXOSX__
-#include <sys/mman.h>
-#define USE_MMAP_RENDERCACHE
-#endif
+// render cache files are <hash>.rcache in the RenderCache folder
+#define RENDER_CACHE_EXT "rcache"
+static const char RENDER_CACHE_MAGIC[4] = { 'X', 'L', 'R', 'C' };
+static const uint32_t RENDER_CACHE_VERSION = 2;
 
-#pragma region RenderCache
+// a frame that isnt a delta every so often so GetFrame doesnt have to decode from the start of the effect
+static const int KEYFRAME_INTERVAL = 16;
+// favour speed, the deltas compress well anyway
+static const int COMPRESSION_LEVEL = 1;
+// the header field holding the section a file has the frames for
+static const std::string SECTION_PROPERTY = "RC_Section";
+
+#pragma region RenderCacheWriter
 
-class RenderCacheLoadThread : public wxThread
+class RenderCacheWriter
 {
 public:
-    RenderCacheLoadThread(RenderCache* cache)
+    RenderCacheWriter()
     {
-        _cache = cache;
-        Run();
+        _cctx = ZSTD_createCCtx();
+        _thread = std::thread([this]() { Run(); });
     }
-
-private:
-    RenderCache* _cache;
-    virtual void* Entry() override
+    ~RenderCacheWriter()
     {
-        std::unique_lock<std::mutex> lock(_cache->GetLoadMutex());
-
-        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _stop = true;
+        }
+        _signal.notify_all();
+        _thread.join();
+        ZSTD_freeCCtx(_cctx);
+    }
 
-        logger_base.debug("Loading cache.");
+    void Queue(RenderCacheItem* item, const std::string& section, int frame, const std::shared_ptr<std::vector<uint8_t>>& pixels)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _jobs.push_back({ item, section, frame, pixels });
+        }
+        _signal.notify_one();
+    }
 
-        wxString cacheFolder = _cache->GetCacheFolder();
+    // drops anything still queued for the item and waits if the writer is working on it
+    void Cancel(RenderCacheItem* item)
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _jobs.remove_if([item](const Job& j) { return j.item == item; });
+        _done.wait(lock, [this, item]() { return _current != item; });
+    }
 
-        wxDir dir(cacheFolder);
-        wxArrayString files;
-        GetAllFilesInDir(cacheFolder, files, "*.cache");
+    // waits until everything queued for the item has been written
+    void Flush(RenderCacheItem* item)
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _done.wait(lock, [this, item]() {
+            if (_current == item) {
+                return false;
+            }
+            for (const auto& j : _jobs) {
+                if (j.item == item) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
 
-        for (const auto& it : files) {
-            // allow up to 3 times physical memory
-            // This means the render cache will be swapped out ... but I think that is still better than re-rendering
-            // Abandon loading render cache if we use too much memory
-            if (IsExcessiveMemoryUsage(3.0)) {
-                logger_base.warn("Render cache loading abandoned due to too much memory use.");
-                break;
+private:
+    struct Job {
+        RenderCacheItem* item;
+        std::string section;
+        int frame;
+        std::shared_ptr<std::vector<uint8_t>> pixels;
+    };
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        while (true) {
+            _signal.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+            if (_jobs.empty()) {
+                // only get here when stopping
+                return;
             }
+            Job job = std::move(_jobs.front());
+            _jobs.pop_front();
+            _current = job.item;
+            lock.unlock();
 
-            auto rci = new RenderCacheItem(_cache, it);
-            if (rci != nullptr && !rci->IsPurged()) {
-                _cache->AddCacheItem(rci);
-            } else {
-                if (rci != nullptr) {
-                    delete rci;
-                }
-                logger_base.warn("Failed to load cache item %s.", (const char*)it.c_str());
+            if (job.item->CompressFrame(_cctx, job.section, job.frame, job.pixels)) {
+                job.item->WriteFile(job.section);
             }
-        }
+            job.pixels.reset();
 
-        logger_base.debug("Cache contained %d files.", (int)files.size());
-        TraceLog::ClearTraceMessages();
-        return nullptr;
+            lock.lock();
+            _current = nullptr;
+            _done.notify_all();
+        }
     }
+
+    std::mutex _lock;
+    std::condition_variable _signal;
+    std::condition_variable _done;
+    std::list<Job> _jobs;
+    RenderCacheItem* _current = nullptr;
+    bool _stop = false;
+    ZSTD_CCtx* _cctx = nullptr;
+    std::thread _thread;
 };
 
-RenderCache::RenderCache()
+#pragma endregion RenderCacheWriter
+
+#pragma region RenderCache
+
+RenderCache::RenderCache() :
+    _writer(std::make_unique<RenderCacheWriter>())
 {
     _enabled = true;
 	_cacheFolder = "";
@@ -137,6 +199,8 @@ void RenderCache::EnforceMaximumSize()
     // each sequence is in a directory
     // for (const auto& d : dirs) {
     wxArrayString files;
+    GetAllFilesInDir(_baseCache, files, "*." RENDER_CACHE_EXT, wxDIR_FILES | wxDIR_DIRS);
+    // files from before the cache was content addressed
     GetAllFilesInDir(_baseCache, files, "*.cache", wxDIR_FILES | wxDIR_DIRS);
 
     for (const auto& f : files) {
@@ -158,7 +222,9 @@ void RenderCache::EnforceMaximumSize()
 
     entries.sort();
 
-    while ((total / 1024 / 1024).ToULong() > _maximumSizeMB && entries.size() > 0) {
+    // go a bit under the limit so we are not back here deleting files the next time a sequence is opened
+    size_t target = _maximumSizeMB * 9 / 10;
+    while ((total / 1024 / 1024).ToULong() > target && entries.size() > 0) {
         if (wxFile::Exists(entries.front().name)) {
             wxRemoveFile(entries.front().name);
             total -= entries.front().size;
@@ -167,24 +233,23 @@ void RenderCache::EnforceMaximumSize()
     }
 }
 
-void RenderCache::LoadCache()
+void RenderCache::RemoveLegacyCache(const std::string& path, const std::string& sequenceFile) const
 {
-    // the thread self deletes so we dont need to track it
-    if (IsEnabled())
-    {
-        wxASSERT(GetBitness() != "32bit");
-        new RenderCacheLoadThread(this);
-    }
-}
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-void RenderCache::AddCacheItem(RenderCacheItem* rci)
-{
-    if (rci != nullptr) {
-        static log4cpp::Category& logger_rcache = log4cpp::Category::getInstance(std::string("log_rendercache"));
-        logger_rcache.info("RenderCache item added " + rci->Description());
-        PerEffectCache *cache = GetPerEffectCache(rci->EffectName());
-        std::unique_lock<std::shared_mutex> lock(cache->lock);
-        cache->cache.push_back(rci);
+    // the per sequence folder the cache used before it was content addressed
+    std::string legacy = path + GetPathSeparator() + "RenderCache" + GetPathSeparator() + sequenceFile + "_RENDER_CACHE";
+    if (wxDir::Exists(legacy))
+    {
+        if (GetBitness() == "32bit")
+        {
+            logger_base.debug("NOT removing old render cache folder %s as this is the 32 bt version.", (const char *)legacy.c_str());
+        }
+        else
+        {
+            logger_base.debug("Removing old render cache folder %s.", (const char *)legacy.c_str());
+            wxDir::Remove(legacy, wxPATH_RMDIR_RECURSIVE);
+        }
     }
 }
 
@@ -199,40 +264,23 @@ void RenderCache::SetSequence(const std::string& path, const std::string& sequen
         EnforceMaximumSize();
     }
 
+    if (sequenceFile != "")
+    {
+        RemoveLegacyCache(path, sequenceFile);
+    }
+
     if (!IsEnabled())
     {
-        if (sequenceFile != "")
-        {
-            _cacheFolder = path + GetPathSeparator() + "RenderCache" + GetPathSeparator() + sequenceFile + "_RENDER_CACHE";
-            if (wxDir::Exists(_cacheFolder))
-            {
-                if (GetBitness() == "32bit")
-                {
-                    logger_base.debug("Render cache disabled but NOT removing folder %s as this is the 32 bt version.", (const char *)_cacheFolder.c_str());
-                }
-                else
-                {
-                    logger_base.debug("Render cache disabled so removing folder %s.", (const char *)_cacheFolder.c_str());
-                    wxDir::Remove(_cacheFolder, wxPATH_RMDIR_RECURSIVE);
-                }
-            }
-        }
         return;
     }
 
     if (sequenceFile != "")
     {
-        _cacheFolder = path + GetPathSeparator() + "RenderCache" + GetPathSeparator() + sequenceFile + "_RENDER_CACHE";
+        _cacheFolder = path + GetPathSeparator() + "RenderCache";
+        _sequence = sequenceFile;
 
         if (!wxDir::Exists(_cacheFolder))
         {
-            wxString common = path + GetPathSeparator() + "RenderCache";
-            if (!wxDir::Exists(common))
-            {
-                logger_base.debug("Creating render cache folder %s.", (const char *)common.c_str());
-                wxDir::Make(common);
-            }
-
             logger_base.debug("Creating render cache folder %s.", (const char *)_cacheFolder.c_str());
             wxDir::Make(_cacheFolder);
         }
@@ -240,23 +288,12 @@ void RenderCache::SetSequence(const std::string& path, const std::string& sequen
         {
             logger_base.debug("Opening render cache folder %s.", (const char *)_cacheFolder.c_str());
         }
-
-        LoadCache();
     }
 }
 
 void RenderCache::RemoveItem(RenderCacheItem *item) {
     static log4cpp::Category& logger_rcache = log4cpp::Category::getInstance(std::string("log_rendercache"));
-    PerEffectCache *c = GetPerEffectCache(item->EffectName());
-    std::unique_lock<std::shared_mutex> lock(c->lock);
-    auto &l = c->cache;
-    for (auto it = l.begin(); it != l.end(); ++it) {
-        if (item == *it) {
-            logger_rcache.info("RenderCache item removed " + (*it)->Description());
-            l.erase(it);
-            break;
-        }
-    }
+    logger_rcache.info("RenderCache item removed " + item->Description());
     delete item;
 }
 
@@ -299,14 +336,55 @@ bool RenderCache::IsEffectOkForCaching(Effect* effect) const
     return true;
 }
 
-RenderCache::PerEffectCache* RenderCache::GetPerEffectCache(const std::string &s) {
-    std::unique_lock<std::recursive_mutex> lock(_cacheLock);
-    PerEffectCache *r = _cache[s];
-    if (r == nullptr) {
-        r = new PerEffectCache();
-        _cache[s] = r;
+std::map<std::string, std::string> RenderCache::GetProperties(Effect* effect) const
+{
+    std::map<std::string, std::string> properties;
+    properties["Effect"] = effect->GetEffectName();
+    properties["StartMS"] = wxString::Format("%d", effect->GetStartTimeMS()).ToStdString();
+    properties["EndMS"] = wxString::Format("%d", effect->GetEndTimeMS()).ToStdString();
+
+    RenderableEffect* reff = effect->GetParentEffectLayer()->GetParentElement()->GetSequenceElements()->GetEffectManager().GetEffect(effect->GetEffectIndex());
+    bool sequenceDependent = reff == nullptr || reff->RenderCacheDependsOnSequence(effect->GetSettings());
+    for (const auto& it : effect->GetSettings()) {
+        // X_ settings are things like the locked flag and description which dont change what is rendered
+        if (it.first.rfind("X_", 0) == 0) {
+            continue;
+        }
+        properties[it.first] = it.second;
+        // value curves driven by the music or a timing track
+        if (it.second.find("Type=Music") != std::string::npos ||
+            it.second.find("Type=Inverted Music") != std::string::npos ||
+            it.second.find("Type=Timing Track") != std::string::npos) {
+            sequenceDependent = true;
+        }
+    }
+    for (const auto& it : effect->GetPaletteMap()) {
+        properties[it.first] = it.second;
     }
-    return r;
+    if (sequenceDependent) {
+        properties["Sequence"] = _sequence;
+    }
+    return properties;
+}
+
+std::string RenderCache::GetKey(const std::map<std::string, std::string>& properties)
+{
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto add = [&hash](const std::string& s) {
+        for (unsigned char c : s) {
+            hash ^= c;
+            hash *= 0x100000001b3ULL;
+        }
+        // include the terminator so "ab","c" and "a","bc" differ
+        hash ^= 0;
+        hash *= 0x100000001b3ULL;
+    };
+    for (const auto& it : properties) {
+        add(it.first);
+        add(it.second);
+    }
+    return wxString::Format("%016llx", (unsigned long long)hash).ToStdString();
 }
 
 RenderCacheItem* RenderCache::GetItem(Effect* effect, RenderBuffer* buffer)
@@ -317,44 +395,14 @@ RenderCacheItem* RenderCache::GetItem(Effect* effect, RenderBuffer* buffer)
 
     if (!IsEffectOkForCaching(effect)) return nullptr;
 
-    {
-        // wait for the cache to finish loading
-        std::unique_lock<std::mutex> lock(_loadMutex);
-    }
-
-    PerEffectCache *cache = GetPerEffectCache(effect->GetEffectName());
-    std::shared_lock<std::shared_mutex> lock(cache->lock);
-    auto &l = cache->cache;
-    for (auto it = l.begin(); it != l.end(); ++it) {
-        if ((*it)->IsMatch(effect, buffer)) {
-            RenderCacheItem *item = *it;
-            //release the readlock
-            lock.unlock();
-            
-            //grab the write lock
-            std::unique_lock<std::shared_mutex> ulock(cache->lock);
-            l.erase(it);
-            logger_rcache.info("RenderCache GetItem found an existing render cache item for effect %s on model %s on layer %d at start time %dms.",
-                (const char*)effect->GetEffectName().c_str(),
-                (const char*)buffer->GetModelName().c_str(),
-                effect->GetParentEffectLayer()->GetLayerNumber(),
-                effect->GetStartTimeMS());
-
-            if (item != nullptr)
-                item->Touch();
-
-            return item;
-        }
-    }
-    lock.unlock();
-
-    logger_rcache.info("RenderCache GetItem created a new render cache item for effect %s on model %s on layer %d at start time %dms.",
+    logger_rcache.info("RenderCache GetItem created a render cache item for effect %s on model %s on layer %d at start time %dms.",
         (const char*)effect->GetEffectName().c_str(),
         (const char*)buffer->GetModelName().c_str(),
         effect->GetParentEffectLayer()->GetLayerNumber(),
         effect->GetStartTimeMS());
 
-    return new RenderCacheItem(this, effect, buffer);
+    // the frames are read from the files as each buffer asks for them
+    return new RenderCacheItem(this, effect);
 }
 
 void RenderCache::Close()
@@ -365,22 +413,9 @@ void RenderCache::Close()
 
     logger_base.debug("Closing render cache folder %s.", (const char *)_cacheFolder.c_str());
 
-    {
-        // wait for the cache to finish loading
-        std::unique_lock<std::mutex> lock(_loadMutex);
-    }
-
-    logger_base.debug("    Got lock.");
-
     Purge(nullptr, false);
     _cacheFolder = "";
-
-    std::unique_lock<std::recursive_mutex> lock(_cacheLock);
-    for (auto &a : _cache) {
-        delete a.second;
-        a.second = nullptr;
-    }
-    _cache.clear();
+    _sequence = "";
     logger_base.debug("    Closed.");
 }
 
@@ -428,50 +463,15 @@ static void purgeCache(Element *em, bool del) {
     });
 }
 
-static bool findMatch(Element *em, RenderCacheItem* item) {
-    return doOnEffects(em, [item] (Effect* e) {
-        return item->IsMatch(e, nullptr);
-    });
-}
-
 void RenderCache::CleanupCache(SequenceElements* sequenceElements)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
     logger_base.debug("Cleaning up the cache.");
 
-    // clean up cache
-    // Because effects are removed from the cache then if you go from cache enabled to cache disabled this wont actually
-    // clean out all the cache items ... as we dont know about them.
-    int deleted = 0;
-    std::unique_lock<std::recursive_mutex> lock(_cacheLock);
-    for (auto &l : _cache) {
-        if (l.second != nullptr) {
-            std::unique_lock<std::shared_mutex> ulock(l.second->lock);
-            auto it = l.second->cache.begin();
-            while (it != l.second->cache.end()) {
-                bool found = false;
-
-                for (int i = 0; i < sequenceElements->GetElementCount() && !found; i++) {
-                    Element* em = sequenceElements->GetElement(i);
-                    found = findMatch(em, *it);
-                }
-
-                if (!found) {
-                    auto todelete = it;
-                    ++it;
-                    ulock.unlock();
-                    (*todelete)->Delete();
-                    ulock.lock();
-                    deleted++;
-                } else {
-                    ++it;
-                }
-            }
-        }
-    }
-    logger_base.debug("    Cleaned up %d items in the cache.", deleted);
-
+    // A file holds the frames of one effect at one buffer shape, any effect with the same settings
+    // on a buffer of that shape uses it so they are left for EnforceMaximumSize to age out, all we
+    // do is release the frames held in memory
     for (int i = 0; i < sequenceElements->GetElementCount(); i++) {
         Element* em = sequenceElements->GetElement(i);
         purgeCache(em, false);
@@ -480,6 +480,35 @@ void RenderCache::CleanupCache(SequenceElements* sequenceElements)
     logger_base.debug("    Cache purge done.");
 }
 
+void RenderCache::AddGarbage(const std::list<std::string>& files)
+{
+    std::unique_lock<std::mutex> lock(_garbageLock);
+    _garbage.insert(_garbage.end(), files.begin(), files.end());
+}
+
+void RenderCache::CollectGarbage()
+{
+    static log4cpp::Category& logger_rcache = log4cpp::Category::getInstance(std::string("log_rendercache"));
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::list<std::string> garbage;
+    {
+        std::unique_lock<std::mutex> lock(_garbageLock);
+        std::swap(garbage, _garbage);
+    }
+
+    wxLogNull logNo; //kludge: avoid user error messahe
+    for (const auto& file : garbage) {
+        if (FileExists(file)) {
+            if (!wxRemoveFile(file)) {
+                logger_base.warn("Unable to remove cache file " + file);
+            } else {
+                logger_rcache.info("RenderCache removed file " + file);
+            }
+        }
+    }
+}
+
 void RenderCache::SetRenderCacheFolder(const std::string& path)
 {
     _baseCache = path + GetPathSeparator() + "RenderCache";
@@ -492,27 +521,7 @@ void RenderCache::Purge(SequenceElements* sequenceElements, bool dodelete)
 
     if (dodelete && _cacheFolder != "")
     {
-        logger_base.debug("Purging render cache folder %s.", (const char *)_cacheFolder.c_str());
-    }
-
-    std::unique_lock<std::recursive_mutex> lock(_cacheLock);
-    for (auto &it : _cache) {
-        if (it.second != nullptr) {
-            auto& l = it.second;
-            std::unique_lock<std::shared_mutex> ulock(l->lock);
-            while (l->cache.size() > 0) {
-                auto frnt = l->cache.front();
-                if (dodelete) {
-                    ulock.unlock();
-                    frnt->Delete();
-                    ulock.lock();
-                } else {
-                    frnt->Save();
-                    delete frnt;
-                    l->cache.pop_front();
-                }
-            }
-        }
+        logger_base.debug("Purging render cache items for sequence %s.", (const char *)_sequence.c_str());
     }
 
     if (sequenceElements) {
@@ -521,100 +530,80 @@ void RenderCache::Purge(SequenceElements* sequenceElements, bool dodelete)
             purgeCache(em, dodelete);
         }
     }
+    if (dodelete) {
+        CollectGarbage();
+    }
 }
-bool RenderCache::UseMMap() const {
-#ifdef USE_MMAP_RENDERCACHE
-    return true;
-#else
-    return false;
-#endif
-}
-
 
 #pragma endregion RenderCache
 
 #pragma region RenderCacheItem
 RenderCacheItem::~RenderCacheItem()
 {
-    PurgeFrames();
+    // the writer thread must be done with us before anything goes away
+    _renderCache->GetWriter()->Cancel(this);
 }
 
 void RenderCacheItem::PurgeFrames()
 {
+    // let anything already rendered make it to disk first
+    _renderCache->GetWriter()->Flush(this);
+
+    std::unique_lock<std::mutex> lock(_lock);
     _purged = true;
-    for (auto& it : _frames) {
-        for (int x = it.second.size() - 1; x >= 0; --x) {
-            if (it.second[x] != nullptr) {
-                if (!_mmap) {
-                    free(it.second[x]);
-                }
-                it.second[x] = nullptr;
-            }
-        }
-    }
-#ifdef USE_MMAP_RENDERCACHE
-    if (_mmap) {
-        munmap(_mmap, _mmapSize);
-        _mmap = nullptr;
-        _mmapSize = 0;
-    }
-#endif
+    _sections.clear();
 }
 
-std::string RenderCacheItem::GetModelName(RenderBuffer* buffer)
+std::string RenderCacheItem::GetSectionName(RenderBuffer* buffer)
 {
-    if (buffer == nullptr) {
-        return "";
-    } else {
-        wxString mname = buffer->GetModelName();
-        mname.Replace("/", "_");
-        mname.Replace("\\", "_");
-        mname.Replace(":", "_");
-        mname.Replace("?", "_");
-        mname.Replace("*", "_");
-        mname.Replace("$", "_");
-        return mname.ToStdString();
-    }
+    // only the buffer's shape and settings, the same effect on another model with the same buffer shares the file.
+    // Effects that read the model itself (faces, states, DMX) don't support the render cache
+    return wxString::Format("%dx%d_%dms_%d%d%d", buffer->BufferWi, buffer->BufferHt, buffer->frameTimeInMs,
+                            buffer->allowAlpha ? 1 : 0, buffer->dmx_buffer ? 1 : 0, buffer->_nodeBuffer ? 1 : 0).ToStdString();
 }
 
-RenderCacheItem::RenderCacheItem(RenderCache* renderCache, Effect* effect, RenderBuffer* buffer) : _renderCache(renderCache)
+RenderCacheItem::RenderCacheItem(RenderCache* renderCache, Effect* effect) : _renderCache(renderCache)
 {
-    _mmap = nullptr;
-    _mmapSize = 0;
     _purged = false;
-    _dirty = true;
-    std::string mname = GetModelName(buffer);
-    wxASSERT(mname != "");
-    _frameSize[mname] = sizeof(xlColor) * buffer->GetPixelCount();
-    wxString elname = effect->GetParentEffectLayer()->GetParentElement()->GetFullName();
-    elname.Replace("/", "_");
-    elname.Replace("\\", "_");
-    elname.Replace(":", "_");
-    elname.Replace("?", "_");
-    elname.Replace("*", "_");
-    elname.Replace("$", "_");
-    std::string file = wxString::Format("%s_%s_%d_%d.cache",
-            effect->GetEffectName(),
-            elname,
-            effect->GetParentEffectLayer()->GetLayerNumber(),
-            effect->GetStartTimeMS()).ToStdString();
-    _effectName = effect->GetEffectName();
-    _cacheFile = renderCache->GetCacheFolder() + GetPathSeparator() + file;
-    _properties["Effect"] = effect->GetEffectName();
-    _properties["Element"] = effect->GetParentEffectLayer()->GetParentElement()->GetFullName();
-    _properties["EffectLayer"] = wxString::Format("%d", effect->GetParentEffectLayer()->GetLayerNumber());
-    _properties["StartMS"] = wxString::Format("%d", effect->GetStartTimeMS());
-    _properties["EndMS"] = wxString::Format("%d", effect->GetEndTimeMS());
-    _properties["Frames"] = wxString::Format("%d", buffer->curEffEndPer - buffer->curEffStartPer + 1);
-    _properties["Models"] = "-1";
-    for (const auto& it : effect->GetSettings())
-    {
-        _properties[it.first] = it.second;
+    _properties = renderCache->GetProperties(effect);
+    _key = RenderCache::GetKey(_properties);
+}
+
+RenderCacheItem::Section* RenderCacheItem::GetSection(RenderBuffer* buffer, std::unique_lock<std::mutex>& lock)
+{
+    if (_purged) {
+        return nullptr;
     }
-    for (const auto& it : effect->GetPaletteMap())
-    {
-        _properties[it.first] = it.second;
+    std::string name = GetSectionName(buffer);
+    auto it = _sections.find(name);
+    if (it != _sections.end()) {
+        return &it->second;
     }
+
+    Section section;
+    auto properties = _properties;
+    properties[SECTION_PROPERTY] = name;
+    section.file = _renderCache->GetCacheFolder() + GetPathSeparator() + RenderCache::GetKey(properties) + "." RENDER_CACHE_EXT;
+    if (FileExists(section.file)) {
+        // the other buffers and the writer thread carry on while the file is read
+        lock.unlock();
+        if (!ReadFile(name, section)) {
+            // a hash collision or a corrupt file, either way it gets replaced
+            std::string file = section.file;
+            section = Section();
+            section.file = file;
+        }
+        lock.lock();
+        if (_purged) {
+            return nullptr;
+        }
+        it = _sections.find(name);
+        if (it != _sections.end()) {
+            // another buffer read it first
+            return &it->second;
+        }
+    }
+    return &_sections.emplace(name, std::move(section)).first->second;
 }
 
 bool RenderCacheItem::IsMatch(Effect* effect, RenderBuffer* buffer)
@@ -622,83 +611,38 @@ bool RenderCacheItem::IsMatch(Effect* effect, RenderBuffer* buffer)
     static log4cpp::Category& logger_rcache = log4cpp::Category::getInstance(std::string("log_rendercache"));
     if (_purged) return false;
 
-    if (wxAtoi(_properties.at("StartMS")) != effect->GetStartTimeMS()) return false;
-
-    EffectLayer* el = effect->GetParentEffectLayer();
-    if (wxAtoi(_properties.at("EffectLayer")) != el->GetLayerNumber()) return false;
-
-    Element* e = el->GetParentElement();
-    if (_properties.at("Element") != e->GetFullName()) return false;
-
-    if (buffer != nullptr)
-    {
-        std::string mname = GetModelName(buffer);
-        if (_frameSize.at(mname) != sizeof(xlColor) * buffer->GetPixelCount()) return false;
-    }
-
-    if (wxAtoi(_properties.at("EndMS")) != effect->GetEndTimeMS()) return false;
-    if (_properties.at("Effect") != effect->GetEffectName()) return false;
+    auto properties = _renderCache->GetProperties(effect);
+    if (RenderCache::GetKey(properties) != _key) return false;
 
-    // We only log failures from here on because they should be relatively rare
-
-    // 8 is the number of predefined tags
-    if (_properties.size() - 7 != effect->GetSettings().size() + effect->GetPaletteMap().size())
-    {
-        logger_rcache.debug("RenderCache no mantch because number of proprerties different.");
+    // the key is a hash so make sure it really is the same effect
+    if (properties != _properties) {
+        logger_rcache.debug("RenderCache no match because the properties are different despite the same key " + _key);
         return false;
     }
 
-    for (const auto& it : effect->GetSettings())
-    {
-        if (_properties.find(it.first) == _properties.end()) {
-            logger_rcache.debug("RenderCache no match because proprerty not present: " + it.first);
-            return false;
-        }
-        else
-        {
-            if (_properties.at(it.first) != it.second)
-            {
-                logger_rcache.debug("RenderCache no match because proprerty different: " + it.first);
-                return false;
-            }
-        }
-    }
-
-    for (const auto& it : effect->GetPaletteMap())
-    {
-        if (_properties.find(it.first) == _properties.end()) {
-            logger_rcache.debug("RenderCache no match because pallette map not present: " + it.first);
-            return false;
-        }
-        else
-        {
-            if (_properties.at(it.first) != it.second)
-            {
-                logger_rcache.debug("RenderCache no match because pallette map different: " + it.first);
-                return false;
-            }
-        }
-    }
-
     return true;
 }
 
 void RenderCacheItem::Delete()
 {
-    static log4cpp::Category& logger_rcache = log4cpp::Category::getInstance(std::string("log_rendercache"));
-    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    wxLogNull logNo; //kludge: avoid user error messahe
-    if (!_purged && FileExists(_cacheFile)) {
-        if (!wxRemoveFile(_cacheFile)) {
-            logger_base.warn("Unable to remove cache file " + _cacheFile);
-        } else {
-            logger_rcache.info("RenderCache removed file " + _cacheFile);
-        }
-    }
+    // only the frames in memory go, the files may be shared with other effects and sequences
+    _renderCache->GetWriter()->Cancel(this);
     PurgeFrames();
     _renderCache->RemoveItem(this);
 }
 
+void RenderCacheItem::RemoveFilesLater()
+{
+    std::list<std::string> files;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        for (const auto& it : _sections) {
+            files.push_back(it.second.file);
+        }
+    }
+    _renderCache->AddGarbage(files);
+}
+
 void RenderCacheItem::AddFrame(RenderBuffer* buffer)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
@@ -706,7 +650,7 @@ void RenderCacheItem::AddFrame(RenderBuffer* buffer)
         logger_base.error("RenderCacheItem::AddFrame was passed a null buffer");
         return;
     }
-    
+
     if (buffer->GetPixelCount() == 0) {
         logger_base.error("RenderCacheItem::AddFrame was passed a buffer with no pixels in it");
         return;
@@ -715,10 +659,6 @@ void RenderCacheItem::AddFrame(RenderBuffer* buffer)
     if (_purged) {
         return;
     }
-    if (_mmap) {
-        // need to undo the mmap so we can append frames
-        unmmap();
-    }
     // allow up to 3 times physical memory
     // This means the render cache will be swapped out ... but I think that is still better than re-rendering
     if (IsExcessiveMemoryUsage(3.0)) {
@@ -728,21 +668,10 @@ void RenderCacheItem::AddFrame(RenderBuffer* buffer)
     }
 
     int frame = buffer->curPeriod - buffer->curEffStartPer;
-
-    std::string mname = GetModelName(buffer);
-    if (_frameSize.find(mname) == _frameSize.end()) {
-        _frameSize[mname] = sizeof(xlColor) * buffer->GetPixelCount();
-    } else {
-        if (_frameSize[mname] != sizeof(xlColor) * buffer->GetPixelCount()) {
-            // the buffer size has changed ... we dont support this.
-            logger_base.warn("RenderCacheItem::AddFrame buffer size changed ... we dont support this.");
-            PurgeFrames();
-            return;
-        }
-    }
+    size_t frameSize = sizeof(xlColor) * buffer->GetPixelCount();
 
     size_t totFramesSize = buffer->curEffEndPer - buffer->curEffStartPer + 1;
-    totFramesSize *= _frameSize[mname];
+    totFramesSize *= frameSize;
     constexpr size_t MAX = 4LL * 1024LL * 1024LL * 1024LL;
     if (totFramesSize > MAX) {
         // more that 4GB in size, we're not going to cache this effect
@@ -750,291 +679,370 @@ void RenderCacheItem::AddFrame(RenderBuffer* buffer)
         return;
     }
 
-    if (_frames.find(mname) == _frames.end()) {
-        std::vector<unsigned char *> n;
-        _frames[mname] = n;
+    if (frame < 0) {
+        return;
     }
 
-    if (frame >= _frames.at(mname).size()) {
-        int maxframe = std::max(frame+1,buffer->curEffEndPer - buffer->curEffStartPer + 1);
-        _frames.at(mname).resize(maxframe);
+    // just take a copy, the writer thread does the rest
+    auto pixels = std::make_shared<std::vector<uint8_t>>((uint8_t*)buffer->GetPixels(), (uint8_t*)buffer->GetPixels() + frameSize);
+    std::string name = GetSectionName(buffer);
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        Section* section = GetSection(buffer, lock);
+        if (section == nullptr) {
+            return;
+        }
+        if (section->frameSize == 0) {
+            section->frameSize = frameSize;
+        } else if (section->frameSize != frameSize) {
+            // the section name includes the buffer size so this should not happen
+            logger_base.warn("RenderCacheItem::AddFrame buffer size changed ... we dont support this.");
+            lock.unlock();
+            PurgeFrames();
+            return;
+        }
+        if (frame >= (int)section->frames.size()) {
+            size_t maxframe = std::max(frame + 1, buffer->curEffEndPer - buffer->curEffStartPer + 1);
+            section->frames.resize(maxframe);
+            section->keyframe.resize(maxframe);
+        }
+        section->pending[frame] = pixels;
+        section->dirty = true;
     }
+    _renderCache->GetWriter()->Queue(this, name, frame, pixels);
+}
 
-    unsigned char* frameBuffer = (unsigned char *)malloc(_frameSize.at(mname));
-    if (frameBuffer == nullptr) {
-        logger_base.warn("RenderCacheItem::AddFrame failed to allocate frameBuffer.");
-        PurgeFrames();
-        wxASSERT(false);
-        return;
+bool RenderCacheItem::CompressFrame(ZSTD_CCtx_s* ctx, const std::string& name, int frame, const std::shared_ptr<std::vector<uint8_t>>& pixels)
+{
+    // the section can be cleared by PurgeFrames whenever the lock is not held so only the
+    // frame before is kept hold of while compressing
+    std::shared_ptr<std::vector<uint8_t>> lastRaw;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        auto it = _sections.find(name);
+        if (_purged || it == _sections.end()) {
+            return false;
+        }
+        if (it->second.lastRawFrame == frame - 1) {
+            lastRaw = it->second.lastRaw;
+        }
     }
-    memcpy(frameBuffer, buffer->GetPixels(), _frameSize.at(mname));
 
-    if (_frames.at(mname)[frame] != nullptr) {
-        free(_frames.at(mname)[frame]);
-        _frames.at(mname)[frame] = nullptr;
+    const std::vector<uint8_t>& raw = *pixels;
+    bool keyframe = frame % KEYFRAME_INTERVAL == 0 || lastRaw == nullptr || lastRaw->size() != raw.size();
+    std::vector<uint8_t> delta;
+    const uint8_t* src = raw.data();
+    if (!keyframe) {
+        delta.resize(raw.size());
+        const std::vector<uint8_t>& last = *lastRaw;
+        for (size_t i = 0; i < raw.size(); i++) {
+            delta[i] = raw[i] ^ last[i];
+        }
+        src = delta.data();
+    }
+    std::vector<uint8_t> compressed(ZSTD_compressBound(raw.size()));
+    size_t size = ZSTD_compressCCtx(ctx, compressed.data(), compressed.size(), src, raw.size(), COMPRESSION_LEVEL);
+    if (ZSTD_isError(size)) {
+        static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        logger_base.warn("RenderCacheItem::CompressFrame failed %s.", ZSTD_getErrorName(size));
+        return false;
     }
+    compressed.resize(size);
+    compressed.shrink_to_fit();
 
-    _frames.at(mname)[frame] = frameBuffer;
-    _dirty = true;
+    std::unique_lock<std::mutex> lock(_lock);
+    auto it = _sections.find(name);
+    if (_purged || it == _sections.end()) {
+        return false;
+    }
+    Section* section = &it->second;
+    section->lastRaw = pixels;
+    section->lastRawFrame = frame;
+    bool replaced = !section->frames[frame].empty();
+    section->frames[frame] = std::move(compressed);
+    section->keyframe[frame] = keyframe ? 1 : 0;
+    auto p = section->pending.find(frame);
+    if (p != section->pending.end() && p->second == pixels) {
+        section->pending.erase(p);
+    }
+    if (replaced) {
+        // the deltas that followed the old frame are no good any more
+        for (size_t i = frame + 1; i < section->frames.size() && !section->keyframe[i] && !section->frames[i].empty(); i++) {
+            section->frames[i].clear();
+        }
+        section->decodedFrame = -1;
+    }
+    return section->dirty && IsComplete(*section);
+}
 
-    if (buffer->curPeriod == buffer->curEffEndPer) {
-        // if multi models in this cache then only call save when none of them have null pointers at the end
-        for (const auto& itm : _frames) {
-            if (itm.second.size() == 0 || itm.second.back() == nullptr) {
-                //logger_base.warn("RenderCacheItem::AddFrame save abandoned due to null frame.");
-                return;
+bool RenderCacheItem::IsComplete(const Section& section)
+{
+    if (section.frames.empty() || !section.pending.empty()) {
+        return false;
+    }
+    for (const auto& f : section.frames) {
+        if (f.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RenderCacheItem::Decode(Section& section, int frame)
+{
+    if (frame >= (int)section.frames.size() || section.frames[frame].empty()) {
+        return false;
+    }
+    if (section.decodedFrame == frame) {
+        return true;
+    }
+
+    int start = frame;
+    while (start > 0 && !section.keyframe[start]) {
+        --start;
+    }
+    for (int i = start; i <= frame; i++) {
+        if (section.frames[i].empty()) {
+            return false;
+        }
+    }
+    // carry on from the last frame decoded if we can, frames are nearly always asked for in order
+    if (section.decodedFrame >= start && section.decodedFrame < frame) {
+        start = section.decodedFrame + 1;
+    }
+
+    section.decoded.resize(section.frameSize);
+    section.scratch.resize(section.frameSize);
+    for (int i = start; i <= frame; i++) {
+        const auto& c = section.frames[i];
+        bool key = section.keyframe[i];
+        uint8_t* dest = key ? section.decoded.data() : section.scratch.data();
+        size_t size = ZSTD_decompress(dest, section.frameSize, c.data(), c.size());
+        if (ZSTD_isError(size) || size != section.frameSize) {
+            section.decodedFrame = -1;
+            return false;
+        }
+        if (!key) {
+            for (size_t x = 0; x < section.frameSize; x++) {
+                section.decoded[x] ^= section.scratch[x];
             }
         }
-        Save();
+        section.decodedFrame = i;
     }
+    return true;
 }
 
 bool RenderCacheItem::GetFrame(RenderBuffer* buffer)
 {
     static log4cpp::Category& logger_rcache = log4cpp::Category::getInstance(std::string("log_rendercache"));
-    std::string mname = GetModelName(buffer);
-    if (_frameSize.find(mname) == _frameSize.end()) {
-        logger_rcache.info("RenderCache::GetFrame on model " + mname + " failed due to number of frames difference.");
+    std::unique_lock<std::mutex> lock(_lock);
+    Section* s = GetSection(buffer, lock);
+    if (s == nullptr || s->frames.empty()) {
         return false;
     }
-
-    auto modelFrames = _frames[mname];
-    if (_frameSize.at(mname) != (sizeof(xlColor) * buffer->GetPixelCount())) {
-        logger_rcache.info("RenderCache::GetFrame on model " + mname + " failed due to frame size difference.");
+    Section& section = *s;
+    if (section.frameSize != (sizeof(xlColor) * buffer->GetPixelCount())) {
+        logger_rcache.info("RenderCache::GetFrame on model " + buffer->GetModelName() + " failed due to frame size difference.");
         return false;
     }
 
     int frame = buffer->curPeriod - buffer->curEffStartPer;
-    if (frame < modelFrames.size() && modelFrames[frame]) {
-        // its in memory ... read it from there
-        unsigned char* pc = modelFrames[frame];
-        memcpy(buffer->GetPixels(), pc, _frameSize.at(mname));
+    auto p = section.pending.find(frame);
+    if (p != section.pending.end()) {
+        // still waiting to be compressed
+        memcpy(buffer->GetPixels(), p->second->data(), section.frameSize);
+        return true;
+    }
+    if (frame >= 0 && Decode(section, frame)) {
+        memcpy(buffer->GetPixels(), section.decoded.data(), section.frameSize);
         return true;
     }
 
-    logger_rcache.info("RenderCache::GetFrame %d on model %s failed due to fall through.", frame, (const char*)mname.c_str());
+    logger_rcache.info("RenderCache::GetFrame %d on model %s failed due to fall through.", frame, (const char*)buffer->GetModelName().c_str());
     return false;
 }
 
-void RenderCacheItem::Touch() const
+void RenderCacheItem::Save()
 {
-    wxFileName fn(_cacheFile);
-    fn.Touch();
+    // the writer thread writes each section as soon as all its frames are compressed
+    _renderCache->GetWriter()->Flush(this);
 }
 
-void RenderCacheItem::Save()
+void RenderCacheItem::WriteFile(const std::string& name)
 {
-    if (_purged) return;
-    if (!_dirty) return;
-    
-    if (_mmap) {
-        return;
-    }
-
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    //logger_base.debug("Saving render cache file %s.", (const char *)_cacheFile.c_str());
-
-    char zero = 0x00;
 
-    // check all the data is there
-    for (const auto& itm : _frames) {
-        for (const auto& it : itm.second) {
-            // we are missing data
-            //wxASSERT(false);
-            if (it == nullptr) return;
-        }
+    // take a copy of the compressed frames so GetFrame isnt held up by the disk
+    std::map<std::string, std::string> properties;
+    Section section;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        auto it = _sections.find(name);
+        if (_purged || it == _sections.end() || !it->second.dirty || !IsComplete(it->second)) return;
+        properties = _properties;
+        section.file = it->second.file;
+        section.frameSize = it->second.frameSize;
+        section.frames = it->second.frames;
+        section.keyframe = it->second.keyframe;
+        it->second.dirty = false;
     }
+    properties[SECTION_PROPERTY] = name;
 
+    char zero = 0x00;
+    // only the writer thread writes files so this can't clash with another write of the same file
+    wxString tmpFile = section.file + ".tmp";
     wxFile file;
 
-    if (file.Create(_cacheFile, true)) {
-        _properties["Models"] = wxString::Format("%d", (int)_frames.size());
+    if (file.Create(tmpFile, true)) {
+        file.Write(RENDER_CACHE_MAGIC, sizeof(RENDER_CACHE_MAGIC));
+        file.Write(&RENDER_CACHE_VERSION, sizeof(RENDER_CACHE_VERSION));
+
         // write the header fields
-        for (const auto& it : _properties) {
+        for (const auto& it : properties) {
             file.Write(it.first);
             file.Write(&zero, 1);
             file.Write(it.second);
             file.Write(&zero, 1);
         }
-
         file.Write("RC_HEADEREND");
         file.Write(&zero, 1);
 
-        for (const auto& it : _frames) {
-            file.Write(it.first);
-            file.Write(&zero, 1);
-            file.Write(wxString::Format("%d", (int)it.second.size()));
-            file.Write(&zero, 1);
-            file.Write(wxString::Format("%ld", _frameSize.at(it.first)));
-            file.Write(&zero, 1);
+        uint32_t frames = section.frames.size();
+        uint32_t frameSize = section.frameSize;
+        file.Write(&frames, sizeof(frames));
+        file.Write(&frameSize, sizeof(frameSize));
+        for (size_t i = 0; i < section.frames.size(); i++) {
+            uint8_t key = section.keyframe[i];
+            uint32_t size = section.frames[i].size();
+            file.Write(&key, sizeof(key));
+            file.Write(&size, sizeof(size));
+            file.Write(section.frames[i].data(), size);
         }
-        _firstFrameOffset = file.Tell();
-        
-        // write the frames
-        for (const auto& itm : _frames) {
-            for (const auto& it : itm.second) {
-                wxASSERT(it != nullptr);
-                if (it != nullptr) {
-                    file.Write(it, _frameSize.at(itm.first));
-                }
-            }
-        }
-
         file.Close();
-        
-        remmap();
+
+        // so no one ever sees a half written file, the file is the whole section so nothing needs merging
+        if (!wxRenameFile(tmpFile, section.file, true)) {
+            logger_base.warn("    Failed to rename render cache file %s.", (const char*)section.file.c_str());
+            wxRemoveFile(tmpFile);
+        }
     } else {
         logger_base.warn("    Failed to create file.");
     }
 }
 
-bool RenderCacheItem::IsDone(RenderBuffer* buffer) const
+bool RenderCacheItem::IsDone(RenderBuffer* buffer)
 {
     int frame = buffer->curPeriod - buffer->curEffStartPer;
-    std::string mname = GetModelName(buffer);
-    auto modelFrames = _frames.at(mname);
-    return modelFrames[frame];
+    std::unique_lock<std::mutex> lock(_lock);
+    Section* section = GetSection(buffer, lock);
+    if (section == nullptr || frame < 0 || frame >= (int)section->frames.size()) {
+        return false;
+    }
+    return !section->frames[frame].empty() || section->pending.find(frame) != section->pending.end();
 }
 
-RenderCacheItem::RenderCacheItem(RenderCache* renderCache, const std::string& filename) : _renderCache(renderCache)
+// called without _lock held, only reads the file and the item's properties which never change
+bool RenderCacheItem::ReadFile(const std::string& name, Section& section)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    static log4cpp::Category& logger_rcache = log4cpp::Category::getInstance(std::string("log_rendercache"));
 
-    _mmap = nullptr;
-    _mmapSize = 0;
-    _cacheFile = filename;
-    wxFileName fn(_cacheFile);
-    _effectName = fn.GetName();
-    int idx = _effectName.find('_');
-    _effectName = _effectName.substr(0, idx);
-    _purged = false;
-    _dirty = false;
-
+    const std::string& filename = section.file;
+    std::vector<uint8_t> data;
     wxFile file;
+    if (!file.Open(filename)) {
+        return false;
+    }
+    data.resize(file.Length());
+    if (data.empty() || file.Read(data.data(), data.size()) != (ssize_t)data.size()) {
+        return false;
+    }
+    file.Close();
 
-    if (file.Open(_cacheFile)) {
-        char headerBuffer[8192];
-        memset(headerBuffer, 0x00, sizeof(headerBuffer));
-        file.Read(headerBuffer, sizeof(headerBuffer));
-
-        char* ps = headerBuffer;
-
-        while (strcmp(ps, "RC_HEADEREND") != 0) {
-            std::string key(ps);
-            ps += strlen(ps) + 1;
-            std::string value(ps);
-            ps += strlen(ps) + 1;
-
-            if (key == "") {
-                // file looks corrupt
-                logger_base.debug("Cache file %s appears corrupt.", (const char*)filename.c_str());
-                _purged = true;
-                return;
-            } else {
-                _properties[key] = value;
-            }
+    const uint8_t* ps = data.data();
+    const uint8_t* end = ps + data.size();
+    auto corrupt = [&filename]() {
+        logger_base.debug("Cache file %s appears corrupt.", (const char*)filename.c_str());
+        return false;
+    };
+    auto readString = [&ps, end](std::string& s) {
+        const uint8_t* z = (const uint8_t*)memchr(ps, 0, end - ps);
+        if (z == nullptr) {
+            return false;
         }
-        ps += strlen(ps) + 1;
-
-        int models = wxAtoi(_properties["Models"]);
-
-        for (int i = 0; i < models; i++) {
-            std::string model(ps);
-            ps += strlen(ps) + 1;
-            std::string frames(ps);
-            ps += strlen(ps) + 1;
-            int fs = wxAtoi(frames);
-            std::string frameSize(ps);
-            ps += strlen(ps) + 1;
-            long fsz = wxAtol(frameSize);
-
-            std::vector<unsigned char *> n;
-            _frames[model] = n;
-            _frames.at(model).resize(fs);
-            _frameSize[model] = fsz;
+        s.assign((const char*)ps, z - ps);
+        ps = z + 1;
+        return true;
+    };
+    auto readValue = [&ps, end](auto& v) {
+        if ((size_t)(end - ps) < sizeof(v)) {
+            return false;
         }
+        memcpy(&v, ps, sizeof(v));
+        ps += sizeof(v);
+        return true;
+    };
 
-        _firstFrameOffset = ps - headerBuffer;
-#ifdef USE_MMAP_RENDERCACHE
-        if (renderCache->UseMMap()) {
-            file.Seek(0);
-            _mmapSize = file.Length();
-            _mmap = (uint8_t*)mmap(nullptr, _mmapSize, PROT_READ, MAP_PRIVATE, file.fd(), 0);
-            
-            size_t cur = _firstFrameOffset;
-            for (auto& itm : _frames) {
-                for (int i = 0; i < itm.second.size(); i++) {
-                    itm.second[i] = &_mmap[cur];
-                    cur += _frameSize.at(itm.first);
-                }
-            }
-        } else
-#endif
-        {
-            file.Seek(_firstFrameOffset);
-            for (auto& itm : _frames) {
-                for (int i = 0; i < itm.second.size(); i++) {
-                    uint8_t* frameBuffer = (uint8_t *)malloc(_frameSize.at(itm.first));
-                    
-                    if (frameBuffer == nullptr) {
-                        file.Close();
-                        PurgeFrames();
-                        logger_base.debug("Render Cache Item file %s fails due to memory allocation issue.", (const char*)filename.c_str());
-                        return;
-                    }
-                    
-                    file.Read(frameBuffer, _frameSize.at(itm.first));
-                    itm.second[i] = frameBuffer;
-                }
-            }
-        }
-        file.Close();
+    uint32_t version = 0;
+    if ((size_t)(end - ps) < sizeof(RENDER_CACHE_MAGIC) || memcmp(ps, RENDER_CACHE_MAGIC, sizeof(RENDER_CACHE_MAGIC)) != 0) {
+        return corrupt();
+    }
+    ps += sizeof(RENDER_CACHE_MAGIC);
+    if (!readValue(version) || version != RENDER_CACHE_VERSION) {
+        logger_base.debug("Cache file %s is not a version we understand.", (const char*)filename.c_str());
+        return false;
     }
-}
 
-void RenderCacheItem::unmmap() {
-#ifdef USE_MMAP_RENDERCACHE
-    if (_mmap) {
-        for (auto& it : _frames) {
-            for (int x = it.second.size() - 1; x >= 0; --x) {
-                if (it.second[x]) {
-                    uint8_t* frameBuffer = (uint8_t *)malloc(_frameSize.at(it.first));
-                    memcpy(frameBuffer, it.second[x], _frameSize.at(it.first));
-                    it.second[x] = frameBuffer;
-                }
-            }
+    std::map<std::string, std::string> properties;
+    while (true) {
+        std::string key;
+        std::string value;
+        if (!readString(key)) {
+            return corrupt();
+        }
+        if (key == "RC_HEADEREND") {
+            break;
         }
-        munmap(_mmap, _mmapSize);
-        _mmap = nullptr;
-        _mmapSize = 0;
+        if (key == "" || !readString(value)) {
+            return corrupt();
+        }
+        properties[key] = value;
+    }
+    // the file name is a hash so make sure it really is this effect and buffer
+    if (properties[SECTION_PROPERTY] != name) {
+        logger_rcache.debug("RenderCache no match because the file %s is for a different buffer.", (const char*)filename.c_str());
+        return false;
+    }
+    properties.erase(SECTION_PROPERTY);
+    if (properties != _properties) {
+        logger_rcache.debug("RenderCache no match because the properties are different despite the same key " + _key);
+        return false;
     }
-#endif
-}
-void RenderCacheItem::remmap() {
-#ifdef USE_MMAP_RENDERCACHE
-    if (_mmap) return;
-    if (!_renderCache->UseMMap()) return;
 
-    wxFile file;
-    if (file.Open(_cacheFile)) {
-        file.Seek(0);
-        _mmapSize = file.Length();
-        _mmap = (uint8_t*)mmap(nullptr, _mmapSize, PROT_READ, MAP_PRIVATE, file.fd(), 0);
-        
-        size_t cur = _firstFrameOffset;
-        for (auto& itm : _frames) {
-            for (int i = 0; i < itm.second.size(); i++) {
-                if (itm.second[i]) {
-                    free(itm.second[i]);
-                    itm.second[i] = nullptr;
-                }
-                itm.second[i] = &_mmap[cur];
-                cur += _frameSize.at(itm.first);
-            }
+    uint32_t frames = 0;
+    uint32_t frameSize = 0;
+    if (!readValue(frames) || !readValue(frameSize)) {
+        return corrupt();
+    }
+    section.frameSize = frameSize;
+    section.frames.resize(frames);
+    section.keyframe.resize(frames);
+    for (uint32_t i = 0; i < frames; i++) {
+        uint8_t key = 0;
+        uint32_t size = 0;
+        if (!readValue(key) || !readValue(size) || (size_t)(end - ps) < size) {
+            return corrupt();
         }
+        section.keyframe[i] = key;
+        section.frames[i].assign(ps, ps + size);
+        ps += size;
     }
-#endif
-}
 
+    logger_rcache.info("RenderCache found existing frames for %s in %s.", (const char*)name.c_str(), (const char*)filename.c_str());
+    // so the maximum size keeps the files in use
+    wxFileName fn(filename);
+    fn.Touch();
+    return true;
+}
 
 #pragma endregion RenderCacheItem
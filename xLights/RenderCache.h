@@ -13,40 +13,76 @@
 #include <string>
 #include <list>
 #include <map>
+#include <memory>
 #include <vector>
 #include <mutex>
-#include <shared_mutex>
 
 
 class Effect;
 class RenderCache;
 class SequenceElements;
 class RenderBuffer;
-class RenderCacheLoadThread;
+class RenderCacheWriter;
+struct ZSTD_CCtx_s;
 
+/**
+ * The cached frames for one effect.
+ *
+ * The frames for each buffer the effect renders, that is each model and buffer
+ * geometry, are a section stored in a file of its own.  The file name is a hash
+ * of the effect settings, palette and timing and the section so the same effect
+ * on the same model in another sequence finds the same file, unless the effect
+ * says it depends on the sequence (see RenderableEffect::RenderCacheDependsOnSequence).
+ * Frames are stored zstd compressed, most of them as the XOR with the frame before
+ * which compresses far better than the raw pixels.
+ *
+ * AddFrame only copies the pixels, the compression and the file writing are
+ * done on the RenderCache's writer thread.  Deleting an item never removes its
+ * files as another copy of the effect may be using them, RenderCache::CollectGarbage
+ * and the maximum cache size do that.
+ */
 class RenderCacheItem
 {
+    struct Section {
+        std::string file;
+        size_t frameSize = 0;
+        std::vector<std::vector<uint8_t>> frames; // compressed, empty if not rendered yet
+        std::vector<uint8_t> keyframe;            // 1 if the frame is not a delta from the frame before
+        std::map<int, std::shared_ptr<std::vector<uint8_t>>> pending; // waiting for the writer thread
+        bool dirty = false;
+
+        // the last frame compressed, only used by the writer thread and only with _lock held
+        std::shared_ptr<std::vector<uint8_t>> lastRaw;
+        int lastRawFrame = -1;
+
+        // the last frame decompressed by GetFrame
+        std::vector<uint8_t> decoded;
+        std::vector<uint8_t> scratch;
+        int decodedFrame = -1;
+    };
+
     RenderCache* _renderCache = nullptr;
-    std::string _cacheFile;
-    std::string _effectName;
+    std::string _key;
     std::map<std::string, std::string> _properties;
-    std::map<std::string, std::vector<uint8_t *>> _frames;
-    std::map<std::string, long> _frameSize;
+    std::map<std::string, Section> _sections;
     bool _purged = false;
-    bool _dirty = false;
-    static std::string GetModelName(RenderBuffer* buffer);
+    std::mutex _lock;
+    static std::string GetSectionName(RenderBuffer* buffer);
 
-    
-    uint8_t *_mmap = nullptr;
-    size_t _mmapSize = 0;
-    size_t _firstFrameOffset = 0;
+    // finds the section for the buffer, reading it from its file the first time.  lock must hold _lock,
+    // it is released while the file is read
+    Section* GetSection(RenderBuffer* buffer, std::unique_lock<std::mutex>& lock);
+    bool ReadFile(const std::string& name, Section& section);
+    bool Decode(Section& section, int frame);
+    static bool IsComplete(const Section& section);
+    void WriteFile(const std::string& name);
 
-    void unmmap();
-    void remmap();
+    friend class RenderCacheWriter;
+    // compresses a frame passed to AddFrame, returns true if that was the last missing frame of the section
+    bool CompressFrame(ZSTD_CCtx_s* ctx, const std::string& section, int frame, const std::shared_ptr<std::vector<uint8_t>>& pixels);
 
 public:
-    RenderCacheItem(RenderCache* renderCache, const std::string& file);
-    RenderCacheItem(RenderCache* renderCache, Effect* effect, RenderBuffer* buffer);
+    RenderCacheItem(RenderCache* renderCache, Effect* effect);
     virtual ~RenderCacheItem();
     bool GetFrame(RenderBuffer* buffer);
     void AddFrame(RenderBuffer* buffer);
@@ -54,36 +90,27 @@ public:
     bool IsPurged() const { return _purged; }
     bool IsMatch(Effect* effect, RenderBuffer* buffer);
     void Delete();
+    // hands the files of the sections used so far to the cache to remove when it next collects its garbage
+    void RemoveFilesLater();
     void Save();
-    void Touch() const;
-    bool IsDone(RenderBuffer* buffer) const;
-    const std::string& Description() const { return _cacheFile; }
-    const std::string& EffectName() const { return _effectName; }
+    bool IsDone(RenderBuffer* buffer);
+    const std::string& Description() const { return _key; }
 };
 
 class RenderCache
 {
-    class PerEffectCache {
-    public:
-        PerEffectCache() {}
-        ~PerEffectCache() {}
-        std::list<RenderCacheItem*> cache;
-        std::shared_mutex lock;
-    };
-    
-    std::recursive_mutex  _cacheLock;
 	std::string _cacheFolder;
-	std::map<std::string, PerEffectCache*> _cache;
+    std::string _sequence;
     std::string _enabled; // Disabled | Locked Only | Enabled
-    std::mutex _loadMutex;
     size_t _maximumSizeMB = 0;
     std::string _baseCache = "";
+    std::unique_ptr<RenderCacheWriter> _writer;
+    std::list<std::string> _garbage;
+    std::mutex _garbageLock;
 
     void Close();
-    void LoadCache();
-    
-    PerEffectCache* GetPerEffectCache(const std::string &s);
     void EnforceMaximumSize();
+    void RemoveLegacyCache(const std::string& path, const std::string& sequenceFile) const;
 
     public:
 		RenderCache();
@@ -95,13 +122,18 @@ class RenderCache
         void RemoveItem(RenderCacheItem *item);
         std::string GetCacheFolder() const { return _cacheFolder; }
         void CleanupCache(SequenceElements* sequenceElements);
+        void AddGarbage(const std::list<std::string>& files);
+        // removes the files given to AddGarbage
+        void CollectGarbage();
         void Purge(SequenceElements* sequenceElements, bool dodelete);
-        void Enable(std::string enabled) { 
-            _enabled = enabled; 
+        void Enable(std::string enabled) {
+            _enabled = enabled;
         }
-        std::mutex& GetLoadMutex() { return _loadMutex; }
-        void AddCacheItem(RenderCacheItem* rci);
         bool IsEffectOkForCaching(Effect* effect) const;
-        bool UseMMap() const;
         void SetMaximumSizeMB(size_t mb);
+
+        // the properties that identify an effect's rendered frames and the hash of them used as the file name
+        std::map<std::string, std::string> GetProperties(Effect* effect) const;
+        static std::string GetKey(const std::map<std::string, std::string>& properties);
+        RenderCacheWriter* GetWriter() const { return _writer.get(); }
 };
@@ -0,0 +1,140 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <algorithm>
+#include <vector>
+
+#include "RenderProfiler.h"
+#include "UtilFunctions.h"
+
+void RenderProfileTimes::Add(const RenderProfileTimes& t)
+{
+    renderUS += t.renderUS;
+    blendUS += t.blendUS;
+    transitionUS += t.transitionUS;
+    restoreUS += t.restoreUS;
+    renders += t.renders;
+    cacheHits += t.cacheHits;
+}
+
+static void AddTimes(std::map<std::string, RenderProfileTimes>& to, const std::map<std::string, RenderProfileTimes>& from)
+{
+    for (const auto& it : from) {
+        to[it.first].Add(it.second);
+    }
+}
+
+void RenderProfile::Add(const RenderProfile& p)
+{
+    AddTimes(effects, p.effects);
+    AddTimes(models, p.models);
+    AddTimes(layers, p.layers);
+    wallUS += p.wallUS;
+}
+
+void RenderProfile::Clear()
+{
+    effects.clear();
+    models.clear();
+    layers.clear();
+    wallUS = 0;
+}
+
+static std::vector<std::pair<std::string, RenderProfileTimes>> Slowest(const std::map<std::string, RenderProfileTimes>& times, int top)
+{
+    std::vector<std::pair<std::string, RenderProfileTimes>> res(times.begin(), times.end());
+    std::stable_sort(res.begin(), res.end(), [](const auto& a, const auto& b) {
+        return a.second.GetTotalUS() > b.second.GetTotalUS();
+    });
+    if (top > 0 && (int)res.size() > top) {
+        res.resize(top);
+    }
+    return res;
+}
+
+static std::string FormatMS(int64_t us)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3f", us / 1000.0);
+    return buf;
+}
+
+std::string RenderProfile::GetReport(int top) const
+{
+    int64_t total = 0;
+    for (const auto& it : models) {
+        total += it.second.GetTotalUS();
+    }
+
+    std::string report = "Render profile: " + FormatMS(wallUS) + "ms elapsed, " + FormatMS(total) + "ms across all render threads.\n";
+    auto section = [&report, top, total](const std::string& title, const std::map<std::string, RenderProfileTimes>& times) {
+        report += title + ":\n";
+        for (const auto& it : Slowest(times, top)) {
+            const RenderProfileTimes& t = it.second;
+            char buf[256];
+            snprintf(buf, sizeof(buf), ": %sms (%.1f%%), render %sms, blend %sms, transitions %sms, %u frames rendered, %u from the cache\n",
+                     FormatMS(t.GetTotalUS()).c_str(), total == 0 ? 0.0 : t.GetTotalUS() * 100.0 / total,
+                     FormatMS(t.renderUS).c_str(), FormatMS(t.blendUS).c_str(), FormatMS(t.transitionUS).c_str(), t.renders, t.cacheHits);
+            report += "    " + it.first + buf;
+        }
+    };
+    section("Effects", effects);
+    section("Models", models);
+    section("Layers", layers);
+    return report;
+}
+
+std::string RenderProfile::GetJSON(int top) const
+{
+    auto section = [top](const std::map<std::string, RenderProfileTimes>& times) {
+        std::string json = "[";
+        for (const auto& it : Slowest(times, top)) {
+            const RenderProfileTimes& t = it.second;
+            if (json.size() > 1) json += ",";
+            json += "{\"name\":\"" + JSONSafe(it.first) + "\"" +
+                    ",\"totalMS\":" + FormatMS(t.GetTotalUS()) +
+                    ",\"renderMS\":" + FormatMS(t.renderUS) +
+                    ",\"blendMS\":" + FormatMS(t.blendUS) +
+                    ",\"transitionMS\":" + FormatMS(t.transitionUS) +
+                    ",\"restoreMS\":" + FormatMS(t.restoreUS) +
+                    ",\"renders\":" + std::to_string(t.renders) +
+                    ",\"cacheHits\":" + std::to_string(t.cacheHits) + "}";
+        }
+        return json + "]";
+    };
+    return "{\"elapsedMS\":" + FormatMS(wallUS) +
+           ",\"effects\":" + section(effects) +
+           ",\"models\":" + section(models) +
+           ",\"layers\":" + section(layers) + "}";
+}
+
+RenderProfiler& RenderProfiler::GetDefaultProfiler()
+{
+    static RenderProfiler profiler;
+    return profiler;
+}
+
+void RenderProfiler::Add(const RenderProfile& profile)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    _profile.Add(profile);
+}
+
+void RenderProfiler::Reset()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    _profile.Clear();
+}
+
+RenderProfile RenderProfiler::GetProfile()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    return _profile;
+}
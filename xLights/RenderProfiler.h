@@ -0,0 +1,74 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+// where the time went for one effect, model or layer
+struct RenderProfileTimes
+{
+    int64_t renderUS = 0;     // rendering the effects
+    int64_t blendUS = 0;      // blending the layers together and into the output, less the transitions
+    int64_t transitionUS = 0; // in and out transitions
+    int64_t restoreUS = 0;    // copying layers back out of the layer frame cache
+    uint32_t renders = 0;     // frames the effects were rendered
+    uint32_t cacheHits = 0;   // frames restored from the layer frame cache instead of rendered
+
+    int64_t GetTotalUS() const { return renderUS + blendUS + transitionUS + restoreUS; }
+    void Add(const RenderProfileTimes& t);
+};
+
+// the times of one or more renders by effect name, model name and "model/layer"
+struct RenderProfile
+{
+    std::map<std::string, RenderProfileTimes> effects;
+    std::map<std::string, RenderProfileTimes> models;
+    std::map<std::string, RenderProfileTimes> layers;
+    int64_t wallUS = 0; // from the start of the render until the last model finished
+
+    void Add(const RenderProfile& p);
+    void Clear();
+    bool IsEmpty() const { return models.empty(); }
+
+    // the top entries of each, slowest first, top <= 0 for all of them
+    std::string GetReport(int top = 10) const;
+    std::string GetJSON(int top = 0) const;
+};
+
+/**
+ * Collects where render time is spent when turned on.
+ *
+ * Each RenderJob keeps its own RenderProfile while it renders so the render threads
+ * never wait on each other, they are added together here when the render finishes.
+ * When it is off the only cost to rendering is checking whether it is on as each job
+ * is created.
+ */
+class RenderProfiler
+{
+public:
+    static RenderProfiler& GetDefaultProfiler();
+
+    void SetEnabled(bool enabled) { _enabled = enabled; }
+    bool IsEnabled() const { return _enabled; }
+
+    void Add(const RenderProfile& profile);
+    void Reset();
+    RenderProfile GetProfile();
+
+private:
+    std::atomic_bool _enabled { false };
+    std::mutex _lock;
+    RenderProfile _profile;
+};
@@ -9,6 +9,8 @@
  **************************************************************/
 
 #include <wx/wx.h>
+#include <wx/file.h>
+#include <wx/filename.h>
 
 
 #include <log4cpp/Category.hh>
@@ -40,7 +42,34 @@ static const size_t DEFAULT_HUGE_ALLOC_SIZE = MAX_BLOCK_SIZE;
 #endif
 static size_t _hugePageAllocSize = DEFAULT_HUGE_ALLOC_SIZE;
 static bool _hugePagesFailed;
+
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+static bool _fileBackedThresholdSet = false;
+static size_t _fileBackedThresholdMB = 0;
+
+static size_t GetFileBackedThreshold()
+{
+    if (!_fileBackedThresholdSet) {
+        _fileBackedThresholdSet = true;
+        long pages = sysconf(_SC_PHYS_PAGES);
+        long pageSize = sysconf(_SC_PAGESIZE);
+        if (pages > 0 && pageSize > 0) {
+            _fileBackedThresholdMB = (size_t)pages / 4 * (size_t)pageSize / (1024 * 1024);
+        }
+    }
+    return _fileBackedThresholdMB * 1024 * 1024;
+}
+#endif
+
+void SequenceData::SetFileBackedThresholdMB(size_t mb)
+{
+#ifdef USE_MMAP_BLOCKS
+    _fileBackedThresholdSet = true;
+    _fileBackedThresholdMB = mb;
 #endif
+}
 
 SequenceData::SequenceData() : _invalidFrame()
 {
@@ -273,6 +302,90 @@ unsigned char *SequenceData::checkBlockPtr(unsigned char *block, size_t sizeRema
     return block;
 }
 
+#ifdef USE_MMAP_BLOCKS
+unsigned char* SequenceData::MapTempFile(size_t size)
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::string dir = wxFileName::GetTempDir().ToStdString();
+#ifdef LINUX
+    // /tmp is often a ram disk which would defeat the point
+    if (getenv("TMPDIR") == nullptr && wxDirExists("/var/tmp")) {
+        dir = "/var/tmp";
+    }
+#endif
+    // the file starts out sparse, make sure there is room for it to fill up as writing
+    // to the mapping once the disk is full would crash
+    struct statvfs fs;
+    if (statvfs(dir.c_str(), &fs) != 0 || (uint64_t)fs.f_bavail * fs.f_frsize < size + size / 4) {
+        logger_base.warn("Not enough space in %s to page the frame data to disk.", (const char*)dir.c_str());
+        return nullptr;
+    }
+
+    std::string name = dir + "/xLightsFrameDataXXXXXX";
+    int fd = mkstemp(&name[0]);
+    if (fd < 0) {
+        logger_base.warn("Unable to create %s to page the frame data to disk.", (const char*)name.c_str());
+        return nullptr;
+    }
+    // only the mapping refers to the file now so it goes away however xLights exits
+    unlink(name.c_str());
+
+    unsigned char* data = nullptr;
+    if (ftruncate(fd, size) == 0) {
+        data = (unsigned char*)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            data = nullptr;
+        }
+    }
+    close(fd);
+    if (data == nullptr) {
+        logger_base.warn("Unable to map %s to page the frame data to disk.", (const char*)name.c_str());
+    }
+    return data;
+}
+#endif
+
+void SequenceData::AllocFrames()
+{
+    _frames.reserve(_numFrames);
+    size_t sizeRemaining = (size_t)_bytesPerFrame * (size_t)_numFrames;
+
+#ifdef USE_MMAP_BLOCKS
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    size_t threshold = GetFileBackedThreshold();
+    if (threshold > 0 && sizeRemaining > threshold) {
+        // too big to comfortably hold in memory, let the OS page the frames to a file
+        // rather than pushing everything else out to swap
+        unsigned char* block = MapTempFile(sizeRemaining);
+        if (block != nullptr) {
+            logger_base.debug("Frame data paged to disk. Frames=%d, Channels=%d, Memory=%ld.", _numFrames, _numChannels, sizeRemaining);
+            _dataBlocks.push_back(std::make_unique<DataBlock>(sizeRemaining, block, BlockType::FILE_MAPPED));
+            for (unsigned int frame = 0; frame < _numFrames; ++frame) {
+                _frames.push_back(FrameData(_numChannels, block + (size_t)frame * _bytesPerFrame));
+            }
+            return;
+        }
+    }
+#endif
+
+    size_t blockSize = 0;
+    BlockType type = BlockType::NORMAL;
+    unsigned char* block = checkBlockPtr(AllocBlock(sizeRemaining, blockSize, type), sizeRemaining);
+    _dataBlocks.push_back(std::make_unique<DataBlock>(blockSize, block, type));
+
+    for (unsigned int frame = 0; frame < _numFrames; ++frame) {
+        if (blockSize < _bytesPerFrame) {
+            block = checkBlockPtr(AllocBlock(sizeRemaining, blockSize, type), sizeRemaining);
+            _dataBlocks.push_back(std::make_unique<DataBlock>(blockSize, block, type));
+        }
+        _frames.push_back(FrameData(_numChannels, block));
+        block += _bytesPerFrame;
+        sizeRemaining -= _bytesPerFrame;
+        blockSize -= _bytesPerFrame;
+    }
+}
+
 void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsigned int frameTime, bool roundto4)
 {
     static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
@@ -288,24 +401,7 @@ void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsign
     _bytesPerFrame = roundTo4(numChannels);
 
     if (numFrames > 0 && numChannels > 0) {
-        _frames.reserve(numFrames);
-        size_t sizeRemaining = (size_t)_bytesPerFrame * (size_t)_numFrames;
-        size_t blockSize = 0;
-        
-        BlockType type = BlockType::NORMAL;
-        unsigned char* block = checkBlockPtr(AllocBlock(sizeRemaining, blockSize, type), sizeRemaining);
-        _dataBlocks.push_back(std::make_unique<DataBlock>(blockSize, block, type));
-        
-        for (unsigned int frame = 0; frame < numFrames; ++frame) {
-            if (blockSize < _bytesPerFrame) {
-                block = checkBlockPtr(AllocBlock(sizeRemaining, blockSize, type), sizeRemaining);
-                _dataBlocks.push_back(std::make_unique<DataBlock>(blockSize, block, type));
-            }
-            _frames.push_back(FrameData(_numChannels, block));
-            block += _bytesPerFrame;
-            sizeRemaining -= _bytesPerFrame;
-            blockSize -= _bytesPerFrame;
-        }
+        AllocFrames();
     }
     else {
         logger_base.debug("Sequence memory released.");
@@ -314,6 +410,109 @@ void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsign
     _invalidFrame._numChannels = _numChannels;
 }
 
+void SequenceData::initSparse(unsigned int numChannels, unsigned int numFrames, unsigned int frameTime, const std::vector<std::pair<uint32_t, uint32_t>>& ranges)
+{
+#ifdef USE_MMAP_BLOCKS
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t bytesPerFrame = roundTo4(numChannels);
+    size_t framePages = (bytesPerFrame + pageSize - 1) / pageSize;
+    size_t usedPages = 0;
+    for (const auto& r : ranges) {
+        // a range can straddle a page boundary in every frame
+        usedPages += (r.second + pageSize - 1) / pageSize + 1;
+    }
+    if (numFrames > 0 && numChannels > 0 && usedPages * 2 <= framePages) {
+        size_t size = bytesPerFrame * (size_t)numFrames;
+        unsigned char* block = (unsigned char*)mmap(nullptr, size,
+            PROT_READ | PROT_WRITE,
+            MAP_ANON | MAP_PRIVATE | MAP_NORESERVE,
+            -1, 0);
+        if (block != MAP_FAILED) {
+#ifdef LINUX
+            // a huge page would commit all the channels around the ranges
+            madvise(block, size, MADV_NOHUGEPAGE);
+#endif
+            Cleanup();
+            _numChannels = roundTo4(numChannels);
+            _numFrames = numFrames;
+            _frameTime = frameTime;
+            _bytesPerFrame = bytesPerFrame;
+            _dataBlocks.push_back(std::make_unique<DataBlock>(size, block, BlockType::NORMAL));
+            _frames.reserve(_numFrames);
+            for (unsigned int frame = 0; frame < _numFrames; ++frame) {
+                _frames.push_back(FrameData(_numChannels, block + (size_t)frame * _bytesPerFrame));
+            }
+            _invalidFrame._data = (unsigned char*)calloc(1, _bytesPerFrame);
+            _invalidFrame._numChannels = _numChannels;
+            logger_base.debug("Sparse frame data reserved. Frames=%d, Channels=%d, Pages used per frame=%d of %d.",
+                              _numFrames, _numChannels, (int)usedPages, (int)framePages);
+            return;
+        }
+    }
+#endif
+    init(numChannels, numFrames, frameTime);
+}
+
+bool SequenceData::initFromFile(const std::string& filename, uint64_t offset, unsigned int numChannels, unsigned int numFrames, unsigned int frameTime)
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    Cleanup();
+    _numChannels = 0;
+    _numFrames = 0;
+    _bytesPerFrame = 0;
+    _frameTime = frameTime;
+
+    if (numChannels == 0 || numFrames == 0 || numChannels != roundTo4(numChannels)) {
+        return false;
+    }
+    wxFile file;
+    if (!file.Open(filename) || (uint64_t)file.Length() < offset + (uint64_t)numChannels * numFrames || file.Seek(offset) == wxInvalidOffset) {
+        logger_base.debug("Unable to read the frame data from %s.", (const char*)filename.c_str());
+        return false;
+    }
+
+    // the frames are read into our own memory rather than mapping the fseq as it can be
+    // rewritten or deleted while the sequence is open
+    _numChannels = numChannels;
+    _numFrames = numFrames;
+    _bytesPerFrame = numChannels;
+    AllocFrames();
+    _invalidFrame._data = (unsigned char*)calloc(1, _bytesPerFrame);
+    _invalidFrame._numChannels = _numChannels;
+
+    unsigned int frame = 0;
+    while (frame < _numFrames) {
+        // read as many frames as are next to each other in one go
+        unsigned int count = 1;
+        while (frame + count < _numFrames && _frames[frame + count]._data == _frames[frame]._data + (size_t)count * _bytesPerFrame) {
+            count++;
+        }
+        size_t size = (size_t)count * _bytesPerFrame;
+        if ((size_t)file.Read(_frames[frame]._data, size) != size) {
+            logger_base.debug("Unable to read the frame data from %s.", (const char*)filename.c_str());
+            Cleanup();
+            _numChannels = 0;
+            _numFrames = 0;
+            _bytesPerFrame = 0;
+            return false;
+        }
+        frame += count;
+    }
+    logger_base.debug("Frame data read from %s. Frames=%d, Channels=%d.", (const char*)filename.c_str(), _numFrames, _numChannels);
+    return true;
+}
+
+bool SequenceData::IsFileBacked() const
+{
+    for (auto& b : _dataBlocks) {
+        if (b->type == BlockType::FILE_MAPPED) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // This encodes the sequence data grouped by channel
 wxString SequenceData::base64_encode()
 {
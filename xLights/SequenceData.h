@@ -13,6 +13,8 @@
 #include <wx/wx.h>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 #ifdef __WXOSX__
 #include <sys/mman.h>
@@ -70,7 +72,10 @@ public:
 
     enum class BlockType {
         NORMAL,
-        HUGE_PAGE
+        HUGE_PAGE,
+        // every frame back to back in one shared mapping of an unlinked temp file so the OS can
+        // page them out to it, used for sequences over the file backed threshold
+        FILE_MAPPED
     };
     class DataBlock {
         DataBlock(const DataBlock&d) = delete;
@@ -102,11 +107,30 @@ public:
     void Cleanup();
     unsigned char *checkBlockPtr(unsigned char *block, size_t sizeRemaining);
     static unsigned char *AllocBlock(size_t requested, size_t &szAllocated, BlockType &bt);
+    void AllocFrames();
+#ifdef USE_MMAP_BLOCKS
+    static unsigned char *MapTempFile(size_t size);
+#endif
 public:
     SequenceData();
     virtual ~SequenceData();
     
     void init(unsigned int numChannels, unsigned int numFrames, unsigned int frameTime, bool roundto4 = true);
+    // Like init but only the channels in ranges (start, count) are going to be used, as when
+    // rendering one model.  The frames are reserved without committing memory so only the
+    // pages the ranges fall in take up memory.  Falls back to init if the ranges cover most
+    // of each frame or the platform can't reserve memory that way.
+    void initSparse(unsigned int numChannels, unsigned int numFrames, unsigned int frameTime, const std::vector<std::pair<uint32_t, uint32_t>>& ranges);
+    // Like init but the frames are read straight from the channel data of an uncompressed
+    // fseq.  numChannels must be the fseq's channel count rounded to 4.  Returns false if
+    // the file can't be read, the frames are then left empty and init should be used.
+    bool initFromFile(const std::string& filename, uint64_t offset, unsigned int numChannels, unsigned int numFrames, unsigned int frameTime);
+    [[nodiscard]] bool IsFileBacked() const;
+
+    // Sequences needing more than this many MB are kept in a sparse temp file the OS can
+    // page in and out rather than in memory, 0 never uses a file.  Defaults to a quarter
+    // of the physical memory.
+    static void SetFileBackedThresholdMB(size_t mb);
     unsigned int TotalTime() const { return _numFrames * _frameTime; }
     bool OK(unsigned int frame, unsigned int channel) const { return frame < _numFrames && channel < _numChannels; }
     
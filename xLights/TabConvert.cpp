@@ -43,6 +43,7 @@ extern "C"
 #include "sequencer/EffectLayer.h"
 #include "xLightsMain.h"
 #include "FSEQFile.h"
+#include "FSEQStreamWriter.h"
 #include "CopyFormat1.h"
 #include "VideoExporter.h"
 
@@ -1436,8 +1437,6 @@ static void addRanges(Model* m, std::map<uint32_t, uint32_t>& ranges)
 
 void xLightsFrame::WriteFalconPiFile(const wxString& filename, bool allowSparse)
 {
-    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
     ConvertParameters write_params(filename,                               // filename
                                    _seqData,                               // sequence data object
                                    &_outputManager,                        // global network info
@@ -1450,49 +1449,98 @@ void xLightsFrame::WriteFalconPiFile(const wxString& filename, bool allowSparse)
                                    filename);
     write_params.elements = &_sequenceElements;
     if (allowSparse) {
-        std::map<uint32_t, uint32_t> ranges;
-        int numElements = _sequenceElements.GetElementCount();
-        for (int i = 0; i < numElements; ++i) {
-            Element* element = _sequenceElements.GetElement(i);
-            if (element == nullptr)
-                logger_base.crit("Element %d returns as null.", i);
-            if (element->GetType() == ElementType::ELEMENT_TYPE_MODEL) {
-                std::string modelName = element->GetModelName();
-                Model* m = this->GetModel(modelName);
-                if (m == nullptr) {
-                    logger_base.crit("Model %s returns as null.", (const char*)modelName.c_str());
-                } else {
-                    addRanges(m, ranges);
-                }
+        AddFalconPiFileRanges(write_params);
+    }
+
+    FileConverter::WriteFalconPiFile(write_params);
+}
+
+FSEQStreamWriter* xLightsFrame::StartFalconPiFileStream(const wxString& filename)
+{
+    // written to a temporary file so an aborted render doesn't leave the fseq truncated
+    wxString tempFilename = filename + ".tmp";
+    ConvertParameters write_params(filename,                               // filename
+                                   _seqData,                               // sequence data object
+                                   &_outputManager,                        // global network info
+                                   ConvertParameters::READ_MODE_LOAD_MAIN, // file read mode
+                                   this,                                   // xLights main frame
+                                   nullptr,
+                                   nullptr,
+                                   &mediaFilename, // media filename
+                                   nullptr,
+                                   tempFilename);
+    write_params.elements = &_sequenceElements;
+    AddFalconPiFileRanges(write_params);
+
+    FSEQFile* file = FileConverter::CreateFalconPiFile(write_params);
+    if (file == nullptr) {
+        return nullptr;
+    }
+    return new FSEQStreamWriter(file, _seqData, filename.ToStdString());
+}
+
+// The frames can only be written as they render if nothing changes them afterwards,
+// which is the case unless there are imported data layers above the effects
+bool xLightsFrame::CanStreamFalconPiFile()
+{
+    if (CurrentSeqXmlFile == nullptr) {
+        return false;
+    }
+    DataLayerSet& data_layers = CurrentSeqXmlFile->GetDataLayers();
+    bool above = false;
+    for (int i = 0; i < data_layers.GetNumLayers(); ++i) {
+        if (data_layers.GetDataLayer(i)->GetName() == "Nutcracker") {
+            return !above;
+        }
+        above = true;
+    }
+    return true;
+}
+
+void xLightsFrame::AddFalconPiFileRanges(ConvertParameters& write_params)
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::map<uint32_t, uint32_t> ranges;
+    int numElements = _sequenceElements.GetElementCount();
+    for (int i = 0; i < numElements; ++i) {
+        Element* element = _sequenceElements.GetElement(i);
+        if (element == nullptr)
+            logger_base.crit("Element %d returns as null.", i);
+        if (element->GetType() == ElementType::ELEMENT_TYPE_MODEL) {
+            std::string modelName = element->GetModelName();
+            Model* m = this->GetModel(modelName);
+            if (m == nullptr) {
+                logger_base.crit("Model %s returns as null.", (const char*)modelName.c_str());
+            } else {
+                addRanges(m, ranges);
             }
         }
+    }
 
-        uint32_t gapEliminate = 0; // set if we want to eliminate gaps
-        std::pair<uint32_t, uint32_t> cur(INT_MAX, INT_MAX);
-        for (auto& a : ranges) {
-            if (cur.first == INT_MAX) {
+    uint32_t gapEliminate = 0; // set if we want to eliminate gaps
+    std::pair<uint32_t, uint32_t> cur(INT_MAX, INT_MAX);
+    for (auto& a : ranges) {
+        if (cur.first == INT_MAX) {
+            cur.first = a.first;
+            cur.second = a.second;
+        } else {
+            if (a.first <= (cur.first + cur.second + gapEliminate)) {
+                // overlap or within 1025 channels of an overlap, need to combine
+                // if the two ranges are "close" (wthin 1025 channels) we'll combine
+                // as the overhead of doing ranges wouldn't benefit with a small gap
+                uint32_t max = cur.first + cur.second - 1;
+                uint32_t amax = a.first + a.second - 1;
+                max = std::max(max, amax);
+                cur.second = max - cur.first + 1;
+            } else {
+                write_params.ranges.push_back(cur);
                 cur.first = a.first;
                 cur.second = a.second;
-            } else {
-                if (a.first <= (cur.first + cur.second + gapEliminate)) {
-                    // overlap or within 1025 channels of an overlap, need to combine
-                    // if the two ranges are "close" (wthin 1025 channels) we'll combine
-                    // as the overhead of doing ranges wouldn't benefit with a small gap
-                    uint32_t max = cur.first + cur.second - 1;
-                    uint32_t amax = a.first + a.second - 1;
-                    max = std::max(max, amax);
-                    cur.second = max - cur.first + 1;
-                } else {
-                    write_params.ranges.push_back(cur);
-                    cur.first = a.first;
-                    cur.second = a.second;
-                }
             }
         }
-        if (cur.first != INT_MAX) {
-            write_params.ranges.push_back(cur);
-        }
     }
-
-    FileConverter::WriteFalconPiFile(write_params);
+    if (cur.first != INT_MAX) {
+        write_params.ranges.push_back(cur);
+    }
 }
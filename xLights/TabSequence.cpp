@@ -40,6 +40,10 @@
 #include "sequencer/MainSequencer.h"
 #include "HousePreviewPanel.h"
 #include "ExternalHooks.h"
+#include "FSEQStreamWriter.h"
+#include "RenderBenchmark.h"
+#include "RenderProfiler.h"
+#include "effects/TextLineCache.h"
 
 #include "xLightsVersion.h"
 #include "TopEffectsPanel.h"
@@ -324,6 +328,7 @@ wxString xLightsFrame::LoadEffectsFileNoCheck()
         UnsavedRgbEffectsChanges = true;
     }
     _renderCache.SetRenderCacheFolder(renderCacheDirectory);
+    AudioManager::SetAnalysisCacheFolder(renderCacheDirectory);
 
     mStoredLayoutGroup = GetXmlSetting("storedLayoutGroup", "Default");
 
@@ -1223,7 +1228,9 @@ void xLightsFrame::OpenRenderAndSaveSequences(const wxArrayString &origFilenames
     RenderIseqData(true, nullptr); // render ISEQ layers below the Nutcracker layer
     logger_base.info("   iseq below effects done.");
     ProgressBar->SetValue(10);
-    RenderGridToSeqData([this, sw, fileNames, exitOnDone, alreadyRetried] (bool aborted) {
+    // write the fseq as the frames are rendered
+    FSEQStreamWriter* fseqStream = CanStreamFalconPiFile() ? StartFalconPiFileStream(xlightsFilename) : nullptr;
+    RenderGridToSeqData([this, sw, fileNames, exitOnDone, alreadyRetried, fseqStream] (bool aborted) {
         static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
         logger_base.info("   Effects done.");
         ProgressBar->SetValue(90);
@@ -1238,7 +1245,12 @@ void xLightsFrame::OpenRenderAndSaveSequences(const wxArrayString &origFilenames
         if (!aborted || alreadyRetried) {
             logger_base.info("Saving fseq file.");
             SetStatusText(_("Saving ") + xlightsFilename + _(" ... Writing fseq."));
-            WriteFalconPiFile(xlightsFilename);
+            if (fseqStream != nullptr) {
+                fseqStream->Finish();
+                delete fseqStream;
+            } else {
+                WriteFalconPiFile(xlightsFilename);
+            }
             logger_base.info("fseq file done.");
             DisplayXlightsFilename(xlightsFilename);
             float elapsedTime = sw.Time() / 1000.0; // now stop stopwatch timer and get elapsed time. change into seconds from ms
@@ -1253,9 +1265,101 @@ void xLightsFrame::OpenRenderAndSaveSequences(const wxArrayString &origFilenames
             CallAfter(&xLightsFrame::OpenRenderAndSaveSequencesF, nFileNames, (exitOnDone ? RENDER_EXIT_ON_DONE : 0));
         } else {
             logger_base.info("Render was aborted, retrying.");
+            delete fseqStream;
             CallAfter(&xLightsFrame::OpenRenderAndSaveSequencesF, fileNames, (exitOnDone ? RENDER_EXIT_ON_DONE : 0) | RENDER_ALREADY_RETRIED);
         }
-    } );
+    }, fseqStream);
+}
+
+void xLightsFrame::OpenAndBenchmarkSequencesF(const wxArrayString& filenames, int flags)
+{
+    OpenAndBenchmarkSequences(filenames, flags & RENDER_EXIT_ON_DONE);
+}
+
+void xLightsFrame::OpenAndBenchmarkSequences(const wxArrayString& origFilenames, bool exitOnDone)
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (origFilenames.IsEmpty()) {
+        RenderProfiler::GetDefaultProfiler().SetEnabled(false);
+        if (_benchmarkResultsFile != "") {
+            wxFile f;
+            if (f.Create(_benchmarkResultsFile, true) && f.Write("[" + _benchmarkResults + "]\n")) {
+                logger_base.info("Benchmark results written to %s.", (const char*)_benchmarkResultsFile.c_str());
+            } else {
+                logger_base.error("Unable to write benchmark results to %s.", (const char*)_benchmarkResultsFile.c_str());
+                printf("Unable to write benchmark results to %s\n", (const char*)_benchmarkResultsFile.c_str());
+            }
+        }
+        _benchmarkResults = "";
+        _renderMode = false;
+        EnableSequenceControls(true);
+        logger_base.debug("Benchmark done.");
+        printf("Benchmark done\n");
+        if (exitOnDone) {
+            Destroy();
+        } else {
+            CloseSequence();
+            SetStatusText(_("Benchmark Done."));
+        }
+        return;
+    }
+
+    // frames from an earlier render would make the numbers meaningless, the preference is left alone
+    _renderCache.Enable("Disabled");
+
+    wxArrayString fileNames = origFilenames;
+    wxString seq = fileNames[0];
+    fileNames.RemoveAt(0);
+
+    printf("Benchmarking %s\n", (const char*)seq.c_str());
+    logger_base.info("Benchmarking %s.", (const char*)seq.c_str());
+    EnableSequenceControls(false);
+    OpenSequence(seq, nullptr);
+    EnableSequenceControls(false);
+    if (CurrentSeqXmlFile == nullptr || _seqData.NumFrames() == 0) {
+        logger_base.error("Unable to open %s to benchmark it.", (const char*)seq.c_str());
+        printf("Unable to open %s\n", (const char*)seq.c_str());
+        CallAfter(&xLightsFrame::OpenAndBenchmarkSequencesF, fileNames, (exitOnDone ? RENDER_EXIT_ON_DONE : 0));
+        return;
+    }
+    SetStatusText(_("Benchmarking ") + seq + _("."));
+
+    // each sequence is timed from the same start, nothing left from the one before
+    TextLineCache::GetDefaultCache().Clear();
+    TextLineCache::GetDefaultCache().ResetCounters();
+    RenderProfiler::GetDefaultProfiler().Reset();
+    RenderProfiler::GetDefaultProfiler().SetEnabled(true);
+    auto benchmark = std::make_shared<RenderBenchmark>();
+    benchmark->Start();
+    RenderIseqData(true, nullptr);
+    RenderGridToSeqData([this, benchmark, seq, fileNames, exitOnDone](bool aborted) {
+        static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        RenderIseqData(false, nullptr);
+        benchmark->Finish(_seqData);
+
+        std::string name = wxFileName(seq).GetFullName().ToStdString();
+        std::string report = benchmark->GetReport(name);
+        if (aborted) {
+            report += "    The render was aborted, the results are not complete.\n";
+        }
+        printf("%s", report.c_str());
+        logger_base.info("%s", report.c_str());
+
+        std::string json = benchmark->GetJSON(name);
+        json.pop_back();
+        json += std::string(",\"aborted\":") + (aborted ? "true" : "false") +
+                ",\"profile\":" + RenderProfiler::GetDefaultProfiler().GetProfile().GetJSON(10) + "}";
+        if (!_benchmarkResults.empty()) {
+            _benchmarkResults += ",";
+        }
+        _benchmarkResults += json;
+
+        // nothing is saved so don't ask about it
+        mSavedChangeCount = _sequenceElements.GetChangeCount();
+        mLastAutosaveCount = mSavedChangeCount;
+        CallAfter(&xLightsFrame::OpenAndBenchmarkSequencesF, fileNames, (exitOnDone ? RENDER_EXIT_ON_DONE : 0));
+    }, nullptr);
 }
 
 void xLightsFrame::SaveSequence()
@@ -1378,7 +1482,9 @@ void xLightsFrame::SaveSequence()
         RenderIseqData(true, nullptr); // render ISEQ layers below the Nutcracker layer
         logger_base.info("   iseq below effects done.");
         ProgressBar->SetValue(10);
-        RenderGridToSeqData([this, sw] (bool aborted) {
+        // write the fseq as the frames are rendered
+        FSEQStreamWriter* fseqStream = CanStreamFalconPiFile() ? StartFalconPiFileStream(xlightsFilename) : nullptr;
+        RenderGridToSeqData([this, sw, fseqStream] (bool aborted) {
             static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
             logger_base.info("   Effects done.");
             ProgressBar->SetValue(90);
@@ -1393,7 +1499,12 @@ void xLightsFrame::SaveSequence()
             logger_base.info("Saving fseq file.");
 
             SetStatusText(_("Saving ") + xlightsFilename + _(" ... Writing fseq."));
-            WriteFalconPiFile(xlightsFilename);
+            if (fseqStream != nullptr) {
+                fseqStream->Finish();
+                delete fseqStream;
+            } else {
+                WriteFalconPiFile(xlightsFilename);
+            }
             logger_base.info("fseq file done.", true);
             DisplayXlightsFilename(xlightsFilename);
             float elapsedTime = sw.Time()/1000.0; // now stop stopwatch timer and get elapsed time. change into seconds from ms
@@ -1403,7 +1514,7 @@ void xLightsFrame::SaveSequence()
             EnableSequenceControls(true);
             mSavedChangeCount = _sequenceElements.GetChangeCount();
             mLastAutosaveCount = mSavedChangeCount;
-        } );
+        }, fseqStream);
         return;
     }
     wxString display_name;
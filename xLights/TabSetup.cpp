@@ -55,6 +55,7 @@
 #include "outputs/DMXOutput.h"
 #include "outputs/LOROptimisedOutput.h"
 #include "outputs/TwinklyOutput.h"
+#include "outputs/UDPTransmitter.h"
 #include "Discovery.h"
 
 #include "../xFade/wxLED.h"
@@ -1653,6 +1654,13 @@ void xLightsFrame::SetControllersProperties(bool rebuildPropGrid) {
         p->SetAttribute("Min", 0);
         p->SetAttribute("Max", 1000);
         p->SetEditor("SpinCtrl");
+        if (UDPTransmitter::IsAvailable()) {
+            p = Controllers_PropertyEditor->Append(new wxUIntProperty("UDP Packet Pacing (ms)", "UDPPacingMS", _outputManager.GetUDPPacingMS()));
+            p->SetAttribute("Min", 0);
+            p->SetAttribute("Max", 50);
+            p->SetEditor("SpinCtrl");
+            p->SetHelpString("Spreads the E1.31, ArtNET and DDP packets of each frame over this many milliseconds rather than sending them all at once, for switches that drop packets when a large show sends a frame. Keep it well under the frame time. 0 sends them together.");
+        }
 
         auto ips = GetLocalIPs();
         wxPGChoices choices;
@@ -1866,6 +1874,10 @@ void xLightsFrame::OnControllerPropertyGridChange(wxPropertyGridEvent& event) {
             SetSuppressDuplicateFrames((int)event.GetValue().GetLong());
             _outputModelManager.AddASAPWork(OutputModelManager::WORK_NETWORK_CHANGE, "OnControllerPropertyGridChange::MaxSuppressFrames");
         }
+        else if (name == "UDPPacingMS") {
+            _outputManager.SetUDPPacingMS((int)event.GetValue().GetLong());
+            _outputModelManager.AddASAPWork(OutputModelManager::WORK_NETWORK_CHANGE, "OnControllerPropertyGridChange::UDPPacingMS");
+        }
         else if (name == "GlobalFPPProxy") {
             _outputManager.SetGlobalFPPProxy(event.GetValue().GetString().Trim(true).Trim(false));
             _outputModelManager.AddASAPWork(OutputModelManager::WORK_NETWORK_CHANGE, "OnControllerPropertyGridChange::GlobalFPPProxy");
@@ -1789,9 +1789,9 @@ float ValueCurve::GetValueAt(float offset, long startMS, long endMS)
                 float f = 0.0;
                 for (long ms = time; ms < time + msperPoint; ms += frameMS) {
                     auto pf = __audioManager->GetFrameData(FRAMEDATATYPE::FRAMEDATA_HIGH, "", ms + frameMS);
-                    if (pf != nullptr) {
-                        if (*pf->begin() > f) {
-                            f = *pf->begin();
+                    if (pf) {
+                        if (pf.front() > f) {
+                            f = pf.front();
                         }
                     }
                 }
@@ -1900,8 +1900,8 @@ float ValueCurve::GetValueAt(float offset, long startMS, long endMS)
             long time = (float)startMS + offset * (endMS - startMS);
             float f = 0.0;
             auto pf = __audioManager->GetFrameData(FRAMEDATATYPE::FRAMEDATA_HIGH, "", time);
-            if (pf != nullptr) {
-                f = ApplyGain(*pf->begin(), GetParameter3());
+            if (pf) {
+                f = ApplyGain(pf.front(), GetParameter3());
                 if (_type == "Inverted Music") {
                     f = 1.0 - f;
                 }
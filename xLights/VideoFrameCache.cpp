@@ -0,0 +1,357 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "VideoFrameCache.h"
+#include "VideoReader.h"
+
+#include <log4cpp/Category.hh>
+
+#pragma region VideoClip
+VideoClip::VideoClip(VideoFrameCache* cache, const std::string& filename, int width, int height, bool keepAspectRatio,
+                     bool nativeResolution, bool alpha, int decodeAheadMS) :
+    _cache(cache), _filename(filename), _pixelChannels(alpha ? 4 : 3), _decodeAheadMS(decodeAheadMS)
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    _reader = new VideoReader(filename, width, height, keepAspectRatio, nativeResolution, alpha);
+    if (_reader->IsValid()) {
+        _valid = true;
+        _lengthMS = _reader->GetLengthMS();
+        _width = _reader->GetWidth();
+        _height = _reader->GetHeight();
+        _frameMS = _reader->GetFrameMS();
+
+        // read the first frame ... if i dont it thinks the first frame i read is the first frame
+        _reader->GetNextFrame(0);
+
+        _thread = std::thread(&VideoClip::Run, this);
+    } else {
+        logger_base.warn("VideoFrameCache: Failed to load video file %s.", (const char*)filename.c_str());
+        delete _reader;
+        _reader = nullptr;
+    }
+}
+
+VideoClip::~VideoClip()
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    {
+        std::unique_lock<std::mutex> lock(_cache->_lock);
+        _stop = true;
+        _signal.notify_all();
+    }
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_cache->_lock);
+        _cache->Remove(this);
+    }
+
+    if (_reader != nullptr) {
+        delete _reader;
+        _reader = nullptr;
+    }
+
+    if (_valid) {
+        logger_base.debug("VideoFrameCache: %s (%dx%d) closed, %u frames decoded, %u found in the cache, %u waited for.",
+                          (const char*)_filename.c_str(), _width, _height, _decodedCount, _hits, _misses);
+    }
+}
+
+long VideoClip::GetAheadFrames() const
+{
+    if (_frameMS <= 0) return 0;
+
+    // never decode so far ahead the frames would push each other out of the cache
+    size_t frameBytes = std::max((size_t)1, (size_t)_width * _height * _pixelChannels);
+    return std::min((long)(_decodeAheadMS / _frameMS), (long)(_cache->GetMaxBytes() / 2 / frameBytes));
+}
+
+std::shared_ptr<const VideoFrame> VideoClip::GetFrame(long ms, int waitMS)
+{
+    if (!_valid || ms < 0 || ms > _lengthMS) return nullptr;
+
+    long key = GetKey(ms);
+
+    std::unique_lock<std::mutex> lock(_cache->_lock);
+
+    // whoever asked last decides where the thread decodes ahead
+    long aheadEnd = key + 1 + GetAheadFrames();
+    if (_aheadNext != key + 1 || _aheadEnd != aheadEnd) {
+        _aheadNext = key + 1;
+        _aheadEnd = aheadEnd;
+        _signal.notify_one();
+    }
+
+    auto it = _frames.find(key);
+    if (it != _frames.end()) {
+        _hits++;
+        _cache->Touch(this, key);
+        return it->second;
+    }
+    if (_empty.find(key) != _empty.end() || _failed.find(key) != _failed.end()) return nullptr;
+
+    _misses++;
+    _requests.push_back(key);
+    _waiting[key]++;
+    _signal.notify_one();
+
+    auto ready = [this, key]() { return _stop || _frames.find(key) != _frames.end() || _empty.find(key) != _empty.end() || _failed.find(key) != _failed.end(); };
+    if (waitMS < 0) {
+        _decoded.wait(lock, ready);
+    } else {
+        _decoded.wait_for(lock, std::chrono::milliseconds(waitMS), ready);
+    }
+
+    if (--_waiting[key] == 0) {
+        _waiting.erase(key);
+        // everyone waiting has been told, the next request decodes it again
+        _failed.erase(key);
+    }
+
+    it = _frames.find(key);
+    if (it == _frames.end()) return nullptr;
+    _cache->Touch(this, key);
+    return it->second;
+}
+
+bool VideoClip::IsPastEnd(long ms)
+{
+    if (!_valid || ms >= _lengthMS) return true;
+
+    std::unique_lock<std::mutex> lock(_cache->_lock);
+    return _empty.find(GetKey(ms)) != _empty.end();
+}
+
+void VideoClip::Run()
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    logger_base.debug("VideoFrameCache: Decoding thread for %s (%dx%d) started.", (const char*)_filename.c_str(), _width, _height);
+
+    std::unique_lock<std::mutex> lock(_cache->_lock);
+    while (!_stop) {
+        auto has = [this](long k) { return _frames.find(k) != _frames.end() || _empty.find(k) != _empty.end() || _failed.find(k) != _failed.end(); };
+
+        // frames someone is waiting on come first
+        long key = -1;
+        bool requested = false;
+        while (!_requests.empty() && key < 0) {
+            long k = _requests.front();
+            _requests.pop_front();
+            if (!has(k)) {
+                key = k;
+                requested = true;
+            }
+        }
+        if (key < 0) {
+            while (_aheadNext < _aheadEnd && has(_aheadNext)) {
+                _aheadNext++;
+            }
+            if (_aheadNext < _aheadEnd) {
+                key = _aheadNext++;
+            }
+        }
+        if (key < 0) {
+            _signal.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        auto frame = Decode(key);
+        bool atEnd = frame == nullptr && _reader->AtEnd();
+        lock.lock();
+
+        if (atEnd) {
+            _empty.insert(key);
+            if (!requested && key < _aheadEnd) {
+                // we have run off the end of the video
+                _aheadEnd = _aheadNext;
+            }
+        } else if (frame == nullptr) {
+            // only remembered while someone is waiting for it so a bad read is not permanent
+            if (_waiting.find(key) != _waiting.end()) {
+                _failed.insert(key);
+            }
+        } else {
+            _decodedCount++;
+            _frames[key] = frame;
+            _cache->Add(this, key, frame);
+        }
+        _decoded.notify_all();
+    }
+
+    logger_base.debug("VideoFrameCache: Decoding thread for %s (%dx%d) stopped.", (const char*)_filename.c_str(), _width, _height);
+}
+
+std::shared_ptr<VideoFrame> VideoClip::Decode(long key)
+{
+    AVFrame* image = _reader->GetNextFrame(_frameMS > 0 ? key * _frameMS : key);
+    if (image == nullptr || image->data[0] == nullptr) return nullptr;
+
+    auto frame = std::make_shared<VideoFrame>();
+    frame->width = _reader->GetWidth();
+    frame->height = _reader->GetHeight();
+    int ch = _reader->GetPixelChannels();
+    int linesize = image->linesize[0] > 0 ? image->linesize[0] : frame->width * ch;
+
+    // most videos have no transparency so there is no point keeping the alpha channel
+    bool opaque = ch == 4;
+    for (int y = 0; y < frame->height && opaque; y++) {
+        const uint8_t* p = image->data[0] + y * linesize + 3;
+        for (int x = 0; x < frame->width; x++, p += 4) {
+            if (*p != 0xFF) {
+                opaque = false;
+                break;
+            }
+        }
+    }
+
+    frame->channels = opaque ? 3 : ch;
+    frame->data.resize((size_t)frame->width * frame->height * frame->channels);
+    uint8_t* dst = frame->data.data();
+    for (int y = 0; y < frame->height; y++) {
+        const uint8_t* src = image->data[0] + y * linesize;
+        if (frame->channels == ch) {
+            memcpy(dst, src, frame->width * ch);
+            dst += frame->width * ch;
+        } else {
+            for (int x = 0; x < frame->width; x++, src += 4, dst += 3) {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+            }
+        }
+    }
+    return frame;
+}
+#pragma endregion
+
+#pragma region VideoFrameCache
+VideoFrameCache& VideoFrameCache::GetDefaultCache()
+{
+    static VideoFrameCache cache;
+    return cache;
+}
+
+std::shared_ptr<VideoClip> VideoFrameCache::Open(const std::string& filename, int width, int height, bool keepAspectRatio,
+                                                 bool nativeResolution, bool alpha, int decodeAheadMS)
+{
+    std::string key = filename + "|" + (nativeResolution ? std::string("native") : std::to_string(width) + "x" + std::to_string(height)) +
+                      (keepAspectRatio ? "|aspect" : "") + (alpha ? "|alpha" : "");
+
+    // declared before the locks so if we hold the last reference the clip is not closed while the lock is held
+    std::shared_ptr<VideoClip> existing;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        auto it = _clips.find(key);
+        if (it != _clips.end()) {
+            existing = it->second.lock();
+        }
+    }
+    if (existing != nullptr) {
+        if (existing->_decodeAheadMS < decodeAheadMS) {
+            existing->_decodeAheadMS = decodeAheadMS;
+        }
+        return existing;
+    }
+
+    // opening the video can take a while so it is done without the lock
+    std::shared_ptr<VideoClip> clip(new VideoClip(this, filename, width, height, keepAspectRatio, nativeResolution, alpha, decodeAheadMS));
+
+    std::unique_lock<std::mutex> lock(_lock);
+    for (auto it = _clips.begin(); it != _clips.end();) {
+        if (it->second.expired()) {
+            it = _clips.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto& slot = _clips[key];
+    existing = slot.lock();
+    if (existing != nullptr) {
+        // someone else opened it while we were
+        lock.unlock();
+        return existing;
+    }
+    slot = clip;
+    return clip;
+}
+
+void VideoFrameCache::SetMaxBytes(size_t maxBytes)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    _maxBytes = maxBytes;
+    Trim();
+}
+
+size_t VideoFrameCache::GetBytes()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    return _bytes;
+}
+
+void VideoFrameCache::Add(VideoClip* clip, long key, const std::shared_ptr<const VideoFrame>& frame)
+{
+    _lru.push_front({ clip, key });
+    _lruIndex[{ clip, key }] = _lru.begin();
+    _bytes += frame->GetBytes();
+    Trim();
+}
+
+void VideoFrameCache::Touch(VideoClip* clip, long key)
+{
+    auto it = _lruIndex.find({ clip, key });
+    if (it != _lruIndex.end()) {
+        _lru.splice(_lru.begin(), _lru, it->second);
+    }
+}
+
+void VideoFrameCache::Remove(VideoClip* clip)
+{
+    for (const auto& it : clip->_frames) {
+        auto i = _lruIndex.find({ clip, it.first });
+        if (i != _lruIndex.end()) {
+            _lru.erase(i->second);
+            _lruIndex.erase(i);
+        }
+        _bytes -= it.second->GetBytes();
+    }
+    clip->_frames.clear();
+}
+
+void VideoFrameCache::Trim()
+{
+    auto it = _lru.end();
+    while (_bytes > _maxBytes && it != _lru.begin()) {
+        --it;
+        VideoClip* clip = it->clip;
+        long key = it->key;
+
+        // someone is waiting on this one and it would be decoded again straight away
+        if (clip->_waiting.find(key) != clip->_waiting.end()) continue;
+
+        auto f = clip->_frames.find(key);
+        if (f != clip->_frames.end()) {
+            _bytes -= f->second->GetBytes();
+            clip->_frames.erase(f);
+        }
+        _lruIndex.erase({ clip, key });
+        it = _lru.erase(it);
+    }
+}
+#pragma endregion
@@ -0,0 +1,153 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+class VideoReader;
+class VideoFrameCache;
+
+// A decoded frame with its rows tightly packed in the order VideoReader returns them
+struct VideoFrame
+{
+    int width = 0;
+    int height = 0;
+    int channels = 3; // 3 is RGB, 4 is RGBA ... frames without any transparency are kept as RGB
+    std::vector<uint8_t> data;
+
+    size_t GetBytes() const { return data.size(); }
+};
+
+/**
+ * One video file decoded at one size.
+ *
+ * Frames are decoded on a thread of the clip's own and kept in the shared VideoFrameCache keyed
+ * by the video frame they show, so every user of the clip asking for a time within the same video
+ * frame gets the same decoded frame.  After each request the thread keeps decoding ahead of it.
+ */
+class VideoClip
+{
+public:
+    ~VideoClip();
+
+    bool IsValid() const { return _valid; }
+    int GetLengthMS() const { return _lengthMS; }
+    int GetWidth() const { return _width; }
+    int GetHeight() const { return _height; }
+    const std::string& GetFilename() const { return _filename; }
+
+    // returns null past the end of the video or if the frame could not be decoded.
+    // waits up to waitMS for the frame to be decoded, a negative wait waits for as long as it takes
+    std::shared_ptr<const VideoFrame> GetFrame(long ms, int waitMS = -1);
+
+    // true if ms is past the last frame of the video, either by its length or because the reader
+    // ran out of frames there
+    bool IsPastEnd(long ms);
+
+    VideoClip(const VideoClip&) = delete;
+    VideoClip& operator=(const VideoClip&) = delete;
+
+private:
+    friend class VideoFrameCache;
+
+    VideoClip(VideoFrameCache* cache, const std::string& filename, int width, int height, bool keepAspectRatio,
+              bool nativeResolution, bool alpha, int decodeAheadMS);
+    void Run();
+    long GetKey(long ms) const { return _frameMS > 0 ? ms / _frameMS : ms; }
+    long GetAheadFrames() const;
+    std::shared_ptr<VideoFrame> Decode(long key);
+
+    VideoFrameCache* _cache = nullptr;
+    std::string _filename;
+    bool _valid = false;
+    int _lengthMS = 0;
+    int _width = 0;
+    int _height = 0;
+    int _frameMS = 0;
+    int _pixelChannels = 3;
+    std::atomic_int _decodeAheadMS;
+
+    // only used on the decoding thread once the clip is open
+    VideoReader* _reader = nullptr;
+
+    // guarded by the cache's lock
+    std::map<long, std::shared_ptr<const VideoFrame>> _frames;
+    std::set<long> _empty;       // frames past the end of the video
+    std::set<long> _failed;      // frames that failed to decode, retried once nobody is waiting on them
+    std::list<long> _requests;   // frames callers are waiting on, oldest first
+    std::map<long, int> _waiting; // how many callers are waiting on each frame, these are never dropped
+    long _aheadNext = 0;         // the next frame to decode when nobody is waiting
+    long _aheadEnd = 0;
+    bool _stop = false;
+    std::condition_variable _signal;  // wakes the decoding thread
+    std::condition_variable _decoded; // wakes callers waiting for a frame
+    std::thread _thread;
+
+    uint32_t _hits = 0;
+    uint32_t _misses = 0;
+    uint32_t _decodedCount = 0;
+};
+
+/**
+ * Decoded video frames shared between everything that plays video.
+ *
+ * Clips are shared by file, size and format so effects on several models playing the same video
+ * at the same size decode it once.  The frames of all clips count towards one memory limit and
+ * the least recently used are dropped first.
+ */
+class VideoFrameCache
+{
+public:
+    static VideoFrameCache& GetDefaultCache();
+
+    VideoFrameCache() {}
+    ~VideoFrameCache() {}
+
+    // decodeAheadMS is how much video to decode past the last frame asked for
+    std::shared_ptr<VideoClip> Open(const std::string& filename, int width, int height, bool keepAspectRatio,
+                                    bool nativeResolution = false, bool alpha = false, int decodeAheadMS = 2000);
+
+    void SetMaxBytes(size_t maxBytes);
+    size_t GetMaxBytes() const { return _maxBytes; }
+    size_t GetBytes();
+
+private:
+    friend class VideoClip;
+
+    struct Entry
+    {
+        VideoClip* clip;
+        long key;
+    };
+
+    // all need the lock held
+    void Add(VideoClip* clip, long key, const std::shared_ptr<const VideoFrame>& frame);
+    void Touch(VideoClip* clip, long key);
+    void Remove(VideoClip* clip);
+    void Trim();
+
+    std::mutex _lock;
+    std::map<std::string, std::weak_ptr<VideoClip>> _clips;
+    std::list<Entry> _lru; // most recently used first
+    std::map<std::pair<VideoClip*, long>, std::list<Entry>::iterator> _lruIndex;
+    size_t _bytes = 0;
+    std::atomic<size_t> _maxBytes { 512 * 1024 * 1024 };
+};
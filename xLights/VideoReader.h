@@ -42,6 +42,7 @@ public:
     int GetPos();
     std::string GetFilename() const { return _filename; }
     int GetPixelChannels() const { return _wantAlpha ? 4 : 3; }
+    int GetFrameMS() const { return _frameMS; }
     static void SetHardwareAcceleratedVideo(bool accel);
     static bool IsHardwareAcceleratedVideo() { return HW_ACCELERATION_ENABLED; }
     static void InitHWAcceleration();
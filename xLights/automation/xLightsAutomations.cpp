@@ -28,6 +28,8 @@
 #include "../outputs/E131Output.h"
 #include "../../xSchedule/wxHTTPServer/wxhttpserver.h"
 #include "../sequencer/MainSequencer.h"
+#include "../effects/ShaderEffect.h"
+#include "../RenderProfiler.h"
 #include <wx/uri.h>
 
 #include "LuaRunner.h"
@@ -242,10 +244,23 @@ bool xLightsFrame::ProcessAutomation(std::vector<std::string> &paths,
             _outputModelManager.AddImmediateWork(OutputModelManager::WORK_RELOAD_MODEL_FROM_XML, "Automation::renderAll");
             _outputModelManager.AddImmediateWork(OutputModelManager::WORK_MODELS_CHANGE_REQUIRING_RERENDER, "Automation::renderAll");
         }
+        auto bgShaders = ShaderEffect::IsBackgroundRender();
+        if (params["shadersOnBackgroundThreads"] != "") {
+            ShaderEffect::SetBackgroundRender(ReadBool(params["shadersOnBackgroundThreads"]));
+        }
+        bool profile = ReadBool(params["profile"]);
+        if (profile) {
+            RenderProfiler::GetDefaultProfiler().Reset();
+            RenderProfiler::GetDefaultProfiler().SetEnabled(true);
+        }
         RenderAll();
         while (mRendering) {
             wxYield();
         }
+        if (profile) {
+            RenderProfiler::GetDefaultProfiler().SetEnabled(false);
+        }
+        ShaderEffect::SetBackgroundRender(bgShaders);
         if (ld != _lowDefinitionRender) {
             _lowDefinitionRender = ld;
             _outputModelManager.AddImmediateWork(OutputModelManager::WORK_RELOAD_MODEL_FROM_XML, "Automation::renderAll");
@@ -278,6 +293,17 @@ bool xLightsFrame::ProcessAutomation(std::vector<std::string> &paths,
         auto oldPrompt = _promptBatchRenderIssues;
         _promptBatchRenderIssues = ReadBool(params["promptIssues"]);
 
+        auto bgShaders = ShaderEffect::IsBackgroundRender();
+        if (params["shadersOnBackgroundThreads"] != "") {
+            ShaderEffect::SetBackgroundRender(ReadBool(params["shadersOnBackgroundThreads"]));
+        }
+
+        bool profile = ReadBool(params["profile"]);
+        if (profile) {
+            RenderProfiler::GetDefaultProfiler().Reset();
+            RenderProfiler::GetDefaultProfiler().SetEnabled(true);
+        }
+
         _renderMode = true;
         _saveLowDefinitionRender = _lowDefinitionRender;
         OpenRenderAndSaveSequences(files, false);
@@ -286,6 +312,10 @@ bool xLightsFrame::ProcessAutomation(std::vector<std::string> &paths,
             wxYield();
         }
 
+        if (profile) {
+            RenderProfiler::GetDefaultProfiler().SetEnabled(false);
+        }
+        ShaderEffect::SetBackgroundRender(bgShaders);
         _promptBatchRenderIssues = oldPrompt;
         if (ld != _lowDefinitionRender) {
             _lowDefinitionRender = ld;
@@ -293,6 +323,16 @@ bool xLightsFrame::ProcessAutomation(std::vector<std::string> &paths,
             _outputModelManager.AddImmediateWork(OutputModelManager::WORK_MODELS_CHANGE_REQUIRING_RERENDER, "Automation::batchRender");
         }
         return sendResponse("Sequence batch rendered.", "msg", 200, false);
+    } else if (cmd == "getRenderProfile") {
+        auto profile = RenderProfiler::GetDefaultProfiler().GetProfile();
+        if (profile.IsEmpty()) {
+            return sendResponse("No render has been profiled.", "msg", 503, false);
+        }
+        int top = 0;
+        if (!params["top"].empty()) {
+            top = std::stoi(params["top"]);
+        }
+        return sendResponse(profile.GetJSON(top), "profile", 200, true);
     } else if (cmd == "uploadController") {
         auto ip = params["ip"];
         Controller* c = _outputManager.GetControllerWithIP(ip);
@@ -28,6 +28,11 @@ public:
     {
         return true;
     }
+    // the frames depend on the model's channels, not just the buffer
+    virtual bool SupportsRenderCache(const SettingsMap& settings) const override
+    {
+        return false;
+    }
     virtual std::list<std::string> CheckEffectSettings(const SettingsMap& settings, AudioManager* media, Model* model, Effect* eff, bool renderCache) override;
 
 protected:
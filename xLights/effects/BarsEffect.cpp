@@ -14,6 +14,7 @@
 #include "../RenderBuffer.h"
 #include "../UtilClasses.h"
 #include "../sequencer/Effect.h"
+#include "EffectParameters.h"
 
 #include "../../include/bars-16.xpm"
 #include "../../include/bars-24.xpm"
@@ -120,17 +121,38 @@ void BarsEffect::GetSpatialColor(xlColor& color, size_t colorIndex, float x, flo
     }
 }
 
+enum {
+    BARS_BARCOUNT,
+    BARS_CYCLES,
+    BARS_CENTER,
+    BARS_DIRECTION,
+    BARS_HIGHLIGHT,
+    BARS_3D,
+    BARS_GRADIENT
+};
+
 void BarsEffect::Render(Effect* effect, const SettingsMap& SettingsMap, RenderBuffer& buffer)
 {
+    EffectParameters& params = EffectParameters::Get(buffer);
+    if (params.NeedsCompile()) {
+        params.AddInt(BARS_BARCOUNT, "Bars_BarCount", 1, SettingsMap, BARCOUNT_MIN, BARCOUNT_MAX);
+        params.AddDouble(BARS_CYCLES, "Bars_Cycles", 1.0, SettingsMap, BARCYCLES_MIN, BARCYCLES_MAX, 10);
+        params.AddDouble(BARS_CENTER, "Bars_Center", 0, SettingsMap, BARCENTER_MIN, BARCENTER_MAX);
+        params.AddValue(BARS_DIRECTION, GetDirection(SettingsMap["CHOICE_Bars_Direction"]));
+        params.AddBool(BARS_HIGHLIGHT, "CHECKBOX_Bars_Highlight", false, SettingsMap);
+        params.AddBool(BARS_3D, "CHECKBOX_Bars_3D", false, SettingsMap);
+        params.AddBool(BARS_GRADIENT, "CHECKBOX_Bars_Gradient", false, SettingsMap);
+    }
+
     float offset = buffer.GetEffectTimeIntervalPosition();
-    int paletteRepeat = GetValueCurveInt("Bars_BarCount", 1, SettingsMap, offset, BARCOUNT_MIN, BARCOUNT_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    double cycles = GetValueCurveDouble("Bars_Cycles", 1.0, SettingsMap, offset, BARCYCLES_MIN, BARCYCLES_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 10);
+    int paletteRepeat = params.GetInt(BARS_BARCOUNT, offset);
+    double cycles = params.GetDouble(BARS_CYCLES, offset);
     double position = buffer.GetEffectTimeIntervalPosition(cycles);
-    double center = GetValueCurveDouble("Bars_Center", 0, SettingsMap, position, BARCENTER_MIN, BARCENTER_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int direction = GetDirection(SettingsMap["CHOICE_Bars_Direction"]);
-    bool highlight = SettingsMap.GetBool("CHECKBOX_Bars_Highlight", false);
-    bool show3D = SettingsMap.GetBool("CHECKBOX_Bars_3D", false);
-    bool gradient = SettingsMap.GetBool("CHECKBOX_Bars_Gradient", false);
+    double center = params.GetDouble(BARS_CENTER, position);
+    int direction = params.GetInt(BARS_DIRECTION, offset);
+    bool highlight = params.GetBool(BARS_HIGHLIGHT);
+    bool show3D = params.GetBool(BARS_3D);
+    bool gradient = params.GetBool(BARS_GRADIENT);
 
     size_t colorcnt = buffer.GetColorCount();
     if (colorcnt == 0) {
@@ -188,40 +210,45 @@ void BarsEffect::Render(Effect* effect, const SettingsMap& SettingsMap, RenderBu
                 }
                 color = hsv;
             }
+
+            // a bar only varies across the row if its palette entry is spatial
+            auto fillRow = [&](int row, float spatialY) {
+                if (row < 0 || row >= buffer.BufferHt) {
+                    return;
+                }
+                if (!buffer.palette.IsSpatial(colorIdx)) {
+                    buffer.FillRow(row, 0, buffer.BufferWi - 1, color);
+                    return;
+                }
+                RenderBuffer::Row pixels(buffer, row);
+                for (int x = 0; x < buffer.BufferWi; ++x) {
+                    xlColor c = color;
+                    GetSpatialColor(c, colorIdx, (float)x / (float)buffer.BufferWi, spatialY, buffer, gradient, highlight, show3D, barHt, n, pct, color2);
+                    pixels[x] = c;
+                }
+            };
             switch (direction) {
             case 1:
                 // down
-                for (int x = 0; x < buffer.BufferWi; ++x) {
-                    GetSpatialColor(color, colorIdx, (float)x / (float)buffer.BufferWi, (float)(n % barHt) / (float)barHt, buffer, gradient, highlight, show3D, barHt, n, pct, color2);
-                    buffer.SetPixel(x, y, color);
-                }
+                fillRow(y, (float)(n % barHt) / (float)barHt);
                 break;
             case 2:
                 // expand
                 if (y <= newCenter) {
-                    for (int x = 0; x < buffer.BufferWi; ++x) {
-                        GetSpatialColor(color, colorIdx, (float)x / (float)buffer.BufferWi, (float)(n % barHt) / (float)barHt, buffer, gradient, highlight, show3D, barHt, n, pct, color2);
-                        buffer.SetPixel(x, y, color);
-                        buffer.SetPixel(x, newCenter + (newCenter - y), color);
-                    }
+                    fillRow(y, (float)(n % barHt) / (float)barHt);
+                    fillRow(newCenter + (newCenter - y), (float)(n % barHt) / (float)barHt);
                 }
                 break;
             case 3:
                 // compress
                 if (y >= newCenter) {
-                    for (int x = 0; x < buffer.BufferWi; ++x) {
-                        GetSpatialColor(color, colorIdx, (float)x / (float)buffer.BufferWi, (float)(n % barHt) / (float)barHt, buffer, gradient, highlight, show3D, barHt, n, pct, color2);
-                        buffer.SetPixel(x, y, color);
-                        buffer.SetPixel(x, newCenter + (newCenter - y), color);
-                    }
+                    fillRow(y, (float)(n % barHt) / (float)barHt);
+                    fillRow(newCenter + (newCenter - y), (float)(n % barHt) / (float)barHt);
                 }
                 break;
             default:
                 // up
-                for (int x = 0; x < buffer.BufferWi; ++x) {
-                    GetSpatialColor(color, colorIdx, (float)x / (float)buffer.BufferWi, 1.0 - (float)(n % barHt) / (float)barHt, buffer, gradient, highlight, show3D, barHt, n, pct, color2);
-                    buffer.SetPixel(x, buffer.BufferHt - y - 1, color);
-                }
+                fillRow(buffer.BufferHt - y - 1, 1.0 - (float)(n % barHt) / (float)barHt);
                 break;
             }
         }
@@ -239,6 +266,9 @@ void BarsEffect::Render(Effect* effect, const SettingsMap& SettingsMap, RenderBu
         if (BlockWi < 1)
             BlockWi = 1;
 
+        // Custom Horz bars are columns, remember which bar ends up in each
+        // column and then write the buffer a row at a time
+        std::vector<BarColumn> columns(direction == 12 ? width : 0);
         for (int x = -2 * width; x < 2 * width; ++x) {
             int n = width + x;
             int colorIdx = (n % BlockWi) / BarWi;
@@ -266,15 +296,25 @@ void BarsEffect::Render(Effect* effect, const SettingsMap& SettingsMap, RenderBu
             }
 
             int position_x = width - x - 1 + NewCenter;
-            for (int y = 0; y < height; ++y) {
-                GetSpatialColor(color, colorIdx, 1.0 - pct, (float)y / (float)height, buffer, gradient, highlight, show3D, BarWi, n, pct, color2);
-                if (direction == 12) {
-                    buffer.SetPixel(position_x, y, color);
-                } else {
-                    buffer.SetPixel(y, position_x, color);
+            if (position_x < 0 || position_x >= width) {
+                continue;
+            }
+            if (direction == 12) {
+                columns[position_x].Set(color, colorIdx, color2, n, pct, 1.0 - pct);
+            } else if (!buffer.palette.IsSpatial(colorIdx)) {
+                buffer.FillRow(position_x, 0, buffer.BufferWi - 1, color);
+            } else {
+                RenderBuffer::Row pixels(buffer, position_x);
+                for (int y = 0; y < height; ++y) {
+                    xlColor c = color;
+                    GetSpatialColor(c, colorIdx, 1.0 - pct, (float)y / (float)height, buffer, gradient, highlight, show3D, BarWi, n, pct, color2);
+                    pixels[y] = c;
                 }
             }
         }
+        if (direction == 12) {
+            FillColumns(columns, buffer, gradient, highlight, show3D, BarWi);
+        }
     } else {
         int barWi = (int)std::ceil((float)buffer.BufferWi / (float)barCount);
         if (barWi < 1)
@@ -289,6 +329,7 @@ void BarsEffect::Render(Effect* effect, const SettingsMap& SettingsMap, RenderBu
         }
 
         direction = direction > 9 ? direction - 6 : direction;
+        std::vector<BarColumn> columns(buffer.BufferWi);
         for (int x = -2 * buffer.BufferWi; x < 2 * buffer.BufferWi; ++x) {
             int n = buffer.BufferWi + x + f_offset;
             int colorIdx = (n % blockWi) / barWi;
@@ -314,42 +355,58 @@ void BarsEffect::Render(Effect* effect, const SettingsMap& SettingsMap, RenderBu
                     hsv.value *= double(barWi - n % barWi - 1) / barWi;
                 color = hsv;
             }
+            auto setColumn = [&](int col, double spatialX) {
+                if (col >= 0 && col < buffer.BufferWi) {
+                    columns[col].Set(color, colorIdx, color2, n, pct, spatialX);
+                }
+            };
             switch (direction) {
             case 5:
                 // right
-                for (int y = 0; y < buffer.BufferHt; ++y) {
-                    GetSpatialColor(color, colorIdx, 1.0 - pct, (double)y / (double)buffer.BufferHt, buffer, gradient, highlight, show3D, barWi, n, pct, color2);
-                    buffer.SetPixel(buffer.BufferWi - x - 1, y, color);
-                }
+                setColumn(buffer.BufferWi - x - 1, 1.0 - pct);
                 break;
             case 6:
                 // H-expand
                 if (x <= newCenter) {
-                    for (int y = 0; y < buffer.BufferHt; ++y) {
-                        GetSpatialColor(color, colorIdx, pct, (double)y / (double)buffer.BufferHt, buffer, gradient, highlight, show3D, barWi, n, pct, color2);
-                        buffer.SetPixel(x, y, color);
-                        buffer.SetPixel(newCenter + (newCenter - x), y, color);
-                    }
+                    setColumn(x, pct);
+                    setColumn(newCenter + (newCenter - x), pct);
                 }
                 break;
             case 7:
                 // H-compress
                 if (x >= newCenter) {
-                    for (int y = 0; y < buffer.BufferHt; ++y) {
-                        GetSpatialColor(color, colorIdx, pct, (double)y / (double)buffer.BufferHt, buffer, gradient, highlight, show3D, barWi, n, pct, color2);
-                        buffer.SetPixel(x, y, color);
-                        buffer.SetPixel(newCenter + (newCenter - x), y, color);
-                    }
+                    setColumn(x, pct);
+                    setColumn(newCenter + (newCenter - x), pct);
                 }
                 break;
             default:
                 // left
-                for (int y = 0; y < buffer.BufferHt; ++y) {
-                    GetSpatialColor(color, colorIdx, pct, (double)y / (double)buffer.BufferHt, buffer, gradient, highlight, show3D, barWi, n, pct, color2);
-                    buffer.SetPixel(x, y, color);
-                }
+                setColumn(x, pct);
                 break;
             }
         }
+        FillColumns(columns, buffer, gradient, highlight, show3D, barWi);
+    }
+}
+
+void BarsEffect::FillColumns(const std::vector<BarColumn>& columns, RenderBuffer& buffer, bool gradient, bool highlight, bool show3d, int barWi)
+{
+    bool spatial = false;
+    for (const auto& c : columns) {
+        spatial |= c.set && buffer.palette.IsSpatial(c.colorIdx);
+    }
+    for (int y = 0; y < buffer.BufferHt; ++y) {
+        RenderBuffer::Row pixels(buffer, y);
+        for (int x = 0; x < (int)columns.size() && x < buffer.BufferWi; ++x) {
+            const BarColumn& col = columns[x];
+            if (!col.set) {
+                continue;
+            }
+            xlColor c = col.color;
+            if (spatial) {
+                GetSpatialColor(c, col.colorIdx, col.spatialX, (double)y / (double)buffer.BufferHt, buffer, gradient, highlight, show3d, barWi, col.n, col.pct, col.color2);
+            }
+            pixels[x] = c;
+        }
     }
 }
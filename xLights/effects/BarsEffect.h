@@ -10,6 +10,8 @@
  * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
  **************************************************************/
 
+#include <vector>
+
 #include "RenderableEffect.h"
 
 #define BARCOUNT_MIN 1
@@ -63,4 +65,27 @@ public:
 protected:
     virtual xlEffectPanel* CreatePanel(wxWindow* parent) override;
     void GetSpatialColor(xlColor& color, size_t colorIndex, float x, float y, RenderBuffer& buffer, bool gradient, bool highlight, bool show3d, int BarHt, int n, float pct, int color2Index);
+
+    // the bar that ends up in a column for the horizontally moving directions
+    struct BarColumn {
+        bool set = false;
+        xlColor color;
+        int colorIdx = 0;
+        int color2 = 0;
+        int n = 0;
+        double pct = 0.0;
+        double spatialX = 0.0;
+
+        void Set(const xlColor& c, int idx, int idx2, int nn, double p, double sx)
+        {
+            set = true;
+            color = c;
+            colorIdx = idx;
+            color2 = idx2;
+            n = nn;
+            pct = p;
+            spatialX = sx;
+        }
+    };
+    void FillColumns(const std::vector<BarColumn>& columns, RenderBuffer& buffer, bool gradient, bool highlight, bool show3d, int barWi);
 };
@@ -99,16 +99,54 @@ void ButterflyEffect::Render(Effect *effect, const SettingsMap &SettingsMap, Ren
     const int xc=buffer.BufferWi/2;
     const int yc=buffer.BufferHt/2;
     int block = buffer.BufferHt * buffer.BufferWi > 100 ? 1 : -1;
-    parallel_for(0, buffer.BufferWi, [&buffer, Style, &xc, &yc, &offset, frame, maxframe, Chunks, colorcnt, Skip, ColorScheme, butterFlySpeed](int x) {
+    // the plasma styles are a function of x and y only
+    auto plasma = [&buffer, butterFlySpeed, Style](int x, int y) {
+        double rx,ry,cx,cy,v,time;
+        int state = (buffer.curPeriod - buffer.curEffStartPer); // frames 0 to N
+        double Speed_plasma = (Style == 10) ? (101-butterFlySpeed)*3 : (101-butterFlySpeed)*5;
+        time = (state+1.0)/Speed_plasma;
+        
+        v=0;
+        
+        rx = ((float)x/buffer.BufferWi) -0.5;
+        ry = ((float)y/buffer.BufferHt) -0.5;
+        
+        
+        
+        // 1st equation
+        v=buffer.sin(rx*10+time);
+        
+        //  second equation
+        v+=buffer.sin(10*(rx*buffer.sin(time/2)+ry*buffer.cos(time/3))+time);
+        
+        //  third equation
+        cx=rx+.5*buffer.sin(time/5);
+        cy=ry+.5*buffer.cos(time/3);
+        v+=buffer.sin ( sqrt(100*((cx*cx)+(cy*cy))+1+time));
+        
+        
+        //    vec2 c = v_coords * u_k - u_k/2.0;
+        v += buffer.sin(rx+time);
+        v += buffer.sin((ry+time)/2.0);
+        v += buffer.sin((rx+ry+time)/2.0);
+        //   c += u_k/2.0 * vec2(sin(u_time/3.0), cos(u_time/2.0));
+        v += buffer.sin(sqrt(rx*rx+ry*ry+1.0)+time);
+        v = v/2.0;
+        // vec3 col = vec3(1, sin(PI*v), cos(PI*v));
+        //   gl_FragColor = vec4(col*.5 + .5, 1);
+        return v;
+    };
+    parallel_for(0, buffer.BufferHt, [&buffer, &plasma, Style, &xc, &yc, &offset, frame, maxframe, Chunks, colorcnt, Skip, ColorScheme](int y) {
         double  fractpart, intpart;
         double h=0.0,hue1,hue2;
         xlColor color;
         HSVValue hsv;
-        int y, d, x0, y0;
+        int x, d, x0, y0;
         double n,x1,y1,f;
-        double rx,ry,cx,cy,v,time,multiplier;
+        double v,multiplier;
+        RenderBuffer::Row row(buffer, y);
 
-        for (y=0; y<buffer.BufferHt; y++)
+        for (x=0; x<buffer.BufferWi; x++)
         {
             switch (Style)
             {
@@ -211,12 +249,12 @@ void ButterflyEffect::Render(Effect *effect, const SettingsMap &SettingsMap, Ren
                     if (ColorScheme == 0)
                     {
                         hsv.hue=h;
-                        buffer.SetPixel(x,y,hsv);
+                        row[x] = hsv;
                     }
                     else
                     {
                         buffer.GetMultiColorBlend(h,false,color);
-                        buffer.SetPixel(x,y,color);
+                        row[x] = color;
                     }
                 }
             }
@@ -224,38 +262,13 @@ void ButterflyEffect::Render(Effect *effect, const SettingsMap &SettingsMap, Ren
             {
                 // reference: http://www.bidouille.org/prog/plasma
                 
-                int state = (buffer.curPeriod - buffer.curEffStartPer); // frames 0 to N
-                double Speed_plasma = (Style == 10) ? (101-butterFlySpeed)*3 : (101-butterFlySpeed)*5;
-                time = (state+1.0)/Speed_plasma;
-                
-                v=0;
-                
-                rx = ((float)x/buffer.BufferWi) -0.5;
-                ry = ((float)y/buffer.BufferHt) -0.5;
-                
-                
-                
-                // 1st equation
-                v=buffer.sin(rx*10+time);
-                
-                //  second equation
-                v+=buffer.sin(10*(rx*buffer.sin(time/2)+ry*buffer.cos(time/3))+time);
-                
-                //  third equation
-                cx=rx+.5*buffer.sin(time/5);
-                cy=ry+.5*buffer.cos(time/3);
-                v+=buffer.sin ( sqrt(100*((cx*cx)+(cy*cy))+1+time));
-                
-                
-                //    vec2 c = v_coords * u_k - u_k/2.0;
-                v += buffer.sin(rx+time);
-                v += buffer.sin((ry+time)/2.0);
-                v += buffer.sin((rx+ry+time)/2.0);
-                //   c += u_k/2.0 * vec2(sin(u_time/3.0), cos(u_time/2.0));
-                v += buffer.sin(sqrt(rx*rx+ry*ry+1.0)+time);
-                v = v/2.0;
-                // vec3 col = vec3(1, sin(PI*v), cos(PI*v));
-                //   gl_FragColor = vec4(col*.5 + .5, 1);
+                v = plasma(x, y);
+                if (Style == 10 && colorcnt >= 2)
+                {
+                    // style 10 blends using the hue left by the pixel above, rows are
+                    // rendered in parallel so work that out again
+                    h = y > 0 ? buffer.sin(plasma(x, y - 1)*Chunks*pi+2*pi/3)+1*0.5 : 0.0;
+                }
                 
                 buffer.GetMultiColorBlend(h,false,color);
                 //color.red=color.green=color.blue=h*255;
@@ -304,7 +317,7 @@ void ButterflyEffect::Render(Effect *effect, const SettingsMap &SettingsMap, Ren
                         break;
                 }
                 
-                buffer.SetPixel(x,y,color);
+                row[x] = color;
             }
         }
     }, block);
@@ -184,7 +184,11 @@ void ColorWashEffect::Render(Effect *effect, const SettingsMap &SettingsMap, Ren
 
         orig = color;
         HSVValue hsvOrig = color.asHSV();
-        xlColor color2 = color;
+
+        // work out the horizontal fade for each column first, then the
+        // rows are either all the same or just need the vertical fade applied
+        std::vector<xlColor> colColors(endX - StartX + 1);
+        std::vector<HSVValue> colHSV(endX - StartX + 1);
         for (int x = StartX; x <= endX; x++)
         {
             HSVValue hsv = hsvOrig;
@@ -211,31 +215,32 @@ void ColorWashEffect::Render(Effect *effect, const SettingsMap &SettingsMap, Ren
             {
                 color.alpha = orig.alpha;
             }
- 
-            color2.alpha = color.alpha;
-            for (y=StartY; y<=endY; y++) {
-                if (VertFade) {
-                    if (reverseFades) {
-                        double mult = std::abs(HalfHt - (y - StartY)) / HalfHt;
-                        if (buffer.allowAlpha) {
-                            color.alpha = (double)color2.alpha * mult;
-                        } else {
-                            HSVValue hsv2 = hsv;
-                            hsv2.value *= mult;
-                            color = hsv2;
-                        }
-                    } else {
-                        double mult = 1.0 - std::abs(HalfHt - (y - StartY)) / HalfHt;
-                        if (buffer.allowAlpha) {
-                            color.alpha = (double)color2.alpha * mult;
-                        } else {
-                            HSVValue hsv2 = hsv;
-                            hsv2.value *= mult;
-                            color = hsv2;
-                        }
-                    }
+            colColors[x - StartX] = color;
+            colHSV[x - StartX] = hsv;
+        }
+
+        for (y=StartY; y<=endY; y++) {
+            RenderBuffer::Row row(buffer, y);
+            if (!VertFade) {
+                std::copy(colColors.begin(), colColors.end(), &row[StartX]);
+                continue;
+            }
+            double mult;
+            if (reverseFades) {
+                mult = std::abs(HalfHt - (y - StartY)) / HalfHt;
+            } else {
+                mult = 1.0 - std::abs(HalfHt - (y - StartY)) / HalfHt;
+            }
+            for (int x = StartX; x <= endX; x++) {
+                color = colColors[x - StartX];
+                if (buffer.allowAlpha) {
+                    color.alpha = (double)colColors[x - StartX].alpha * mult;
+                } else {
+                    HSVValue hsv2 = colHSV[x - StartX];
+                    hsv2.value *= mult;
+                    color = hsv2;
                 }
-                buffer.SetPixel(x, y, color);
+                row[x] = color;
             }
         }
     } else {
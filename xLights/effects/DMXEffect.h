@@ -34,6 +34,11 @@ public:
     {
         return true;
     }
+    // the frames depend on the model's channels, not just the buffer
+    virtual bool SupportsRenderCache(const SettingsMap& settings) const override
+    {
+        return false;
+    }
     void RemapSelectedDMXEffectValues(Effect* effect, const std::vector<std::tuple<int, int, float, int>>& dmxmappings) const;
 
     virtual double GetSettingVCMin(const std::string& name) const override
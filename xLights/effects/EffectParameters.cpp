@@ -0,0 +1,191 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "EffectParameters.h"
+#include "../UtilClasses.h"
+#include "../ValueCurve.h"
+
+EffectParameters::EffectParameters()
+{
+}
+
+EffectParameters::~EffectParameters()
+{
+}
+
+EffectParameters& EffectParameters::Get(RenderBuffer& buffer)
+{
+    EffectParameters* params = (EffectParameters*)buffer.infoCache[CACHE_ID];
+    if (params == nullptr) {
+        params = new EffectParameters();
+        buffer.infoCache[CACHE_ID] = params;
+    }
+    if (params->_generation != buffer.effectGeneration) {
+        params->_params.clear();
+        params->_generation = buffer.effectGeneration;
+    }
+    long startMS = buffer.GetStartTimeMS();
+    long endMS = buffer.GetEndTimeMS();
+    if (startMS != params->_startMS || endMS != params->_endMS) {
+        // the curves may depend on the times so nothing remembered can be used
+        params->_startMS = startMS;
+        params->_endMS = endMS;
+        params->_frames = std::max(0, buffer.curEffEndPer - buffer.curEffStartPer);
+        for (auto& p : params->_params) {
+            if (p.curve != nullptr) {
+                p.values.assign(params->_frames + 1, 0.0f);
+                p.offsets.assign(params->_frames + 1, std::numeric_limits<float>::quiet_NaN());
+            }
+        }
+    }
+    return *params;
+}
+
+EffectParameters::Param& EffectParameters::Add(int idx)
+{
+    if (idx >= (int)_params.size()) {
+        _params.resize(idx + 1);
+    }
+    Param& p = _params[idx];
+    p.value = 0.0;
+    p.text.clear();
+    p.curve.reset();
+    p.values.clear();
+    p.offsets.clear();
+    return p;
+}
+
+void EffectParameters::AddCurve(Param& p, const std::string& name, const SettingsMap& settings, float min, float max, int divisor, bool isInt)
+{
+    const std::string vn = "VALUECURVE_" + name;
+    if (!settings.Contains(vn)) {
+        return;
+    }
+    const std::string& vc = settings.Get(vn, xlEMPTY_STRING);
+    if (vc == xlEMPTY_STRING) {
+        return;
+    }
+    // built the same way as GetValueCurveInt/GetValueCurveDouble so the values are identical
+    std::unique_ptr<ValueCurve> curve;
+    if (isInt) {
+        curve = std::make_unique<ValueCurve>();
+        curve->SetDivisor(divisor);
+        curve->SetLimits(min, max);
+        curve->Deserialise(vc);
+    } else {
+        curve = std::make_unique<ValueCurve>(vc);
+    }
+    if (!curve->IsActive()) {
+        return;
+    }
+    if (!isInt) {
+        curve->SetLimits(min, max);
+        curve->SetDivisor(divisor);
+    }
+    p.divided = !isInt;
+    p.curve = std::move(curve);
+    p.values.assign(_frames + 1, 0.0f);
+    p.offsets.assign(_frames + 1, std::numeric_limits<float>::quiet_NaN());
+}
+
+void EffectParameters::AddDouble(int idx, const std::string& name, double def, const SettingsMap& settings, double min, double max, int divisor)
+{
+    Param& p = Add(idx);
+    AddCurve(p, name, settings, min, max, divisor, false);
+    if (p.curve == nullptr) {
+        p.value = def;
+        const std::string sn = "SLIDER_" + name;
+        const std::string tn = "TEXTCTRL_" + name;
+        if (settings.Contains(sn)) {
+            p.value = settings.GetDouble(sn, def);
+        } else if (settings.Contains(tn)) {
+            p.value = settings.GetDouble(tn, def);
+        }
+    }
+}
+
+void EffectParameters::AddInt(int idx, const std::string& name, int def, const SettingsMap& settings, int min, int max, int divisor)
+{
+    Param& p = Add(idx);
+    AddCurve(p, name, settings, min, max, divisor, true);
+    if (p.curve == nullptr) {
+        p.value = def;
+        const std::string sn = "SLIDER_" + name;
+        const std::string tn = "TEXTCTRL_" + name;
+        if (settings.Contains(sn)) {
+            p.value = settings.GetInt(sn, def);
+        } else if (settings.Contains(tn)) {
+            p.value = settings.GetInt(tn, def);
+        }
+    }
+}
+
+void EffectParameters::AddIntSetting(int idx, const std::string& setting, int def, const SettingsMap& settings)
+{
+    Param& p = Add(idx);
+    p.value = settings.GetInt(setting, def);
+}
+
+void EffectParameters::AddBool(int idx, const std::string& setting, bool def, const SettingsMap& settings)
+{
+    Param& p = Add(idx);
+    p.value = settings.GetBool(setting, def) ? 1.0 : 0.0;
+}
+
+void EffectParameters::AddString(int idx, const std::string& setting, const std::string& def, const SettingsMap& settings)
+{
+    Param& p = Add(idx);
+    p.text = settings.Get(setting, def);
+}
+
+void EffectParameters::AddValue(int idx, double value)
+{
+    Param& p = Add(idx);
+    p.value = value;
+}
+
+float EffectParameters::GetCurveValue(Param& p, float offset)
+{
+    // effects mostly ask for the value at the frame's position within the effect, remember
+    // those by frame, anything else is evaluated from the deserialised curve
+    long k = std::lround(offset * _frames);
+    if (k >= 0 && k < (long)p.values.size()) {
+        if (p.offsets[k] == offset) {
+            return p.values[k];
+        }
+        float v = p.divided ? p.curve->GetOutputValueAtDivided(offset, _startMS, _endMS) : p.curve->GetOutputValueAt(offset, _startMS, _endMS);
+        p.offsets[k] = offset;
+        p.values[k] = v;
+        return v;
+    }
+    return p.divided ? p.curve->GetOutputValueAtDivided(offset, _startMS, _endMS) : p.curve->GetOutputValueAt(offset, _startMS, _endMS);
+}
+
+double EffectParameters::GetDouble(int idx, float offset)
+{
+    Param& p = _params[idx];
+    if (p.curve == nullptr) {
+        return p.value;
+    }
+    return GetCurveValue(p, offset);
+}
+
+int EffectParameters::GetInt(int idx, float offset)
+{
+    Param& p = _params[idx];
+    if (p.curve == nullptr) {
+        return (int)p.value;
+    }
+    return (int)GetCurveValue(p, offset);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../RenderBuffer.h"
+
+class SettingsMap;
+class ValueCurve;
+
+/**
+ * An effect's settings, parsed once when the effect starts rendering.
+ *
+ * GetValueCurveDouble and GetValueCurveInt build the setting names, look them up in the
+ * SettingsMap and deserialise the value curve every time they are called, which for most
+ * effects is several times a frame.  An effect can instead add its parameters to the block
+ * by index when it needs compiling and then read them each frame.  Value curves are kept
+ * deserialised with the limits applied, and the value at each frame position of the effect
+ * is kept in a table so a curve is evaluated at most once per frame position.
+ *
+ * The block is kept in the RenderBuffer's infoCache and is cleared whenever the buffer
+ * starts a new effect or the effect's settings change, see RenderBuffer::effectGeneration.
+ */
+class EffectParameters : public EffectRenderCache
+{
+public:
+    EffectParameters();
+    virtual ~EffectParameters();
+
+    // the block for the effect rendering into buffer, cleared if the effect has changed
+    static EffectParameters& Get(RenderBuffer& buffer);
+
+    // true until the effect's parameters have been added
+    bool NeedsCompile() const { return _params.empty(); }
+
+    // these match GetValueCurveDouble/GetValueCurveInt for SLIDER_/TEXTCTRL_/VALUECURVE_ name
+    void AddDouble(int idx, const std::string& name, double def, const SettingsMap& settings, double min, double max, int divisor = 1);
+    void AddInt(int idx, const std::string& name, int def, const SettingsMap& settings, int min, int max, int divisor = 1);
+    // the setting is looked up as given, including the SLIDER_/CHECKBOX_/CHOICE_ prefix
+    void AddIntSetting(int idx, const std::string& setting, int def, const SettingsMap& settings);
+    void AddBool(int idx, const std::string& setting, bool def, const SettingsMap& settings);
+    void AddString(int idx, const std::string& setting, const std::string& def, const SettingsMap& settings);
+    // something the effect works out from its settings, read back with GetInt/GetDouble
+    void AddValue(int idx, double value);
+
+    double GetDouble(int idx, float offset);
+    int GetInt(int idx, float offset);
+    bool GetBool(int idx) const { return _params[idx].value != 0.0; }
+    const std::string& GetString(int idx) const { return _params[idx].text; }
+
+    // the unique id the blocks are stored under in RenderBuffer::infoCache
+    static const int CACHE_ID = -1;
+
+private:
+    struct Param {
+        double value = 0.0;
+        std::string text;
+        std::unique_ptr<ValueCurve> curve;
+        bool divided = false;
+        // curve values by frame position and the offset each was evaluated at
+        std::vector<float> values;
+        std::vector<float> offsets;
+    };
+
+    Param& Add(int idx);
+    void AddCurve(Param& p, const std::string& name, const SettingsMap& settings, float min, float max, int divisor, bool isInt);
+    float GetCurveValue(Param& p, float offset);
+
+    std::vector<Param> _params;
+    uint32_t _generation = 0;
+    long _startMS = 0;
+    long _endMS = 0;
+    int _frames = 0;
+};
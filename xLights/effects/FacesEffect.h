@@ -27,6 +27,15 @@ public:
     virtual void SetPanelStatus(Model* cls) override;
     virtual void SetDefaultParameters() override;
     virtual void Render(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer) override;
+    virtual bool RenderCacheDependsOnSequence(const SettingsMap& settings) const override
+    {
+        return true;
+    }
+    // the frames depend on the model's face definitions, not just the buffer
+    virtual bool SupportsRenderCache(const SettingsMap& settings) const override
+    {
+        return false;
+    }
     virtual void RenameTimingTrack(std::string oldname, std::string newname, Effect* effect) override;
     virtual std::list<std::string> CheckEffectSettings(const SettingsMap& settings, AudioManager* media, Model* model, Effect* eff, bool renderCache) override;
     virtual bool AppropriateOnNodes() const override
@@ -29,6 +29,10 @@ public:
     virtual ~FireEffect();
     virtual void SetDefaultParameters() override;
     virtual void Render(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer) override;
+    virtual bool RenderCacheDependsOnSequence(const SettingsMap& settings) const override
+    {
+        return true;
+    }
     virtual std::list<std::string> CheckEffectSettings(const SettingsMap& settings, AudioManager* media, Model* model, Effect* eff, bool renderCache) override;
 
     virtual double GetSettingVCMin(const std::string& name) const override
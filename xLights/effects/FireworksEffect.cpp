@@ -359,10 +359,10 @@ void FireworksEffect::Render(Effect *effect, const SettingsMap &SettingsMap, Ren
     if (useMusic)
     {
         if (buffer.GetMedia() != nullptr) {
-            std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr)
+            AudioFrameData const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (pf)
             {
-                f = *pf->cbegin();
+                f = pf.front();
             }
         }
     }
@@ -42,6 +42,10 @@ public:
     virtual void SetDefaultParameters() override;
     virtual void SetPanelStatus(Model* cls) override;
     virtual void Render(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer) override;
+    virtual bool RenderCacheDependsOnSequence(const SettingsMap& settings) const override
+    {
+        return true;
+    }
     virtual std::list<std::string> CheckEffectSettings(const SettingsMap& settings, AudioManager* media, Model* model, Effect* eff, bool renderCache) override;
     virtual bool AppropriateOnNodes() const override
     {
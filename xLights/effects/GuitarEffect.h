@@ -31,6 +31,10 @@ public:
         return false;
     }
     virtual void Render(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer) override;
+    virtual bool RenderCacheDependsOnSequence(const SettingsMap& settings) const override
+    {
+        return true;
+    }
     static std::vector<float> Parse(wxString& l);
     virtual void SetDefaultParameters() override;
     virtual void SetPanelStatus(Model* cls) override;
@@ -183,9 +183,9 @@ void MeteorsEffect::Render(Effect *effect, const SettingsMap &SettingsMap, Rende
     if (SettingsMap.GetBool("CHECKBOX_Meteors_UseMusic", false)) {
         float f = 0.0;
         if (buffer.GetMedia() != nullptr) {
-            std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr) {
-                f = *pf->cbegin();
+            AudioFrameData const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (pf) {
+                f = pf.front();
             }
         }
         Count = (float)Count * f;
@@ -27,6 +27,10 @@ public:
     MusicEffect(int id);
     virtual ~MusicEffect();
     virtual void Render(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer) override;
+    virtual bool RenderCacheDependsOnSequence(const SettingsMap& settings) const override
+    {
+        return true;
+    }
     void Render(RenderBuffer& buffer,
                 int bars, const std::string& type, int sensitivity, bool scale, const std::string& scalenotes, int offsetx, int startnote, int endnote, const std::string& colourtreatment, bool fade, bool logarithmicX);
     virtual void SetDefaultParameters() override;
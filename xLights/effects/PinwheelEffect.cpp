@@ -14,6 +14,7 @@
 #include "../sequencer/Effect.h"
 #include "../RenderBuffer.h"
 #include "../UtilClasses.h"
+#include "EffectParameters.h"
 
 #include "../../include/pinwheel-16.xpm"
 #include "../../include/pinwheel-24.xpm"
@@ -95,8 +96,40 @@ PinwheelEffect::Pinwheel3DType PinwheelEffect::to3dType(const std::string& pinwh
     return PW_3D_NONE;
 }
 
+enum {
+    PWP_STYLE,
+    PWP_ARMS,
+    PWP_TWIST,
+    PWP_THICKNESS,
+    PWP_ROTATION,
+    PWP_3D,
+    PWP_XC,
+    PWP_YC,
+    PWP_ARMSIZE,
+    PWP_SPEED,
+    PWP_OFFSET
+};
+
+static EffectParameters& GetPinwheelParameters(const SettingsMap& SettingsMap, RenderBuffer& buffer) {
+    EffectParameters& params = EffectParameters::Get(buffer);
+    if (params.NeedsCompile()) {
+        params.AddString(PWP_STYLE, "CHOICE_Pinwheel_Style", "", SettingsMap);
+        params.AddIntSetting(PWP_ARMS, "SLIDER_Pinwheel_Arms", 3, SettingsMap);
+        params.AddInt(PWP_TWIST, "Pinwheel_Twist", 0, SettingsMap, PINWHEEL_TWIST_MIN, PINWHEEL_TWIST_MAX);
+        params.AddInt(PWP_THICKNESS, "Pinwheel_Thickness", 0, SettingsMap, PINWHEEL_THICKNESS_MIN, PINWHEEL_THICKNESS_MAX);
+        params.AddBool(PWP_ROTATION, "CHECKBOX_Pinwheel_Rotation", false, SettingsMap);
+        params.AddString(PWP_3D, "CHOICE_Pinwheel_3D", "", SettingsMap);
+        params.AddInt(PWP_XC, "PinwheelXC", 0, SettingsMap, PINWHEEL_X_MIN, PINWHEEL_X_MAX);
+        params.AddInt(PWP_YC, "PinwheelYC", 0, SettingsMap, PINWHEEL_Y_MIN, PINWHEEL_Y_MAX);
+        params.AddInt(PWP_ARMSIZE, "Pinwheel_ArmSize", 100, SettingsMap, PINWHEEL_ARMSIZE_MIN, PINWHEEL_ARMSIZE_MAX);
+        params.AddInt(PWP_SPEED, "Pinwheel_Speed", 10, SettingsMap, PINWHEEL_SPEED_MIN, PINWHEEL_SPEED_MAX);
+        params.AddInt(PWP_OFFSET, "Pinwheel_Offset", 0, SettingsMap, PINWHEEL_OFFSET_MIN, PINWHEEL_OFFSET_MAX);
+    }
+    return params;
+}
+
 void PinwheelEffect::Render(Effect* effect, const SettingsMap& SettingsMap, RenderBuffer& buffer) {
-    const std::string& pinwheel_style = SettingsMap["CHOICE_Pinwheel_Style"];
+    const std::string& pinwheel_style = GetPinwheelParameters(SettingsMap, buffer).GetString(PWP_STYLE);
     if (pinwheel_style == "New Render Method") {
         RenderNewMethod(effect, SettingsMap, buffer);
     } else {
@@ -105,19 +138,20 @@ void PinwheelEffect::Render(Effect* effect, const SettingsMap& SettingsMap, Rend
 }
 void PinwheelEffect::RenderNewMethod(Effect* effect, const SettingsMap& SettingsMap, RenderBuffer& buffer) {
     float oset = buffer.GetEffectTimeIntervalPosition();
+    EffectParameters& params = GetPinwheelParameters(SettingsMap, buffer);
     
-    int pinwheel_arms = SettingsMap.GetInt("SLIDER_Pinwheel_Arms", 3);
+    int pinwheel_arms = params.GetInt(PWP_ARMS, oset);
     PinwheelData data(pinwheel_arms);
     
-    data.pinwheel_twist = GetValueCurveInt("Pinwheel_Twist", 0, SettingsMap, oset, PINWHEEL_TWIST_MIN, PINWHEEL_TWIST_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int pinwheel_thickness = GetValueCurveInt("Pinwheel_Thickness", 0, SettingsMap, oset, PINWHEEL_THICKNESS_MIN, PINWHEEL_THICKNESS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    data.pinwheel_rotation = SettingsMap.GetBool("CHECKBOX_Pinwheel_Rotation");
-    const std::string& pinwheel_3d = SettingsMap["CHOICE_Pinwheel_3D"];
-    data.xc_adj = GetValueCurveInt("PinwheelXC", 0, SettingsMap, oset, PINWHEEL_X_MIN, PINWHEEL_X_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    data.yc_adj = GetValueCurveInt("PinwheelYC", 0, SettingsMap, oset, PINWHEEL_Y_MIN, PINWHEEL_Y_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int pinwheel_armsize = GetValueCurveInt("Pinwheel_ArmSize", 100, SettingsMap, oset, PINWHEEL_ARMSIZE_MIN, PINWHEEL_ARMSIZE_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int pspeed = GetValueCurveInt("Pinwheel_Speed", 10, SettingsMap, oset, PINWHEEL_SPEED_MIN, PINWHEEL_SPEED_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    data.poffset = GetValueCurveInt("Pinwheel_Offset", 0, SettingsMap, oset, PINWHEEL_OFFSET_MIN, PINWHEEL_OFFSET_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
+    data.pinwheel_twist = params.GetInt(PWP_TWIST, oset);
+    int pinwheel_thickness = params.GetInt(PWP_THICKNESS, oset);
+    data.pinwheel_rotation = params.GetBool(PWP_ROTATION);
+    const std::string& pinwheel_3d = params.GetString(PWP_3D);
+    data.xc_adj = params.GetInt(PWP_XC, oset);
+    data.yc_adj = params.GetInt(PWP_YC, oset);
+    int pinwheel_armsize = params.GetInt(PWP_ARMSIZE, oset);
+    int pspeed = params.GetInt(PWP_SPEED, oset);
+    data.poffset = params.GetInt(PWP_OFFSET, oset);
     
     data.pos = (float)((buffer.curPeriod - buffer.curEffStartPer) * pspeed * buffer.frameTimeInMs) / (float)PINWHEEL_SPEED_MAX;
     data.degrees_per_arm = 1;
@@ -252,17 +286,18 @@ void PinwheelEffect::RenderNewArms(RenderBuffer& buffer, PinwheelData &data) {
 }
 void PinwheelEffect::RenderOldMethod(Effect* effect, const SettingsMap& SettingsMap, RenderBuffer& buffer) {
     float oset = buffer.GetEffectTimeIntervalPosition();
+    EffectParameters& params = GetPinwheelParameters(SettingsMap, buffer);
     
-    int pinwheel_arms = SettingsMap.GetInt("SLIDER_Pinwheel_Arms", 3);
-    int pinwheel_twist = GetValueCurveInt("Pinwheel_Twist", 0, SettingsMap, oset, PINWHEEL_TWIST_MIN, PINWHEEL_TWIST_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int pinwheel_thickness = GetValueCurveInt("Pinwheel_Thickness", 0, SettingsMap, oset, PINWHEEL_THICKNESS_MIN, PINWHEEL_THICKNESS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int pinwheel_rotation = SettingsMap.GetBool("CHECKBOX_Pinwheel_Rotation");
-    const std::string& pinwheel_3d = SettingsMap["CHOICE_Pinwheel_3D"];
-    int xc_adj = GetValueCurveInt("PinwheelXC", 0, SettingsMap, oset, PINWHEEL_X_MIN, PINWHEEL_X_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int yc_adj = GetValueCurveInt("PinwheelYC", 0, SettingsMap, oset, PINWHEEL_Y_MIN, PINWHEEL_Y_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int pinwheel_armsize = GetValueCurveInt("Pinwheel_ArmSize", 100, SettingsMap, oset, PINWHEEL_ARMSIZE_MIN, PINWHEEL_ARMSIZE_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int pspeed = GetValueCurveInt("Pinwheel_Speed", 10, SettingsMap, oset, PINWHEEL_SPEED_MIN, PINWHEEL_SPEED_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int poffset = GetValueCurveInt("Pinwheel_Offset", 0, SettingsMap, oset, PINWHEEL_OFFSET_MIN, PINWHEEL_OFFSET_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
+    int pinwheel_arms = params.GetInt(PWP_ARMS, oset);
+    int pinwheel_twist = params.GetInt(PWP_TWIST, oset);
+    int pinwheel_thickness = params.GetInt(PWP_THICKNESS, oset);
+    int pinwheel_rotation = params.GetBool(PWP_ROTATION);
+    const std::string& pinwheel_3d = params.GetString(PWP_3D);
+    int xc_adj = params.GetInt(PWP_XC, oset);
+    int yc_adj = params.GetInt(PWP_YC, oset);
+    int pinwheel_armsize = params.GetInt(PWP_ARMSIZE, oset);
+    int pspeed = params.GetInt(PWP_SPEED, oset);
+    int poffset = params.GetInt(PWP_OFFSET, oset);
     
     double pos = (double)((buffer.curPeriod - buffer.curEffStartPer) * pspeed * buffer.frameTimeInMs) / (double)PINWHEEL_SPEED_MAX;
     int degrees_per_arm = 1;
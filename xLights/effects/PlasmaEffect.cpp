@@ -98,37 +98,49 @@ void PlasmaEffect::Render(Effect *effect, const SettingsMap &SettingsMap, Render
     const double sin_time_2 = buffer.sin(time / 2);
     static const double pi3 = pi / 3.0;
 
-    int block = buffer.BufferHt * buffer.BufferWi > 100 ? 1 : -1;
-    parallel_for(0, buffer.BufferWi, [&] (int x) {
+    // the terms that only depend on x are the same for every row
+    std::vector<double> rxs(buffer.BufferWi);
+    std::vector<double> rx2s(buffer.BufferWi);
+    std::vector<double> cx2s(buffer.BufferWi);
+    std::vector<double> sin_rx_times(buffer.BufferWi);
+    std::vector<double> v1s(buffer.BufferWi);
+    for (int x = 0; x < buffer.BufferWi; x++) {
         double rx = ((float)x / (buffer.BufferWi - 1)); // rx is now in the range 0.0 to 1.0
-        double rx2 = rx * rx;
         double cx = rx + .5*sin_time_5;
-        double cx2 = cx*cx;
-        double sin_rx_time = buffer.sin(rx + time);
+        rxs[x] = rx;
+        rx2s[x] = rx * rx;
+        cx2s[x] = cx*cx;
+        sin_rx_times[x] = buffer.sin(rx + time);
 
         // 1st equation
-        double v1 = buffer.sin(rx * 10 + time);
+        v1s[x] = buffer.sin(rx * 10 + time);
+    }
 
-        for (int y=0; y<buffer.BufferHt; y++)
+    int block = buffer.BufferHt * buffer.BufferWi > 100 ? 1 : -1;
+    parallel_for(0, buffer.BufferHt, [&] (int y) {
+        // reference: http://www.bidouille.org/prog/plasma
+        double ry = ((float)y/(buffer.BufferHt-1)) ;
+        double cy=ry+.5*cos_time_3;
+        double sin_ry_time = buffer.sin ((ry+time)/2.0);
+
+        RenderBuffer::Row row(buffer, y);
+        for (int x = 0; x < buffer.BufferWi; x++)
         {
-            // reference: http://www.bidouille.org/prog/plasma
-
-            double ry = ((float)y/(buffer.BufferHt-1)) ;
-            double v = v1;
+            double rx = rxs[x];
+            double v = v1s[x];
 
             //  second equation
             v+=buffer.sin (10*(rx*sin_time_2+ry*cos_time_3)+time);
 
             //  third equation
-            double cy=ry+.5*cos_time_3;
-            v+=buffer.sin ( sqrt((Style*50)*((cx2)+(cy*cy))+time));
+            v+=buffer.sin ( sqrt((Style*50)*((cx2s[x])+(cy*cy))+time));
 
             //    vec2 c = v_coords * u_k - u_k/2.0;
-            v += sin_rx_time;
-            v += buffer.sin ((ry+time)/2.0);
+            v += sin_rx_times[x];
+            v += sin_ry_time;
             v += buffer.sin ((rx+ry+time)/2.0);
             //   c += u_k/2.0 * vec2(buffer.sin (u_time/3.0), buffer.cos (u_time/2.0));
-            v += buffer.sin (sqrt(rx2+ry*ry)+time);
+            v += buffer.sin (sqrt(rx2s[x]+ry*ry)+time);
             v = v/2.0;
             // vec3 col = vec3(1, buffer.sin (PI*v), buffer.cos (PI*v));
             //   gl_FragColor = vec4(col*.5 + .5, 1);
@@ -164,7 +176,7 @@ void PlasmaEffect::Render(Effect *effect, const SettingsMap &SettingsMap, Render
                     color.red=color.green=color.blue = (buffer.sin(vldpi) + 1) * 128;
                     break;
             }
-            buffer.SetPixel(x,y,color);
+            row[x] = color;
         }
     }, block);
 }
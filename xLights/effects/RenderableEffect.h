@@ -114,6 +114,12 @@ public:
         return true;
     }
     virtual bool SupportsRenderCache(const SettingsMap& settings) const;
+    // true if what is rendered depends on the audio, the timing tracks or other parts of the sequence so
+    // the render cache only reuses the frames in the same sequence
+    virtual bool RenderCacheDependsOnSequence(const SettingsMap& settings) const
+    {
+        return false;
+    }
     virtual void Render(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer) = 0;
     virtual void RenameTimingTrack(std::string oldname, std::string newname, Effect* effect)
     {}
@@ -26,6 +26,15 @@ public:
         return false;
     }
     virtual void Render(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer) override;
+    virtual bool RenderCacheDependsOnSequence(const SettingsMap& settings) const override
+    {
+        return true;
+    }
+    // the frames depend on the model's channels, not just the buffer
+    virtual bool SupportsRenderCache(const SettingsMap& settings) const override
+    {
+        return false;
+    }
     virtual void RenameTimingTrack(std::string oldname, std::string newname, Effect* effect) override;
     virtual void SetPanelStatus(Model* cls) override;
     virtual void SetDefaultParameters() override;
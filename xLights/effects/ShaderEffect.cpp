@@ -26,6 +26,9 @@
 
     #ifdef __WXMSW__
         extern PFNGLACTIVETEXTUREPROC glActiveTexture;
+    #else
+        #include <EGL/egl.h>
+        #include <EGL/eglext.h>
     #endif
     extern PFNGLGENBUFFERSPROC glGenBuffers;
     extern PFNGLBINDBUFFERPROC glBindBuffer;
@@ -81,11 +84,14 @@
 
 #include <log4cpp/Category.hh>
 
+#include <cstring>
 #include <fstream>
 #include <map>
 #include <set>
 #include <mutex>
+#include <queue>
 #include <string>
+#include <thread>
 
 namespace
 {
@@ -547,6 +553,135 @@ private:
 } GL_CONTEXT_POOL;
 #endif /* __WXMSW__*/
 
+#if !defined(__WXOSX__) && !defined(__WXMSW__)
+// Contexts on Mesa's software renderer (llvmpipe) for rendering shaders on the render threads.
+// llvmpipe compiles the shaders to SIMD code with LLVM and rasterises on threads of its own.  It
+// needs no GPU or display so the contexts can be created on any thread, and they all share objects
+// with one context so compiled programs can be handed between them like on OSX.
+class SoftwareGLContextPool {
+public:
+
+    EGLContext GetContext() {
+        static log4cpp::Category& logger_opengl = log4cpp::Category::getInstance(std::string("log_opengl"));
+        std::unique_lock<std::mutex> locker(lock);
+        if (!Initialise()) {
+            return EGL_NO_CONTEXT;
+        }
+        if (!contexts.empty()) {
+            EGLContext ret = contexts.front();
+            contexts.pop();
+            logger_opengl.debug("Shader software context taken from pool 0x%llx", (uint64_t)ret);
+            return ret;
+        }
+        locker.unlock();
+        return Create(sharedContext);
+    }
+    void ReleaseContext(EGLContext ctx) {
+        static log4cpp::Category& logger_opengl = log4cpp::Category::getInstance(std::string("log_opengl"));
+        std::unique_lock<std::mutex> locker(lock);
+        contexts.push(ctx);
+        logger_opengl.debug("Shader software context released 0x%llx", (uint64_t)ctx);
+    }
+
+    bool SetCurrent(EGLContext ctx) {
+        static log4cpp::Category& logger_opengl = log4cpp::Category::getInstance(std::string("log_opengl"));
+        if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+            logger_opengl.error("ShaderEffect unable to give thread %d software context 0x%llx (0x%x).", wxThread::GetCurrentId(), (uint64_t)ctx, eglGetError());
+            return false;
+        }
+        return true;
+    }
+    void UnsetCurrent() {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+private:
+    // called with the lock held
+    bool Initialise() {
+        static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        if (initialised) {
+            return sharedContext != EGL_NO_CONTEXT;
+        }
+        initialised = true;
+
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        auto queryDevices = (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+        auto queryDeviceString = (PFNEGLQUERYDEVICESTRINGEXTPROC)eglGetProcAddress("eglQueryDeviceStringEXT");
+        if (getPlatformDisplay == nullptr) {
+            logger_base.error("ShaderEffect - EGL has no eglGetPlatformDisplayEXT, shaders cannot be rendered in software.");
+            return false;
+        }
+
+        // ask for the software device by name so we never end up on a GPU driver
+        if (queryDevices != nullptr && queryDeviceString != nullptr) {
+            EGLDeviceEXT devices[16];
+            EGLint count = 0;
+            if (queryDevices(16, devices, &count)) {
+                for (int i = 0; i < count && display == EGL_NO_DISPLAY; i++) {
+                    const char* ext = queryDeviceString(devices[i], EGL_EXTENSIONS);
+                    if (ext != nullptr && strstr(ext, "EGL_MESA_device_software") != nullptr) {
+                        display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr);
+                    }
+                }
+            }
+        }
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+        if (display == EGL_NO_DISPLAY) {
+            // older Mesa does not list the software device but falls back to it when there is no GPU
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+#endif
+        EGLint major = 0;
+        EGLint minor = 0;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+            logger_base.error("ShaderEffect - unable to open an EGL display for software rendering (0x%x).", eglGetError());
+            display = EGL_NO_DISPLAY;
+            return false;
+        }
+
+        sharedContext = Create(EGL_NO_CONTEXT);
+        if (sharedContext == EGL_NO_CONTEXT) {
+            return false;
+        }
+        if (SetCurrent(sharedContext)) {
+            // nothing may have loaded the GL functions if no OpenGL window has been opened
+            if (!OpenGLShaders::HasShaderSupport() || !OpenGLShaders::HasFramebufferObjects()) {
+                DrawGLUtils::LoadGLFunctions();
+            }
+            logger_base.info("ShaderEffect - software rendering with EGL %d.%d glVer:  %s  (%s)(%s)", major, minor,
+                             (const char*)glGetString(GL_VERSION), (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VENDOR));
+            UnsetCurrent();
+        }
+        return true;
+    }
+
+    EGLContext Create(EGLContext share) {
+        static log4cpp::Category& logger_opengl = log4cpp::Category::getInstance(std::string("log_opengl"));
+        // the bound API is per thread
+        eglBindAPI(EGL_OPENGL_API);
+        EGLint attrs[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        EGLContext ctx = eglCreateContext(display, EGL_NO_CONFIG_KHR, share, attrs);
+        if (ctx == EGL_NO_CONTEXT) {
+            logger_opengl.error("ShaderEffect Thread %d unable to create software context (0x%x).", wxThread::GetCurrentId(), eglGetError());
+        } else {
+            logger_opengl.debug("ShaderEffect Thread %d created software context 0x%llx.", wxThread::GetCurrentId(), (uint64_t)ctx);
+        }
+        return ctx;
+    }
+
+    std::mutex lock;
+    bool initialised = false;
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext sharedContext = EGL_NO_CONTEXT;
+    std::queue<EGLContext> contexts;
+} SOFTWARE_GL_CONTEXT_POOL;
+#endif
+
 
 class ShaderRenderCache : public EffectRenderCache {
 public:
@@ -655,7 +790,23 @@ public:
             }
         }
 #else
-        if (preview) {
+        if (software) {
+            if (s_eglContext != EGL_NO_CONTEXT) {
+                auto destroy = [this]() {
+                    if (SOFTWARE_GL_CONTEXT_POOL.SetCurrent(s_eglContext)) {
+                        DestroyResources();
+                        SOFTWARE_GL_CONTEXT_POOL.UnsetCurrent();
+                    }
+                };
+                if (wxIsMainThread()) {
+                    // the main thread may have the preview's context current and can't take ours as well
+                    std::thread(destroy).join();
+                } else {
+                    destroy();
+                }
+                SOFTWARE_GL_CONTEXT_POOL.ReleaseContext(s_eglContext);
+            }
+        } else if (preview) {
             unsigned vertexArrayId = s_vertexArrayId;
             unsigned vertexBufferId = s_vertexBufferId;
             unsigned fbId = s_fbId;
@@ -705,8 +856,16 @@ public:
         s_programId = programId;
         s_shaderInfo = si;
         if (_shaderConfig) {
-            s_code = _shaderConfig->GetCode();
+            s_code = GetShaderKey(_shaderConfig->GetCode());
+        }
+    }
+
+    // programs can only be shared between caches whose contexts share objects
+    std::string GetShaderKey(const std::string& code) const {
+        if (software) {
+            return "software:" + code;
         }
+        return code;
     }
 
     ShaderConfig* _shaderConfig = nullptr;
@@ -723,6 +882,7 @@ public:
     int s_rbWidth = 0;
     int s_rbHeight = 0;
     long _timeMS = 0;
+    bool software = false; // rendering on a software context of its own rather than the GPU
 
     void InitialiseShaderConfig(const wxString& filename, SequenceElements* sequenceElements) {
         if (_shaderConfig != nullptr) delete _shaderConfig;
@@ -776,7 +936,8 @@ public:
 #elif defined(__WXMSW__)
     GLContextInfo *glContextInfo = nullptr;
 #else
-    xlGLCanvas *preview;
+    EGLContext s_eglContext = EGL_NO_CONTEXT;
+    xlGLCanvas *preview = nullptr;
 #endif
 };
 std::map<std::string, ShaderRenderCache::ShaderInfo*> ShaderRenderCache::shaderMap;
@@ -796,7 +957,13 @@ bool ShaderEffect::CanRenderOnBackgroundThread(Effect* effect, const SettingsMap
 #elif defined(__WXMSW__)
     return useBackgroundRender;
 #else
-    return false;
+    // on linux shaders go to the background threads on software contexts of their own, an effect
+    // that started out on the preview's context has to stay on the main thread
+    ShaderRenderCache* cache = (ShaderRenderCache*)buffer.infoCache[id];
+    if (cache != nullptr) {
+        return cache->software;
+    }
+    return useBackgroundRender;
 #endif
 }
 
@@ -808,6 +975,10 @@ void ShaderEffect::UnsetGLContext(ShaderRenderCache* cache) {
         // release it from the thread every time so we never find ourselves in a situation where it has not been released by a thread
         cache->glContextInfo->UnsetCurrent();
     }
+#else
+    if (cache->software) {
+        SOFTWARE_GL_CONTEXT_POOL.UnsetCurrent();
+    }
 #endif
 }
 
@@ -981,6 +1152,16 @@ bool ShaderEffect::SetGLContext(ShaderRenderCache *cache) {
     }
     return true;
 #else
+    if (cache->software) {
+        if (cache->s_eglContext == EGL_NO_CONTEXT) {
+            // we grab it here and release it when the cache is deleted
+            cache->s_eglContext = SOFTWARE_GL_CONTEXT_POOL.GetContext();
+            if (cache->s_eglContext == EGL_NO_CONTEXT) {
+                return false;
+            }
+        }
+        return SOFTWARE_GL_CONTEXT_POOL.SetCurrent(cache->s_eglContext);
+    }
     ShaderPanel *p = (ShaderPanel *)panel;
     cache->preview = p->_preview;
     p->_preview->SetCurrentGLContext();
@@ -993,19 +1174,28 @@ void ShaderEffect::Render(Effect* eff, const SettingsMap& SettingsMap, RenderBuf
 {
     static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
+    ShaderRenderCache* cache = (ShaderRenderCache*)buffer.infoCache[id];
+    if (cache == nullptr) {
+        cache = new ShaderRenderCache();
+#if !defined(__WXOSX__) && !defined(__WXMSW__)
+        cache->software = IsBackgroundRender();
+#endif
+        buffer.infoCache[id] = cache;
+    }
+
+    // a software context loads the GL functions itself if no OpenGL window has done so
+    bool contextSet = cache->software && SetGLContext(cache);
+
     // Bail out right away if we don't have the necessary OpenGL support
     if (!OpenGLShaders::HasFramebufferObjects() || !OpenGLShaders::HasShaderSupport()) {
         setRenderBufferAll(buffer, xlCYAN);
         logger_base.error("ShaderEffect::Render() - missing OpenGL support!!");
+        if (contextSet) {
+            UnsetGLContext(cache);
+        }
         return;
     }
 
-    ShaderRenderCache* cache = (ShaderRenderCache*)buffer.infoCache[id];
-    if (cache == nullptr) {
-        cache = new ShaderRenderCache();
-        buffer.infoCache[id] = cache;
-    }
-
     // This object has all the data from the json in the .fs file
     ShaderConfig*& _shaderConfig = cache->_shaderConfig;
     bool& s_shadersInit = cache->s_shadersInit;
@@ -1019,7 +1209,9 @@ void ShaderEffect::Render(Effect* eff, const SettingsMap& SettingsMap, RenderBuf
     int& s_rbHeight = cache->s_rbHeight;
     long& _timeMS = cache->_timeMS;
 
-    bool contextSet = SetGLContext(cache);
+    if (!cache->software) {
+        contextSet = SetGLContext(cache);
+    }
 
     float oset = buffer.GetEffectTimeIntervalPosition();
     double timeRate = GetValueCurveDouble("Shader_Speed", 100, SettingsMap, oset, SHADER_SPEED_MIN, SHADER_SPEED_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 1) / 100.0;
@@ -1102,9 +1294,9 @@ void ShaderEffect::Render(Effect* eff, const SettingsMap& SettingsMap, RenderBuf
 
             std::vector<float> fft128;
             if ( _shaderConfig->IsAudioFFTShader() )
-               fft128.insert( fft128.begin(), fftData->cbegin(), fftData->cend()  );
+               fft128.insert( fft128.begin(), fftData.cbegin(), fftData.cend()  );
             else
-               fft128.insert( fft128.begin(), 127, *(fftData->cbegin()) );
+               fft128.insert( fft128.begin(), 127, fftData.front() );
             fft128.push_back( 0.f );
 
             LOG_GL_ERRORV(glActiveTexture(GL_TEXTURE0));
@@ -1342,13 +1534,14 @@ unsigned ShaderEffect::programIdForShaderCode(ShaderConfig* cfg, ShaderRenderCac
 
     std::unique_lock<std::mutex> lock(ShaderRenderCache::shaderMapMutex);
     std::string fragmentShaderSrc(cfg->GetCode());
-    if (ShaderRenderCache::failedShaders.find(fragmentShaderSrc) != ShaderRenderCache::failedShaders.end()) {
+    std::string shaderKey(cache->GetShaderKey(fragmentShaderSrc));
+    if (ShaderRenderCache::failedShaders.find(shaderKey) != ShaderRenderCache::failedShaders.end()) {
         //previously failed to compile, don't try again
         return 0u;
     }
 
     ShaderRenderCache::ShaderInfo *shaderInfo = nullptr;
-    auto iter = ShaderRenderCache::shaderMap.find(fragmentShaderSrc);
+    auto iter = ShaderRenderCache::shaderMap.find(shaderKey);
     if (iter != ShaderRenderCache::shaderMap.cend()) {
         shaderInfo = (*iter).second;
         while (!shaderInfo->programIds.empty()) {
@@ -1369,16 +1562,16 @@ unsigned ShaderEffect::programIdForShaderCode(ShaderConfig* cfg, ShaderRenderCac
     if (programId == 0u) {
         lock.lock();
         logger_base.error("ShaderEffect::programIdForShaderCode() - failed to compile shader program %s", (const char *)cfg->GetFilename().c_str());
-        ShaderRenderCache::failedShaders.emplace(fragmentShaderSrc);
+        ShaderRenderCache::failedShaders.emplace(shaderKey);
         lock.unlock();
     } else {
         logger_base.debug("ShaderEffect::programIdForShaderCode() - fragment shader %s compiled successfully", (const char*)cfg->GetFilename().c_str());
         if (shaderInfo == nullptr) {
             lock.lock();
-            shaderInfo = ShaderRenderCache::shaderMap[fragmentShaderSrc];
+            shaderInfo = ShaderRenderCache::shaderMap[shaderKey];
             if (shaderInfo  == nullptr) {
                 shaderInfo = new ShaderRenderCache::ShaderInfo(programId);
-                ShaderRenderCache::shaderMap[fragmentShaderSrc] = shaderInfo;
+                ShaderRenderCache::shaderMap[shaderKey] = shaderInfo;
             }
             lock.unlock();
         }
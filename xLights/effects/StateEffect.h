@@ -24,10 +24,16 @@ class StateEffect : public RenderableEffect
         virtual void SetDefaultParameters() override;
         virtual void SetPanelStatus(Model *cls) override;
         virtual void Render(Effect *effect, const SettingsMap &settings, RenderBuffer &buffer) override;
+        virtual bool RenderCacheDependsOnSequence(const SettingsMap& settings) const override
+        {
+            return true;
+        }
         std::list<std::string> GetStates(Model* cls, std::string model);
         virtual void RenameTimingTrack(std::string oldname, std::string newname, Effect* effect) override;
         virtual std::list<std::string> CheckEffectSettings(const SettingsMap& settings, AudioManager* media, Model* model, Effect* eff, bool renderCache) override;
         virtual bool CanRenderPartialTimeInterval() const override { return true; }
+        // the frames depend on the model's state definitions, not just the buffer
+        virtual bool SupportsRenderCache(const SettingsMap& settings) const override { return false; }
         std::list<std::string> GetStatesUsed(const SettingsMap& SettingsMap);
     protected:
         virtual xlEffectPanel *CreatePanel(wxWindow *parent) override;
@@ -19,6 +19,10 @@ class StrobeEffect : public RenderableEffect
         virtual ~StrobeEffect();
         virtual void SetDefaultParameters() override;
         virtual void Render(Effect *effect, const SettingsMap &settings, RenderBuffer &buffer) override;
+        virtual bool RenderCacheDependsOnSequence(const SettingsMap& settings) const override
+        {
+            return true;
+        }
         virtual std::list<std::string> CheckEffectSettings(const SettingsMap& settings, AudioManager* media, Model* model, Effect* eff, bool renderCache) override;
 protected:
         virtual xlEffectPanel *CreatePanel(wxWindow *parent) override;
@@ -92,12 +92,10 @@ public:
     virtual ~TendrilEffect();
     virtual void SetDefaultParameters() override;
     virtual void Render(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer) override;
-#ifdef LINUX
-    virtual bool CanRenderOnBackgroundThread(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer) override
+    virtual bool RenderCacheDependsOnSequence(const SettingsMap& settings) const override
     {
-        return false;
+        return true;
     }
-#endif
     virtual bool AppropriateOnNodes() const override
     {
         return false;
@@ -9,10 +9,10 @@
  **************************************************************/
 
 #include "TextEffect.h"
+#include "TextLineCache.h"
 
 #include <mutex>
 #include <array>
-#include <unordered_map>
 
 #include "TextPanel.h"
 #include <wx/checkbox.h>
@@ -540,6 +540,7 @@ void TextEffect::Render(Effect *effect, const SettingsMap &SettingsMap, RenderBu
         bool pixelOffsets = wxAtoi(SettingsMap.Get("CHECKBOX_Text_PixelOffsets", "0"));
         bool perWord = wxAtoi(SettingsMap.Get("CHECKBOX_Text_Color_PerWord", "0"));
 
+        bool drawnToBuffer = false;
         wxImage * i = RenderTextLine(buffer,
                        buffer.GetTextDrawingContext(),
                        text,
@@ -549,9 +550,9 @@ void TextEffect::Render(Effect *effect, const SettingsMap &SettingsMap, RenderBu
                        TextEffectsIndex(SettingsMap["CHOICE_Text_Effect"]),
                        TextCountDownIndex(SettingsMap["CHOICE_Text_Count"]),
                        wxAtoi(SettingsMap.Get("TEXTCTRL_Text_Speed", "10")),
-                       startx, starty, endx, endy, pixelOffsets, perWord);
+                       startx, starty, endx, endy, pixelOffsets, perWord, drawnToBuffer);
         
-        if (i == nullptr) {
+        if (drawnToBuffer || i == nullptr) {
             return;
         }
         xlColor c;
@@ -644,57 +645,13 @@ wxSize GetMultiLineTextExtent(TextDrawingContext *dc,
     return wxSize(widthTextMax, heightTextTotal);
 }
 
-class CachedTextInfo {
-public:
-    CachedTextInfo() {}
-    CachedTextInfo(const std::string &txt, const std::string font, const std::vector<xlColor> &c, const wxRect &r)
-    : text(txt), rect(r), color(c), fontString(font) {}
-    ~CachedTextInfo() {}
-    
-    bool operator==(const CachedTextInfo &i) const {
-        return (text == i.text)
-            && (fontString == i.fontString)
-            && (rect == i.rect)
-            && (color == i.color);
-    }
-    
-    std::string text;
-    wxRect rect;
-    std::vector<xlColor> color;
-    std::string fontString;
-};
-
-struct CachedTextInfoHasher {
-    size_t operator()(const CachedTextInfo& t) const {
-        std::size_t h1 = std::hash<std::string>{}(t.text);
-        std::size_t h2 = std::hash<std::string>{}(t.fontString);
-        h1 ^= (h2 << 1);
-        for (auto a : t.color) {
-            h1 ^= a.GetRGB() << 3;
-        }
-        h1 ^= (std::abs(t.rect.x) << 8) + (std::abs(t.rect.y) << 16);
-        return h1;
-    }
-};
-
 class TextRenderCache : public EffectRenderCache {
 public:
     TextRenderCache() : timer_countdown(0), synced_textsize(wxSize(0,0)) {};
-    virtual ~TextRenderCache() {
-        for (const auto& it : textCache) {
-            delete it.second;
-        }
-    };
+    virtual ~TextRenderCache() {};
     int timer_countdown;
     wxSize synced_textsize;
     
-    wxImage *GetImage(const CachedTextInfo &inf) {
-        return textCache[inf];
-    }
-    void PutImage(const CachedTextInfo &inf, wxImage *img) {
-        textCache[inf] = img;
-    }
-    
     wxSize GetMultiLineTextExtent(const std::string &font, const wxString &msg) {
         std::pair<std::string, wxString> key(font, msg);
         auto i = textExtentCache.find(key);
@@ -708,7 +665,6 @@ public:
         textExtentCache[key] = sz;
     }
     
-    std::unordered_map<CachedTextInfo, wxImage*, CachedTextInfoHasher> textCache;
     std::map<std::pair<std::string, wxString>, wxSize> textExtentCache;
 };
 
@@ -906,6 +862,57 @@ TextRenderCache *GetCache(RenderBuffer &buffer, int id) {
     return cache;
 }
 
+// Draws a block of text on a drawing context of its own with room around it for glyphs that hang
+// outside the text's extent
+static std::shared_ptr<TextLine> DrawTextLine(TextDrawingContext* dc,
+                                              const wxString& msg,
+                                              TextRenderCache* cache,
+                                              const std::string& fontString,
+                                              const std::vector<xlColor>& colors,
+                                              bool perWord)
+{
+    dc->Clear();
+    SetFont(dc, fontString, colors[0]);
+    wxCoord width, height, heightLine;
+    GetMultiLineTextExtent(dc, msg, &width, &height, &heightLine);
+
+    TextDrawingContext* tdc = TextDrawingContext::GetContext();
+    if (tdc == nullptr) {
+        return nullptr;
+    }
+
+    auto line = std::make_shared<TextLine>();
+    line->textX = line->textY = heightLine / 2 + 1;
+    line->textWidth = width;
+    line->textHeight = height;
+    line->width = width + line->textX * 2;
+    line->height = height + line->textY * 2;
+
+    tdc->ResetSize(line->width, line->height);
+    tdc->Clear();
+    SetFont(tdc, fontString, colors[0]);
+    DrawLabel(tdc, msg, wxRect(line->textX, line->textY, width, height), wxALIGN_CENTER_HORIZONTAL | wxALIGN_CENTER_VERTICAL, cache, fontString, colors, perWord);
+    wxImage* img = tdc->FlushAndGetImage();
+
+    line->rgba.resize((size_t)line->width * line->height * 4);
+    bool ha = img->HasAlpha();
+    const unsigned char* data = img->GetData();
+    const unsigned char* alpha = ha ? img->GetAlpha() : nullptr;
+    uint8_t* p = line->rgba.data();
+    for (int i = 0; i < line->width * line->height; i++, p += 4, data += 3) {
+        p[0] = data[0];
+        p[1] = data[1];
+        p[2] = data[2];
+        if (ha) {
+            p[3] = alpha[i];
+        } else {
+            p[3] = (data[0] == 0 && data[1] == 0 && data[2] == 0) ? 0 : 255;
+        }
+    }
+    TextDrawingContext::ReleaseContext(tdc);
+    return line;
+}
+
 //jwylie - 2016-11-01  -- enhancement: add minute seconds countdown
 wxImage *TextEffect::RenderTextLine(RenderBuffer &buffer,
                                     TextDrawingContext* dc,
@@ -914,7 +921,7 @@ wxImage *TextEffect::RenderTextLine(RenderBuffer &buffer,
                                     int dir,
                                     bool center, int Effect, int Countdown, int tspeed,
                                     int startx, int starty, int endx, int endy,
-                                    bool isPixelBased, bool perWord) const
+                                    bool isPixelBased, bool perWord, bool& drawnToBuffer) const
 {
     int i;
     wxString Line = Line_orig;
@@ -1085,18 +1092,34 @@ wxImage *TextEffect::RenderTextLine(RenderBuffer &buffer,
         if (colors.size() == 0) {
             colors.push_back(xlWHITE);
         }
-        CachedTextInfo inf(msg.ToStdString(), fontString, colors, rect);
-        wxImage *img = GetCache(buffer,id)->GetImage(inf);
-        if (img == nullptr) {
-            dc->Clear();
-            SetFont(dc, fontString, colors[0]);
-            DrawLabel(dc, msg, rect, wxALIGN_CENTER_HORIZONTAL|wxALIGN_CENTER_VERTICAL, GetCache(buffer,id), fontString, colors, perWord);
-            wxImage *i2 = dc->FlushAndGetImage();
-            img = new wxImage(i2->GetSize());
-            *img = i2->Copy();
-            GetCache(buffer,id)->PutImage(inf, img);
+        auto& lineCache = TextLineCache::GetDefaultCache();
+        std::string key = TextLineCache::GetKey(msg.ToStdString(), fontString, colors, perWord);
+        auto line = lineCache.Get(key);
+        if (line == nullptr) {
+            line = DrawTextLine(dc, msg, GetCache(buffer, id), fontString, colors, perWord);
+            if (line == nullptr) {
+                return nullptr;
+            }
+            line = lineCache.Put(key, line);
+        }
+
+        // centre the text in rect like DrawLabel would have
+        int left = (rect.GetLeft() + rect.GetRight() + 1 - line->textWidth) / 2 - line->textX;
+        int top = (rect.GetTop() + rect.GetBottom() + 1 - line->textHeight) / 2 - line->textY;
+        for (int y = 0; y < buffer.BufferHt; y++) {
+            int row = buffer.BufferHt - 1 - y - top;
+            for (int x = 0; x < buffer.BufferWi; x++) {
+                int col = x - left;
+                if (row < 0 || row >= line->height || col < 0 || col >= line->width) {
+                    buffer.SetPixel(x, y, xlCLEAR);
+                } else {
+                    const uint8_t* p = &line->rgba[(row * line->width + col) * 4];
+                    buffer.SetPixel(x, y, xlColor(p[0], p[1], p[2], p[3]));
+                }
+            }
         }
-        return img;
+        drawnToBuffer = true;
+        return nullptr;
     }
     
     xlColor c;
@@ -1476,8 +1499,8 @@ void TextEffect::RenderXLText(Effect* effect, const SettingsMap& settings, Rende
     font_mgr.init();  // make sure font class is initialized
     wxString xl_font = settings["CHOICE_Text_Font"];
     xlFont* font = font_mgr.get_font(xl_font);
-    wxBitmap* bmp = font->get_bitmap();
-    wxImage image = bmp->ConvertToImage();
+    // a reference as the image is shared by every render thread
+    const wxImage& image = font->get_image();
     int char_width = font->GetWidth();
     int char_height = font->GetHeight();
 
@@ -26,10 +26,11 @@ public:
     virtual ~TextEffect();
     virtual void SetDefaultParameters() override;
     virtual void Render(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer) override;
+    virtual bool RenderCacheDependsOnSequence(const SettingsMap& settings) const override
+    {
+        return true;
+    }
     virtual void SetPanelStatus(Model* cls) override;
-#ifdef LINUX
-    virtual bool CanRenderOnBackgroundThread(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer) override { return false; };
-#endif
     virtual bool CanBeRandom() override { return false; }
     virtual bool SupportsRenderCache(const SettingsMap& settings) const override;
 
@@ -57,7 +58,7 @@ private:
         int dir,
         bool center, int Effect, int Countdown, int tspeed,
         int startx, int starty, int endx, int endy,
-        bool isPixelBased, bool perWord) const;
+        bool isPixelBased, bool perWord, bool& drawnToBuffer) const;
     void RenderXLText(Effect* effect, const SettingsMap& settings, RenderBuffer& buffer);
     void AddMotions(int& OffsetLeft, int& OffsetTop, const SettingsMap& settings, RenderBuffer& buffer,
         int txtLen, int endx, int endy, bool pixelOffsets, int PreOffsetLeft, int PreOffsetTop, int text_len, int char_width, int char_height, bool vertical, bool rotate_90) const;
@@ -0,0 +1,111 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <algorithm>
+#include <mutex>
+
+#include "TextLineCache.h"
+#include "../Color.h"
+
+TextLineCache& TextLineCache::GetDefaultCache()
+{
+    static TextLineCache cache;
+    return cache;
+}
+
+std::string TextLineCache::GetKey(const std::string& text, const std::string& font, const std::vector<xlColor>& colors, bool perWord)
+{
+    std::string key = font + "|" + (perWord ? "word" : "letter");
+    for (const auto& it : colors) {
+        key += "|" + std::to_string(it.GetRGB());
+    }
+    return key + "|" + text;
+}
+
+std::shared_ptr<const TextLine> TextLineCache::Get(const std::string& key)
+{
+    std::shared_lock<std::shared_timed_mutex> lock(_lock);
+    auto it = _lines.find(key);
+    if (it == _lines.end()) {
+        _misses++;
+        return nullptr;
+    }
+    _hits++;
+    it->second.lastUsed = ++_clock;
+    return it->second.line;
+}
+
+std::shared_ptr<const TextLine> TextLineCache::Put(const std::string& key, const std::shared_ptr<const TextLine>& line)
+{
+    std::unique_lock<std::shared_timed_mutex> lock(_lock);
+    auto res = _lines.try_emplace(key);
+    Entry& e = res.first->second;
+    e.lastUsed = ++_clock;
+    if (!res.second) {
+        return e.line;
+    }
+    e.line = line;
+    _bytes += line->GetBytes();
+    Trim();
+    return line;
+}
+
+void TextLineCache::Clear()
+{
+    std::unique_lock<std::shared_timed_mutex> lock(_lock);
+    _lines.clear();
+    _bytes = 0;
+}
+
+void TextLineCache::SetMaxBytes(size_t maxBytes)
+{
+    std::unique_lock<std::shared_timed_mutex> lock(_lock);
+    _maxBytes = maxBytes;
+    Trim();
+}
+
+size_t TextLineCache::GetBytes()
+{
+    std::shared_lock<std::shared_timed_mutex> lock(_lock);
+    return _bytes;
+}
+
+size_t TextLineCache::GetCount()
+{
+    std::shared_lock<std::shared_timed_mutex> lock(_lock);
+    return _lines.size();
+}
+
+void TextLineCache::ResetCounters()
+{
+    _hits = 0;
+    _misses = 0;
+}
+
+void TextLineCache::Trim()
+{
+    if (_bytes <= _maxBytes) return;
+
+    // drop down to three quarters of the limit so we are not back here for the next line
+    std::vector<std::pair<uint64_t, std::string>> lines;
+    lines.reserve(_lines.size());
+    for (const auto& it : _lines) {
+        lines.emplace_back(it.second.lastUsed, it.first);
+    }
+    std::sort(lines.begin(), lines.end());
+
+    size_t target = _maxBytes / 4 * 3;
+    for (const auto& it : lines) {
+        if (_bytes <= target) break;
+        auto l = _lines.find(it.second);
+        _bytes -= l->second.line->GetBytes();
+        _lines.erase(l);
+    }
+}
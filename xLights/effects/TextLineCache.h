@@ -0,0 +1,85 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class xlColor;
+
+// A block of text drawn once with its top left at (textX, textY) in an image of its own
+struct TextLine
+{
+    int width = 0;
+    int height = 0;
+    int textX = 0;
+    int textY = 0;
+    int textWidth = 0;  // the extent of the text, which is where the lines are centred
+    int textHeight = 0;
+    std::vector<uint8_t> rgba; // top row first
+
+    size_t GetBytes() const { return rgba.size(); }
+};
+
+/**
+ * Text drawn by the text effect shared by every model showing it.
+ *
+ * Lines are kept by their text, font and colours, not by where they are drawn, so the same lyric on
+ * many singing faces, or one line scrolling across a matrix, is drawn once.  The lines count towards
+ * one memory limit and the least recently used are dropped first.  Any number of threads can look
+ * lines up at the same time.
+ */
+class TextLineCache
+{
+public:
+    static TextLineCache& GetDefaultCache();
+    static std::string GetKey(const std::string& text, const std::string& font, const std::vector<xlColor>& colors, bool perWord);
+
+    TextLineCache() {}
+    ~TextLineCache() {}
+
+    std::shared_ptr<const TextLine> Get(const std::string& key);
+    // returns the line kept for the key which is another thread's if it got there first
+    std::shared_ptr<const TextLine> Put(const std::string& key, const std::shared_ptr<const TextLine>& line);
+    void Clear();
+
+    void SetMaxBytes(size_t maxBytes);
+    size_t GetMaxBytes() const { return _maxBytes; }
+    size_t GetBytes();
+    size_t GetCount();
+
+    uint32_t GetHits() const { return _hits; }
+    uint32_t GetMisses() const { return _misses; }
+    void ResetCounters();
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<const TextLine> line;
+        std::atomic<uint64_t> lastUsed { 0 };
+    };
+
+    // needs the lock held exclusively
+    void Trim();
+
+    std::shared_timed_mutex _lock;
+    std::unordered_map<std::string, Entry> _lines;
+    size_t _bytes = 0;
+    std::atomic<size_t> _maxBytes { 64 * 1024 * 1024 };
+    std::atomic<uint64_t> _clock { 0 };
+    std::atomic<uint32_t> _hits { 0 };
+    std::atomic<uint32_t> _misses { 0 };
+};
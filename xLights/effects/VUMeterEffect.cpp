@@ -803,21 +803,21 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
 
     int truexoffset = xoffset * buffer.BufferWi / 100;
     int trueyoffset = yoffset * buffer.BufferHt / 100;
-	std::list<float> const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+	AudioFrameData const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
     while (lineHistory.size() > sensitivity / 10)
     {
         lineHistory.pop_front();
     }
 
-	if (pdata != nullptr && pdata->size() != 0)
+	if (pdata && pdata.size() != 0)
 	{
         if (peak)
         {
             if (lastvalues.size() == 0)
             {
-                lastvalues = *pdata;
-                lastpeaks = *pdata;
+                lastvalues.assign(pdata.begin(), pdata.end());
+                lastpeaks.assign(pdata.begin(), pdata.end());
                 for (auto it = lastvalues.begin(); it != lastvalues.end(); ++it)
                 {
                     pauseuntilpeakfall.push_back(0);
@@ -825,7 +825,7 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
             }
             else
             {
-                std::list<float>::const_iterator newdata = pdata->cbegin();
+                AudioFrameData::const_iterator newdata = pdata.cbegin();
                 std::list<float>::iterator olddata = lastpeaks.begin();
                 auto pause = pauseuntilpeakfall.begin();
 
@@ -860,11 +860,11 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
 		{
 			if (lastvalues.size() == 0)
 			{
-				lastvalues = *pdata;
+				lastvalues.assign(pdata.begin(), pdata.end());
 			}
 			else
 			{
-				std::list<float>::const_iterator newdata = pdata->cbegin();
+				AudioFrameData::const_iterator newdata = pdata.cbegin();
 				std::list<float>::iterator olddata = lastvalues.begin();
 
 				while (olddata != lastvalues.end())
@@ -889,10 +889,10 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
 		}
 		else
 		{
-			lastvalues = *pdata;
+			lastvalues.assign(pdata.begin(), pdata.end());
 		}
 
-        int datapoints = std::min((int)pdata->size(), endNote - startNote + 1);
+        int datapoints = std::min((int)pdata.size(), endNote - startNote + 1);
 
 		if (usebars > datapoints)
 		{
@@ -1109,9 +1109,9 @@ void VUMeterEffect::RenderVolumeBarsFrame(RenderBuffer &buffer, int usebars, int
         int i = start + (int)((float)x / cols);
         if (i > 0) {
             float f = 0.0;
-            std::list<float> const* const pf = buffer.GetMedia()->GetFrameData(i, FRAMEDATA_HIGH, "");
-            if (pf != nullptr) {
-                f = ApplyGain(*pf->cbegin(), gain);
+            AudioFrameData const pf = buffer.GetMedia()->GetFrameData(i, FRAMEDATA_HIGH, "");
+            if (pf) {
+                f = ApplyGain(pf.front(), gain);
             }
             int colheight = buffer.BufferHt * f;
             for (int y = 0; y < colheight; y++) {
@@ -1177,22 +1177,16 @@ void VUMeterEffect::RenderWaveformFrame(RenderBuffer &buffer, int usebars, int y
     {
         int start = buffer.curPeriod - usebars;
         int x = 0;
+        std::vector<float> highs(usebars);
+        std::vector<float> lows(usebars);
+        buffer.GetMedia()->GetFrameLevels(FRAMEDATA_HIGH, start, usebars, highs.data());
+        buffer.GetMedia()->GetFrameLevels(FRAMEDATA_LOW, start, usebars, lows.data());
         for (int i = 0; i < usebars; i++)
         {
             if (start + i >= 0)
             {
-                float fh = 0.0;
-                std::list<float> const * pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
-                if (pf != nullptr)
-                {
-                    fh = ApplyGain(*pf->cbegin(), gain);
-                }
-                float fl = 0.0;
-                pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_LOW, "");
-                if (pf != nullptr)
-                {
-                    fl = ApplyGain(*pf->cbegin(), gain);
-                }
+                float fh = ApplyGain(highs[i], gain);
+                float fl = ApplyGain(lows[i], gain);
                 int s = (1.0 - fl) * buffer.BufferHt / 2;
                 int e = (1.0 + fh) * buffer.BufferHt / 2;
                 if (e < s)
@@ -1404,10 +1398,10 @@ void VUMeterEffect::RenderOnFrame(RenderBuffer& buffer, int gain)
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-	std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	AudioFrameData const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (pf)
 	{
-		f = ApplyGain(*pf->cbegin(), gain);
+		f = ApplyGain(pf.front(), gain);
 	}
 	xlColor color1;
 	buffer.palette.GetColor(0, color1);
@@ -1428,14 +1422,14 @@ void VUMeterEffect::RenderDominantFrequencyColour(RenderBuffer& buffer, int sens
 
     float sns = (float)sensitivity / 100.0;
 
-    std::list<float> const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    AudioFrameData const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (pdata && pdata.size() != 0)
     {
         int note = -1;
         float max = -1000;
-        auto it = pdata->cbegin();
-        for (int i = 0; i < std::min((int)pdata->size(), endnote+1); i++)
+        auto it = pdata.cbegin();
+        for (int i = 0; i < std::min((int)pdata.size(), endnote+1); i++)
         {
             if (i >= startnote)
             {
@@ -1478,10 +1472,10 @@ void VUMeterEffect::RenderOnColourFrame(RenderBuffer& buffer, int gain)
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    AudioFrameData const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (pf)
     {
-        f = ApplyGain(*pf->cbegin(), gain);
+        f = ApplyGain(pf.front(), gain);
     }
 
     xlColor color1;
@@ -1557,10 +1551,10 @@ void VUMeterEffect::RenderIntensityWaveFrame(RenderBuffer &buffer, int usebars,
 		if (start + i >= 0)
 		{
 			float f = 0.0;
-			std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
-			if (pf != nullptr)
+			AudioFrameData const pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
+			if (pf)
 			{
-				f = ApplyGain(*pf->begin(), gain);
+				f = ApplyGain(pf.front(), gain);
 			}
 			xlColor color1;
 			if (buffer.palette.Size() < 2)
@@ -1593,10 +1587,10 @@ void VUMeterEffect::RenderLevelPulseFrame(RenderBuffer &buffer, int fadeframes,
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-	std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	AudioFrameData const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (pf)
 	{
-		f = ApplyGain(*pf->cbegin(), gain);
+		f = ApplyGain(pf.front(), gain);
 	}
 
 	if (f > (float)sensitivity / 100.0)
@@ -1634,10 +1628,10 @@ void VUMeterEffect::RenderLevelJumpFrame(RenderBuffer& buffer, int fadeframes, i
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    AudioFrameData const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (pf)
     {
-        f = ApplyGain(*pf->cbegin(), gain);
+        f = ApplyGain(pf.front(), gain);
     }
 
     if (f > (float)sensitivity / 100.0)
@@ -1682,10 +1676,10 @@ void VUMeterEffect::RenderLevelPulseColourFrame(RenderBuffer &buffer, int fadefr
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    AudioFrameData const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (pf)
     {
-        f = ApplyGain(*pf->begin(), gain);
+        f = ApplyGain(pf.front(), gain);
     }
 
     if (f > (float)sensitivity / 100.0)
@@ -1732,10 +1726,10 @@ void VUMeterEffect::RenderLevelColourFrame(RenderBuffer &buffer, int& colourinde
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    AudioFrameData const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (pf)
     {
-        f = ApplyGain(*pf->begin(), gain);
+        f = ApplyGain(pf.front(), gain);
     }
 
     if (f > (float)sensitivity / 100.0)
@@ -2346,10 +2340,10 @@ void VUMeterEffect::RenderLevelShapeFrame(RenderBuffer& buffer, const std::strin
     float scaling = (float)scale / 100.0 * 7.0;
 
 	float f = 0.0;
-	std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	AudioFrameData const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (pf)
 	{
-		f = ApplyGain(*pf->begin(), gain);
+		f = ApplyGain(pf.front(), gain);
 	}
 
 	int centerx = (buffer.BufferWi / 2.0) + truexoffset;
@@ -2681,9 +2675,9 @@ void VUMeterEffect::RenderTimingEventJumpFrame(RenderBuffer& buffer, int fallfra
         {
             if (useAudioLevel) {
                 float f = 0.0;
-                std::list<float> const* const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-                if (pf != nullptr) {
-                    f = ApplyGain(*pf->cbegin(), gain);
+                AudioFrameData const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+                if (pf) {
+                    f = ApplyGain(pf.front(), gain);
                 }
                 lastsize = f;
             } else {
@@ -2809,13 +2803,13 @@ void VUMeterEffect::RenderNoteOnFrame(RenderBuffer& buffer, int startNote, int e
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float> const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    AudioFrameData const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (pdata && pdata.size() != 0)
     {
         int i = 0;
         float level = 0.0;
-        for (const auto& it : *pdata)
+        for (const auto& it : pdata)
         {
             if (i > startNote && i <= endNote)
             {
@@ -2844,13 +2838,13 @@ void VUMeterEffect::RenderNoteLevelPulseFrame(RenderBuffer& buffer, int fadefram
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float>const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    AudioFrameData const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (pdata && pdata.size() != 0)
     {
         int i = 0;
         float level = 0.0;
-        for (const auto& it : *pdata)
+        for (const auto& it : pdata)
         {
             if (i > startNote && i <= endNote)
             {
@@ -2896,13 +2890,13 @@ void VUMeterEffect::RenderNoteLevelJumpFrame(RenderBuffer& buffer, int fadeframe
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float> const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    AudioFrameData const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (pdata && pdata.size() != 0)
     {
         int i = 0;
         float level = 0.0;
-        for (const auto& it : *pdata)
+        for (const auto& it : pdata)
         {
             if (i > startNote && i <= endNote)
             {
@@ -2954,11 +2948,11 @@ void VUMeterEffect::RenderLevelBarFrame(RenderBuffer &buffer, int bars, int sens
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float> const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    AudioFrameData const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (pdata && pdata.size() != 0)
     {
-        float level = ApplyGain(pdata->front(), gain);
+        float level = ApplyGain(pdata.front(), gain);
 
         xlColor color1;
         if (level > (float)sensitivity / 100.0)
@@ -3075,12 +3069,12 @@ void VUMeterEffect::RenderNoteLevelBarFrame(RenderBuffer& buffer, int bars, int
     if (buffer.GetMedia() == nullptr)
         return;
 
-    std::list<float> const* const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    AudioFrameData const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0) {
+    if (pdata && pdata.size() != 0) {
         int i = 0;
         float level = 0.0;
-        for (const auto& it : *pdata) {
+        for (const auto& it : pdata) {
             if (i > startNote && i <= endNote) {
                 level = std::max(it, level);
             }
@@ -17,6 +17,7 @@
 #include "VideoEffect.h"
 #include "VideoPanel.h"
 #include "../VideoReader.h"
+#include "../VideoFrameCache.h"
 #include "../sequencer/Effect.h"
 #include "../RenderBuffer.h"
 #include "../UtilClasses.h"
@@ -235,20 +236,15 @@ public:
     VideoRenderCache()
 	{
 		_videoframerate = -1;
-		_videoreader = nullptr;
         _loops = 0;
         _frameMS = 50;
         _nextManualMS = 0;
 	};
     virtual ~VideoRenderCache() {
-		if (_videoreader != nullptr)
-		{
-			delete _videoreader;
-			_videoreader = nullptr;
-		}
 	};
 
-    VideoReader* _videoreader;
+    // shared with every other effect playing the same video at the same size
+    std::shared_ptr<VideoClip> _clip;
 	int _videoframerate;
 	int _loops;
     int _frameMS;
@@ -300,7 +296,7 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
     }
 
     int &_loops = cache->_loops;
-    VideoReader* &_videoreader = cache->_videoreader;
+    std::shared_ptr<VideoClip>& _clip = cache->_clip;
     int& _frameMS = cache->_frameMS;
     int& _nextManualMS = cache->_nextManualMS;
 
@@ -323,11 +319,7 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
         _loops = 0;
         _nextManualMS = 0;
         _frameMS = buffer.frameTimeInMs;
-        if (_videoreader != nullptr)
-        {
-            delete _videoreader;
-            _videoreader = nullptr;
-        }
+        _clip = nullptr;
 
         if (buffer.BufferHt == 1)
         {
@@ -341,25 +333,22 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
 
             bool useNativeResolution = (sampleSpacing > 0);
 
-            _videoreader = new VideoReader(filename, width, height, aspectratio, useNativeResolution, true);
+            _clip = VideoFrameCache::GetDefaultCache().Open(filename, width, height, aspectratio, useNativeResolution, true);
 
-            if (_videoreader == nullptr)
+            if (!_clip->IsValid())
             {
                 logger_base.warn("VideoEffect: Failed to load video file %s.", (const char *)filename.c_str());
             }
             else
             {
                 // extract the video length
-                int videolen = _videoreader->GetLengthMS();
+                int videolen = _clip->GetLengthMS();
 
                 if (videolen == 0)
                 {
                     logger_base.warn("VideoEffect: Video %s was read as 0 length.", (const char *)filename.c_str());
                 }
 
-                // read the first frame ... if i dont it thinks the first frame i read is the first frame
-                _videoreader->GetNextFrame(0);
-
                 VideoPanel *fp = static_cast<VideoPanel*>(panel);
                 if (fp != nullptr)
                 {
@@ -370,12 +359,6 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
                     //fp->addVideoTime(filename, videolen);
                 }
 
-                if (starttime != 0)
-                {
-                    logger_base.debug("Video effect initialising ... seeking to start location for the video %f.", (float)starttime);
-                    _videoreader->Seek(starttime * 1000);
-                }
-
                 if (durationTreatment == "Slow/Accelerate")
                 {
                     int effectFrames = buffer.curEffEndPer - buffer.curEffStartPer + 1;
@@ -397,24 +380,23 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
         }
     }
 
-    if (_videoreader != nullptr && sampleSpacing == 0) {
+    if (_clip != nullptr && _clip->IsValid() && sampleSpacing == 0) {
         int width = buffer.BufferWi * 100 / (cropRight - cropLeft);
         int height = buffer.BufferHt * 100 / (cropTop - cropBottom);
-        bool vwidthEq = width == _videoreader->GetWidth();
-        bool vheightEq = height == _videoreader->GetHeight();
+        bool vwidthEq = width == _clip->GetWidth();
+        bool vheightEq = height == _clip->GetHeight();
         if (aspectratio) {
             // if aspect ratio scaling, then only one or the other will be equal
             vwidthEq = vheightEq | vwidthEq;
             vheightEq = vwidthEq;
         }
         if (!vwidthEq || !vheightEq) {
-            // need to close and reopen video reader to the new size ... this is inefficient ... but lots of work to do to change video reader size dynamically
-            delete _videoreader;
-            _videoreader = new VideoReader(filename, width, height, aspectratio, false, true);
+            // switch to the video at the new size ... another model may already have it decoded
+            _clip = VideoFrameCache::GetDefaultCache().Open(filename, width, height, aspectratio, false, true);
         }
     }
 
-    if (_videoreader != nullptr && _videoreader->GetLengthMS() > 0)
+    if (_clip != nullptr && _clip->IsValid() && _clip->GetLengthMS() > 0)
     {
         long frame = 0;
         
@@ -429,63 +411,61 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
 
             while (frame < 0)
             {
-                frame += _videoreader->GetLengthMS();
+                frame += _clip->GetLengthMS();
             }
 
-            while (frame > _videoreader->GetLengthMS())
+            while (frame > _clip->GetLengthMS())
             {
-                frame -= _videoreader->GetLengthMS();
+                frame -= _clip->GetLengthMS();
             }
 
             _nextManualMS += speed * _frameMS;
         }
         else
         {
-            frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_videoreader->GetLengthMS() + _frameMS);
+            frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_clip->GetLengthMS() + _frameMS);
         }
 
         // get the image for the current frame
-        AVFrame* image = _videoreader->GetNextFrame(frame);
+        auto image = _clip->GetFrame(frame);
 
         // if we have reached the end and we are to loop
-        if (_videoreader->AtEnd() && durationTreatment == "Loop")
+        if (image == nullptr && frame >= 0 && durationTreatment == "Loop" && _clip->IsPastEnd(frame))
         {
             // jump back to start and try to read frame again
             _loops++;
-            frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_videoreader->GetLengthMS() + _frameMS);
+            frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_clip->GetLengthMS() + _frameMS);
             if (frame < 0)
             {
                 frame = 0;
             }
             logger_base.debug("Video effect loop #%d at frame %d to video frame %d.", _loops, buffer.curPeriod - buffer.curEffStartPer, frame);
 
-            _videoreader->Seek(0);
-            image = _videoreader->GetNextFrame(frame);
+            image = _clip->GetFrame(frame);
         }
 
-            int ch = _videoreader->GetPixelChannels();
-
             // check it looks valid
             if (image != nullptr && frame >= 0) {
+                int ch = image->channels;
 
                 // This handles normal scaling of videos
                 if (sampleSpacing == 0) {
-                    int xoffset = cropLeft * _videoreader->GetWidth() / 100;
-                    int yoffset = cropBottom * _videoreader->GetHeight() / 100;
-                    int xtail = (100 - cropRight) * _videoreader->GetWidth() / 100;
-                    int ytail = (100 - cropTop) * _videoreader->GetHeight() / 100;
-                    int startx = (buffer.BufferWi - _videoreader->GetWidth() * (cropRight - cropLeft) / 100) / 2;
-                    int starty = (buffer.BufferHt - _videoreader->GetHeight() * (cropTop - cropBottom) / 100) / 2;
+                    int xoffset = cropLeft * image->width / 100;
+                    int yoffset = cropBottom * image->height / 100;
+                    int xtail = (100 - cropRight) * image->width / 100;
+                    int ytail = (100 - cropTop) * image->height / 100;
+                    int startx = (buffer.BufferWi - image->width * (cropRight - cropLeft) / 100) / 2;
+                    int starty = (buffer.BufferHt - image->height * (cropTop - cropBottom) / 100) / 2;
 
-                    // wxASSERT(xoffset + xtail + buffer.BufferWi == _videoreader->GetWidth());
-                    // wxASSERT(yoffset + ytail + buffer.BufferHt == _videoreader->GetHeight());
+                    // wxASSERT(xoffset + xtail + buffer.BufferWi == image->width);
+                    // wxASSERT(yoffset + ytail + buffer.BufferHt == image->height);
 
                     // draw the image
                     xlColor c;
-                    for (int y = 0; y < _videoreader->GetHeight() - yoffset - ytail; y++) {
-                        uint8_t* ptr = image->data[0] + (_videoreader->GetHeight() - 1 - y - yoffset) * _videoreader->GetWidth() * ch + xoffset * ch;
+                    for (int y = 0; y < image->height - yoffset - ytail; y++) {
+                        const uint8_t* ptr = image->data.data() + (image->height - 1 - y - yoffset) * image->width * ch + xoffset * ch;
 
-                        for (int x = 0; x < _videoreader->GetWidth() - xoffset - xtail; x++) {
+                        for (int x = 0; x < image->width - xoffset - xtail; x++) {
                             try {
                                 c.Set(*(ptr),
                                       *(ptr + 1),
@@ -528,7 +508,7 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
                             int curx = startx;
                             for (int x = 0; x < buffer.BufferWi; ++x) {
                                 if (curx >= 0 && curx < image->width) {
-                                    uint8_t* ptr = image->data[0] + (_videoreader->GetHeight() - 1 - cury) * _videoreader->GetWidth() * ch + curx * ch;
+                                    const uint8_t* ptr = image->data.data() + (image->height - 1 - cury) * image->width * ch + curx * ch;
                                     try {
                                         c.Set(*(ptr),
                                               *(ptr + 1),
@@ -13,6 +13,7 @@
 
 #include "ArtNetOutput.h"
 #include "OutputManager.h"
+#include "UDPTransmitter.h"
 #include "../UtilFunctions.h"
 #include "ControllerEthernet.h"
 #include "../OutputModelManager.h"
@@ -332,6 +333,7 @@ bool ArtNetOutput::Open() {
     _remoteAddr.Service(ARTNET_PORT);
 
     wxString ipAddr = _remoteAddr.IPAddress();
+    _udpDestination = UDPTransmitter::Instance().AddDestination(GetForceLocalIPToUse(), _forceSourcePort ? ARTNET_PORT : 0, ipAddr.ToStdString(), ARTNET_PORT);
 
     // work out our broascast address
     wxArrayString ipc = wxSplit(ipAddr, '.');
@@ -372,6 +374,7 @@ void ArtNetOutput::Close() {
         delete _datagram;
         _datagram = nullptr;
     }
+    _udpDestination = -1;
 }
 #pragma endregion
 
@@ -398,7 +401,9 @@ void ArtNetOutput::EndFrame(int suppressFrames) {
 
     if (_changed || NeedToOutput(suppressFrames)) {
         _data[12] = _sequenceNum;
-        _datagram->SendTo(_remoteAddr, _data, ARTNET_PACKET_LEN - (512 - _channels));
+        if (!UDPTransmitter::Instance().Queue(_udpDestination, _data, ARTNET_PACKET_LEN - (512 - _channels))) {
+            _datagram->SendTo(_remoteAddr, _data, ARTNET_PACKET_LEN - (512 - _channels));
+        }
         _sequenceNum = _sequenceNum == 255 ? 0 : _sequenceNum + 1;
         FrameOutput();
         _changed = false;
@@ -39,6 +39,7 @@ class ArtNetOutput : public IPOutput
     uint8_t _sequenceNum = 0;
     wxIPV4address _remoteAddr;
     wxDatagramSocket* _datagram = nullptr;
+    int _udpDestination = -1; // see UDPTransmitter
     bool _forceSourcePort = false;
 
     // These are used for artnet sync
@@ -431,12 +431,18 @@ Output* Controller::GetOutput(int32_t absoluteChannel, int32_t& startChannel) co
 
 void Controller::DeleteAllOutputs() {
 
+    OutputsChanged();
     while (_outputs.size() > 0) {
         delete _outputs.front();
         _outputs.pop_front();
     }
 }
 
+void Controller::OutputsChanged() const {
+
+    if (_outputManager != nullptr) _outputManager->InvalidateOutputPlan();
+}
+
 // Gets the start channel of the first output on this controller
 int32_t Controller::GetStartChannel() const {
 
@@ -1092,6 +1098,7 @@ void Controller::SetAutoSize(bool autosize, OutputModelManager* omm)
 bool Controller::SetChannelSize(int32_t channels, std::list<Model*> models, uint32_t universeSize)
 {
     if (_outputs.size() == 0) return false;
+    OutputsChanged();
 
     for (auto& it2 : GetOutputs()) {
         it2->AllOff();
@@ -105,6 +105,8 @@ public:
     Output* GetFirstOutput() const { wxASSERT(_outputs.size() > 0); return _outputs.front(); }
 
     void DeleteAllOutputs();
+    // the output manager sends frames from a plan of the outputs, call this before they are added, removed or changed
+    void OutputsChanged() const;
 
     int32_t GetStartChannel() const;
     int32_t GetEndChannel() const;
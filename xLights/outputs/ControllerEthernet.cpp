@@ -208,6 +208,7 @@ void ControllerEthernet::SetIP(const std::string& ip) {
 
     auto const& iip = ip_utils::CleanupIP(ip);
     if (_ip != iip) {
+        OutputsChanged();
         _ip = iip;
         if (IsActive()) _resolvedIp = ip_utils::ResolveIP(_ip);
         _dirty = true;
@@ -240,6 +241,7 @@ std::string ControllerEthernet::GetResolvedIP(bool forceResolve) const {
 
 void ControllerEthernet::SetProtocol(const std::string& protocol) {
 
+    OutputsChanged();
     int totchannels = GetChannels();
     auto const oldtype = _type;
     auto oldoutputs = _outputs;
@@ -395,6 +397,7 @@ std::string ControllerEthernet::GetControllerForceLocalIP() const
 void ControllerEthernet::SetForceLocalIP(const std::string& localIP)
 {
     if (_forceLocalIP != localIP) {
+        OutputsChanged();
         _forceLocalIP = localIP;
         _dirty = true;
         for (auto& it : _outputs) {
@@ -405,6 +408,7 @@ void ControllerEthernet::SetForceLocalIP(const std::string& localIP)
 
 void ControllerEthernet::SetGlobalForceLocalIP(const std::string& localIP)
 {
+    OutputsChanged();
     for (const auto& it : _outputs) {
         it->SetGlobalForceLocalIP(localIP);
     }
@@ -788,6 +792,7 @@ bool ControllerEthernet::SupportsUpload() const {
 bool ControllerEthernet::SetChannelSize(int32_t channels, std::list<Model*> models, uint32_t universeSize)
 {
     if (_outputs.size() == 0) return false;
+    OutputsChanged();
 
     for (auto& it2 : GetOutputs()) {
         it2->AllOff();
@@ -1182,6 +1187,7 @@ bool ControllerEthernet::HandlePropertyEvent(wxPropertyGridEvent& event, OutputM
         outputModelManager->AddLayoutTabWork(OutputModelManager::WORK_CALCULATE_START_CHANNELS, "ControllerEthernet::HandlePropertyEvent::Universe", nullptr);
         return true;
     } else if (name == "Universes") {
+        OutputsChanged();
         // add universes
         while (_outputs.size() < event.GetValue().GetLong()) {
             AddOutput();
@@ -1389,6 +1395,7 @@ void ControllerEthernet::ValidateProperties(OutputManager* om, wxPropertyGrid* p
 
 void ControllerEthernet::AddOutput()
 {
+    OutputsChanged();
 	if (_type == OUTPUT_E131) {
 		_outputs.push_back(new E131Output());
 	}
@@ -1425,6 +1432,7 @@ void ControllerEthernet::SetAllSameSize(bool allSame, OutputModelManager* omm)
         _forceSizes = !allSame;
 
         if (allSame) {
+            OutputsChanged();
             for (auto& it : _outputs) {
                 it->SetChannels(_outputs.front()->GetChannels());
             }
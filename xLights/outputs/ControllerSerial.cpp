@@ -304,6 +304,7 @@ void ControllerSerial::SetFPPProxy(const std::string& proxy) {
 void ControllerSerial::VMVChanged(wxPropertyGrid *grid) {
     if (_model == "FPP") {
         if (GetFirstOutput()->GetType() != "DDP") {
+            OutputsChanged();
             if (_serialOutput && GetFirstOutput() != _serialOutput) delete _serialOutput;
             _serialOutput = dynamic_cast<SerialOutput *>(_outputs.front());
             int sc = _serialOutput->GetStartChannel();
@@ -334,6 +335,7 @@ void ControllerSerial::VMVChanged(wxPropertyGrid *grid) {
 void ControllerSerial::SetPort(const std::string& port) {
     if (_serialOutput) {
         if (_port != port) {
+            OutputsChanged();
             if (_model != "FPP") {
                 _serialOutput->SetCommPort(port);
             } else {
@@ -389,6 +391,7 @@ void ControllerSerial::SetPostfix(const std::string& postfix)
 void ControllerSerial::SetChannels(int channels) {
     if (_outputs.front() != nullptr) {
         if (_outputs.front()->GetChannels() != channels) {
+            OutputsChanged();
             _outputs.front()->SetChannels(channels);
             if (_serialOutput) {
                 _serialOutput->SetChannels(channels);
@@ -406,6 +409,7 @@ void ControllerSerial::SetProtocol(const std::string& type)
         return;
     }
 
+    OutputsChanged();
     auto const c = _serialOutput->GetChannels();
     _type = type;
     _dirty = true;
@@ -17,6 +17,7 @@
 
 #include "DDPOutput.h"
 #include "OutputManager.h"
+#include "UDPTransmitter.h"
 #include "../UtilFunctions.h"
 #include "../OutputModelManager.h"
 #include "ControllerEthernet.h"
@@ -456,6 +457,7 @@ bool DDPOutput::Open() {
 
     _remoteAddr.Hostname(_ip.c_str());
     _remoteAddr.Service(DDP_PORT);
+    _udpDestination = UDPTransmitter::Instance().AddDestination(GetForceLocalIP(), 0, _remoteAddr.IPAddress().ToStdString(), DDP_PORT);
 
     return _ok;
 }
@@ -470,6 +472,7 @@ void DDPOutput::Close() {
         free(_fulldata);
         _fulldata = nullptr;
     }
+    _udpDestination = -1;
     IPOutput::Close();
 }
 #pragma endregion
@@ -534,7 +537,9 @@ void DDPOutput::EndFrame(int suppressFrames) {
 
             memcpy(&_data[10], _fulldata + index, thissend);
 
-            _datagram->SendTo(_remoteAddr, &_data[0], DDP_PACKET_LEN - (1440 - thissend));
+            if (!UDPTransmitter::Instance().Queue(_udpDestination, &_data[0], DDP_PACKET_LEN - (1440 - thissend))) {
+                _datagram->SendTo(_remoteAddr, &_data[0], DDP_PACKET_LEN - (1440 - thissend));
+            }
             _sequenceNum = _sequenceNum == 15 ? 1 : _sequenceNum + 1;
 
             tosend -= thissend;
@@ -54,6 +54,7 @@ class DDPOutput : public IPOutput
     uint8_t _sequenceNum;
     wxIPV4address _remoteAddr;
     wxDatagramSocket *_datagram;
+    int _udpDestination = -1; // see UDPTransmitter
     uint8_t* _fulldata;
     int _channelsPerPacket;
     bool _keepChannelNumbers;
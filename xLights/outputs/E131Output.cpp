@@ -11,6 +11,7 @@
 
 #include "E131Output.h"
 #include "OutputManager.h"
+#include "UDPTransmitter.h"
 #include "../UtilFunctions.h"
 #include "../utils/ip_utils.h"
 #include "ControllerEthernet.h"
@@ -369,6 +370,7 @@ bool E131Output::Open() {
         _remoteAddr.Hostname(_ip.c_str());
     }
     _remoteAddr.Service(E131_PORT);
+    _udpDestination = UDPTransmitter::Instance().AddDestination(GetForceLocalIPToUse(), 0, _remoteAddr.IPAddress().ToStdString(), E131_PORT);
 
     uint8_t NumHi = (_channels + 1) >> 8;   // Channels (high)
     uint8_t NumLo = (_channels + 1) & 0xff; // Channels (low)
@@ -404,6 +406,7 @@ void E131Output::Close() {
         delete _datagram;
         _datagram = nullptr;
     }
+    _udpDestination = -1;
     IPOutput::Close();
 }
 #pragma endregion 
@@ -445,7 +448,9 @@ void E131Output::EndFrame(int suppressFrames) {
 
     if (_changed || NeedToOutput(suppressFrames)) {
         _data[111] = _sequenceNum;
-        _datagram->SendTo(_remoteAddr, _data, E131_PACKET_LEN - (512 - _channels));
+        if (!UDPTransmitter::Instance().Queue(_udpDestination, _data, E131_PACKET_LEN - (512 - _channels))) {
+            _datagram->SendTo(_remoteAddr, _data, E131_PACKET_LEN - (512 - _channels));
+        }
         _sequenceNum = _sequenceNum == 255 ? 0 : _sequenceNum + 1;
         FrameOutput();
     }
@@ -34,6 +34,7 @@ class E131Output : public IPOutput
     uint8_t _priority = E131_DEFAULT_PRIORITY;
     wxIPV4address _remoteAddr;
     wxDatagramSocket *_datagram = nullptr;
+    int _udpDestination = -1; // see UDPTransmitter
 
     // Deprecated properties only accessed for conversion
     int _numUniverses_CONVERT = 1;
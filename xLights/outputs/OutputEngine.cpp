@@ -0,0 +1,251 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "OutputEngine.h"
+#include "OutputManager.h"
+
+#ifdef __WXMSW__
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <log4cpp/Category.hh>
+
+// frames sent more than this after their deadline are counted as late
+#define LATE_FRAME_MS 2
+// how long the last frame is sent again for once the producer stops completing frames
+#define REPEAT_MS 1000
+// each frame the deadline moves this fraction of the way to half a frame after the newest frame was completed
+#define PHASE_GAIN 8
+
+OutputEngine::OutputEngine(OutputManager* outputManager, size_t channels, int frameMS) :
+    _outputManager(outputManager), _frameMS(std::max(1, frameMS)) {
+
+    for (auto& it : _buffers) {
+        it.resize(channels);
+    }
+    _thread = std::thread(&OutputEngine::Run, this);
+}
+
+OutputEngine::~OutputEngine() {
+
+    Stop();
+}
+
+void OutputEngine::Stop() {
+
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _stop = true;
+    }
+    _signal.notify_all();
+    if (!_thread.joinable()) return;
+    _thread.join();
+
+    // a frame produced just before stopping such as the one AllOff sends as output is turned off still goes out
+    std::unique_lock<std::mutex> lock(_lock);
+    if (_newFrame) {
+        _newFrame = false;
+        _outputManager->DoStartFrame(_msec[_ready]);
+        _outputManager->DoSetManyChannels(0, _buffers[_ready].data(), _buffers[_ready].size());
+        _outputManager->DoEndFrame();
+        _stats.framesSent++;
+    }
+}
+
+void OutputEngine::Hold() {
+
+    std::unique_lock<std::mutex> lock(_lock);
+    _held = true;
+    _resize = true;
+    _sent.wait(lock, [this]() { return !_sending; });
+}
+
+void OutputEngine::SetFrameMS(int frameMS) {
+
+    _frameMS = std::max(1, frameMS);
+}
+
+#pragma region Producer
+// lock must hold _lock
+void OutputEngine::OpenFrame(std::unique_lock<std::mutex>& lock) {
+
+    if (_frameOpen) return;
+    _frameOpen = true;
+
+    if (_resize) {
+        // the outputs have been changed, the thread only uses the front buffer without the lock while sending
+        _sent.wait(lock, [this]() { return !_sending; });
+        _resize = false;
+        size_t channels = (size_t)std::max(0, (int)_outputManager->GetTotalChannels());
+        for (auto& it : _buffers) {
+            it.resize(channels);
+        }
+    }
+
+    // continue from the newest frame the producer completed
+    auto& back = _buffers[_back];
+    if (_newFrame) {
+        memcpy(back.data(), _buffers[_ready].data(), back.size());
+    } else if (_haveFrame) {
+        memcpy(back.data(), _buffers[_front].data(), back.size());
+    } else {
+        memset(back.data(), 0x00, back.size());
+    }
+}
+
+void OutputEngine::StartFrame(long msec) {
+
+    std::unique_lock<std::mutex> lock(_lock);
+    OpenFrame(lock);
+    _msec[_back] = msec;
+}
+
+void OutputEngine::SetOneChannel(int32_t channel, uint8_t data) {
+
+    std::unique_lock<std::mutex> lock(_lock);
+    OpenFrame(lock);
+    auto& back = _buffers[_back];
+    if (channel >= 0 && (size_t)channel < back.size()) {
+        back[channel] = data;
+    }
+}
+
+void OutputEngine::SetManyChannels(int32_t channel, const uint8_t* data, size_t size) {
+
+    std::unique_lock<std::mutex> lock(_lock);
+    OpenFrame(lock);
+    auto& back = _buffers[_back];
+    if (channel < 0 || (size_t)channel >= back.size()) return;
+    memcpy(&back[channel], data, std::min(size, back.size() - channel));
+}
+
+void OutputEngine::AllOff(bool send) {
+
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        OpenFrame(lock);
+        memset(_buffers[_back].data(), 0x00, _buffers[_back].size());
+    }
+    if (send) {
+        EndFrame();
+    }
+}
+
+void OutputEngine::EndFrame() {
+
+    std::unique_lock<std::mutex> lock(_lock);
+    if (!_frameOpen) return;
+    _frameOpen = false;
+
+    _produced[_back] = std::chrono::steady_clock::now();
+    std::swap(_back, _ready);
+    if (_newFrame) {
+        _stats.framesDropped++;
+    }
+    _newFrame = true;
+    _haveFrame = true;
+    // the outputs the producer was changing are done with
+    _held = false;
+    _stats.framesProduced++;
+}
+#pragma endregion
+
+OutputEngine::Stats OutputEngine::GetStats() const {
+
+    std::unique_lock<std::mutex> lock(_lock);
+    return _stats;
+}
+
+void OutputEngine::Run() {
+
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+#ifdef __WXMSW__
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+#elif defined(__linux__)
+    // only works with the privilege to do so, otherwise the thread just runs at normal priority
+    sched_param param;
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+        logger_base.debug("Output engine running at normal priority.");
+    }
+#endif
+    logger_base.debug("Output engine started at %dms per frame.", (int)_frameMS);
+
+    auto deadline = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(_lock);
+    while (!_stop) {
+        _signal.wait_until(lock, deadline, [this]() { return _stop; });
+        if (_stop) break;
+
+        auto frame = std::chrono::milliseconds(_frameMS);
+        auto now = std::chrono::steady_clock::now();
+        if (now - deadline >= frame) {
+            // we fell more than a frame behind so skip the deadlines that have already passed
+            auto missed = (now - deadline) / frame;
+            _stats.missedDeadlines += (uint32_t)missed;
+            deadline += missed * frame;
+        }
+
+        if (_held || !_haveFrame) {
+            deadline += frame;
+            continue;
+        }
+        bool newFrame = _newFrame;
+        if (newFrame) {
+            std::swap(_front, _ready);
+            _newFrame = false;
+        } else if (now - _produced[_front] < std::chrono::milliseconds(REPEAT_MS)) {
+            _stats.framesRepeated++;
+        } else {
+            // the producer has stopped, its last frame has been sent for long enough
+            deadline += frame;
+            continue;
+        }
+        const int front = _front;
+        // repeated frames carry on the producer's clock
+        long msec = _msec[front] + std::chrono::duration_cast<std::chrono::milliseconds>(now - _produced[front]).count();
+        // measured against the deadline the frame was due at, not the one it is moved to below
+        double late = std::chrono::duration<double, std::milli>(now - deadline).count();
+
+        if (newFrame) {
+            // keep the deadlines half a frame after the producer completes its frames
+            std::chrono::steady_clock::duration half = frame / 2;
+            std::chrono::steady_clock::duration limit = frame / PHASE_GAIN;
+            auto step = (deadline - _produced[front] - half) / PHASE_GAIN;
+            deadline -= std::clamp(step, -limit, limit);
+        }
+
+        _sending = true;
+        lock.unlock();
+        _outputManager->DoStartFrame(msec);
+        _outputManager->DoSetManyChannels(0, _buffers[front].data(), _buffers[front].size());
+        _outputManager->DoEndFrame();
+        lock.lock();
+        _sending = false;
+        _sent.notify_all();
+
+        _stats.framesSent++;
+        _stats.averageLatenessMS += (late - _stats.averageLatenessMS) / _stats.framesSent;
+        _stats.maxLatenessMS = std::max(_stats.maxLatenessMS, late);
+        if (late > LATE_FRAME_MS) {
+            _stats.lateFrames++;
+        }
+        deadline += frame;
+    }
+
+    logger_base.debug("Output engine stopped.");
+}
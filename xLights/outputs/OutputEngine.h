@@ -0,0 +1,104 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class OutputManager;
+
+/**
+ * Sends the output manager's frames from a thread of its own at fixed frame deadlines.
+ *
+ * The thread that produces the frames (the UI thread in xLights and xSchedule) fills one
+ * buffer while the engine sends another, a third holds the newest complete frame so neither
+ * side waits on the other.  If no new frame is ready at a deadline the previous one is sent
+ * again, for up to REPEAT_MS after the producer's last frame, and if the producer completes
+ * two frames between deadlines only the newer is sent.
+ *
+ * The deadlines follow the producer's timer, they are moved a little each frame towards half
+ * a frame after the frames are completed so the producer can be early or late by almost half
+ * a frame without a frame being repeated or dropped.
+ */
+class OutputEngine
+{
+public:
+    struct Stats {
+        uint32_t framesProduced = 0;
+        uint32_t framesSent = 0;
+        uint32_t framesDropped = 0;   // replaced by a newer frame before they were sent
+        uint32_t framesRepeated = 0;  // deadlines where no new frame was ready
+        uint32_t lateFrames = 0;      // sent more than LATE_FRAME_MS after their deadline
+        uint32_t missedDeadlines = 0; // deadlines that passed without any frame being sent
+        double averageLatenessMS = 0;
+        double maxLatenessMS = 0;
+    };
+
+    OutputEngine(OutputManager* outputManager, size_t channels, int frameMS);
+    ~OutputEngine();
+
+    void SetFrameMS(int frameMS);
+    int GetFrameMS() const { return _frameMS; }
+
+    // the frame being produced starts as a copy of the previous one just as the outputs keep their data between frames
+    void StartFrame(long msec);
+    void SetOneChannel(int32_t channel, uint8_t data);
+    void SetManyChannels(int32_t channel, const uint8_t* data, size_t size);
+    void AllOff(bool send);
+    // the frame is sent at the next deadline
+    void EndFrame();
+
+    // waits for the frame being sent and sends any frame still waiting, nothing is sent after this returns
+    void Stop();
+
+    // waits for the frame being sent and sends nothing more until the producer's next EndFrame,
+    // called before the outputs are changed on the producer's thread.  The next frame the producer
+    // starts resizes the buffers to the output manager's channels as they are then
+    void Hold();
+
+    Stats GetStats() const;
+
+    OutputEngine(const OutputEngine&) = delete;
+    OutputEngine& operator=(const OutputEngine&) = delete;
+
+private:
+    void Run();
+    void OpenFrame(std::unique_lock<std::mutex>& lock);
+
+    OutputManager* _outputManager = nullptr;
+    std::atomic_int _frameMS;
+    std::thread _thread;
+    mutable std::mutex _lock;
+    std::condition_variable _signal;
+    std::condition_variable _sent;
+    bool _stop = false;
+    bool _held = false;     // see Hold
+    bool _resize = false;   // the channel count may have changed since the buffers were sized
+    bool _sending = false;  // the thread is sending a frame without holding _lock
+
+    // the producer writes _buffers[_back], _buffers[_ready] is the newest complete frame and the
+    // thread sends _buffers[_front].  The indexes are only swapped while holding _lock.
+    std::vector<uint8_t> _buffers[3];
+    int _back = 0;
+    int _ready = 1;
+    int _front = 2;
+    bool _frameOpen = false;  // the producer has started writing _back
+    bool _newFrame = false;   // _ready holds a frame not sent yet
+    bool _haveFrame = false;  // a frame has been produced since the engine started
+    long _msec[3] = { 0, 0, 0 };
+    std::chrono::steady_clock::time_point _produced[3];
+    Stats _stats;
+};
@@ -27,9 +27,12 @@
 #include "xxxEthernetOutput.h"
 #include "OPCOutput.h"
 #include "TestPreset.h"
+#include "OutputEngine.h"
+#include "UDPTransmitter.h"
 #include "../Parallel.h"
 #include "../UtilFunctions.h"
 
+#include <algorithm>
 #include <numeric>
 
 #include <log4cpp/Category.hh>
@@ -131,6 +134,100 @@ void OutputManager::AsyncPingAll() {
 
     std::for_each(begin(_controllers), end(_controllers), [](Controller* c) { c->AsyncPing(); });
 }
+
+std::shared_ptr<const OutputManager::OutputPlan> OutputManager::GetOutputPlan() const {
+
+    auto plan = std::atomic_load(&_plan);
+    if (plan != nullptr) return plan;
+
+    auto p = std::make_shared<OutputPlan>();
+    for (const auto& it : _controllers) {
+        for (const auto& it2 : it->GetOutputs()) {
+            p->outputs.push_back(it2);
+        }
+    }
+
+    std::vector<size_t> byChannel;
+    for (size_t i = 0; i < p->outputs.size(); i++) {
+        if (p->outputs[i]->GetChannels() > 0) byChannel.push_back(i);
+    }
+    std::stable_sort(begin(byChannel), end(byChannel), [&p](size_t a, size_t b) { return p->outputs[a]->GetStartChannel() < p->outputs[b]->GetStartChannel(); });
+    for (const auto& it : byChannel) {
+        if (!p->ends.empty() && p->outputs[it]->GetStartChannel() <= p->ends.back()) {
+            p->channelsOverlap = true;
+        }
+        p->starts.push_back(p->outputs[it]->GetStartChannel());
+        p->ends.push_back(p->outputs[it]->GetEndChannel());
+        p->startOutputs.push_back(it);
+    }
+
+    // outputs sending to the same place from the same local ip are sent one after the other by one thread
+    std::map<std::string, std::vector<Output*>> groups;
+    std::vector<std::string> groupOrder;
+    for (const auto& it : p->outputs) {
+        std::string key = it->IsIpOutput() ? it->GetResolvedIP() + "|" + it->GetIP() + "|" + it->GetForceLocalIPToUse() : it->GetCommPort();
+        auto& g = groups[key];
+        if (g.empty()) groupOrder.push_back(key);
+        g.push_back(it);
+    }
+    for (const auto& it : groupOrder) {
+        p->groupStarts.push_back(p->sendOrder.size());
+        p->sendOrder.insert(end(p->sendOrder), begin(groups[it]), end(groups[it]));
+    }
+    p->groupStarts.push_back(p->sendOrder.size());
+
+    for (const auto& it : _controllers) {
+        auto e = dynamic_cast<ControllerEthernet*>(it);
+        if (e == nullptr || it->GetOutputCount() == 0) continue;
+        std::vector<std::string>* ips = nullptr;
+        auto type = e->GetFirstOutput()->GetType();
+        if (type == OUTPUT_E131) ips = &p->e131SyncIPs;
+        else if (type == OUTPUT_ARTNET) ips = &p->artnetSyncIPs;
+        else if (type == OUTPUT_DDP) ips = &p->ddpSyncIPs;
+        else if (type == OUTPUT_ZCPP) ips = &p->zcppSyncIPs;
+        if (ips != nullptr) {
+            auto fip = e->GetForceLocalIP();
+            if (std::find(begin(*ips), end(*ips), fip) == end(*ips))
+                ips->push_back(fip);
+        }
+    }
+
+    plan = p;
+    std::atomic_store(&_plan, plan);
+    return plan;
+}
+
+void OutputManager::InvalidateOutputPlan() const {
+
+    // the outputs are about to change, the engine sends nothing until the next frame is produced
+    auto engine = std::atomic_load(&_engine);
+    if (engine != nullptr) {
+        engine->Hold();
+    }
+    std::atomic_store(&_plan, std::shared_ptr<const OutputPlan>());
+}
+
+bool OutputManager::OutputPlan::FindOutput(int32_t absoluteChannel, size_t& index, int32_t& startChannel) const {
+
+    if (channelsOverlap) {
+        for (size_t i = 0; i < outputs.size(); i++) {
+            if (absoluteChannel >= outputs[i]->GetStartChannel() && absoluteChannel <= outputs[i]->GetEndChannel()) {
+                index = i;
+                startChannel = absoluteChannel - outputs[i]->GetStartChannel() + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto it = std::upper_bound(begin(starts), end(starts), absoluteChannel);
+    if (it == begin(starts)) return false;
+    size_t i = std::distance(begin(starts), it) - 1;
+    if (absoluteChannel > ends[i]) return false;
+    index = startOutputs[i];
+    startChannel = absoluteChannel - starts[i] + 1;
+    return true;
+}
 #pragma endregion
 
 #pragma region Constructors and Destructors
@@ -280,6 +377,9 @@ bool OutputManager::Load(const std::string& showdir, bool syncEnabled) {
             else if (e->GetName() == "suppressframes") {
                 _suppressFrames = wxAtoi(e->GetAttribute("frames"));
             }
+            else if (e->GetName() == "udppacing") {
+                _udpPacingMS = wxAtoi(e->GetAttribute("ms"));
+            }
             else if (e->GetName() == "testpreset") {
                 logger_base.debug("Loading test presets.");
                 TestPreset* tp = new TestPreset(e);
@@ -418,6 +518,12 @@ bool OutputManager::Save() {
         root->AddChild(newNode);
     }
 
+    if (_udpPacingMS != 0) {
+        wxXmlNode* newNode = new wxXmlNode(wxXmlNodeType::wxXML_ELEMENT_NODE, "udppacing");
+        newNode->AddAttribute("ms", wxString::Format("%d", _udpPacingMS));
+        root->AddChild(newNode);
+    }
+
     for (const auto& it : _controllers) {
         root->AddChild(it->Save());
     }
@@ -545,11 +651,13 @@ void OutputManager::AddController(Controller* controller, int pos)
         std::advance(it, pos);
         _controllers.insert(it, controller);
     }
+    InvalidateOutputPlan();
     UpdateUnmanaged();
 }
 
 void OutputManager::DeleteController(const std::string& controllerName) {
 
+    InvalidateOutputPlan();
     for (auto it = begin(_controllers); it != end(_controllers); ++it) {
         if ((*it)->GetName() == controllerName) {
             delete* it;
@@ -562,6 +670,7 @@ void OutputManager::DeleteController(const std::string& controllerName) {
 
 void OutputManager::DeleteAllControllers() {
 
+    InvalidateOutputPlan();
     while (_controllers.size() > 0) {
         delete _controllers.front();
         _controllers.pop_front();
@@ -598,6 +707,7 @@ void OutputManager::MoveController(Controller* controller, int toControllerNumbe
     }
 
     _controllers = res;
+    InvalidateOutputPlan();
     SomethingChanged();
 }
 
@@ -966,12 +1076,24 @@ void OutputManager::SetGlobalForceLocalIP(const std::string& forceLocalIP)
     if (_globalForceLocalIP != forceLocalIP) {
         _globalForceLocalIP = forceLocalIP;
         _dirty = true;
+        InvalidateOutputPlan();
         for (const auto& it : _controllers) {
             it->SetGlobalFPPProxy(forceLocalIP);
         }
     }
 }
 
+void OutputManager::SetUDPPacingMS(int pacingMS)
+{
+    if (_udpPacingMS != pacingMS) {
+        _udpPacingMS = pacingMS;
+        _dirty = true;
+        if (_outputting) {
+            UDPTransmitter::Instance().SetPacingMS(pacingMS);
+        }
+    }
+}
+
 void OutputManager::SetShowDir(const std::string& showDir) {
 
     wxFileName fn(showDir + GetPathSeparator() + GetNetworksFileName());
@@ -1070,6 +1192,7 @@ void OutputManager::SomethingChanged() const {
     for (auto& it : _controllers) {
         it->SetTransientData(start, nullcnt);
     }
+    InvalidateOutputPlan();
 }
 
 bool OutputManager::IsDirty() const {
@@ -1152,6 +1275,11 @@ bool OutputManager::StartOutput() {
 
     logger_base.debug("Starting light output.");
 
+    InvalidateOutputPlan();
+    ResetFrameStats();
+    UDPTransmitter::Instance().ResetStats();
+    UDPTransmitter::Instance().SetPacingMS(_udpPacingMS);
+
     int started = 0;
     bool ok = true;
     bool err = false;
@@ -1197,15 +1325,29 @@ void OutputManager::StopOutput() {
     static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
     if (!_outputting) return;
+
+    // the engine's thread must be done with the outputs before they are closed
+    StopOutputEngine();
+
     if (!_outputCriticalSection.TryEnter()) return;
 
     logger_base.debug("Stopping light output.");
 
+    auto stats = GetFrameStats();
+    logger_base.debug("    %u frames sent, average %.2fms, max %.2fms, max interval %.2fms.",
+        stats.frames, stats.averageSendMS, stats.maxSendMS, stats.maxIntervalMS);
+    auto udp = UDPTransmitter::Instance().GetStats();
+    if (udp.frames > 0) {
+        logger_base.debug("    %llu UDP packets, %llu bytes in %llu sendmmsg calls, %llu errors.",
+            (unsigned long long)udp.packets, (unsigned long long)udp.bytes, (unsigned long long)udp.syscalls, (unsigned long long)udp.errors);
+    }
+
     _outputting = false;
 
     for (const auto& it : GetAllOutputs()) {
         it->Close();
     }
+    UDPTransmitter::Instance().CloseSockets();
 
     SetGlobalOutputtingFlag(false);
     _outputCriticalSection.Leave();
@@ -1232,10 +1374,33 @@ bool OutputManager::TxEmpty() {
 #pragma region Frame Handling
 void OutputManager::StartFrame(long msec) {
 
+    if (!_outputting) return;
+
+    auto engine = std::atomic_load(&_engine);
+    if (engine != nullptr) {
+        engine->StartFrame(msec);
+        return;
+    }
+    DoStartFrame(msec);
+}
+
+void OutputManager::DoStartFrame(long msec) {
+
     if (!_outputting) return;
     if (!_outputCriticalSection.TryEnter()) return;
-    
-    for (const auto& it : GetAllOutputs()) {
+
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock(_frameStatsLock);
+        if (_frameStats.frames > 0) {
+            _frameStats.lastIntervalMS = std::chrono::duration<double, std::milli>(now - _lastStartFrame).count();
+            _frameStats.maxIntervalMS = std::max(_frameStats.maxIntervalMS, _frameStats.lastIntervalMS);
+        }
+        _lastStartFrame = now;
+    }
+
+    auto plan = GetOutputPlan();
+    for (const auto& it : plan->outputs) {
         it->StartFrame(msec);
     }
     _outputCriticalSection.Leave();
@@ -1246,7 +1411,8 @@ void OutputManager::ResetFrame() {
     if (!_outputting) return;
     if (!_outputCriticalSection.TryEnter()) return;
 
-    for (const auto& it : GetAllOutputs()) {
+    auto plan = GetOutputPlan();
+    for (const auto& it : plan->outputs) {
         it->ResetFrame();
     }
     _outputCriticalSection.Leave();
@@ -1254,48 +1420,112 @@ void OutputManager::ResetFrame() {
 
 void OutputManager::EndFrame() {
 
+    if (!_outputting) return;
+
+    auto engine = std::atomic_load(&_engine);
+    if (engine != nullptr) {
+        engine->EndFrame();
+        return;
+    }
+    DoEndFrame();
+}
+
+void OutputManager::DoEndFrame() {
+
     if (!_outputting) return;
     if (!_outputCriticalSection.TryEnter()) return;
 
-    auto outputs = GetAllOutputs();
-    if (_parallelTransmission) {
-        std::function<void(Output*&, int)> f = [this](Output*&o, int n) {
-            o->EndFrame(_suppressFrames);
-        };
-        parallel_for(outputs, f);
+    auto start = std::chrono::steady_clock::now();
+    auto plan = GetOutputPlan();
+    // the E1.31, ArtNet and DDP packets are collected and sent together before the sync packets
+    auto& transmitter = UDPTransmitter::Instance();
+    transmitter.StartBatch();
+    if (_parallelTransmission && plan->groupStarts.size() > 2) {
+        parallel_for(0, (int)plan->groupStarts.size() - 1, [this, &plan](int g) {
+            for (size_t i = plan->groupStarts[g]; i < plan->groupStarts[g + 1]; i++) {
+                plan->sendOrder[i]->EndFrame(_suppressFrames);
+            }
+        });
     }
     else {
-        for (const auto& it : outputs) {
+        for (const auto& it : plan->outputs) {
             it->EndFrame(_suppressFrames);
         }
     }
+    transmitter.Flush();
 
     if (IsSyncEnabled()) {
         if (_syncUniverse != 0) {
-            if (AtLeastOneOutputUsingProtocol(OUTPUT_E131)) {
-                for (const auto& it : GetForceIPs(OUTPUT_E131))
-                    E131Output::SendSync(_syncUniverse, it);
-            }
+            for (const auto& it : plan->e131SyncIPs)
+                E131Output::SendSync(_syncUniverse, it);
         }
 
-        if (AtLeastOneOutputUsingProtocol(OUTPUT_ARTNET)) {
-            for (const auto& it : GetForceIPs(OUTPUT_ARTNET))
-                ArtNetOutput::SendSync(it);
-        }
+        for (const auto& it : plan->artnetSyncIPs)
+            ArtNetOutput::SendSync(it);
 
-        if (AtLeastOneOutputUsingProtocol(OUTPUT_DDP)) {
-            for (const auto& it : GetForceIPs(OUTPUT_DDP))
-                DDPOutput::SendSync(it);
-        }
+        for (const auto& it : plan->ddpSyncIPs)
+            DDPOutput::SendSync(it);
 
-        if (AtLeastOneOutputUsingProtocol(OUTPUT_ZCPP)) {
-            for (const auto& it : GetForceIPs(OUTPUT_ZCPP))
-                ZCPPOutput::SendSync(it);
-        }
+        for (const auto& it : plan->zcppSyncIPs)
+            ZCPPOutput::SendSync(it);
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    {
+        std::unique_lock<std::mutex> lock(_frameStatsLock);
+        _frameStats.frames++;
+        _frameStats.lastSendMS = ms;
+        _frameStats.averageSendMS += (ms - _frameStats.averageSendMS) / _frameStats.frames;
+        _frameStats.maxSendMS = std::max(_frameStats.maxSendMS, ms);
     }
     _outputCriticalSection.Leave();
 }
 
+OutputManager::FrameStats OutputManager::GetFrameStats() const {
+
+    std::unique_lock<std::mutex> lock(_frameStatsLock);
+    return _frameStats;
+}
+
+void OutputManager::ResetFrameStats() {
+
+    std::unique_lock<std::mutex> lock(_frameStatsLock);
+    _frameStats = FrameStats();
+}
+
+bool OutputManager::StartOutputEngine(int frameMS) {
+
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (!_outputting || frameMS <= 0) return false;
+
+    auto engine = std::atomic_load(&_engine);
+    if (engine != nullptr) {
+        if (engine->GetFrameMS() != frameMS) {
+            logger_base.debug("Output engine frame time changed from %dms to %dms.", engine->GetFrameMS(), frameMS);
+            engine->SetFrameMS(frameMS);
+        }
+        return true;
+    }
+
+    std::atomic_store(&_engine, std::make_shared<OutputEngine>(this, (size_t)GetTotalChannels(), frameMS));
+    return true;
+}
+
+void OutputManager::StopOutputEngine() {
+
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    auto engine = std::atomic_exchange(&_engine, std::shared_ptr<OutputEngine>());
+    if (engine == nullptr) return;
+
+    engine->Stop();
+    auto stats = engine->GetStats();
+    logger_base.debug("Output engine: %u frames produced, %u sent, %u dropped, %u repeated, %u late, %u deadlines missed, lateness average %.2fms max %.2fms.",
+        stats.framesProduced, stats.framesSent, stats.framesDropped, stats.framesRepeated, stats.lateFrames, stats.missedDeadlines,
+        stats.averageLatenessMS, stats.maxLatenessMS);
+}
+
 void OutputManager::SendHeartbeat() {
 
     for (const auto& it : GetAllOutputs()) {
@@ -1308,9 +1538,17 @@ void OutputManager::SendHeartbeat() {
 // channel here is zero based
 void OutputManager::SetOneChannel(int32_t channel, unsigned char data) {
 
+    auto engine = std::atomic_load(&_engine);
+    if (engine != nullptr) {
+        engine->SetOneChannel(channel, data);
+        return;
+    }
+
+    auto plan = GetOutputPlan();
     int32_t sc = 0;
-    Output* output = GetOutput(channel + 1, sc);
-    if (output != nullptr) {
+    size_t index = 0;
+    if (plan->FindOutput(channel + 1, index, sc)) {
+        Output* output = plan->outputs[index];
         if (output->IsEnabled()) {
             output->SetOneChannel(sc - 1, data);
         }
@@ -1320,19 +1558,27 @@ void OutputManager::SetOneChannel(int32_t channel, unsigned char data) {
 // channel here is zero based
 void OutputManager::SetManyChannels(int32_t channel, unsigned char* data, size_t size) {
 
+    auto engine = std::atomic_load(&_engine);
+    if (engine != nullptr) {
+        engine->SetManyChannels(channel, data, size);
+        return;
+    }
+    DoSetManyChannels(channel, data, size);
+}
+
+void OutputManager::DoSetManyChannels(int32_t channel, unsigned char* data, size_t size) {
+
     if (size == 0) return;
 
+    auto plan = GetOutputPlan();
     int32_t stch;
-    Output* o = GetOutput(channel + 1, stch);
+    size_t index = 0;
 
     // if this doesnt map to an output then skip it
-    if (o == nullptr) return;
-
-    // get an iterator to the output which contains our first channel
-    auto outputs = GetAllOutputs();
-    auto it = outputs.begin();
-    while (*it != o && it != outputs.end()) ++it;
+    if (!plan->FindOutput(channel + 1, index, stch)) return;
 
+    const auto& outputs = plan->outputs;
+    Output* o = outputs[index];
     size_t left = size;
     while (left > 0 && o != nullptr) {
         wxASSERT(!o->IsOutputCollection_CONVERT());
@@ -1345,26 +1591,35 @@ void OutputManager::SetManyChannels(int32_t channel, unsigned char* data, size_t
         left -= send;
 
         // Move to the next output
-        ++it;
-        if (it == outputs.end()) {
+        ++index;
+        if (index == outputs.size()) {
             o = nullptr;
         }
         else {
-            o = *it;
+            o = outputs[index];
         }
     }
 }
 
 void OutputManager::AllOff(bool send) {
 
+    auto engine = std::atomic_load(&_engine);
+    if (engine != nullptr) {
+        engine->AllOff(send);
+        return;
+    }
+
     if (!_outputCriticalSection.TryEnter()) return;
 
+    auto& transmitter = UDPTransmitter::Instance();
+    if (send) transmitter.StartBatch();
     for (const auto& it : GetAllOutputs()) {
         it->AllOff();
         if (send) {
             it->EndFrame(_suppressFrames);
         }
     }
+    if (send) transmitter.Flush();
     _outputCriticalSection.Leave();
 }
 #pragma endregion 
@@ -12,8 +12,12 @@
 
 #include <wx/thread.h>
 
+#include <chrono>
+#include <cstdint>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -21,6 +25,7 @@ class wxWindow;
 class wxXmlNode;
 
 class Output;
+class OutputEngine;
 class Controller;
 class TestPreset;
 class Controller;
@@ -30,6 +35,41 @@ class ControllerEthernet;
 
 class OutputManager
 {
+public:
+    // How long the frames took to send, see GetFrameStats
+    struct FrameStats {
+        uint32_t frames = 0;
+        double lastSendMS = 0;     // time EndFrame took to send the most recent frame
+        double averageSendMS = 0;
+        double maxSendMS = 0;
+        double lastIntervalMS = 0; // time from the previous frame's StartFrame to the most recent one's
+        double maxIntervalMS = 0;
+    };
+
+private:
+    // The outputs as the frame handling uses them.  It is built from the controllers the first
+    // time it is needed after the network changes and never altered after that.  The controllers
+    // call InvalidateOutputPlan before they add, remove or change their outputs.  The plan points
+    // at the outputs themselves, so it only keeps a frame's view of the network consistent, the
+    // outputs it holds must not be deleted while a frame is being sent.  InvalidateOutputPlan
+    // holds the output engine until the next frame so the engine never sends during an edit.
+    struct OutputPlan {
+        std::vector<Output*> outputs;       // all outputs in controller order
+        std::vector<int32_t> starts;        // start channel of the outputs with channels, in channel order
+        std::vector<int32_t> ends;
+        std::vector<size_t> startOutputs;   // index in outputs of each start
+        bool channelsOverlap = false;       // if they do the outputs are searched in controller order
+        std::vector<Output*> sendOrder;     // the outputs grouped by the ip and local ip they send on
+        std::vector<size_t> groupStarts;    // where each group starts in sendOrder followed by the end
+        std::vector<std::string> e131SyncIPs; // the local ips to send each protocol's sync packets on
+        std::vector<std::string> artnetSyncIPs;
+        std::vector<std::string> ddpSyncIPs;
+        std::vector<std::string> zcppSyncIPs;
+
+        // the index in outputs of the output holding the 1 based absoluteChannel, false if there is none
+        bool FindOutput(int32_t absoluteChannel, size_t& index, int32_t& startChannel) const;
+    };
+
     #pragma region Member Variables
     std::string _filename;
     std::list<Controller*> _controllers;
@@ -39,6 +79,7 @@ class OutputManager
     bool _syncEnabled = false;
     bool _dirty = false;
     int _suppressFrames = 0;
+    int _udpPacingMS = 0;
     bool _parallelTransmission = false;
     bool _outputting = false; // true if we are currently sending out data
     bool _didConvert = false;
@@ -47,6 +88,11 @@ class OutputManager
     wxCriticalSection _outputCriticalSection; // used to protect areas that must be single threaded
     std::string _baseShowDir = "";
     bool _autoUpdateFromBaseShowDir = false;
+    mutable std::shared_ptr<const OutputPlan> _plan; // use std::atomic_load/atomic_store, frames read it on the output thread
+    std::chrono::steady_clock::time_point _lastStartFrame;
+    FrameStats _frameStats;
+    mutable std::mutex _frameStatsLock;
+    std::shared_ptr<OutputEngine> _engine; // use std::atomic_load/atomic_store, see StartOutputEngine
     #pragma endregion 
 
     #pragma region Static Variables
@@ -63,8 +109,15 @@ class OutputManager
     bool SetGlobalOutputtingFlag(bool state, bool force = false);
     bool ConvertStartChannel(const std::string sc, std::string& newsc) const;
     void AsyncPingAll();
+    std::shared_ptr<const OutputPlan> GetOutputPlan() const;
+    // the frame handling without the output engine, the engine's thread sends its frames with these
+    void DoStartFrame(long msec);
+    void DoEndFrame();
+    void DoSetManyChannels(int32_t channel, unsigned char* data, size_t size);
     #pragma endregion 
 
+    friend class OutputEngine;
+
 public:
 
     #pragma region Constructors and Destructors
@@ -145,6 +198,8 @@ public:
     Output* GetOutput_CONVERT(int outputNumber) const;
     Output* GetOutput(int32_t absoluteChannel, int32_t& startChannel) const; // returns the output ... even if it is in a collection
     Output* GetOutput(int universe, const std::string& ip) const;
+    // the plan of the outputs is built again for the next frame, see Controller::OutputsChanged
+    void InvalidateOutputPlan() const;
     #pragma endregion 
 
     #pragma region Channel Mapping
@@ -193,6 +248,9 @@ public:
 
     void SetSuppressFrames(int suppressFrames) { _suppressFrames = suppressFrames; _dirty = true; }
     int GetSuppressFrames() const { return _suppressFrames; }
+    // spreads the E1.31, ArtNet and DDP packets of each frame over this many ms, 0 sends them together
+    void SetUDPPacingMS(int pacingMS);
+    int GetUDPPacingMS() const { return _udpPacingMS; }
     
     std::string GetChannelName(int32_t channel);
 
@@ -212,6 +270,17 @@ public:
     void EndFrame();
     void ResetFrame();
     void SendHeartbeat();
+    FrameStats GetFrameStats() const;
+    void ResetFrameStats();
+
+    // Sends the frames from a thread of its own every frameMS while outputting.  While it runs
+    // StartFrame, SetOneChannel, SetManyChannels, AllOff and EndFrame fill the engine's next frame
+    // rather than the outputs and the engine sends it at the next frame deadline.  Calling it again
+    // while it runs changes the frame time.  It is stopped by StopOutput.
+    bool StartOutputEngine(int frameMS);
+    void StopOutputEngine();
+    bool IsOutputEngineRunning() const { return std::atomic_load(&_engine) != nullptr; }
+    std::shared_ptr<OutputEngine> GetOutputEngine() const { return std::atomic_load(&_engine); }
     #pragma endregion 
 
     #pragma region Packet Sync
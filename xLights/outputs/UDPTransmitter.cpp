@@ -0,0 +1,293 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "UDPTransmitter.h"
+
+#include <log4cpp/Category.hh>
+
+// the most messages one sendmmsg call accepts
+#define MAX_MESSAGES_PER_CALL 1024
+// with pacing on, a batch is not split into slices of fewer packets than this
+#define MIN_PACKETS_PER_SLICE 16
+
+UDPTransmitter& UDPTransmitter::Instance() {
+
+    static UDPTransmitter transmitter;
+    return transmitter;
+}
+
+bool UDPTransmitter::IsAvailable() {
+
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+UDPTransmitter::UDPTransmitter() : _enabled(IsAvailable()) {
+}
+
+UDPTransmitter::~UDPTransmitter() {
+
+    CloseSockets();
+}
+
+void UDPTransmitter::CloseSockets() {
+
+    std::unique_lock<std::mutex> lock(_lock);
+#ifdef __linux__
+    for (const auto& it : _sockets) {
+        if (it.fd >= 0) close(it.fd);
+    }
+#endif
+    _sockets.clear();
+    // the destinations refer to the sockets
+    _destinations.clear();
+    _packets.clear();
+    _batching = false;
+}
+
+int UDPTransmitter::OpenSocket(const std::string& localIP, int localPort) {
+
+#ifdef __linux__
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    for (size_t i = 0; i < _sockets.size(); i++) {
+        if (_sockets[i].localIP == localIP && _sockets[i].localPort == localPort) return i;
+    }
+
+    sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(localPort);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (localIP != "" && inet_pton(AF_INET, localIP.c_str(), &local.sin_addr) != 1) {
+        logger_base.error("UDPTransmitter: Invalid local ip %s.", (const char*)localIP.c_str());
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        logger_base.error("UDPTransmitter: Error creating socket for %s => %d : %s.", (const char*)localIP.c_str(), errno, strerror(errno));
+        return -1;
+    }
+    if (localPort != 0) {
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+    if (bind(fd, (sockaddr*)&local, sizeof(local)) < 0) {
+        logger_base.error("UDPTransmitter: Error binding socket to %s:%d => %d : %s.", (const char*)localIP.c_str(), localPort, errno, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    Socket s;
+    s.localIP = localIP;
+    s.localPort = localPort;
+    s.fd = fd;
+    _sockets.push_back(s);
+    return _sockets.size() - 1;
+#else
+    return -1;
+#endif
+}
+
+int UDPTransmitter::AddDestination(const std::string& localIP, int localPort, const std::string& ip, int port) {
+
+#ifdef __linux__
+    std::unique_lock<std::mutex> lock(_lock);
+
+    in_addr addr;
+    if (inet_pton(AF_INET, ip.c_str(), &addr) != 1) return -1;
+
+    int socket = OpenSocket(localIP, localPort);
+    if (socket < 0) return -1;
+
+    // outputs are opened each time output starts, they get the destination they had before
+    for (size_t i = 0; i < _destinations.size(); i++) {
+        const auto& d = _destinations[i];
+        if (d.socket == (size_t)socket && d.ip == ip && d.port == port) return i;
+    }
+
+    Destination d;
+    d.socket = socket;
+    d.ip = ip;
+    d.port = port;
+    d.addr = addr.s_addr;
+    _destinations.push_back(d);
+    return _destinations.size() - 1;
+#else
+    return -1;
+#endif
+}
+
+void UDPTransmitter::StartBatch() {
+
+    if (!_enabled) return;
+
+    std::unique_lock<std::mutex> lock(_lock);
+    _data.clear();
+    _packets.clear();
+    _batching = true;
+}
+
+bool UDPTransmitter::Queue(int destination, const uint8_t* data, size_t len) {
+
+    if (!_batching || destination < 0) return false;
+
+    std::unique_lock<std::mutex> lock(_lock);
+    if (!_batching || destination >= (int)_destinations.size()) return false;
+    Packet p;
+    p.destination = destination;
+    p.offset = _data.size();
+    p.len = len;
+    _data.insert(_data.end(), data, data + len);
+    _packets.push_back(p);
+    return true;
+}
+
+void UDPTransmitter::Flush() {
+
+    if (!_batching) return;
+
+    std::unique_lock<std::mutex> lock(_lock);
+    _batching = false;
+
+    _stats.frames++;
+    _stats.framePackets = 0;
+    _stats.frameBytes = 0;
+    _stats.frameSyscalls = 0;
+    if (_packets.empty()) return;
+
+    int pacingMS = _pacingMS;
+    size_t slices = 1;
+    if (pacingMS > 0) {
+        slices = std::max((size_t)1, std::min(_packets.size() / MIN_PACKETS_PER_SLICE, (size_t)pacingMS));
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (size_t s = 0; s < slices; s++) {
+        if (s > 0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(pacingMS * 1000 * s / slices));
+        }
+        Send(_packets.size() * s / slices, _packets.size() * (s + 1) / slices);
+    }
+}
+
+void UDPTransmitter::LogSendError(const std::string& ip, int error) {
+
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    _stats.errors++;
+    auto now = std::chrono::steady_clock::now();
+    if (_stats.errors > 1 && now - _lastErrorLogged < std::chrono::seconds(1)) {
+        _errorsNotLogged++;
+        return;
+    }
+    if (_errorsNotLogged > 0) {
+        logger_base.warn("UDPTransmitter: sendmmsg failed to %s => %d : %s, %llu more errors since the last one logged.",
+            (const char*)ip.c_str(), error, strerror(error), (unsigned long long)_errorsNotLogged);
+    } else {
+        logger_base.warn("UDPTransmitter: sendmmsg failed to %s => %d : %s.", (const char*)ip.c_str(), error, strerror(error));
+    }
+    _lastErrorLogged = now;
+    _errorsNotLogged = 0;
+}
+
+void UDPTransmitter::Send(size_t firstPacket, size_t lastPacket) {
+
+#ifdef __linux__
+    // only used under _lock so they can be kept between batches
+    static std::vector<mmsghdr> msgs;
+    static std::vector<iovec> iovecs;
+    static std::vector<sockaddr_in> addrs;
+
+    // packets for each socket are sent in the order they were queued so each destination gets them in order
+    _sendOrder.clear();
+    for (size_t i = firstPacket; i < lastPacket; i++) {
+        _sendOrder.push_back(i);
+    }
+    std::stable_sort(_sendOrder.begin(), _sendOrder.end(), [this](size_t a, size_t b) {
+        return _destinations[_packets[a].destination].socket < _destinations[_packets[b].destination].socket;
+    });
+
+    msgs.resize(_sendOrder.size());
+    iovecs.resize(_sendOrder.size());
+    addrs.resize(_sendOrder.size());
+    for (size_t i = 0; i < _sendOrder.size(); i++) {
+        const Packet& p = _packets[_sendOrder[i]];
+        const Destination& d = _destinations[p.destination];
+        memset(&addrs[i], 0, sizeof(sockaddr_in));
+        addrs[i].sin_family = AF_INET;
+        addrs[i].sin_port = htons(d.port);
+        addrs[i].sin_addr.s_addr = d.addr;
+        iovecs[i].iov_base = &_data[p.offset];
+        iovecs[i].iov_len = p.len;
+        memset(&msgs[i], 0, sizeof(mmsghdr));
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t i = 0;
+    while (i < _sendOrder.size()) {
+        size_t socket = _destinations[_packets[_sendOrder[i]].destination].socket;
+        size_t end = i;
+        while (end < _sendOrder.size() && end - i < MAX_MESSAGES_PER_CALL && _destinations[_packets[_sendOrder[end]].destination].socket == socket) {
+            end++;
+        }
+        int sent = sendmmsg(_sockets[socket].fd, &msgs[i], end - i, 0);
+        _stats.syscalls++;
+        _stats.frameSyscalls++;
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) {
+            // skip the packet the kernel would not take and carry on with the rest
+            LogSendError(_destinations[_packets[_sendOrder[i]].destination].ip, errno);
+            sent = 1;
+        }
+        else {
+            for (int m = 0; m < sent; m++) {
+                _stats.packets++;
+                _stats.bytes += iovecs[i + m].iov_len;
+                _stats.framePackets++;
+                _stats.frameBytes += iovecs[i + m].iov_len;
+            }
+        }
+        i += sent;
+    }
+#endif
+}
+
+UDPTransmitter::Stats UDPTransmitter::GetStats() const {
+
+    std::unique_lock<std::mutex> lock(_lock);
+    return _stats;
+}
+
+void UDPTransmitter::ResetStats() {
+
+    std::unique_lock<std::mutex> lock(_lock);
+    _stats = Stats();
+    _errorsNotLogged = 0;
+}
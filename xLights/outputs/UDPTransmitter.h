@@ -0,0 +1,109 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Collects the UDP packets the E1.31, ArtNet and DDP outputs send in a frame and sends them
+ * together, with sendmmsg on one socket per local ip and port, rather than a SendTo per packet.
+ *
+ * OutputManager::EndFrame starts a batch before the outputs' EndFrame and flushes it after.
+ * Outside a batch, or on platforms without sendmmsg, Queue returns false and the output sends
+ * the packet on its own datagram as before.
+ */
+class UDPTransmitter
+{
+public:
+    struct Stats {
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        uint64_t syscalls = 0;
+        uint64_t errors = 0;        // packets that could not be sent
+        uint32_t frames = 0;
+        uint32_t framePackets = 0;  // in the most recent batch
+        uint32_t frameBytes = 0;
+        uint32_t frameSyscalls = 0;
+    };
+
+    static UDPTransmitter& Instance();
+    // true if packets can be batched on this platform
+    static bool IsAvailable();
+
+    void SetEnabled(bool enabled) { _enabled = enabled; }
+    bool IsEnabled() const { return _enabled; }
+    // spread each batch's packets over this many ms so switches are not sent them all at once, 0 to send them together.
+    // OutputManager sets it from its UDP packet pacing network setting.
+    void SetPacingMS(int ms) { _pacingMS = ms; }
+    int GetPacingMS() const { return _pacingMS; }
+
+    // where an output sends its packets, localIP "" and localPort 0 for any. -1 if the packets cannot be batched.
+    int AddDestination(const std::string& localIP, int localPort, const std::string& ip, int port);
+    // closes the sockets when output stops, the outputs add their destinations again when they are opened
+    void CloseSockets();
+
+    void StartBatch();
+    // copies the packet into the batch, false if there is no batch and the caller must send it
+    bool Queue(int destination, const uint8_t* data, size_t len);
+    // sends the packets queued since StartBatch, spread over the pacing ms if it is set
+    void Flush();
+
+    Stats GetStats() const;
+    void ResetStats();
+
+    UDPTransmitter(const UDPTransmitter&) = delete;
+    UDPTransmitter& operator=(const UDPTransmitter&) = delete;
+
+private:
+    UDPTransmitter();
+    ~UDPTransmitter();
+
+    struct Socket {
+        std::string localIP;
+        int localPort = 0;
+        int fd = -1;
+    };
+    struct Destination {
+        size_t socket = 0;
+        std::string ip;
+        int port = 0;
+        uint32_t addr = 0; // network byte order
+    };
+    struct Packet {
+        int destination;
+        size_t offset;
+        size_t len;
+    };
+
+    int OpenSocket(const std::string& localIP, int localPort);
+    void Send(size_t firstPacket, size_t lastPacket);
+    void LogSendError(const std::string& ip, int error);
+
+    std::atomic_bool _enabled;
+    std::atomic_bool _batching{ false };
+    std::atomic_int _pacingMS{ 0 };
+    mutable std::mutex _lock;
+    std::vector<Socket> _sockets;
+    std::vector<Destination> _destinations;
+    // the batch, the buffers are kept between frames
+    std::vector<uint8_t> _data;
+    std::vector<Packet> _packets;
+    std::vector<size_t> _sendOrder;
+    Stats _stats;
+    // send errors are logged at most once a second, with how many there were since the last one logged
+    std::chrono::steady_clock::time_point _lastErrorLogged;
+    uint64_t _errorsNotLogged = 0;
+};
@@ -49,6 +49,7 @@ const long OtherSettingsPanel::ID_CHOICE2 = wxNewId();
 const long OtherSettingsPanel::ID_CHECKBOX4 = wxNewId();
 const long OtherSettingsPanel::ID_CHECKBOX6 = wxNewId();
 const long OtherSettingsPanel::ID_CHECKBOX5 = wxNewId();
+const long OtherSettingsPanel::ID_CHECKBOX9 = wxNewId();
 const long OtherSettingsPanel::ID_STATICTEXT4 = wxNewId();
 const long OtherSettingsPanel::ID_CHOICE3 = wxNewId();
 const long OtherSettingsPanel::ID_CHECKBOX8 = wxNewId();
@@ -133,6 +134,10 @@ OtherSettingsPanel::OtherSettingsPanel(wxWindow* parent, xLightsFrame* f, wxWind
     CheckBox_IgnoreVendorModelRecommendations = new wxCheckBox(this, ID_CHECKBOX5, _("Ignore vendor model recommendations"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _T("ID_CHECKBOX5"));
     CheckBox_IgnoreVendorModelRecommendations->SetValue(false);
     GridBagSizer1->Add(CheckBox_IgnoreVendorModelRecommendations, wxGBPosition(7, 0), wxDefaultSpan, wxALL|wxEXPAND, 5);
+    CheckBox_CompactAudioFrameData = new wxCheckBox(this, ID_CHECKBOX9, _("Compact audio analysis data"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _T("ID_CHECKBOX9"));
+    CheckBox_CompactAudioFrameData->SetValue(false);
+    CheckBox_CompactAudioFrameData->SetToolTip(_("Keep the spectrum of songs as bytes rather than floats, a quarter of the memory for slightly coarser values. Used by songs opened after it is changed."));
+    GridBagSizer1->Add(CheckBox_CompactAudioFrameData, wxGBPosition(8, 0), wxDefaultSpan, wxALL|wxEXPAND, 5);
     StaticBoxSizer3 = new wxStaticBoxSizer(wxHORIZONTAL, this, _("Tip Of The Day"));
     FlexGridSizer2 = new wxFlexGridSizer(0, 2, 0, 0);
     StaticText5 = new wxStaticText(this, ID_STATICTEXT4, _("Minimum Tip Level"), wxDefaultPosition, wxDefaultSize, 0, _T("ID_STATICTEXT4"));
@@ -167,13 +172,14 @@ OtherSettingsPanel::OtherSettingsPanel(wxWindow* parent, xLightsFrame* f, wxWind
     Connect(ID_CHECKBOX4,wxEVT_COMMAND_CHECKBOX_CLICKED,(wxObjectEventFunction)&OtherSettingsPanel::OnControlChanged);
     Connect(ID_CHECKBOX6,wxEVT_COMMAND_CHECKBOX_CLICKED,(wxObjectEventFunction)&OtherSettingsPanel::OnControlChanged);
     Connect(ID_CHECKBOX5,wxEVT_COMMAND_CHECKBOX_CLICKED,(wxObjectEventFunction)&OtherSettingsPanel::OnControlChanged);
+    Connect(ID_CHECKBOX9,wxEVT_COMMAND_CHECKBOX_CLICKED,(wxObjectEventFunction)&OtherSettingsPanel::OnControlChanged);
     Connect(ID_CHOICE3,wxEVT_COMMAND_CHOICE_SELECTED,(wxObjectEventFunction)&OtherSettingsPanel::OnControlChanged);
     Connect(ID_CHECKBOX8,wxEVT_COMMAND_CHECKBOX_CLICKED,(wxObjectEventFunction)&OtherSettingsPanel::OnControlChanged);
     //*)
 
 #ifdef __LINUX__
     HardwareVideoDecodingCheckBox->Hide();
-    ShaderCheckbox->Hide();
+    ShaderCheckbox->SetToolTip("Render shaders on the CPU with Mesa's software renderer so they render alongside the other effects and do not need a GPU.");
 #endif
 #ifdef __WXOSX__
     //repurpose ShaderCheckbox for GPU rendering
@@ -211,6 +217,7 @@ bool OtherSettingsPanel::TransferDataFromWindow() {
 	frame->SetPromptBatchRenderIssues(CheckBox_BatchRenderPromptIssues->GetValue());
 	frame->SetIgnoreVendorModelRecommendations(CheckBox_IgnoreVendorModelRecommendations->GetValue());
 	frame->SetPurgeDownloadCacheOnStart(CheckBox_PurgeDownloadCache->GetValue());
+    frame->SetCompactAudioFrameData(CheckBox_CompactAudioFrameData->GetValue());
     frame->SetVideoExportCodec(ChoiceCodec->GetStringSelection());
     frame->SetVideoExportBitrate(SpinCtrlDoubleBitrate->GetValue());
     frame->SetMinTipLevel(Choice_MinTipLevel->GetStringSelection());
@@ -233,6 +240,7 @@ bool OtherSettingsPanel::TransferDataToWindow() {
 	CheckBox_BatchRenderPromptIssues->SetValue(frame->GetPromptBatchRenderIssues());
 	CheckBox_IgnoreVendorModelRecommendations->SetValue(frame->GetIgnoreVendorModelRecommendations());
 	CheckBox_PurgeDownloadCache->SetValue(frame->GetPurgeDownloadCacheOnStart());
+    CheckBox_CompactAudioFrameData->SetValue(frame->GetCompactAudioFrameData());
     ChoiceCodec->SetStringSelection(frame->GetVideoExportCodec());
     SpinCtrlDoubleBitrate->SetValue(frame->GetVideoExportBitrate());
     Choice_MinTipLevel->SetStringSelection(frame->GetMinTipLevel());
@@ -34,6 +34,7 @@ class OtherSettingsPanel: public wxPanel
 
 		//(*Declarations(OtherSettingsPanel)
 		wxCheckBox* CheckBox_BatchRenderPromptIssues;
+		wxCheckBox* CheckBox_CompactAudioFrameData;
 		wxCheckBox* CheckBox_IgnoreVendorModelRecommendations;
 		wxCheckBox* CheckBox_PurgeDownloadCache;
 		wxCheckBox* CheckBox_RecycleTips;
@@ -76,6 +77,7 @@ class OtherSettingsPanel: public wxPanel
 		static const long ID_CHECKBOX4;
 		static const long ID_CHECKBOX6;
 		static const long ID_CHECKBOX5;
+		static const long ID_CHECKBOX9;
 		static const long ID_STATICTEXT4;
 		static const long ID_CHOICE3;
 		static const long ID_CHECKBOX8;
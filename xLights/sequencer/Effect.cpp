@@ -850,8 +850,11 @@ void Effect::AddFrame(RenderBuffer &buffer, RenderCache &renderCache) {
 void Effect::PurgeCache(bool deleteCache) {
     std::unique_lock<std::recursive_mutex> lock(settingsLock);
     if (mCache) {
-        // Even though delete also calls PurgeFrames we have to call this here otherwise delete removes the cache files
-        if (!deleteCache) {
+        if (deleteCache) {
+            // the render cache removes the files once all the effects have been purged
+            mCache->RemoveFilesLater();
+        } else {
+            // let the frames already rendered be written first, delete drops anything still waiting
             mCache->PurgeFrames();
         }
         mCache->Delete();
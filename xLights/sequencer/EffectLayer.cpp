@@ -21,6 +21,7 @@
 #include "Element.h"
 #include "../xLightsMain.h"
 #include "../xLightsApp.h"
+#include "../LayerFrameCache.h"
 
 #include <log4cpp/Category.hh>
 #include "effects/DMXEffect.h"
@@ -32,6 +33,7 @@ EffectLayer::EffectLayer(Element* parent)
 {
     mParentElement = parent;
     mIndex = exclusive_index++;
+    mFrameCache = std::make_shared<LayerFrameCache>();
 }
 
 EffectLayer::~EffectLayer()
@@ -1368,6 +1370,7 @@ bool EffectLayer::SortEffectByStartTime(Effect *e1,Effect *e2)
 
 void EffectLayer::IncrementChangeCount(int startMS, int endMS)
 {
+    mFrameCache->Invalidate(startMS, endMS);
     if (mParentElement) {
         mParentElement->IncrementChangeCount(startMS, endMS);
     }
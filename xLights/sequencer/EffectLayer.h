@@ -14,6 +14,7 @@
 #include <atomic>
 #include <string>
 #include <list>
+#include <memory>
 #include <mutex>
 #include "Effect.h"
 #include "UndoManager.h"
@@ -28,6 +29,7 @@ class Model;
 class ValueCurve;
 class EffectsGrid;
 class xLightsFrame;
+class LayerFrameCache;
 
 class EffectLayer
 {
@@ -117,6 +119,8 @@ class EffectLayer
         void UpdateAllSelectedEffects(const std::string& palette);
 
         void IncrementChangeCount(int startMS, int endMS);
+        // the frames rendered for this layer, edits to the layer invalidate the frames they cover
+        const std::shared_ptr<LayerFrameCache>& GetFrameCache() const { return mFrameCache; }
 
         std::recursive_mutex &GetLock() {return lock;}
     
@@ -143,6 +147,7 @@ class EffectLayer
         std::list<Effect*> mEffectsToDelete;
         int mIndex = 0;
         Element* mParentElement = nullptr;
+        std::shared_ptr<LayerFrameCache> mFrameCache;
         std::recursive_mutex lock;
         std::mutex effectsToDeleteLock;
 };
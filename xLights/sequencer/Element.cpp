@@ -16,6 +16,7 @@
 #include <log4cpp/Category.hh>
 #include "SequenceElements.h"
 #include "xLightsMain.h"
+#include "../LayerFrameCache.h"
 
 Element::Element(SequenceElements *p, const std::string &name) :
 mEffectLayers(),
@@ -296,6 +297,13 @@ void Element::IncrementChangeCount(int sms, int ems)
     listener->IncrementChangeCount(this);
 }
 
+void Element::InvalidateLayerFrameCaches(int startMs, int endMs)
+{
+    for (const auto& it : mEffectLayers) {
+        it->GetFrameCache()->Invalidate(startMs, endMs);
+    }
+}
+
 void SubModelElement::IncrementChangeCount(int startMs, int endMS) {
     GetModelElement()->IncrementChangeCount(startMs, endMS);
 }
@@ -760,6 +768,17 @@ StrandElement* ModelElement::GetStrand(int strand) const
     return mStrands[strand];
 }
 
+void ModelElement::InvalidateLayerFrameCaches(int startMs, int endMs)
+{
+    Element::InvalidateLayerFrameCaches(startMs, endMs);
+    for (const auto& it : mSubModels) {
+        it->InvalidateLayerFrameCaches(startMs, endMs);
+    }
+    for (const auto& it : mStrands) {
+        it->InvalidateLayerFrameCaches(startMs, endMs);
+    }
+}
+
 int ModelElement::GetSubModelAndStrandCount() const {
     return mSubModels.size() +  mStrands.size();
 }
@@ -100,6 +100,8 @@ public:
     std::recursive_timed_mutex &GetChangeLock() { return changeLock; }
     virtual void IncrementChangeCount(int startMs, int endMS);
     int getChangeCount() const { return changeCount; }
+    // for changes outside the effects (such as timing tracks) that mean the rendered layers can't be reused
+    virtual void InvalidateLayerFrameCaches(int startMs, int endMs);
     
     void GetDirtyRange(int &startMs, int &endMs) const {
         startMs = dirtyStart;
@@ -285,6 +287,7 @@ class ModelElement : public Element
         int GetStrandCount() const { return mStrands.size(); }
     
         virtual void CleanupAfterRender() override;
+        virtual void InvalidateLayerFrameCaches(int startMs, int endMs) override;
 
     protected:
     private:
@@ -2341,6 +2341,7 @@ void SequenceElements::IncrementChangeCount(Element *el) {
             for (std::set<std::string>::iterator sit = it->second.begin(); sit != it->second.end(); ++sit) {
                 Element *el2 = this->GetElement(*sit);
                 if (el2 != nullptr) {
+                    el2->InvalidateLayerFrameCaches(ss, es);
                     el2->IncrementChangeCount(ss, es);
                     modelsToRender.insert(*sit);
                     xframe->StartOutputTimer(); // start the timer so the render will trigger
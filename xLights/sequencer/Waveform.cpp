@@ -74,6 +74,8 @@ Waveform::Waveform(wxPanel* parent, wxWindowID id, const wxPoint &pos, const wxS
     mFrequency = 40;
     _media = nullptr;
     mTimeline = nullptr;
+    _pyramidTimer.SetOwner(this);
+    Bind(wxEVT_TIMER, &Waveform::OnPyramidTimer, this);
 }
 
 Waveform::~Waveform()
@@ -83,6 +85,7 @@ Waveform::~Waveform()
 
 void Waveform::CloseMedia()
 {
+    _pyramidTimer.Stop();
     views.clear();
     mCurrentWaveView = NO_WAVE_VIEW_SELECTED;
     _type = AUDIOSAMPLETYPE::RAW;
@@ -482,8 +485,14 @@ void Waveform::DrawWaveView(xlGraphicsContext* ctx, const WaveView& wv)
             c = xLightsApp::GetFrame()->color_mgr.GetColor(ColorManager::COLOR_WAVEFORM);
         }
 
-        int max = std::min(mWindowWidth, wv.MinMaxs.size());
-        if (mStartPixelOffset != wv.lastRenderStart || max != wv.lastRenderSize || _doubleHeight != wv._doubleHeight) {
+        // only the pixels on screen are read from the pyramid, there is nothing to draw until it is built
+        const WaveformPyramid* pyramid = _media->GetWaveformPyramid(wv.GetType(), wv.GetLowNote(), wv.GetHighNote());
+        int max = std::min(mWindowWidth, wv.GetPixelCount());
+        if (pyramid == nullptr) {
+            if (!_pyramidTimer.IsRunning()) {
+                _pyramidTimer.StartOnce(100);
+            }
+        } else if (mStartPixelOffset != wv.lastRenderStart || max != wv.lastRenderSize || _doubleHeight != wv._doubleHeight) {
             float pixelOffset = translateOffset(mStartPixelOffset);
 
             if (wv.background.get() == nullptr) {
@@ -498,13 +507,14 @@ void Waveform::DrawWaveView(xlGraphicsContext* ctx, const WaveView& wv)
             std::vector<double> vertexes;
             vertexes.resize((mWindowWidth + 2));
 
-            for (size_t x = 0; x < mWindowWidth && x < wv.MinMaxs.size(); x++) {
+            for (size_t x = 0; x < mWindowWidth && x < wv.GetPixelCount(); x++) {
                 int index = x;
                 index += pixelOffset;
-                if (index >= 0 && index < wv.MinMaxs.size()) {
+                if (index >= 0 && index < wv.GetPixelCount()) {
+                    MINMAX mm = wv.GetMinMax(pyramid, index);
 
-                    double y1 = DoubleHeight(wv.MinMaxs[index].min, _doubleHeight, max_wave_ht) + (mWindowHeight / 2);
-                    double y2 = DoubleHeight(wv.MinMaxs[index].max, _doubleHeight, max_wave_ht) + (mWindowHeight / 2);
+                    double y1 = DoubleHeight(mm.min, _doubleHeight, max_wave_ht) + (mWindowHeight / 2);
+                    double y2 = DoubleHeight(mm.max, _doubleHeight, max_wave_ht) + (mWindowHeight / 2);
 
                     wv.background->AddVertex(x, y1);
                     wv.background->AddVertex(x, y2);
@@ -513,10 +523,10 @@ void Waveform::DrawWaveView(xlGraphicsContext* ctx, const WaveView& wv)
                     vertexes[x] = y2;
                 }
             }
-            for (int x = std::min(mWindowWidth, wv.MinMaxs.size()) - 1; x >= 0; x--) {
+            for (int x = std::min(mWindowWidth, wv.GetPixelCount()) - 1; x >= 0; x--) {
                 int index = x;
                 index += pixelOffset;
-                if (index >= 0 && index < wv.MinMaxs.size()) {
+                if (index >= 0 && index < wv.GetPixelCount()) {
                     wv.outline->AddVertex(x, vertexes[x]);
                 }
             }
@@ -694,35 +704,42 @@ void Waveform::SetWaveFormSize(int h)
 Waveform::WaveView::~WaveView() {
 }
 
-void Waveform::WaveView::SetMinMaxSampleSet(float SamplesPerPixel, AudioManager* media, AUDIOSAMPLETYPE type, int lowNote, int highNote)
-{
-	MinMaxs.clear();
-
-	if (media != nullptr) {
-		float minimum=1;
-		float maximum=-1;
-		long trackSize = media->GetTrackSize();
-		int totalMinMaxs = (int)((float)trackSize/SamplesPerPixel)+1;
-
-		for (int i = 0; i < totalMinMaxs; i++) {
-			// Use float calculation to minimize compounded rounding of position
-			long start = (long)((float)i*SamplesPerPixel);
-			if (start >= trackSize) {
-				return;
-			}
-			long end = start + SamplesPerPixel;
-			if (end >= trackSize) {
-				end = trackSize;
-			}
-			minimum = 1;
-			maximum = -1;
-            media->GetLeftDataMinMax(start, end, minimum, maximum, type, lowNote, highNote);
-			MINMAX mm;
-			mm.min = minimum;
-			mm.max = maximum;
-			MinMaxs.push_back(mm);
-		}
+void Waveform::WaveView::SetSamplesPerPixel(float SamplesPerPixel, AudioManager* media)
+{
+    mSamplesPerPixel = SamplesPerPixel;
+    _trackSize = 0;
+    _pixels = 0;
+    if (media != nullptr && SamplesPerPixel > 0) {
+        _trackSize = media->GetTrackSize();
+        _pixels = (size_t)((float)_trackSize / SamplesPerPixel) + 1;
+        // a pixel is only drawn if it starts within the track
+        while (_pixels > 0 && (long)((float)(_pixels - 1) * SamplesPerPixel) >= _trackSize) {
+            _pixels--;
+        }
+    }
+}
+
+Waveform::MINMAX Waveform::WaveView::GetMinMax(const WaveformPyramid* pyramid, size_t pixel) const
+{
+    // Use float calculation to minimize compounded rounding of position
+    long start = (long)((float)pixel * mSamplesPerPixel);
+    long end = start + mSamplesPerPixel;
+    if (end >= _trackSize) {
+        end = _trackSize;
     }
+    MINMAX mm;
+    float rms;
+    pyramid->GetMinMaxRMS(start, end, mm.min, mm.max, rms);
+    // the waveform is always drawn through the centre line
+    mm.min = std::min(mm.min, 0.0f);
+    mm.max = std::max(mm.max, 0.0f);
+    return mm;
+}
+
+void Waveform::OnPyramidTimer(wxTimerEvent& event)
+{
+    ForceRedraw();
+    Refresh(false);
 }
 
 void Waveform::mouseLeftWindow(wxMouseEvent& event)
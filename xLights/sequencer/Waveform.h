@@ -111,6 +111,8 @@ class Waveform : public GRAPHICS_BASE_CLASS
         static const long ID_WAVE_MNU_CUSTOM;
         static const long ID_WAVE_MNU_NONVOCALS;
         static const long ID_WAVE_MNU_DOUBLEHEIGHT;
+        // redraws while the waveform pyramid for the current view is being built
+        wxTimer _pyramidTimer;
 
         class WaveView
         {
@@ -120,6 +122,8 @@ class Waveform : public GRAPHICS_BASE_CLASS
             int _lowNote = -1;
             int _highNote = -1;
             AUDIOSAMPLETYPE _type = AUDIOSAMPLETYPE::RAW;
+            long _trackSize = 0;
+            size_t _pixels = 0;
 
         public:
 
@@ -127,14 +131,12 @@ class Waveform : public GRAPHICS_BASE_CLASS
             mutable std::unique_ptr<xlVertexAccumulator> outline = nullptr;
             mutable int lastRenderStart = -1;
             mutable int lastRenderSize = 0;
-            std::vector<MINMAX> MinMaxs;
             mutable bool _doubleHeight = false;
 
             WaveView(int ZoomLevel, float SamplesPerPixel, AudioManager* media, AUDIOSAMPLETYPE type, int lowNote, int highNote)
             {
                 mZoomLevel = ZoomLevel;
-                mSamplesPerPixel = SamplesPerPixel;
-                SetMinMaxSampleSet(SamplesPerPixel, media, type, lowNote, highNote);
+                SetSamplesPerPixel(SamplesPerPixel, media);
                 lastRenderStart = -1;
                 lastRenderSize = 0;
                 _type = type;
@@ -160,7 +162,10 @@ class Waveform : public GRAPHICS_BASE_CLASS
             AUDIOSAMPLETYPE GetType() const { return _type; }
             int GetLowNote() const { return _lowNote; }
             int GetHighNote() const { return _highNote; }
-            void SetMinMaxSampleSet(float SamplesPerPixel, AudioManager* media, AUDIOSAMPLETYPE type, int lowNote, int highNote);
+            size_t GetPixelCount() const { return _pixels; }
+            void SetSamplesPerPixel(float SamplesPerPixel, AudioManager* media);
+            // the range of the samples drawn at pixel, read from the track's waveform pyramid
+            MINMAX GetMinMax(const WaveformPyramid* pyramid, size_t pixel) const;
         };
 
 
@@ -176,6 +181,7 @@ class Waveform : public GRAPHICS_BASE_CLASS
         void OnGridPopup(wxCommandEvent& event);
         void OnLostMouseCapture(wxMouseCaptureLostEvent& event);
         void mouseLeftWindow(wxMouseEvent& event);
+        void OnPyramidTimer(wxTimerEvent& event);
 
         float translateOffset(float f);
 
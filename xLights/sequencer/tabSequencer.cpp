@@ -2312,6 +2312,8 @@ void xLightsFrame::SetPlayStatus(int status) {
 void xLightsFrame::StartOutputTimer() {
     GPURenderUtils::prioritizeGraphics(true);
     OutputTimer.Start(_seqData.FrameTime(), wxTIMER_CONTINUOUS);
+    // the timer produces the frames, the output engine sends them on time even if the UI is busy
+    _outputManager.StartOutputEngine(_seqData.FrameTime());
 }
 void xLightsFrame::StopOutputTimer() {
     OutputTimer.Stop();
@@ -3302,10 +3304,10 @@ std::map<int, std::list<float>> xLightsFrame::LoadPolyphonicTranscription(AudioM
 
         for (size_t i = 0; i < frames; i++)
         {
-            std::list<float> const * const pdata = audio->GetFrameData(i, FRAMEDATA_NOTES, "");
-            if (pdata != nullptr)
+            AudioFrameData const pdata = audio->GetFrameData(i, FRAMEDATA_NOTES, "");
+            if (pdata)
             {
-                res[i*intervalMS] = *pdata;
+                res[i*intervalMS] = std::list<float>(pdata.begin(), pdata.end());
             }
         }
 
@@ -483,6 +483,8 @@ bool xLightsApp::OnInit()
         { wxCMD_LINE_SWITCH, "h", "help", "displays help on the command line parameters", wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
         { wxCMD_LINE_SWITCH, "r", "render", "render files and exit"},
         { wxCMD_LINE_SWITCH, "cs", "checksequence", "run check sequence and exit" },
+        { wxCMD_LINE_SWITCH, "bm", "benchmark", "render files without saving them, report how fast they rendered and exit" },
+        { wxCMD_LINE_OPTION, "bo", "benchmarkoutput", "write the benchmark results as JSON to this file" },
         { wxCMD_LINE_OPTION, "m", "media", "specify media directory"},
         { wxCMD_LINE_OPTION, "s", "show", "specify show directory" },
         { wxCMD_LINE_SWITCH, "w", "wipe", "wipe settings clean" },
@@ -608,7 +610,7 @@ bool xLightsApp::OnInit()
             }
             sequenceFiles.push_back(sequenceFile);
         }
-        if (!parser.Found("cs") && !parser.Found("r") && !parser.Found("o") && !info.empty())
+        if (!parser.Found("cs") && !parser.Found("r") && !parser.Found("bm") && !parser.Found("o") && !info.empty())
         {
             DisplayInfo(info); //give positive feedback*/
         }
@@ -623,6 +625,12 @@ bool xLightsApp::OnInit()
         logger_base.info("-r: Render mode is ON");
         renderOnlyMode = true;
     }
+    bool benchmarkMode = false;
+    if (parser.Found("bm")) {
+        logger_base.info("-bm: Benchmark mode is ON");
+        benchmarkMode = true;
+        renderOnlyMode = true;
+    }
 
     //(*AppInitialize
     bool wxsOK = true;
@@ -634,7 +642,10 @@ bool xLightsApp::OnInit()
         if (Frame->CurrentDir == "") {
             logger_base.info("Show directory not set");
         }
-    	Frame->Show();
+        // nobody is watching a benchmark so the window is never shown
+        if (!benchmarkMode) {
+            Frame->Show();
+        }
     	SetTopWindow(Frame);
     }
     //*)
@@ -642,7 +653,14 @@ bool xLightsApp::OnInit()
     xLightsFrame* const topFrame = (xLightsFrame*)GetTopWindow();
     __frame = topFrame;
 
-    if (renderOnlyMode) {
+    if (benchmarkMode) {
+        wxString output;
+        if (parser.Found("bo", &output)) {
+            logger_base.info("-bo: Benchmark results will be written to %s.", (const char*)output.c_str());
+            topFrame->_benchmarkResultsFile = output;
+        }
+        topFrame->CallAfter(&xLightsFrame::OpenAndBenchmarkSequencesF, sequenceFiles, xLightsFrame::RENDER_EXIT_ON_DONE);
+    } else if (renderOnlyMode) {
         topFrame->CallAfter(&xLightsFrame::OpenRenderAndSaveSequencesF, sequenceFiles, xLightsFrame::RENDER_EXIT_ON_DONE);
     }
 
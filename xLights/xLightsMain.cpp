@@ -1667,6 +1667,10 @@ xLightsFrame::xLightsFrame(wxWindow* parent, int ab, wxWindowID id, bool renderO
     config->Read("xLightsPurgeDownloadCacheOnStart", &_purgeDownloadCacheOnStart, false);
     logger_base.debug("Purge download cache on start: %s.", toStr(_purgeDownloadCacheOnStart));
 
+    config->Read("xLightsCompactAudioFrameData", &_compactAudioFrameData, false);
+    AudioManager::SetCompactFrameData(_compactAudioFrameData);
+    logger_base.debug("Compact audio frame data: %s.", toStr(_compactAudioFrameData));
+
     config->Read("xLightsVideoExportCodec", &_videoExportCodec, "H.264");
     logger_base.debug("Video Export Codec: %s.", (const char*)_videoExportCodec.c_str());
 
@@ -1991,15 +1995,16 @@ xLightsFrame::xLightsFrame(wxWindow* parent, int ab, wxWindowID id, bool renderO
 #else
     config->Read(_("xLightsVideoReaderAccelerated"), &_hwVideoAccleration, false);
     VideoReader::SetHardwareAcceleratedVideo(_hwVideoAccleration);
-#endif
-#ifdef __WXMSW__
-    // make sure Direct2DRenderer is created on the main thread before the other threads need it
-    wxGraphicsRenderer::GetDirect2DRenderer();
 
+    // on linux shaders on background threads are rendered in software
     bool bgShaders = false;
     config->Read(_("xLightsShadersOnBackgroundThreads"), &bgShaders, false);
     ShaderEffect::SetBackgroundRender(bgShaders);
 #endif
+#ifdef __WXMSW__
+    // make sure Direct2DRenderer is created on the main thread before the other threads need it
+    wxGraphicsRenderer::GetDirect2DRenderer();
+#endif
 
     DrawingContext::Initialize(this);
 
@@ -2093,6 +2098,7 @@ xLightsFrame::~xLightsFrame()
     config->Write("xLightsPromptBatchRenderIssues", _promptBatchRenderIssues);
     config->Write("xLightsIgnoreVendorModelRecommendations2", _ignoreVendorModelRecommendations);
     config->Write("xLightsPurgeDownloadCacheOnStart", _purgeDownloadCacheOnStart);
+    config->Write("xLightsCompactAudioFrameData", _compactAudioFrameData);
     config->Write("xLightsExcludeAudioPkgSeq", _excludeAudioFromPackagedSequences);
     config->Write("xLightsShowACLights", _showACLights);
     config->Write("xLightsShowACRamps", _showACRamps);
@@ -4357,6 +4363,7 @@ void xLightsFrame::SetRenderCacheFolder(bool useShow, const std::string& folder)
     }
 
     SetXmlSetting("renderCacheDir", renderCacheDirectory);
+    AudioManager::SetAnalysisCacheFolder(renderCacheDirectory);
     UnsavedRgbEffectsChanges = true;
     UpdateLayoutSave();
     UpdateControllerSave();
@@ -8787,6 +8794,12 @@ void xLightsFrame::PurgeDownloadCache()
     CachedFileDownloader::GetDefaultCache().Save();
 }
 
+void xLightsFrame::SetCompactAudioFrameData(bool b)
+{
+    _compactAudioFrameData = b;
+    AudioManager::SetCompactFrameData(b);
+}
+
 bool xLightsFrame::GetRecycleTips() const
 {
     wxConfigBase* config = wxConfigBase::Get();
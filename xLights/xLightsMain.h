@@ -223,6 +223,8 @@ class BufferPanel;
 class LayoutPanel;
 class RenderProgressDialog;
 class RenderProgressInfo;
+class FSEQStreamWriter;
+class ConvertParameters;
 class wxLed;
 
 class xlAuiToolBar : public wxAuiToolBar {
@@ -1091,6 +1093,7 @@ public:
     bool _autoSavePerspecive = true;
     bool _ignoreVendorModelRecommendations = false;
     bool _purgeDownloadCacheOnStart = false;
+    bool _compactAudioFrameData = false;
     int _fseqVersion;
     int _timelineZooming;
     bool _wasMaximised = false;
@@ -1227,6 +1230,10 @@ public:
     bool GetPurgeDownloadCacheOnStart() const { return _purgeDownloadCacheOnStart; }
     void SetPurgeDownloadCacheOnStart(bool b) { _purgeDownloadCacheOnStart = b; }
 
+    // keep the audio spectrum as bytes, used by songs analysed after it is changed
+    bool GetCompactAudioFrameData() const { return _compactAudioFrameData; }
+    void SetCompactAudioFrameData(bool b);
+
     bool GetRecycleTips() const;
     void SetRecycleTips(bool b);
 
@@ -1422,12 +1429,16 @@ public:
     void ReadXlightsFile(const wxString& FileName, wxString *mediaFilename = nullptr);
     void ReadFalconFile(const wxString& FileName, ConvertDialog* convertdlg);
     void WriteFalconPiFile(const wxString& filename, bool allowSparse = true); //  Falcon Pi Player *.fseq
+    // creates the fseq so the frames can be written as they are rendered, see RenderGridToSeqData
+    FSEQStreamWriter* StartFalconPiFileStream(const wxString& filename);
+    bool CanStreamFalconPiFile();
     OutputManager* GetOutputManager() { return &_outputManager; };
     OutputModelManager* GetOutputModelManager() { return&_outputModelManager; }
     void WriteGIFForPreset(const std::string& preset);
 
 private:
 
+    void AddFalconPiFileRanges(ConvertParameters& write_params);
     void WriteFalconPiModelFile(const wxString& filename, long numChans, unsigned int startFrame, unsigned int endFrame,
                                 SeqDataType *dataBuf, int startAddr, int modelSize,
                                 bool v2 = false); //Falcon Pi sub sequence .eseq
@@ -1455,7 +1466,7 @@ public:
     int GetCurrentPlayTime();
     bool InitPixelBuffer(const std::string &modelName, PixelBufferClass &buffer, int layerCount, bool zeroBased = false);
     Model *GetModel(const std::string& name) const;
-    void RenderGridToSeqData(std::function<void(bool)>&& callback);
+    void RenderGridToSeqData(std::function<void(bool)>&& callback, FSEQStreamWriter* fseqStream = nullptr);
     bool AbortRender(int maxTimeMs = 60000, int* numThreadsAborted = nullptr);
     std::string GetSelectedLayoutPanelPreview() const;
     void UpdateRenderStatus();
@@ -1466,6 +1477,9 @@ public:
     void RenderMainThreadEffects();
     void RenderEffectOnMainThread(RenderEvent *evt);
     void RenderEffectForModel(const std::string &model, int startms, int endms, bool clear = false);
+    // renders just the model and the models it depends on into sparse frames sized for the
+    // whole show, false if that can't be done and a full render is needed
+    bool RenderModelToSeqData(Model* model, SequenceData& seqData);
     void RenderDirtyModels();
     void RenderTimeSlice(int startms, int endms, bool clear);
     void Render(SequenceElements& seqElements,
@@ -1474,7 +1488,8 @@ public:
                 const std::list<Model *> &restrictToModels,
                 int startFrame, int endFrame,
                 bool progressDialog, bool clear,
-                std::function<void(bool)>&& callback);
+                std::function<void(bool)>&& callback,
+                FSEQStreamWriter* fseqStream = nullptr);
     void BuildRenderTree();
 
     void RenderRange(RenderCommandEvent &cmd);
@@ -1529,6 +1544,11 @@ protected:
     void OpenRenderAndSaveSequences(const wxArrayString& filenames, bool exitOnDone, bool alreadyRetried = false);
     void OpenAndCheckSequence(const wxArrayString& origFilenames, bool exitOnDone);
     std::string OpenAndCheckSequence(const std::string& origFilenames);
+    // renders each sequence without saving it and reports how fast it rendered, for -bm
+    void OpenAndBenchmarkSequencesF(const wxArrayString& filenames, int flags);
+    void OpenAndBenchmarkSequences(const wxArrayString& filenames, bool exitOnDone);
+    wxString _benchmarkResultsFile; // the results as JSON are written here when it is set
+    std::string _benchmarkResults;
     void AddAllModelsToSequence();
     void ShowPreviewTime(long ElapsedMSec);
     void TimerOutput(int period);
@@ -1604,6 +1624,7 @@ private:
         void Print();
 
         unsigned int renderTreeChangeCount;
+        unsigned int modelsChangeCount = 0;
         std::list<RenderTreeData*> data;
     } renderTree;
     int mAutoSaveInterval;
@@ -32,6 +32,7 @@
 #include "sequencer/TimeLine.h"
 #include "Vixen3.h"
 #include "ExternalHooks.h"
+#include "LayerFrameCache.h"
 
 #include <log4cpp/Category.hh>
 
@@ -246,6 +247,8 @@ void xLightsXmlFile::SetMediaFile(const wxString& ShowDir, const wxString& filen
         delete audio;
         audio = nullptr;
     }
+    // the layers kept from the last render followed the old audio
+    LayerFrameCache::InvalidateAll();
 
     ObtainAccessToURL(filename.ToStdString());
     if ((filename != wxEmptyString) && FileExists(filename) && wxIsReadable(filename)) {
@@ -273,6 +276,7 @@ void xLightsXmlFile::ClearMediaFile()
         delete audio;
         audio = nullptr;
     }
+    LayerFrameCache::InvalidateAll();
 
     wxXmlNode* root = seqDocument.GetRoot();
 
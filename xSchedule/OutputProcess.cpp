@@ -23,9 +23,12 @@
 #include "OutputProcessDeadChannel.h"
 #include "../xLights/outputs/OutputManager.h"
 
+int OutputProcess::__nextId = 0;
+
 OutputProcess::OutputProcess(OutputManager* outputManager, wxXmlNode* node)
 {
     _sc = 0;
+    _id = ++__nextId;
     _outputManager = outputManager;
     _changeCount = 0;
     _lastSavedChangeCount = 0;
@@ -37,6 +40,7 @@ OutputProcess::OutputProcess(OutputManager* outputManager, wxXmlNode* node)
 OutputProcess::OutputProcess(const OutputProcess& op)
 {
     _sc = 0;
+    _id = ++__nextId;
     _outputManager = op._outputManager;
     _description = op._description;
     _changeCount = op._changeCount;
@@ -48,6 +52,7 @@ OutputProcess::OutputProcess(const OutputProcess& op)
 OutputProcess::OutputProcess(OutputManager* outputManager)
 {
     _sc = 0;
+    _id = ++__nextId;
     _outputManager = outputManager;
     _changeCount = 1;
     _lastSavedChangeCount = 0;
@@ -59,6 +64,7 @@ OutputProcess::OutputProcess(OutputManager* outputManager)
 OutputProcess::OutputProcess(OutputManager* outputManager, std::string startChannel, const std::string& description)
 {
     _sc = 0;
+    _id = ++__nextId;
     _outputManager = outputManager;
     _changeCount = 1;
     _lastSavedChangeCount = 0;
@@ -16,6 +16,7 @@
 class wxXmlNode;
 class OutputManager;
 class OutputProcessExcludeDim;
+class OutputProcessPlanBuilder;
 
 class OutputProcess
 {
@@ -28,6 +29,8 @@ class OutputProcess
         bool _enabled;
         OutputManager* _outputManager;
         long _sc;
+        int _id;
+        static int __nextId;
 
     void Save(wxXmlNode* node);
 
@@ -42,6 +45,9 @@ class OutputProcess
         OutputProcess(const OutputProcess& op);
         OutputProcess(OutputManager* outputManager, std::string startChannel, const std::string& description);
         std::string GetDescription() const { return _description; }
+        // unique to each process ever created, with the change count it tells a compiled plan if it is still valid
+        int GetId() const { return _id; }
+        int GetChangeCount() const { return _changeCount; }
         virtual ~OutputProcess() {}
         virtual wxXmlNode* Save() = 0;
         std::string GetStartChannel() const { return _startChannel; }
@@ -57,4 +63,7 @@ class OutputProcess
         static std::list<OutputProcessExcludeDim*> GetExcludeDim(std::list<OutputProcess*>& processes, size_t sc, size_t ec);
 
         virtual void Frame(uint8_t* buffer, size_t size, std::list<OutputProcess*>& processes) = 0;
+        // describes to the plan what Frame does so it can be applied in the same pass as the processes
+        // around it, false if the process depends on more than each channel's value and must run Frame
+        virtual bool Compile(OutputProcessPlanBuilder& plan, size_t size) { return false; }
 };
@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "OutputProcessColourOrder.h"
+#include "OutputProcessPlan.h"
 #include <wx/xml/xml.h>
 
 OutputProcessColourOrder::OutputProcessColourOrder(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
@@ -94,3 +95,32 @@ void OutputProcessColourOrder::Frame(uint8_t* buffer, size_t size, std::list<Out
 		}
     }
 }
+
+bool OutputProcessColourOrder::Compile(OutputProcessPlanBuilder& plan, size_t size)
+{
+    if (!_enabled) return true;
+    if (_colourOrder == 123) return true;
+
+    size_t sc = GetStartChannelAsNumber();
+    if (sc == 0 || sc > size) return true;
+
+    // where each colour of the node comes from
+    int from[3];
+    switch (_colourOrder) {
+    case 132: from[0] = 0; from[1] = 2; from[2] = 1; break;
+    case 213: from[0] = 1; from[1] = 0; from[2] = 2; break;
+    case 231: from[0] = 1; from[1] = 2; from[2] = 0; break;
+    case 312: from[0] = 2; from[1] = 0; from[2] = 1; break;
+    case 321: from[0] = 2; from[1] = 1; from[2] = 0; break;
+    default: return true;
+    }
+
+    size_t nodes = std::min(_nodes, (size - (sc - 1)) / 3);
+    for (size_t i = 0; i < nodes; i++) {
+        size_t p = (sc - 1) + (i * 3);
+        for (int j = 0; j < 3; j++) {
+            if (from[j] != j) plan.Move(p + j, p + from[j]);
+        }
+    }
+    return true;
+}
@@ -10,6 +10,7 @@
 
 #include "OutputProcessDim.h"
 #include "OutputProcessExcludeDim.h"
+#include "OutputProcessPlan.h"
 #include <wx/xml/xml.h>
 
 OutputProcessDim::OutputProcessDim(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
@@ -97,12 +98,25 @@ void OutputProcessDim::Frame(uint8_t* buffer, size_t size, std::list<OutputProce
 
             if (!ex) {
                 if (_dim == 0) {
-                    *(buffer + i + sc - 1) = 0;
+                    *(buffer + i) = 0;
                 }
                 else {
-                    *(buffer + i + sc - 1) = _dimTable[*(buffer + i + sc - 1)];
+                    *(buffer + i) = _dimTable[*(buffer + i)];
                 }
             }
         }
     }
 }
+
+bool OutputProcessDim::Compile(OutputProcessPlanBuilder& plan, size_t size)
+{
+    if (!_enabled) return true;
+    if (_dim == 100) return true;
+
+    size_t sc = GetStartChannelAsNumber();
+    if (sc == 0 || sc > size) return true;
+
+    size_t chs = std::min(_channels, size - (sc - 1));
+    plan.ApplyDimmableLut(sc - 1, chs, _dimTable);
+    return true;
+}
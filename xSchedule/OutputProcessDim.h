@@ -30,6 +30,7 @@ public:
     virtual ~OutputProcessDim() {}
     virtual wxXmlNode* Save() override;
     virtual void Frame(uint8_t* buffer, size_t size, std::list<OutputProcess*>& processes) override;
+    virtual bool Compile(OutputProcessPlanBuilder& plan, size_t size) override;
     virtual size_t GetP1() const override { return _channels; }
     virtual size_t GetP2() const override { return _dim; }
     virtual std::string GetType() const override { return "Dim"; }
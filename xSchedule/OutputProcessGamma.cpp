@@ -10,6 +10,7 @@
 
 #include "OutputProcessGamma.h"
 #include "OutputProcessExcludeDim.h"
+#include "OutputProcessPlan.h"
 #include <wx/xml/xml.h>
 
 OutputProcessGamma::OutputProcessGamma(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
@@ -145,3 +146,22 @@ void OutputProcessGamma::Frame(uint8_t* buffer, size_t size, std::list<OutputPro
         }
     }
 }
+
+bool OutputProcessGamma::Compile(OutputProcessPlanBuilder& plan, size_t size)
+{
+    if (!_enabled) return true;
+    if (_gamma == 1.0) return true;
+    if (_gamma == 0.00 && _gammaR == 1.0 && _gammaG == 1.0 && _gammaB == 1.0) return true;
+
+    size_t sc = GetStartChannelAsNumber();
+    if (sc == 0 || sc > size) return true;
+
+    size_t nodes = std::min(_nodes, (size - (sc - 1)) / 3);
+    if (_gamma != 0.0) {
+        plan.ApplyDimmableNodeLuts(sc - 1, nodes, _gammaData, _gammaData, _gammaData);
+    }
+    else {
+        plan.ApplyDimmableNodeLuts(sc - 1, nodes, _gammaDataR, _gammaDataG, _gammaDataB);
+    }
+    return true;
+}
@@ -0,0 +1,483 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "OutputProcessPlan.h"
+#include "OutputProcess.h"
+#include "OutputProcessExcludeDim.h"
+
+#include <log4cpp/Category.hh>
+
+#pragma region OutputProcessPlanBuilder
+OutputProcessPlanBuilder::OutputProcessPlanBuilder(std::list<OutputProcess*>& processes, size_t channels)
+{
+    for (const auto& it : processes) {
+        auto ed = dynamic_cast<OutputProcessExcludeDim*>(it);
+        if (ed != nullptr && ed->GetFirstExcludeChannel() > 0) {
+            _excludes.push_back({ ed->GetFirstExcludeChannel() - 1, ed->GetLastExcludeChannel() - 1 });
+        }
+    }
+    std::sort(_excludes.begin(), _excludes.end());
+
+    std::array<uint8_t, 256> identity;
+    for (int i = 0; i < 256; i++) {
+        identity[i] = i;
+    }
+    Intern(identity);
+
+    _src.resize(channels);
+    _lut.resize(channels);
+    Reset();
+}
+
+void OutputProcessPlanBuilder::Reset()
+{
+    for (size_t i = 0; i < _src.size(); i++) {
+        _src[i] = i;
+    }
+    std::fill(_lut.begin(), _lut.end(), 0);
+    _moves.clear();
+    _first = SIZE_MAX;
+    _last = 0;
+}
+
+bool OutputProcessPlanBuilder::IsDimExcluded(size_t channel) const
+{
+    // the last range starting at or before the channel
+    auto it = std::upper_bound(_excludes.begin(), _excludes.end(), std::make_pair(channel, SIZE_MAX));
+    while (it != _excludes.begin()) {
+        --it;
+        if (channel <= it->second) return true;
+        // ranges can overlap so an earlier one may still reach the channel
+        if (it == _excludes.begin()) break;
+    }
+    return false;
+}
+
+void OutputProcessPlanBuilder::Touch(size_t channel)
+{
+    _first = std::min(_first, channel);
+    _last = std::max(_last, channel);
+}
+
+uint32_t OutputProcessPlanBuilder::Intern(const std::array<uint8_t, 256>& lut)
+{
+    auto it = _lutIds.find(lut);
+    if (it != _lutIds.end()) return it->second;
+    uint32_t id = _luts.size();
+    _luts.push_back(lut);
+    _lutIds[lut] = id;
+    return id;
+}
+
+uint32_t OutputProcessPlanBuilder::Intern(const uint8_t* lut)
+{
+    // processes pass the same few tables for every channel so remember the last ones
+    for (const auto& it : _recent) {
+        if (it.first == lut) return it.second;
+    }
+    std::array<uint8_t, 256> l;
+    memcpy(l.data(), lut, 256);
+    uint32_t id = Intern(l);
+    if (_recent.size() == 4) _recent.erase(_recent.begin());
+    _recent.push_back({ lut, id });
+    return id;
+}
+
+uint32_t OutputProcessPlanBuilder::Compose(uint32_t lut, uint32_t then)
+{
+    if (lut == 0) return then;
+    if (then == 0) return lut;
+
+    uint64_t key = ((uint64_t)lut << 32) | then;
+    auto it = _composed.find(key);
+    if (it != _composed.end()) return it->second;
+
+    std::array<uint8_t, 256> l;
+    for (int i = 0; i < 256; i++) {
+        l[i] = _luts[then][_luts[lut][i]];
+    }
+    uint32_t id = Intern(l);
+    _composed[key] = id;
+    return id;
+}
+
+void OutputProcessPlanBuilder::ApplyLut(size_t start, size_t count, size_t stride, const uint8_t* lut)
+{
+    if (count == 0 || start >= _src.size()) return;
+    uint32_t id = Intern(lut);
+    if (id == 0) return;
+
+    uint32_t lastFrom = UINT32_MAX;
+    uint32_t lastTo = 0;
+    size_t end = std::min(_src.size(), start + count * stride);
+    for (size_t c = start; c < end; c += stride) {
+        if (_lut[c] != lastFrom) {
+            lastFrom = _lut[c];
+            lastTo = Compose(lastFrom, id);
+        }
+        _lut[c] = lastTo;
+        Touch(c);
+    }
+}
+
+void OutputProcessPlanBuilder::ApplyDimmableLut(size_t start, size_t count, const uint8_t* lut)
+{
+    if (_excludes.empty()) {
+        ApplyLut(start, count, 1, lut);
+        return;
+    }
+
+    // apply the runs of channels between the exclusions
+    size_t runStart = start;
+    for (size_t c = start; c < start + count; c++) {
+        if (IsDimExcluded(c)) {
+            if (c > runStart) ApplyLut(runStart, c - runStart, 1, lut);
+            runStart = c + 1;
+        }
+    }
+    if (start + count > runStart) ApplyLut(runStart, start + count - runStart, 1, lut);
+}
+
+void OutputProcessPlanBuilder::ApplyDimmableNodeLuts(size_t start, size_t nodes, const uint8_t* r, const uint8_t* g, const uint8_t* b)
+{
+    const uint8_t* luts[3] = { r, g, b };
+
+    size_t runStart = 0;
+    for (size_t n = 0; n <= nodes; n++) {
+        if (n == nodes || (!_excludes.empty() && IsDimExcluded(start + n * 3))) {
+            if (n > runStart) {
+                for (int i = 0; i < 3; i++) {
+                    ApplyLut(start + runStart * 3 + i, n - runStart, 3, luts[i]);
+                }
+            }
+            runStart = n + 1;
+        }
+    }
+}
+
+void OutputProcessPlanBuilder::SetValue(size_t start, size_t count, uint8_t value)
+{
+    uint8_t lut[256];
+    memset(lut, value, sizeof(lut));
+    _recent.clear(); // lut is on the stack
+    ApplyLut(start, count, 1, lut);
+    _recent.clear();
+}
+
+void OutputProcessPlanBuilder::Move(size_t to, size_t from)
+{
+    if (to >= _src.size() || from >= _src.size() || to == from) return;
+    _moves.push_back({ to, from });
+}
+
+void OutputProcessPlanBuilder::EndProcess()
+{
+    if (_moves.empty()) return;
+
+    // every move reads the channels as they were before the process so read them all first
+    std::vector<std::pair<uint32_t, uint32_t>> values;
+    values.reserve(_moves.size());
+    for (const auto& it : _moves) {
+        values.push_back({ _src[it.second], _lut[it.second] });
+    }
+    for (size_t i = 0; i < _moves.size(); i++) {
+        size_t to = _moves[i].first;
+        _src[to] = values[i].first;
+        _lut[to] = values[i].second;
+        Touch(to);
+    }
+    _moves.clear();
+}
+#pragma endregion
+
+#pragma region OutputProcessPlan
+OutputProcessPlan::OutputProcessPlan(std::list<OutputProcess*>& processes, size_t channels, const uint8_t* brightness, int brightnessLevel) :
+    _channels(channels), _brightnessLevel(brightnessLevel)
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    OutputProcessPlanBuilder builder(processes, channels);
+    for (const auto& it : processes) {
+        _signature.push_back({ it->GetId(), it->GetChangeCount() });
+        if (it->Compile(builder, channels)) {
+            builder.EndProcess();
+        } else {
+            AddStage(builder);
+            Stage stage;
+            stage.process = it;
+            _stages.push_back(stage);
+        }
+    }
+
+    if (brightness != nullptr) {
+        // brightness applies to every channel not excluded from dimming
+        size_t c = 0;
+        for (const auto& it : builder._excludes) {
+            if (it.first > c) {
+                builder.ApplyLut(c, it.first - c, 1, brightness);
+            }
+            c = std::max(c, it.second + 1);
+        }
+        if (c < channels) {
+            builder.ApplyLut(c, channels - c, 1, brightness);
+        }
+    }
+    AddStage(builder);
+    _luts = builder._luts;
+
+    logger_base.debug("Output processing compiled: %d processes into %d stages, %d segments, %d tables.",
+        (int)processes.size(), (int)_stages.size(), (int)GetSegmentCount(), (int)_luts.size());
+}
+
+size_t OutputProcessPlan::GetSegmentCount() const
+{
+    size_t res = 0;
+    for (const auto& it : _stages) {
+        res += it.segments.size();
+    }
+    return res;
+}
+
+bool OutputProcessPlan::IsFor(const std::list<OutputProcess*>& processes, size_t channels, int brightnessLevel) const
+{
+    if (channels != _channels || brightnessLevel != _brightnessLevel || processes.size() != _signature.size()) return false;
+    auto sig = _signature.begin();
+    for (const auto& it : processes) {
+        if (sig->first != it->GetId() || sig->second != it->GetChangeCount()) return false;
+        ++sig;
+    }
+    return true;
+}
+
+// turns what the builder collected into segments of channels that can each be processed with one simple loop
+void OutputProcessPlan::AddStage(OutputProcessPlanBuilder& builder)
+{
+    if (builder.IsEmpty()) return;
+
+    auto isConstant = [&builder](uint32_t lut, uint8_t& value) {
+        const auto& l = builder._luts[lut];
+        value = l[0];
+        for (int i = 1; i < 256; i++) {
+            if (l[i] != value) return false;
+        }
+        return true;
+    };
+    std::vector<int8_t> constant(builder._luts.size(), -1);
+    std::vector<uint8_t> constantValue(builder._luts.size(), 0);
+
+    Stage stage;
+    stage.sourceFirst = UINT32_MAX;
+    Segment* seg = nullptr;
+
+    auto isUnchanged = [&builder](size_t c) {
+        return builder._src[c] == c && builder._lut[c] == 0;
+    };
+    // true if the channel after the segment can use the segment's repeating tables
+    auto fits = [](const Segment* s, uint32_t lut) {
+        uint32_t offset = s->count;
+        return offset < 3 || s->luts[offset % 3] == lut;
+    };
+    auto addSource = [&stage, this](uint32_t src) {
+        _sources.push_back(src);
+        stage.needsSource = true;
+        stage.sourceFirst = std::min(stage.sourceFirst, src);
+        stage.sourceLast = std::max(stage.sourceLast, src);
+    };
+    // a short lut or copy run between gathered channels is cheaper gathered than as a segment of its own
+    auto toGather = [&addSource, this](Segment* s) {
+        uint32_t first = s->source;
+        s->source = _sources.size();
+        for (uint32_t i = 0; i < s->count; i++) {
+            addSource(s->kind == Segment::Kind::Copy ? first + i : s->start + i);
+        }
+        s->kind = Segment::Kind::Gather;
+    };
+
+    for (size_t c = builder._first; c <= builder._last; c++) {
+        uint32_t src = builder._src[c];
+        uint32_t lut = builder._lut[c];
+
+        if (constant[lut] == -1) {
+            uint8_t v;
+            constant[lut] = isConstant(lut, v) ? 1 : 0;
+            constantValue[lut] = v;
+        }
+
+        bool contiguous = seg != nullptr && seg->start + seg->count == c;
+
+        Segment::Kind kind;
+        if (constant[lut] == 1) {
+            kind = Segment::Kind::Set;
+        } else if (src == c) {
+            if (lut == 0) {
+                // the channel ends up unchanged, inside a gather it is cheaper to gather it than to split the gather
+                if (!contiguous || seg->kind != Segment::Kind::Gather || c == builder._last || isUnchanged(c + 1) || !fits(seg, lut)) {
+                    seg = nullptr;
+                    continue;
+                }
+                kind = Segment::Kind::Gather;
+            } else {
+                kind = Segment::Kind::Lut;
+            }
+        } else if (lut == 0) {
+            kind = Segment::Kind::Copy;
+        } else {
+            kind = Segment::Kind::Gather;
+        }
+
+        bool extend = false;
+        if (contiguous) {
+            if (seg->kind == kind) {
+                switch (kind) {
+                case Segment::Kind::Set:
+                    extend = seg->value == constantValue[lut];
+                    break;
+                case Segment::Kind::Copy:
+                    extend = src == seg->source + seg->count;
+                    break;
+                case Segment::Kind::Lut:
+                case Segment::Kind::Gather:
+                    extend = fits(seg, lut);
+                    break;
+                }
+            }
+            if (!extend && kind != Segment::Kind::Set && seg->kind != Segment::Kind::Set && fits(seg, lut)) {
+                if (seg->kind == Segment::Kind::Gather) {
+                    kind = Segment::Kind::Gather;
+                    extend = true;
+                } else if (kind == Segment::Kind::Gather && seg->count < 3) {
+                    toGather(seg);
+                    extend = true;
+                }
+            }
+        }
+
+        if (!extend) {
+            Segment s;
+            s.kind = kind;
+            s.start = c;
+            s.value = constantValue[lut];
+            s.source = kind == Segment::Kind::Gather ? _sources.size() : src;
+            s.luts[0] = s.luts[1] = s.luts[2] = lut;
+            s.singleLut = true;
+            stage.segments.push_back(s);
+            seg = &stage.segments.back();
+        }
+        else if (seg->count < 3) {
+            seg->luts[seg->count] = lut;
+            seg->singleLut = seg->singleLut && lut == seg->luts[0];
+        }
+        seg->count++;
+        if (kind == Segment::Kind::Gather) {
+            addSource(src);
+        }
+        else if (kind == Segment::Kind::Copy) {
+            stage.needsSource = true;
+            stage.sourceFirst = std::min(stage.sourceFirst, src);
+            stage.sourceLast = std::max(stage.sourceLast, src);
+        }
+    }
+
+    // a pattern that never reached three channels does not need the later slots
+    for (auto& it : stage.segments) {
+        if (it.count < 3) {
+            for (uint32_t i = it.count; i < 3; i++) {
+                it.luts[i] = it.luts[0];
+            }
+        }
+    }
+
+    if (!stage.segments.empty()) {
+        _stages.push_back(std::move(stage));
+    }
+    builder.Reset();
+}
+
+void OutputProcessPlan::Frame(uint8_t* buffer, size_t size, std::list<OutputProcess*>& processes)
+{
+    if (size < _channels) {
+        // the plan is for a bigger buffer, nothing is safe to do
+        return;
+    }
+
+    for (const auto& stage : _stages) {
+        if (stage.process != nullptr) {
+            stage.process->Frame(buffer, size, processes);
+            continue;
+        }
+
+        const uint8_t* source = nullptr;
+        if (stage.needsSource) {
+            // copies and gathers read the channels as they were before the stage
+            _scratch.resize(stage.sourceLast - stage.sourceFirst + 1);
+            memcpy(_scratch.data(), buffer + stage.sourceFirst, _scratch.size());
+            source = _scratch.data() - stage.sourceFirst;
+        }
+
+        for (const auto& seg : stage.segments) {
+            uint8_t* p = buffer + seg.start;
+            switch (seg.kind) {
+            case Segment::Kind::Set:
+                memset(p, seg.value, seg.count);
+                break;
+            case Segment::Kind::Copy:
+                memcpy(p, source + seg.source, seg.count);
+                break;
+            case Segment::Kind::Lut:
+                if (seg.singleLut) {
+                    const uint8_t* l = _luts[seg.luts[0]].data();
+                    uint32_t i = 0;
+                    for (; i + 4 <= seg.count; i += 4) {
+                        uint8_t a = l[p[i]];
+                        uint8_t b = l[p[i + 1]];
+                        uint8_t c = l[p[i + 2]];
+                        uint8_t d = l[p[i + 3]];
+                        p[i] = a;
+                        p[i + 1] = b;
+                        p[i + 2] = c;
+                        p[i + 3] = d;
+                    }
+                    for (; i < seg.count; i++) {
+                        p[i] = l[p[i]];
+                    }
+                } else {
+                    const uint8_t* l[3] = { _luts[seg.luts[0]].data(), _luts[seg.luts[1]].data(), _luts[seg.luts[2]].data() };
+                    uint32_t i = 0;
+                    for (; i + 3 <= seg.count; i += 3) {
+                        p[i] = l[0][p[i]];
+                        p[i + 1] = l[1][p[i + 1]];
+                        p[i + 2] = l[2][p[i + 2]];
+                    }
+                    for (uint32_t j = 0; i < seg.count; i++, j++) {
+                        p[i] = l[j][p[i]];
+                    }
+                }
+                break;
+            case Segment::Kind::Gather: {
+                const uint32_t* src = &_sources[seg.source];
+                const uint8_t* l[3] = { _luts[seg.luts[0]].data(), _luts[seg.luts[1]].data(), _luts[seg.luts[2]].data() };
+                uint32_t i = 0;
+                for (; i + 3 <= seg.count; i += 3) {
+                    p[i] = l[0][source[src[i]]];
+                    p[i + 1] = l[1][source[src[i + 1]]];
+                    p[i + 2] = l[2][source[src[i + 2]]];
+                }
+                for (uint32_t j = 0; i < seg.count; i++, j++) {
+                    p[i] = l[j][source[src[i]]];
+                }
+            } break;
+            }
+        }
+    }
+}
+#pragma endregion
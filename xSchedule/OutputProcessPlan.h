@@ -0,0 +1,116 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class OutputProcess;
+
+// Collects what a run of output processes does to each channel.  Each channel ends up as a lookup
+// table applied to the value of a source channel as it was before the run started.
+class OutputProcessPlanBuilder
+{
+public:
+    OutputProcessPlanBuilder(std::list<OutputProcess*>& processes, size_t channels);
+
+    size_t GetChannels() const { return _src.size(); }
+    // channels are zero based
+    bool IsDimExcluded(size_t channel) const;
+    void ApplyLut(size_t start, size_t count, size_t stride, const uint8_t* lut);
+    // skips the channels excluded from dimming
+    void ApplyDimmableLut(size_t start, size_t count, const uint8_t* lut);
+    // applies one table to each colour of the nodes, skips nodes whose first channel is excluded from dimming
+    void ApplyDimmableNodeLuts(size_t start, size_t nodes, const uint8_t* r, const uint8_t* g, const uint8_t* b);
+    void SetValue(size_t start, size_t count, uint8_t value);
+    // channel to gets the value from the channel as it was before the current process, see EndProcess
+    void Move(size_t to, size_t from);
+
+    void EndProcess();
+    bool IsEmpty() const { return _first > _last; }
+
+private:
+    friend class OutputProcessPlan;
+
+    uint32_t Intern(const std::array<uint8_t, 256>& lut);
+    uint32_t Intern(const uint8_t* lut);
+    uint32_t Compose(uint32_t lut, uint32_t then);
+    void Touch(size_t channel);
+    void Reset();
+
+    std::vector<std::pair<size_t, size_t>> _excludes; // zero based first and last channel, sorted
+    std::vector<uint32_t> _src;
+    std::vector<uint32_t> _lut;
+    std::vector<std::pair<size_t, size_t>> _moves;
+    size_t _first = 0;
+    size_t _last = 0;
+
+    // lut 0 is the identity
+    std::vector<std::array<uint8_t, 256>> _luts;
+    std::map<std::array<uint8_t, 256>, uint32_t> _lutIds;
+    std::vector<std::pair<const uint8_t*, uint32_t>> _recent;
+    std::unordered_map<uint64_t, uint32_t> _composed;
+};
+
+/**
+ * The output processing chain compiled so a frame is processed in one pass over the channels
+ * instead of each process making its own pass.
+ *
+ * Consecutive processes that only transform or move channels (dim, gamma, set, colour order,
+ * remap, reverse) are folded into runs of combined lookup tables and gather tables.  Processes
+ * whose result depends on other channels or on earlier frames run their own Frame between the
+ * runs.  The brightness table is folded in after the last process.
+ */
+class OutputProcessPlan
+{
+public:
+    OutputProcessPlan(std::list<OutputProcess*>& processes, size_t channels, const uint8_t* brightness = nullptr, int brightnessLevel = 100);
+
+    // true if the plan was compiled from these processes, unchanged, for this many channels
+    bool IsFor(const std::list<OutputProcess*>& processes, size_t channels, int brightnessLevel) const;
+    void Frame(uint8_t* buffer, size_t size, std::list<OutputProcess*>& processes);
+
+    size_t GetStageCount() const { return _stages.size(); }
+    size_t GetSegmentCount() const;
+
+private:
+    struct Segment {
+        enum class Kind { Set, Lut, Copy, Gather } kind;
+        uint32_t start = 0;
+        uint32_t count = 0;
+        uint32_t source = 0;    // Copy: first source channel, Gather: first entry in _sources
+        uint8_t value = 0;      // Set
+        uint32_t luts[3] = { 0, 0, 0 }; // Lut and Gather: the tables for start, start + 1, start + 2 then repeating
+        bool singleLut = false;
+    };
+    struct Stage {
+        std::vector<Segment> segments;
+        OutputProcess* process = nullptr; // runs its own Frame instead
+        uint32_t sourceFirst = 0;          // the channels Copy and Gather read from
+        uint32_t sourceLast = 0;
+        bool needsSource = false;
+    };
+
+    void AddStage(OutputProcessPlanBuilder& builder);
+
+    std::vector<Stage> _stages;
+    std::vector<std::array<uint8_t, 256>> _luts;
+    std::vector<uint32_t> _sources;
+    std::vector<uint8_t> _scratch;
+    std::vector<std::pair<int, int>> _signature; // process id and change count
+    size_t _channels = 0;
+    int _brightnessLevel = 100;
+};
@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "OutputProcessRemap.h"
+#include "OutputProcessPlan.h"
 #include <wx/xml/xml.h>
 
 OutputProcessRemap::OutputProcessRemap(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
@@ -59,3 +60,20 @@ void OutputProcessRemap::Frame(uint8_t* buffer, size_t size, std::list<OutputPro
 
     memcpy(buffer + _to - 1, buffer + sc - 1, chs);
 }
+
+bool OutputProcessRemap::Compile(OutputProcessPlanBuilder& plan, size_t size)
+{
+    size_t sc = GetStartChannelAsNumber();
+
+    if (sc == _to) return true;
+    if (sc == 0 || _to == 0 || sc > size || _to > size) return true;
+
+    size_t chs1 = std::min(_channels, size - (sc - 1));
+    size_t chs2 = std::min(_channels, size - (_to - 1));
+    size_t chs = std::min(chs1, chs2);
+
+    for (size_t i = 0; i < chs; i++) {
+        plan.Move(_to - 1 + i, sc - 1 + i);
+    }
+    return true;
+}
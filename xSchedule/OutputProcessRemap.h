@@ -26,6 +26,7 @@ class OutputProcessRemap : public OutputProcess
         virtual ~OutputProcessRemap() {}
         virtual wxXmlNode* Save() override;
         virtual void Frame(uint8_t* buffer, size_t size, std::list<OutputProcess*>& processes) override;
+        virtual bool Compile(OutputProcessPlanBuilder& plan, size_t size) override;
         virtual size_t GetP1() const override { return _to; }
         virtual size_t GetP2() const override { return _channels; }
         virtual std::string GetType() const override { return "Remap"; }
@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "OutputProcessReverse.h"
+#include "OutputProcessPlan.h"
 #include <wx/xml/xml.h>
 
 OutputProcessReverse::OutputProcessReverse(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
@@ -55,7 +56,7 @@ void OutputProcessReverse::Frame(uint8_t* buffer, size_t size, std::list<OutputP
 	uint8_t* from = p;
 	uint8_t* to = p + (nodes - 1) * 3;
 		
-	for (int i = 0; i < nodes; i++)
+	for (int i = 0; i < nodes / 2; i++)
 	{
 		memcpy(rgb, from, 3);
 		memcpy(from, to, 3);
@@ -65,3 +66,21 @@ void OutputProcessReverse::Frame(uint8_t* buffer, size_t size, std::list<OutputP
 		to -= 3;
     }
 }
+
+bool OutputProcessReverse::Compile(OutputProcessPlanBuilder& plan, size_t size)
+{
+    if (_nodes < 2) return true;
+
+    size_t sc = GetStartChannelAsNumber();
+    if (sc == 0 || sc > size) return true;
+
+    size_t nodes = std::min(_nodes, (size - (sc - 1)) / 3);
+    for (size_t i = 0; i < nodes; i++) {
+        size_t to = (sc - 1) + i * 3;
+        size_t from = (sc - 1) + (nodes - 1 - i) * 3;
+        for (int j = 0; j < 3; j++) {
+            plan.Move(to + j, from + j);
+        }
+    }
+    return true;
+}
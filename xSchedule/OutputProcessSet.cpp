@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "OutputProcessSet.h"
+#include "OutputProcessPlan.h"
 #include <wx/xml/xml.h>
 
 OutputProcessSet::OutputProcessSet(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
@@ -54,3 +55,13 @@ void OutputProcessSet::Frame(uint8_t* buffer, size_t size, std::list<OutputProce
 
     memset(buffer + sc - 1, (uint8_t)_value, chs);
 }
+
+bool OutputProcessSet::Compile(OutputProcessPlanBuilder& plan, size_t size)
+{
+    size_t sc = GetStartChannelAsNumber();
+    if (sc == 0 || sc > size) return true;
+
+    size_t chs = std::min(_channels, size - (sc - 1));
+    plan.SetValue(sc - 1, chs, (uint8_t)_value);
+    return true;
+}
@@ -18,6 +18,9 @@
 #include "../RunningSchedule.h"
 #include "PlayList.h"
 #include "PlayListStep.h"
+#include "../../xLights/FSEQFile.h"
+
+#include <log4cpp/Category.hh>
 
 int __playlistitemid = 0;
 
@@ -246,6 +249,18 @@ std::string PlayListItem::ReplaceTags(const std::string s) const
     return res.ToStdString();
 }
 
+// how well the fseq read ahead kept up, a stall is a frame that had to wait on its block
+void PlayListItem::LogFSEQReadAhead(FSEQFile* fseq) const
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    FSEQFile::ReadAheadStats stats;
+    if (fseq != nullptr && fseq->getReadAheadStats(stats) && stats.blocksDecoded > 0) {
+        logger_base.debug("FSEQ '%s' read ahead: %u blocks decoded, average %.1fms, max %.1fms. %u stalls, max %.1fms.",
+            (const char*)GetNameNoTime().c_str(), stats.blocksDecoded, stats.averageDecodeMS, stats.maxDecodeMS, stats.stalls, stats.maxStallMS);
+    }
+}
+
 std::string PlayListItem::GetTagHint()
 {
     return "Available variables:\n    %RUNNING_PLAYLIST% - current playlist\n    %RUNNING_PLAYLISTSTEP% - step name\n    %RUNNING_PLAYLISTSTEPMS% - Position in current step\n    %RUNNING_PLAYLISTSTEPMSLEFT% - Time left in current step\n    %RUNNING_SCHEDULE% - Name of schedule\n    %STEPNAME% - Current step\n    %NEXTSTEPNAME% - Next step\n    %NEXTSTEPNAME% - Next step\n    %ALBUM% - from mp3\n    %TITLE% - from mp3\n    %ARTIST% - from mp3\n    %TIMESTAMP% - timestamp\n    %TIME% - time now\n    %MACHINENAME% - computer name\n    %DATE% - date now";
@@ -18,6 +18,7 @@
 class wxXmlNode;
 class AudioManager;
 class ScheduleOptions;
+class FSEQFile;
 
 class PlayListItem
 {
@@ -44,6 +45,7 @@ protected:
     bool IsInSlaveMode() const;
     bool IsSuppressAudioOnSlaves() const;
     std::string ReplaceTags(const std::string s) const;
+    void LogFSEQReadAhead(FSEQFile* fseq) const;
 
     public:
 
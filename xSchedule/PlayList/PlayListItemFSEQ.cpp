@@ -569,6 +569,8 @@ void PlayListItemFSEQ::Start(long stepLengthMS)
     LoadFiles();
 
     if (_fseqFile != nullptr) {
+        // decompress the next blocks in the background so moving into a new block doesn't stall the output
+        _fseqFile->enableReadAhead(2);
         _fseqFile->prepareRead({ { 0, _fseqFile->getMaxChannel() + 1 } });
     }
 
@@ -623,6 +625,7 @@ void PlayListItemFSEQ::CloseFiles()
 {
     if (_fseqFile != nullptr)
     {
+        LogFSEQReadAhead(_fseqFile);
         delete _fseqFile;
         _fseqFile = nullptr;
     }
@@ -682,6 +682,8 @@ void PlayListItemFSEQVideo::Start(long stepLengthMS)
     LoadFiles(true);
 
     if (_fseqFile != nullptr) {
+        // decompress the next blocks in the background so moving into a new block doesn't stall the output
+        _fseqFile->enableReadAhead(2);
         _fseqFile->prepareRead({ { 0, _fseqFile->getMaxChannel() + 1} });
     }
 
@@ -796,6 +798,7 @@ void PlayListItemFSEQVideo::Stop()
 void PlayListItemFSEQVideo::CloseFiles()
 {
     if (_fseqFile != nullptr) {
+        LogFSEQReadAhead(_fseqFile);
         delete _fseqFile;
         _fseqFile = nullptr;
     }
@@ -37,6 +37,9 @@ PlayerWindow::PlayerWindow(wxWindow* parent, bool topMost, wxImageResizeQuality
     _image = wxImage(size, true);
     _inputImage = wxImage(1, 1, true);
     _imageChanged = false;
+    _inputScaled = false;
+    _width = size.GetWidth();
+    _height = size.GetHeight();
     SetDoubleBuffered(true);
     _dragging = false;
 
@@ -58,6 +61,7 @@ PlayerWindow::PlayerWindow(wxWindow* parent, bool topMost, wxImageResizeQuality
     Connect(wxEVT_LEFT_UP, (wxObjectEventFunction)&PlayerWindow::OnMouseLeftUp, 0, this);
     Connect(wxEVT_MOTION, (wxObjectEventFunction)&PlayerWindow::OnMouseMove, 0, this);
     Connect(wxEVT_PAINT, (wxObjectEventFunction)&PlayerWindow::Paint, 0, this);
+    Connect(wxEVT_SIZE, (wxObjectEventFunction)&PlayerWindow::OnSize, 0, this);
 
     // prevent this window from stealing focus
     if (wind != nullptr) {
@@ -67,6 +71,8 @@ PlayerWindow::PlayerWindow(wxWindow* parent, bool topMost, wxImageResizeQuality
     static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     int w, h;
     GetSize(&w, &h);
+    _width = w;
+    _height = h;
     int x, y;
     GetPosition(&x, &y);
     logger_base.info("Player window created location (%d, %d) size (%d, %d) Quality: %s.", x, y, w, h, (const char*)VirtualMatrix::DecodeScalingQuality(quality, swsQuality).c_str());
@@ -94,7 +100,14 @@ bool PlayerWindow::PrepareImage()
                 int srcWidth = _inputImage.GetWidth();
                 int srcHeight = _inputImage.GetHeight();
 
-                if (_swsQuality < 0) {
+                if (_inputScaled) {
+                    _image = _inputImage;
+                    // scaled before the window was last resized
+                    if (srcWidth != width || srcHeight != height) {
+                        _image = _inputImage.Scale(width, height, _quality);
+                    }
+                }
+                else if (_swsQuality < 0) {
                     _image.Destroy();
                     _image = _inputImage.Copy();
                     if (srcWidth != width || srcHeight != height) {
@@ -102,8 +115,6 @@ bool PlayerWindow::PrepareImage()
                     }
                 }
                 else {
-                    // THIS DOES NOT WORK YET ... NOT SURE WHY
-                    wxASSERT(false);
                     if (_image.GetWidth() != width || _image.GetHeight() != height) {
                         _image.Destroy();
                         _image = wxImage(width, height);
@@ -122,7 +133,7 @@ bool PlayerWindow::PrepareImage()
 
                         sws_scale(swsCtx,
                             &srcPtr, &srcRow,
-                            0, height,
+                            0, srcHeight,
                             &dstPtr, &dstRow);
 
                         sws_freeContext(swsCtx);
@@ -134,6 +145,7 @@ bool PlayerWindow::PrepareImage()
                 }
                 logger_frame.debug("Player Window image updated %ldms", sw.Time());
             }
+            _imageChanged = false;
             _mutex.unlock();
         }
         else {
@@ -164,12 +176,37 @@ void PlayerWindow::SetImage(const wxImage& image)
         if (changed) {
             _inputImage.Destroy();
             _inputImage = image.Copy();
+            _inputScaled = false;
             _imageChanged = true;
             Refresh(false); // force a paint on the main thread
         }
     }
 }
 
+void PlayerWindow::SetScaledImage(wxImage& image)
+{
+    if (!image.IsOk()) return;
+
+    {
+        std::unique_lock<std::timed_mutex> lock(_mutex);
+        // image reference counts are not thread safe so the caller's reference is dropped while holding the lock
+        _inputImage = image;
+        image.Destroy();
+        _inputScaled = true;
+        _imageChanged = true;
+    }
+    CallAfter([this]() { Refresh(false); });
+}
+
+void PlayerWindow::OnSize(wxSizeEvent& event)
+{
+    int w, h;
+    GetSize(&w, &h);
+    _width = w;
+    _height = h;
+    event.Skip();
+}
+
 void PlayerWindow::Paint(wxPaintEvent& event)
 {
     wxASSERT(wxThread::IsMain());
@@ -28,6 +28,10 @@ class PlayerWindow: public wxFrame
     int _swsQuality;
     std::timed_mutex _mutex;
     std::atomic_bool _imageChanged;
+    bool _inputScaled;
+    // the window's size kept for the threads that scale images for it
+    std::atomic_int _width;
+    std::atomic_int _height;
 
     bool PrepareImage();
 
@@ -36,6 +40,10 @@ class PlayerWindow: public wxFrame
 		PlayerWindow(wxWindow* parent, bool topMost, wxImageResizeQuality quality = wxIMAGE_QUALITY_HIGH, int swsQuality = -1, wxWindowID id=wxID_ANY,const wxPoint& pos=wxDefaultPosition,const wxSize& size=wxDefaultSize);
 		virtual ~PlayerWindow();
         void SetImage(const wxImage& image);
+        // takes an image already scaled to the window so painting just draws it, can be called from any thread
+        void SetScaledImage(wxImage& image);
+        // the size SetScaledImage expects, can be called from any thread
+        wxSize GetImageSize() const { return wxSize(_width, _height); }
 
 	private:
 
@@ -43,6 +51,7 @@ class PlayerWindow: public wxFrame
         void OnMouseMove(wxMouseEvent& event);
         void OnMouseLeftDown(wxMouseEvent& event);
         void Paint(wxPaintEvent& event);
+        void OnSize(wxSizeEvent& event);
 
 		DECLARE_EVENT_TABLE()
 };
@@ -47,8 +47,6 @@
 #include "wxJSON/jsonreader.h"
 #include "../xLights/VideoReader.h"
 #include "../xLights/outputs/Controller.h"
-#include "OutputProcessExcludeDim.h"
-#include "../xLights/Parallel.h"
 
 #include <memory>
 
@@ -759,15 +757,7 @@ void ScheduleManager::AllOff()
     }
 
     // apply any output processing
-    for (const auto& it : _outputProcessing)
-    {
-        it->Frame(_buffer, _outputManager->GetTotalChannels(), _outputProcessing);
-    }
-
-    //if (_brightness < 100)
-    //{
-    //    ApplyBrightness();
-    //}
+    ApplyOutputProcessing(false);
 
     for (const auto& it : *GetOptions()->GetVirtualMatrices())
     {
@@ -778,43 +768,23 @@ void ScheduleManager::AllOff()
     _outputManager->EndFrame();
 }
 
-void ScheduleManager::ApplyBrightness()
+void ScheduleManager::ApplyOutputProcessing(bool applyBrightness)
 {
-    if (_brightness == 100) return;
+    int brightness = applyBrightness ? _brightness : 100;
+    if (_outputProcessing.size() == 0 && brightness >= 100) return;
 
-    if (_brightness != _lastBrightness) {
+    if (brightness < 100 && _brightness != _lastBrightness) {
         _lastBrightness = _brightness;
         CreateBrightnessArray();
     }
 
+    // the processes are compiled once and recompiled only when they or the brightness change
     auto totalChannels = _outputManager->GetTotalChannels();
-
-    auto ed = OutputProcess::GetExcludeDim(_outputProcessing, 1, totalChannels);
-
-    if (ed.size() == 0) { // handle the simple case fast
-        //uint8_t* pb = _buffer;
-        //for (size_t i = 0; i < totalChannels; ++i) {
-        //    *pb = _brightnessArray[*pb];
-        //    pb++;
-        //}
-        parallel_for(0, totalChannels, [this](int i) {
-            _buffer[i] = _brightnessArray[_buffer[i]];
-        });
-    }
-    else {
-        auto exclude = ed.begin();
-        uint8_t* pb = _buffer;
-        for (size_t i = 0; i < totalChannels; ++i) {
-
-            while (exclude != ed.end() && i > (*exclude)->GetLastExcludeChannel() - 1) ++exclude;
-            bool ex = (exclude != ed.end() && i >= (*exclude)->GetFirstExcludeChannel() - 1);
-
-            if (!ex) {
-                *pb = _brightnessArray[*pb];
-            }
-            pb++;
-        }
+    auto& plan = brightness < 100 ? _outputProcessPlanBright : _outputProcessPlan;
+    if (plan == nullptr || !plan->IsFor(_outputProcessing, totalChannels, brightness)) {
+        plan = std::make_unique<OutputProcessPlan>(_outputProcessing, totalChannels, brightness < 100 ? _brightnessArray : nullptr, brightness);
     }
+    plan->Frame(_buffer, totalChannels, _outputProcessing);
 }
 
 int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
@@ -853,16 +823,8 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
             TestFrame(_buffer, totalChannels, msec);
         }
 
-        // apply any output processing
-        for (const auto& it : _outputProcessing)
-        {
-            it->Frame(_buffer, totalChannels, _outputProcessing);
-        }
-
-        if (outputframe && _brightness < 100)
-        {
-            ApplyBrightness();
-        }
+        // apply any output processing and the brightness
+        ApplyOutputProcessing(outputframe);
 
         for (const auto& it : *GetOptions()->GetVirtualMatrices())
         {
@@ -988,20 +950,10 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
 
                 logger_frame.debug("Frame: Overlay data done %ldms", sw.Time());
 
-                // apply any output processing
-                for (auto it = _outputProcessing.begin(); it != _outputProcessing.end(); ++it)
-                {
-                    (*it)->Frame(_buffer, totalChannels, _outputProcessing);
-                }
-
-                logger_frame.debug("Frame: Output processing done %ldms", sw.Time());
-
-                if (outputframe && _brightness < 100)
-                {
-                    ApplyBrightness();
-                }
+                // apply any output processing and the brightness
+                ApplyOutputProcessing(outputframe);
 
-                logger_frame.debug("Frame: Brightness done %ldms", sw.Time());
+                logger_frame.debug("Frame: Output processing and brightness done %ldms", sw.Time());
 
                 for (const auto& it : *GetOptions()->GetVirtualMatrices())
                 {
@@ -1094,16 +1046,8 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
                     frame->ManipulateBuffer(_buffer, totalChannels);
                 }
 
-                // apply any output processing
-                for (const auto& it : _outputProcessing)
-                {
-                    it->Frame(_buffer, totalChannels, _outputProcessing);
-                }
-
-                if (outputframe && _brightness < 100)
-                {
-                    ApplyBrightness();
-                }
+                // apply any output processing and the brightness
+                ApplyOutputProcessing(outputframe);
 
                 for (const auto& it : *GetOptions()->GetVirtualMatrices())
                 {
@@ -1148,16 +1092,8 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
 
                     frame->ManipulateBuffer(_buffer, totalChannels);
 
-                    // apply any output processing
-                    for (auto it2 = _outputProcessing.begin(); it2 != _outputProcessing.end(); ++it2)
-                    {
-                        (*it2)->Frame(_buffer, totalChannels, _outputProcessing);
-                    }
-
-                    if (outputframe && _brightness < 100)
-                    {
-                        ApplyBrightness();
-                    }
+                    // apply any output processing and the brightness
+                    ApplyOutputProcessing(outputframe);
 
                     for (auto it2 :*GetOptions()->GetVirtualMatrices())
                     {
@@ -1193,6 +1129,9 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
         rate = _overrideMS;
     }
 
+    // the frames built here are sent by the output engine at the frame rate even if the UI thread is late
+    _outputManager->StartOutputEngine(rate);
+
     return rate;
 }
 
@@ -20,6 +20,7 @@
 #include "wxMIDI/src/wxMidi.h"
 #include "Blend.h"
 #include "SyncManager.h"
+#include "OutputProcessPlan.h"
 
 class PlayListItemText;
 class ScheduleOptions;
@@ -99,6 +100,9 @@ class ScheduleManager
     wxDatagramSocket* _artNetSyncMaster = nullptr;
     wxDatagramSocket* _fppSyncMasterUnicast = nullptr;
     std::list<OutputProcess*> _outputProcessing;
+    // one plan for output frames with the brightness folded in and one for frames without
+    std::unique_ptr<OutputProcessPlan> _outputProcessPlan;
+    std::unique_ptr<OutputProcessPlan> _outputProcessPlanBright;
     ListenerManager* _listenerManager = nullptr;
     XyzzyBase* _xyzzy = nullptr;
     wxDateTime _lastXyzzyCommand;
@@ -182,7 +186,7 @@ class ScheduleManager
         int GetBrightness() const { return _brightness; }
         void AdjustBrightness(int by) { _brightness += by; if (_brightness < 0) _brightness = 0; else if (_brightness > 100) _brightness = 100; }
         void SetBrightness(int brightness) { if (brightness < 0) _brightness = 0; else if (brightness > 100) _brightness = 100; else _brightness = brightness; }
-        void ApplyBrightness();
+        void ApplyOutputProcessing(bool applyBrightness);
         int Frame(bool outputframe, xScheduleFrame* frame); // called when a frame needs to be displayed ... returns desired frame rate
         int CheckSchedule();
         std::string GetShowDir() const { return _showDir; }
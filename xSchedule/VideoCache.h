@@ -10,28 +10,21 @@
  * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
  **************************************************************/
 
-#include <mutex>
 #include <wx/wx.h>
+#include <memory>
 #include <string>
-#include <map>
-#include "../xLights/JobPool.h"
 
-class VideoReader;
-class VideoCacheItem;
-class CVRThread;
+class VideoClip;
 struct AVFrame;
 
+// Plays a video for xSchedule from the decode ahead VideoFrameCache shared with everything else playing it
 class CachedVideoReader
 {
-    std::map<long, wxImage> _cache;
-    std::mutex _cacheAccess;
-    int _maxItems;
-    CVRThread* _thread;
+    std::shared_ptr<VideoClip> _clip;
     int _frameTime;
     std::string _videoFile;
     wxSize _size;
     long _lengthMS;
-    bool _done;
 
 public:
     CachedVideoReader(const std::string& videoFile, long startMillisecond, int frameTime, const wxSize& size, bool keepAspectRatio);
@@ -40,13 +33,6 @@ public:
     static wxImage CreateImageFromFrame(AVFrame* frame, const wxSize& size);
     static wxImage FadeImage(const wxImage& image, int brightness);
 
-    bool HasFrame(long millisecond);
-    void CacheImage(long millisecond, const wxImage& image);
-    void SetLengthMS(long lengthMS);
-    void Done();
-    void PurgeCachePriorTo(long start);
-
     long GetLengthMS() const { return _lengthMS; };
     wxImage GetNextFrame(long ms);
 };
-
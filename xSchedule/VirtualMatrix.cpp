@@ -15,6 +15,7 @@
 #include "xScheduleApp.h"
 #include "../xLights/outputs/OutputManager.h"
 #include "ScheduleOptions.h"
+#include "VirtualMatrixRenderer.h"
 
 extern "C"
 {
@@ -43,6 +44,7 @@ VirtualMatrix::VirtualMatrix(OutputManager* outputManager, int width, int height
     _location = loc;
     _startChannel = startChannel;
     _window = nullptr;
+    _renderer = nullptr;
 }
 
 VirtualMatrix::VirtualMatrix(OutputManager* outputManager, ScheduleOptions* options)
@@ -65,6 +67,7 @@ VirtualMatrix::VirtualMatrix(OutputManager* outputManager, ScheduleOptions* opti
     _location = options->GetDefaultVideoPos();
     _startChannel = "1";
     _window = nullptr;
+    _renderer = nullptr;
 }
 
 VirtualMatrix::VirtualMatrix(OutputManager* outputManager, int width, int height, bool topMost, const std::string& rotation, const std::string& pixelChannels, const std::string& quality, const std::string& startChannel, const std::string& name, wxSize size, wxPoint loc, bool useMatrixSize, int matrixMultiplier)
@@ -86,6 +89,7 @@ VirtualMatrix::VirtualMatrix(OutputManager* outputManager, int width, int height
     _location = loc;
     _startChannel = startChannel;
     _window = nullptr;
+    _renderer = nullptr;
 }
 
 VirtualMatrix::VirtualMatrix(OutputManager* outputManager, wxXmlNode* n)
@@ -107,6 +111,7 @@ VirtualMatrix::VirtualMatrix(OutputManager* outputManager, wxXmlNode* n)
     _location = wxPoint(wxAtoi(n->GetAttribute("X", "0")), wxAtoi(n->GetAttribute("Y", "0")));
     _startChannel = n->GetAttribute("StartChannel", "1");
     _window = nullptr;
+    _renderer = nullptr;
 }
 
 wxXmlNode* VirtualMatrix::Save()
@@ -335,98 +340,20 @@ std::string VirtualMatrix::DecodeScalingQuality(wxImageResizeQuality quality, in
 
 void VirtualMatrix::AllOff()
 {
-    if (!_image.IsOk()) return;
-    if (_window == nullptr) return;
+    if (_renderer == nullptr) return;
 
-    _image.Clear();
-
-    if (_rotation == VMROTATION::VM_NORMAL)
-    {
-        _window->SetImage(_image);
-    }
-    else if (_rotation == VMROTATION::VM_FLIP_HORIZONTAL) {
-        wxImage rot = _image.Mirror(true);
-        _window->SetImage(rot);
-    }
-    else if (_rotation == VMROTATION::VM_FLIP_VERTICAL) {
-        wxImage rot = _image.Mirror(false);
-        _window->SetImage(rot);
-    }
-    else if (_rotation == VMROTATION::VM_90)
-    {
-        wxImage rot = _image.Rotate90();
-        _window->SetImage(rot);
-    }
-    else
-    {
-        wxImage rot = _image.Rotate90(false);
-        _window->SetImage(rot);
-    }
+    _renderer->PushFrame(nullptr, 0);
 }
 
 void VirtualMatrix::Frame(uint8_t*buffer, size_t size)
 {
-    if (!_image.IsOk()) return;
-    if (_window == nullptr) return;
-
-    // If there is no width or height there is nothing to draw
-    if (_width == 0 || _height == 0) return;
+    if (_renderer == nullptr) return;
 
     long sc = _outputManager->DecodeStartChannel(_startChannel);
+    if (sc < 1 || (size_t)sc > size) return;
 
-    const int channelsPerPixel = GetPixelChannelsCount();
-    size_t end = _width * _height * channelsPerPixel < size - (sc - 1) ? _width * _height * channelsPerPixel : size - (sc - 1);
-
-    for (size_t i = 0; i < end; i += channelsPerPixel)
-    {
-        uint8_t* pb = buffer + (sc - 1) + i;
-        uint8_t r = *pb;
-        uint8_t g = 0;
-        if (i + 1 < end)
-        {
-            g = *(pb + 1);
-        }
-        uint8_t b = 0;
-        if (i + 2 < end)
-        {
-            b = *(pb + 2);
-        }
-        if (channelsPerPixel > 3)
-        {
-            uint8_t w = 0;
-            if (i + 3 < end) {
-                w = *(pb + 3);
-            }
-            if (w != 0)
-            {
-                r = g = b = w;
-            }
-        }
-        _image.SetRGB((i / channelsPerPixel) % _width, i / channelsPerPixel / _width, r, g, b);
-    }
-
-    if (_rotation == VMROTATION::VM_NORMAL)
-    {
-        _window->SetImage(_image);
-    }
-    else if (_rotation == VMROTATION::VM_FLIP_HORIZONTAL) {
-        wxImage rot = _image.Mirror(true);
-        _window->SetImage(rot);
-    }
-    else if (_rotation == VMROTATION::VM_FLIP_VERTICAL) {
-        wxImage rot = _image.Mirror(false);
-        _window->SetImage(rot);
-    }
-    else if (_rotation == VMROTATION::VM_90)
-    {
-        wxImage rot = _image.Rotate90();
-        _window->SetImage(rot);
-    }
-    else
-    {
-        wxImage rot = _image.Rotate90(false);
-        _window->SetImage(rot);
-    }
+    // the renderer converts, rotates and scales the channels on its own thread
+    _renderer->PushFrame(buffer + (sc - 1), size - (sc - 1));
 }
 
 void VirtualMatrix::Start()
@@ -450,7 +377,18 @@ void VirtualMatrix::Start()
         _window->Hide();
     }
 
-    _image = wxImage(_width, _height);
+    // start again as the size or settings may have changed
+    if (_renderer != nullptr)
+    {
+        delete _renderer;
+        _renderer = nullptr;
+    }
+
+    // If there is no width or height there is nothing to draw
+    if (_width != 0 && _height != 0)
+    {
+        _renderer = new VirtualMatrixRenderer(_window, _width, _height, GetPixelChannelsCount(), _rotation, _quality, _swsQuality);
+    }
 }
 
 void VirtualMatrix::Stop()
@@ -458,6 +396,13 @@ void VirtualMatrix::Stop()
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     logger_base.debug("Virtual matrix stopped %s.", (const char *)_name.c_str());
 
+    // the renderer draws into the window so it goes first
+    if (_renderer != nullptr)
+    {
+        delete _renderer;
+        _renderer = nullptr;
+    }
+
     // destroy the window
     if (_window != nullptr)
     {
@@ -17,6 +17,7 @@
 class wxXmlNode;
 class OutputManager;
 class ScheduleOptions;
+class VirtualMatrixRenderer;
 
 typedef enum {VM_NORMAL, VM_90, VM_270, VM_FLIP_HORIZONTAL, VM_FLIP_VERTICAL } VMROTATION;
 typedef enum {RGB, RGBW } VMPIXELCHANNELS;
@@ -37,10 +38,10 @@ class VirtualMatrix
     VMROTATION _rotation;
     VMPIXELCHANNELS _pixelChannels;
     std::string _startChannel;
-    wxImage _image;
     wxImageResizeQuality _quality;
     int _swsQuality;
     PlayerWindow* _window;
+    VirtualMatrixRenderer* _renderer;
     bool _suppress;
 
 public:
@@ -0,0 +1,192 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "VirtualMatrixRenderer.h"
+#include "PlayList/PlayerWindow.h"
+
+extern "C"
+{
+    #include <libswscale/swscale.h>
+}
+
+#include <log4cpp/Category.hh>
+
+// set in _ready when the slot there holds a frame the renderer has not taken yet
+#define NEW_FRAME 0x10
+
+VirtualMatrixRenderer::VirtualMatrixRenderer(PlayerWindow* window, size_t width, size_t height, int channelsPerPixel, VMROTATION rotation,
+                                             wxImageResizeQuality quality, int swsQuality) :
+    _window(window), _width(width), _height(height), _channelsPerPixel(channelsPerPixel), _rotation(rotation),
+    _quality(quality), _swsQuality(swsQuality), _ready(2), _sleeping(false), _stop(false)
+{
+    for (auto& it : _slots) {
+        it.resize(width * height * channelsPerPixel);
+    }
+    _thread = std::thread(&VirtualMatrixRenderer::Run, this);
+}
+
+VirtualMatrixRenderer::~VirtualMatrixRenderer()
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    _stop = true;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _signal.notify_all();
+    }
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+
+    if (_swsContext != nullptr) {
+        sws_freeContext(_swsContext);
+        _swsContext = nullptr;
+    }
+
+    logger_base.debug("Virtual matrix renderer: %u frames pushed, %u skipped, %u rendered.", _framesPushed, _framesSkipped, _framesRendered);
+}
+
+void VirtualMatrixRenderer::PushFrame(const uint8_t* channels, size_t size)
+{
+    auto& back = _slots[_back];
+    size = std::min(size, back.size());
+    if (size > 0) {
+        memcpy(back.data(), channels, size);
+    }
+    if (size < back.size()) {
+        memset(back.data() + size, 0x00, back.size() - size);
+    }
+
+    // publish the slot and take whichever one was waiting in its place
+    int prev = _ready.exchange(_back | NEW_FRAME);
+    _back = prev & ~NEW_FRAME;
+    _framesPushed++;
+    if (prev & NEW_FRAME) {
+        _framesSkipped++;
+    }
+
+    // only take the lock when the renderer is asleep, it never holds it for long
+    if (_sleeping) {
+        std::unique_lock<std::mutex> lock(_lock);
+        _signal.notify_one();
+    }
+}
+
+void VirtualMatrixRenderer::Run()
+{
+    while (!_stop) {
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _sleeping = true;
+            _signal.wait(lock, [this]() { return _stop || (_ready & NEW_FRAME) != 0; });
+            _sleeping = false;
+        }
+        if (_stop) break;
+
+        _front = _ready.exchange(_front) & ~NEW_FRAME;
+        Render(_slots[_front]);
+    }
+}
+
+void VirtualMatrixRenderer::Render(const std::vector<uint8_t>& channels)
+{
+    static log4cpp::Category& logger_frame = log4cpp::Category::getInstance(std::string("log_frame"));
+
+    // most frames on most matrices are the same as the last one
+    wxSize size = _window->GetImageSize();
+    if (channels == _lastRendered && size == _lastSize) return;
+    _lastRendered = channels;
+    _lastSize = size;
+
+    bool turned = _rotation == VMROTATION::VM_90 || _rotation == VMROTATION::VM_270;
+    int imageWidth = turned ? _height : _width;
+    int imageHeight = turned ? _width : _height;
+    wxImage image(imageWidth, imageHeight, false);
+    uint8_t* data = image.GetData();
+
+    const uint8_t* pb = channels.data();
+    for (size_t y = 0; y < _height; y++) {
+        for (size_t x = 0; x < _width; x++) {
+            uint8_t r = pb[0];
+            uint8_t g = pb[1];
+            uint8_t b = pb[2];
+            if (_channelsPerPixel > 3 && pb[3] != 0) {
+                r = g = b = pb[3];
+            }
+            pb += _channelsPerPixel;
+
+            // the same mapping as wxImage::Mirror and wxImage::Rotate90
+            size_t tx = x;
+            size_t ty = y;
+            switch (_rotation) {
+            case VMROTATION::VM_FLIP_HORIZONTAL:
+                tx = _width - 1 - x;
+                break;
+            case VMROTATION::VM_FLIP_VERTICAL:
+                ty = _height - 1 - y;
+                break;
+            case VMROTATION::VM_90:
+                tx = _height - 1 - y;
+                ty = x;
+                break;
+            case VMROTATION::VM_270:
+                tx = y;
+                ty = _width - 1 - x;
+                break;
+            default:
+                break;
+            }
+            uint8_t* p = data + (ty * imageWidth + tx) * 3;
+            p[0] = r;
+            p[1] = g;
+            p[2] = b;
+        }
+    }
+
+    wxImage scaled = Scale(image, size);
+    image.Destroy();
+    _window->SetScaledImage(scaled);
+    _framesRendered++;
+    logger_frame.debug("Virtual matrix rendered.");
+}
+
+wxImage VirtualMatrixRenderer::Scale(const wxImage& image, const wxSize& size)
+{
+    int width = size.GetWidth();
+    int height = size.GetHeight();
+    int srcWidth = image.GetWidth();
+    int srcHeight = image.GetHeight();
+
+    if (width <= 0 || height <= 0 || (srcWidth == width && srcHeight == height)) {
+        return image;
+    }
+
+    if (_swsQuality < 0) {
+        return image.Scale(width, height, _quality);
+    }
+
+    _swsContext = sws_getCachedContext(_swsContext, srcWidth, srcHeight, AVPixelFormat::AV_PIX_FMT_RGB24,
+                                       width, height, AVPixelFormat::AV_PIX_FMT_RGB24,
+                                       _swsQuality, nullptr, nullptr, nullptr);
+    if (_swsContext == nullptr) {
+        return image.Scale(width, height, _quality);
+    }
+
+    wxImage scaled(width, height, false);
+    const int srcRow = srcWidth * 3;
+    const int dstRow = width * 3;
+    const uint8_t* srcPtr = image.GetData();
+    uint8_t* const dstPtr = scaled.GetData();
+    sws_scale(_swsContext, &srcPtr, &srcRow, 0, srcHeight, &dstPtr, &dstRow);
+    return scaled;
+}
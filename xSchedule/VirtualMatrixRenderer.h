@@ -0,0 +1,82 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/xLightsSequencer/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/xLightsSequencer/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <wx/image.h>
+
+#include "VirtualMatrix.h"
+
+class PlayerWindow;
+struct SwsContext;
+
+/**
+ * Turns a virtual matrix's channels into the image its window shows on a thread of its own.
+ *
+ * The scheduler thread only copies the matrix's channels into a ring of three slots and never
+ * waits for the renderer.  The renderer picks up the newest slot, converts it to RGB, rotates it
+ * and scales it to the window, so the window only has to draw it.  A frame replaced before the
+ * renderer got to it is skipped.  The window's size is read for each frame so a resized window
+ * gets images of its new size.
+ */
+class VirtualMatrixRenderer
+{
+public:
+    VirtualMatrixRenderer(PlayerWindow* window, size_t width, size_t height, int channelsPerPixel, VMROTATION rotation,
+                          wxImageResizeQuality quality, int swsQuality);
+    ~VirtualMatrixRenderer();
+
+    // called from the scheduler thread, channels beyond size are treated as zero
+    void PushFrame(const uint8_t* channels, size_t size);
+
+    VirtualMatrixRenderer(const VirtualMatrixRenderer&) = delete;
+    VirtualMatrixRenderer& operator=(const VirtualMatrixRenderer&) = delete;
+
+private:
+    void Run();
+    void Render(const std::vector<uint8_t>& channels);
+    wxImage Scale(const wxImage& image, const wxSize& size);
+
+    PlayerWindow* _window = nullptr;
+    size_t _width = 0;
+    size_t _height = 0;
+    int _channelsPerPixel = 3;
+    VMROTATION _rotation = VMROTATION::VM_NORMAL;
+    wxImageResizeQuality _quality;
+    int _swsQuality = -1;
+
+    // _slots[_back] belongs to the scheduler thread, _slots[_front] to the renderer and _ready
+    // holds the third along with NEW_FRAME if the scheduler put a frame there the renderer has not taken
+    std::vector<uint8_t> _slots[3];
+    int _back = 0;
+    int _front = 1;
+    std::atomic_int _ready;
+    uint32_t _framesPushed = 0;
+    uint32_t _framesSkipped = 0;
+
+    std::thread _thread;
+    std::mutex _lock;
+    std::condition_variable _signal;
+    std::atomic_bool _sleeping;
+    std::atomic_bool _stop;
+
+    // only used on the render thread
+    std::vector<uint8_t> _lastRendered;
+    wxSize _lastSize;
+    SwsContext* _swsContext = nullptr;
+    uint32_t _framesRendered = 0;
+};